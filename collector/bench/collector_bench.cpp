@@ -0,0 +1,886 @@
+/*
+ * Collector microbenchmarks (host tool).
+ * Times the per-reading hot paths of the ingest pipeline: UDP datagram
+ * decode, HTTP head parse, reading batch decode, the sequence tracker, an
+ * SPSC ring handoff between two threads and a store append, plus a month
+ * of one device's 1 Hz data in the store: aggregate() and a full read(),
+ * and the fleet query kernels on one block, vector against scalar.
+ * Before timing anything it checks the wire code (round trips, bad
+ * inputs, ack bytes), seq_tracker (duplicates, holes in acks, epoch rules,
+ * window slide, reboot), the ring (order and completeness across threads),
+ * the HTTP parser, the block codec (round trip at the field limits, torn
+ * blocks) and the store against a brute-force reference (late readings,
+ * range edges, reopen), the work pool (every index once, concurrent
+ * callers), the kernels against their scalar references and the fleet
+ * queries against a brute-force scan (gaps, late fills, unsealed heads, both
+ * directions, every variant), the alert rules (cooldowns, rule set parsing)
+ * and the alert replay against stepping every reading through them, and
+ * exits 1 if any check fails. The month is also replayed through the
+ * device's alert rules, with and without block pruning. Results are
+ * reported in ns/op as JSON on stdout.
+ *
+ *   collector_bench [--reps N] [--min-batch-ms MS] [--filter SUBSTR]
+ */
+
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "alert_replay.h"
+#include "http_parse.h"
+#include "kernels.h"
+#include "query.h"
+#include "seq_tracker.h"
+#include "spsc_ring.h"
+#include "ts_store.h"
+#include "wire.h"
+#include "work_pool.h"
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace collector;
+
+static int s_fails;
+static volatile uint64_t s_sink;   // keeps results observable to the optimizer
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            s_fails++;                                                      \
+        }                                                                   \
+    } while (0)
+
+static int64_t host_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static udp_reading sample_udp(uint32_t seq)
+{
+    udp_reading u{};
+    u.device = 4242;
+    u.epoch = 0xBEEF;
+    u.depth = 600;
+    u.type = UDPT_READING;
+    u.r.unix_ms = 1760000000123LL + seq * 1000LL;
+    u.r.seq = seq;
+    u.r.t_cC = -1234;
+    u.r.h_cRH = 9999;
+    u.r.p_dPa = 0xFFFFFF;
+    return u;
+}
+
+static void check_wire()
+{
+    uint8_t pkt[UDPT_READING_LEN];
+    udp_reading in = sample_udp(0xDEADBEEF), out{};
+    encode_udp_reading(in, pkt);
+    CHECK(pkt[0] == (UDPT_VERSION << 4 | UDPT_READING));
+    CHECK(decode_udp_reading(pkt, sizeof pkt, out));
+    CHECK(out.device == in.device && out.epoch == in.epoch && out.depth == in.depth && out.type == in.type);
+    CHECK(out.r.seq == in.r.seq && out.r.unix_ms == in.r.unix_ms && out.r.t_cC == in.r.t_cC);
+    CHECK(out.r.h_cRH == in.r.h_cRH && out.r.p_dPa == in.r.p_dPa);
+    CHECK(!decode_udp_reading(pkt, sizeof pkt - 1, out));
+    pkt[0] = 2 << 4 | UDPT_READING;
+    CHECK(!decode_udp_reading(pkt, sizeof pkt, out));        // future version
+    pkt[0] = UDPT_VERSION << 4 | UDPT_ACK;
+    CHECK(!decode_udp_reading(pkt, sizeof pkt, out));        // an ack is not a reading
+
+    udp_ack a{};
+    a.device = 7;
+    a.epoch = 0x0102;
+    a.next = 100;
+    a.n = 2;
+    a.missing[0] = { 103, 2 };
+    a.missing[1] = { 110, 0x1234 };
+    uint8_t buf[udpt_ack_len(UDPT_ACK_RANGES_MAX)];
+    CHECK(encode_udp_ack(a, buf, udpt_ack_len(1)) == 0);
+    size_t len = encode_udp_ack(a, buf, sizeof buf);
+    CHECK(len == udpt_ack_len(2));
+    static const uint8_t want[] = { UDPT_VERSION << 4 | UDPT_ACK, 7, 0, 0x02, 0x01, 2, 100, 0, 0, 0,
+                                    103, 0, 0, 0, 2, 0, 110, 0, 0, 0, 0x34, 0x12 };
+    CHECK(len == sizeof want && memcmp(buf, want, sizeof want) == 0);
+    udp_ack b{};
+    CHECK(decode_udp_ack(buf, len, b));
+    CHECK(b.next == 100 && b.n == 2 && b.missing[1].first == 110 && b.missing[1].count == 0x1234);
+    CHECK(!decode_udp_ack(buf, len - 1, b));
+}
+
+static void check_seq_tracker()
+{
+    seq_tracker t;
+    udp_ack a{};
+    t.on_udp(1, 10, 10);                   // device holds 0..10
+    CHECK(t.next() == 0);
+    CHECK(t.add(10));
+    CHECK(!t.add(10));                     // duplicate
+    CHECK(t.missing(a) == 1 && a.next == 0 && a.missing[0].first == 0 && a.missing[0].count == 10);
+    for (uint32_t s = 0; s < 10; s++) CHECK(t.add(s));
+    CHECK(t.next() == 11 && t.missing(a) == 0);
+    CHECK(!t.add(3));                      // below next()
+
+    CHECK(t.add(13) && t.add(16));         // holes 11-12, 14-15
+    CHECK(t.missing(a) == 2 && a.missing[0].first == 11 && a.missing[0].count == 2);
+    CHECK(a.missing[1].first == 14 && a.missing[1].count == 2);
+
+    t.on_udp(1, 17, 3);                    // oldest 14: 11-12 can no longer be sent
+    CHECK(t.next() == 14 && t.lost() == 2);
+    t.on_udp(2, 18, 18);                   // reboot, history reaches back past next(): keep position
+    CHECK(t.next() == 14);
+    t.on_udp(3, 5, 5);                     // reboot with a short history: start over at its oldest
+    CHECK(t.next() == 0 && t.top() == 0);
+
+    seq_tracker w;
+    w.on_udp(1, 0, 0);
+    CHECK(w.add(0));
+    CHECK(w.add(seq_tracker::WINDOW + 5)); // slides the window; 1..5 given up
+    CHECK(w.next() == 6 && w.lost() == 5);
+    CHECK(w.add(1000000000));              // a huge jump is O(WINDOW), the rest of the window lost
+    CHECK(w.next() == 1000000000 - seq_tracker::WINDOW + 1);
+
+    seq_tracker z;                         // wrap-around
+    z.on_udp(1, 0xFFFFFFFE, 0);
+    CHECK(z.add(0xFFFFFFFE) && z.add(0) && z.add(0xFFFFFFFF));
+    CHECK(z.next() == 1 && z.missing(a) == 0);
+}
+
+static void check_ring()
+{
+    spsc_ring<uint64_t> ring(1000);
+    CHECK(ring.capacity() == 1024);
+    for (uint64_t i = 0; i < 1024; i++) CHECK(ring.push(i));
+    CHECK(!ring.push(0) && !ring.has_room(1));
+    uint64_t out[2048];
+    CHECK(ring.pop(out, 2048) == 1024 && out[1023] == 1023);
+
+    const uint64_t N = 2000000;
+    bool ordered = true;
+    uint64_t got = 0;
+    std::thread consumer([&] {
+        uint64_t buf[256];
+        while (got < N) {
+            size_t n = ring.pop(buf, 256);
+            for (size_t i = 0; i < n; i++) ordered &= buf[i] == got + i;
+            got += n;
+        }
+    });
+    for (uint64_t i = 0; i < N;)
+        if (ring.push(i)) i++;
+    consumer.join();
+    CHECK(ordered && got == N);
+}
+
+static void check_http()
+{
+    http_request r;
+    const char *req = "POST /ingest?x=1&device=1234 HTTP/1.1\r\nHost: c\r\nContent-Length: 16\r\n"
+                      "Connection: close\r\n\r\nBODY";
+    long n = parse_http_head(req, strlen(req), r);
+    CHECK(n == (long)strlen(req) - 4);
+    CHECK(r.method == "POST" && r.path == "/ingest" && r.has_length && r.content_length == 16 && !r.keep_alive);
+    CHECK(query_number(r.query, "device") == 1234 && query_number(r.query, "dev") == -1);
+    CHECK(parse_http_head(req, 30, r) == 0);                           // incomplete
+    const char *gz = "POST /ingest HTTP/1.1\r\nContent-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n";
+    CHECK(parse_http_head(gz, strlen(gz), r) > 0 && r.encoded && r.chunked && r.keep_alive);
+    const char *old = "GET /stats HTTP/1.0\r\n\r\n";
+    CHECK(parse_http_head(old, strlen(old), r) > 0 && !r.keep_alive);
+    CHECK(parse_http_head("GARBAGE\r\n\r\n", 11, r) < 0);
+    std::string big = "GET / HTTP/1.1\r\nX: " + std::string(HTTP_HEAD_MAX, 'a');
+    CHECK(parse_http_head(big.data(), big.size(), r) < 0);            // too long, even unfinished
+}
+
+static std::string make_tmp_dir()
+{
+    char tmpl[] = "/tmp/collector_bench.XXXXXX";
+    return mkdtemp(tmpl) ? tmpl : "";
+}
+
+static void remove_dir(const std::string &dir)
+{
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *e = readdir(d))
+            if (e->d_name[0] != '.') unlink((dir + "/" + e->d_name).c_str());
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+static void check_codec()
+{
+    std::vector<reading_t> rows(TS_BLOCK_ROWS);
+    uint32_t x = 12345;
+    auto rnd = [&x] { x ^= x << 13; x ^= x >> 17; x ^= x << 5; return x; };
+    int64_t t = 1760000000000LL;
+    for (size_t i = 0; i < rows.size(); i++) {
+        t += i == 500 ? 86400000LL * 40 : 1000 + (int)(rnd() % 61) - 30;   // jitter and one long outage
+        rows[i].unix_ms = t;
+        rows[i].t_cC = i % 7 == 0 ? (int16_t)(i & 1 ? 32767 : -32768) : (int16_t)(rnd() % 4000 - 2000);
+        rows[i].h_cRH = (uint16_t)(i % 5 == 0 ? 65535 : rnd() % 10000);
+        rows[i].p_dPa = i % 3 == 0 ? 0xFFFFFF : 950000 + rnd() % 100000;
+    }
+    static uint8_t block[TS_BLOCK_MAX];
+    ts_block_info info, back;
+    size_t size = ts_encode_block(77, rows.data(), rows.size(), block, info);
+    CHECK(size % 8 == 0 && size <= TS_BLOCK_MAX);
+    CHECK(!ts_read_header(block, size, back));                     // not sealed yet: a torn block
+    ts_seal_block(block);
+    CHECK(ts_read_header(block, size, back) && back.size() == size && back.device == 77);
+    CHECK(!ts_read_header(block, size - 8, back));                  // runs past the room given
+    CHECK(ts_read_header(block, size, back) && back.rows == TS_BLOCK_ROWS && back.t_last == t);
+    std::vector<int64_t> times(TS_BLOCK_ROWS);
+    std::vector<int32_t> vals(TS_BLOCK_ROWS);
+    ts_decode_times(block, back, times.data());
+    bool ok = true;
+    for (size_t i = 0; i < rows.size(); i++) ok &= times[i] == rows[i].unix_ms;
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        ts_decode_channel(block, back, (ts_channel)ch, vals.data());
+        ts_agg a;
+        for (size_t i = 0; i < rows.size(); i++) {
+            ok &= vals[i] == ts_value(rows[i], (ts_channel)ch);
+            a.add(vals[i]);
+        }
+        ok &= a.min == back.ch[ch].min && a.max == back.ch[ch].max && a.sum == back.ch[ch].sum;
+    }
+    CHECK(ok);
+
+    reading_t one{};                                                // a single-row block
+    one.unix_ms = -5;
+    one.t_cC = -40;
+    CHECK(ts_encode_block(1, &one, 1, block, info) == 88 + 8 && info.col_len[0] == 0);
+}
+
+static void check_store()
+{
+    std::string dir = make_tmp_dir();
+    CHECK(!dir.empty());
+    std::vector<reading_t> ref[3];
+    {
+        ts_store st(dir);
+        CHECK(st.open());
+        int64_t t0 = 1760000000000LL;
+        for (uint32_t i = 0; i < 5000; i++) {
+            for (uint16_t d = 0; d < 3; d++) {
+                if (d == 2 && i % 2) continue;                      // a slower device
+                reading_t r{};
+                r.unix_ms = t0 + i * 1000LL + d;
+                if (d == 1 && i % 1500 == 1499) r.unix_ms -= 1200000;   // a late gap fill, 20 min old
+                r.t_cC = (int16_t)(2000 + (int)(i % 700) - (int)d * 100);
+                r.h_cRH = (uint16_t)(4000 + i % 1000);
+                r.p_dPa = 1000000 + i;
+                st.append(d, r);
+                ref[d].push_back(r);
+            }
+        }
+        CHECK(st.stats().rows == ref[0].size() + ref[1].size() + ref[2].size());
+        CHECK(st.stats().blocks == 4 + 4 + 2 && st.stats().devices == 3);
+    }
+    ts_store st(dir);                                               // reopened: the heads were sealed on close
+    CHECK(st.open());
+    CHECK(st.stats().rows == ref[0].size() + ref[1].size() + ref[2].size() && st.stats().blocks == 13);
+    int64_t t0 = 1760000000000LL;
+    const int64_t ranges[][2] = { { 0, INT64_MAX }, { t0, t0 + 1 }, { t0 + 1023000, t0 + 1025000 },
+                                  { t0 + 777777, t0 + 4321000 }, { t0 + 3600000, t0 + 3600000 },
+                                  { t0 + 6000000, INT64_MAX } };
+    bool ok = true;
+    for (uint16_t d = 0; d < 3; d++) {
+        for (const auto &rg : ranges) {
+            for (int ch = 0; ch < TS_CHANNELS; ch++) {
+                ts_agg want;
+                for (const reading_t &r : ref[d])
+                    if (r.unix_ms >= rg[0] && r.unix_ms < rg[1]) want.add(ts_value(r, (ts_channel)ch));
+                ts_agg got = st.aggregate(d, (ts_channel)ch, rg[0], rg[1]);
+                ok &= got.count == want.count && got.sum == want.sum && (!want.count || (got.min == want.min && got.max == want.max));
+            }
+            std::vector<reading_t> rows;
+            size_t n = st.read(d, rg[0], rg[1], rows);
+            size_t want_n = 0;
+            for (const reading_t &r : ref[d]) want_n += r.unix_ms >= rg[0] && r.unix_ms < rg[1];
+            ok &= n == want_n && std::is_sorted(rows.begin(), rows.end(),
+                                                [](const reading_t &a, const reading_t &b) { return a.unix_ms < b.unix_ms; });
+        }
+    }
+    CHECK(ok);
+    CHECK(st.aggregate(9, TS_T, 0, INT64_MAX).count == 0);
+    remove_dir(dir);
+}
+
+static void check_pool()
+{
+    for (int threads : { 1, 4 }) {
+        work_pool pool(threads);
+        CHECK(pool.threads() == threads);
+        std::vector<std::atomic<int>> hits(10000);
+        pool.parallel_for(hits.size(), [&](size_t i) { hits[i].fetch_add(1); });
+        pool.parallel_for(hits.size(), [&](size_t i) { hits[i].fetch_add(1); }, 64);
+        pool.parallel_for(0, [&](size_t) { CHECK(false); });
+        std::vector<std::thread> callers;                           // concurrent jobs share the deques
+        for (int c = 0; c < 3; c++)
+            callers.emplace_back([&] { pool.parallel_for(hits.size(), [&](size_t i) { hits[i].fetch_add(1); }, 7); });
+        for (std::thread &t : callers) t.join();
+        bool ok = true;
+        for (auto &h : hits) ok &= h.load() == 5;
+        CHECK(ok);
+    }
+}
+
+static void check_kernels()
+{
+    uint32_t x = 777;
+    auto rnd = [&x] { x ^= x << 13; x ^= x >> 17; x ^= x << 5; return x; };
+    std::vector<int32_t> raw(TS_BLOCK_ROWS);
+    std::vector<float> f(TS_BLOCK_ROWS);
+    std::vector<int64_t> t(TS_BLOCK_ROWS);
+    uint64_t bits[TS_BLOCK_ROWS / 64], want[TS_BLOCK_ROWS / 64];
+    bool ok = true;
+    for (size_t n : { (size_t)1, (size_t)7, (size_t)8, (size_t)9, (size_t)63, (size_t)64, (size_t)65, (size_t)1000,
+                      TS_BLOCK_ROWS }) {
+        for (size_t i = 0; i < n; i++) {
+            raw[i] = (int32_t)(rnd() % 8001) - 4000;
+            t[i] = (i ? t[i - 1] : 0) + 900 + rnd() % 300 + (i == n / 2 ? 70000 : 0);
+        }
+        k_to_float(raw.data(), n, 0.01f, f.data());
+        for (size_t i = 0; i < n; i++) ok &= f[i] == (float)raw[i] * 0.01f;
+        k_minmax a = k_minmaxsum(f.data(), n), b = k_minmaxsum_scalar(f.data(), n);
+        ok &= a.min == b.min && a.max == b.max && fabs(a.sum - b.sum) < 0.01;
+        for (size_t i = 0; i < n; i++) f[i] = (float)(1013250 + raw[i]) * 0.1f;   // pressure, Pa
+        a = k_minmaxsum(f.data(), n), b = k_minmaxsum_scalar(f.data(), n);
+        ok &= a.min == b.min && a.max == b.max && fabs(a.sum - b.sum) < 0.01;
+        for (float thr : { -50.0f, 0.0f, f[n - 1], 12.34f, 50.0f }) {
+            k_mask_above(f.data(), n, thr, bits);
+            k_mask_above_scalar(f.data(), n, thr, want);
+            ok &= memcmp(bits, want, (n + 63) / 64 * 8) == 0;
+            k_mask_below(f.data(), n, thr, bits);
+            k_mask_below_scalar(f.data(), n, thr, want);
+            ok &= memcmp(bits, want, (n + 63) / 64 * 8) == 0;
+        }
+        int64_t step = 0;
+        for (size_t i = 1; i < n; i++) step = std::max(step, t[i] - t[i - 1]);
+        ok &= k_max_step(t.data(), n) == step;
+    }
+    CHECK(ok);
+}
+
+// Threshold episodes by the definition in query.h, one reading at a time.
+static threshold_hit reference_threshold(const std::vector<reading_t> &rows, uint16_t device, const threshold_query &q)
+{
+    threshold_hit h{ device, 0, 0, 0, 0 };
+    float scale = (float)ts_scale(q.ch);
+    bool in = false;
+    int64_t start = 0, last = 0;
+    auto close = [&] {
+        if (in && last - start >= q.min_duration_ms) {
+            if (!h.episodes++) h.first_start_ms = start;
+            h.longest_ms = std::max(h.longest_ms, last - start);
+            h.total_ms += last - start;
+        }
+        in = false;
+    };
+    for (size_t i = 0; i < rows.size(); i++) {
+        float v = (float)ts_value(rows[i], q.ch) * scale;
+        if (i && rows[i].unix_ms - rows[i - 1].unix_ms > q.max_gap_ms) close();
+        if (q.above ? v > q.threshold : v < q.threshold) {
+            if (!in) start = rows[i].unix_ms;
+            in = true;
+            last = rows[i].unix_ms;
+        } else {
+            close();
+        }
+    }
+    close();
+    return h;
+}
+
+static void check_query()
+{
+    std::string dir = make_tmp_dir();
+    CHECK(!dir.empty());
+    ts_store st(dir);
+    CHECK(st.open());
+    int64_t t0 = 1760000000000LL;
+    for (uint32_t i = 0; i < 6000; i++) {
+        for (uint16_t d = 0; d < 5; d++) {
+            reading_t r{};
+            r.unix_ms = t0 + i * 1000LL;
+            r.t_cC = (int16_t)(2000 + (int)(i % 97));
+            r.h_cRH = 4000;
+            r.p_dPa = 1000000;
+            if (d == 0 && ((i >= 100 && i < 800) || (i >= 1500 && i < 1560) || (i >= 2048 && i < 4096)))
+                r.t_cC = 3000;                                      // hot: 700 s, 60 s, two whole blocks
+            if (d == 0 && i >= 300 && i < 400) continue;            // offline 100 s in the first episode
+            if (d == 1 && i >= 1000 && i < 2500) r.t_cC = 500;      // cold
+            if (d == 2 && i >= 5000) r.t_cC = 3100;                 // hot in the head, not sealed yet
+            if (d == 3) {
+                r.t_cC = i >= 3000 && i < 3700 ? 2950 : 2100;
+                if (i % 1200 == 1100) r.unix_ms -= 900000;          // late fills: overlapping blocks
+            }
+            if (d == 4) {
+                r.t_cC = 3000;                                      // always hot, offline between two blocks
+                if (i >= 1024 && i < 1124) continue;
+            }
+            st.append(d, r);
+        }
+    }
+    work_pool pool(3);
+    query_engine engine(st, pool);
+    const query_options variants[] = { { true, true }, { true, false }, { false, true }, { false, false } };
+    const int64_t ranges[][2] = { { 0, INT64_MAX }, { t0 + 150000, t0 + 3000000 }, { t0 + 2100000, t0 + 2200000 } };
+    bool ok = true;
+    for (const auto &rg : ranges) {
+        std::vector<reading_t> rows[5];
+        for (uint16_t d = 0; d < 5; d++) st.read(d, rg[0], rg[1], rows[d]);
+        for (const query_options &opt : variants) {
+            fleet_agg a = engine.aggregate(TS_T, rg[0], rg[1], opt);
+            ok &= a.devices.size() == 5;
+            for (const fleet_agg_row &r : a.devices) {
+                ts_agg want = st.aggregate(r.device, TS_T, rg[0], rg[1]);
+                ok &= r.count == want.count && fabs(r.min - want.min * 0.01) < 1e-3 &&
+                      fabs(r.max - want.max * 0.01) < 1e-3 && fabs(r.mean() - want.mean() * 0.01) < 1e-3;
+            }
+            for (float thr : { 28.5f, 29.6f, 6.0f }) {
+                for (bool above : { true, false }) {
+                    for (int64_t dur : { (int64_t)0, (int64_t)120000, (int64_t)600000 }) {
+                        threshold_query q;
+                        q.above = above;
+                        q.threshold = thr;
+                        q.min_duration_ms = dur;
+                        q.from_ms = rg[0];
+                        q.to_ms = rg[1];
+                        std::vector<threshold_hit> got = engine.threshold(q, opt), want;
+                        for (uint16_t d = 0; d < 5; d++) {
+                            threshold_hit h = reference_threshold(rows[d], d, q);
+                            if (h.episodes) want.push_back(h);
+                        }
+                        bool same = got.size() == want.size();
+                        for (size_t i = 0; same && i < got.size(); i++)
+                            same = got[i].device == want[i].device && got[i].episodes == want[i].episodes &&
+                                   got[i].first_start_ms == want[i].first_start_ms &&
+                                   got[i].longest_ms == want[i].longest_ms && got[i].total_ms == want[i].total_ms;
+                        ok &= same;
+                    }
+                }
+            }
+        }
+    }
+    threshold_query q;                                              // the gap splits device 0's first episode
+    q.threshold = 28.5f;
+    q.min_duration_ms = 120000;
+    std::vector<threshold_hit> hits = engine.threshold(q);
+    CHECK(hits.size() == 4 && hits[0].device == 0 && hits[0].episodes == 3 && hits[0].first_start_ms == t0 + 100000);
+    CHECK(hits[0].longest_ms == 2047000 && hits[1].device == 2 && hits[2].device == 3);
+    CHECK(hits[3].device == 4 && hits[3].episodes == 2 && hits[3].first_start_ms == t0);
+    CHECK(ok);
+    remove_dir(dir);
+}
+
+static void check_alert_rules()
+{
+    alert_rules_t r = ALERT_RULES_DEFAULT;
+    alert_state_t st{ 0, 0 };
+    const int64_t min = 60000000;
+    CHECK(alert_rules_step(&r, &st, 22.0, 0) == ALERT_NONE && st.warn_until_us == 0);
+    CHECK(alert_rules_step(&r, &st, 16.5, 0) == ALERT_COLD_WARNING);
+    CHECK(alert_rules_step(&r, &st, 16.0, 29 * min) == ALERT_NONE);          // warning cooldown
+    CHECK(alert_rules_step(&r, &st, 15.0, 29 * min) == ALERT_COLD_ALERT);    // alerts have their own
+    CHECK(alert_rules_step(&r, &st, 28.5, 30 * min) == ALERT_HOT_WARNING);   // shared by both directions
+    CHECK(alert_rules_step(&r, &st, 31.0, 88 * min) == ALERT_NONE);
+    CHECK(alert_rules_step(&r, &st, 31.0, 89 * min) == ALERT_HOT_ALERT);
+    CHECK(alert_rules_quiet_lo(&r) == 16.5 && alert_rules_quiet_hi(&r) == 28.5);
+    char buf[96];
+    alert_rules_message(&r, ALERT_HOT_ALERT, 31.04, buf, sizeof buf);
+    CHECK(strcmp(buf, "Hot Alert: Inside temperature 31.0C is above 30.0C.") == 0);
+
+    alert_rules_t p;
+    CHECK(parse_alert_rules("device", p) && format_alert_rules(p) == "15,16.5,28.5,30,30,60");
+    CHECK(parse_alert_rules("14,16", p) && format_alert_rules(p) == "14,16,28.5,30,30,60");
+    CHECK(parse_alert_rules("14,16,29,31,10,20.5", p) && p.alert_cooldown_us == 1230000000LL);
+    CHECK(!parse_alert_rules("", p) && !parse_alert_rules("14,", p) && !parse_alert_rules("a", p));
+    CHECK(!parse_alert_rules("1,2,3,4,5,6,7", p) && !parse_alert_rules("14;16", p));
+    CHECK(!parse_alert_rules("14,16,28,30,-1", p));
+}
+
+static alert_tally reference_alerts(const std::vector<reading_t> &rows, const alert_rules_t &r)
+{
+    alert_tally t;
+    alert_state_t st{ 0, 0 };
+    for (const reading_t &x : rows) {
+        alert_kind_t k = alert_rules_step(&r, &st, x.t_cC / 100.0, x.unix_ms * 1000);
+        if (k == ALERT_NONE) continue;
+        t.sms++;
+        t.kinds[k]++;
+    }
+    t.devices = t.sms > 0;
+    return t;
+}
+
+static void check_alert_replay()
+{
+    std::string dir = make_tmp_dir();
+    CHECK(!dir.empty());
+    ts_store st(dir);
+    CHECK(st.open());
+    int64_t t0 = 1760000000000LL;
+    for (uint32_t i = 0; i < 6000; i++) {
+        for (uint16_t d = 0; d < 4; d++) {
+            reading_t r{};
+            r.unix_ms = t0 + i * 60000LL;                               // once a minute: 4 days
+            r.t_cC = (int16_t)(2150 + (int)(i % 37) - 18);
+            if (d == 0 && ((i >= 500 && i < 700) || (i >= 2000 && i < 2100))) r.t_cC = (int16_t)(2850 + i % 200);
+            if (d == 1) {
+                if (i >= 1000 && i < 1400) r.t_cC = (int16_t)(1650 - (int)(i - 1000) / 2);   // down through 15
+                if (i % 1200 == 1100) r.unix_ms -= 90 * 60000;          // late fills: overlapping blocks
+            }
+            if (d == 2 && i >= 5500) r.t_cC = 3000;                     // in the head, not sealed yet
+            st.append(d, r);
+        }
+    }
+    std::vector<alert_rules_t> sets(3);
+    CHECK(parse_alert_rules("device", sets[0]));
+    CHECK(parse_alert_rules("15,16.5,29,30.5,60,120", sets[1]));
+    CHECK(parse_alert_rules("18,21.5,22,25,5,10", sets[2]));        // fires on the baseline too
+    work_pool pool(3), one(1);
+    const int64_t ranges[][2] = { { 0, INT64_MAX }, { t0 + 450 * 60000LL, t0 + 4000 * 60000LL } };
+    bool ok = true;
+    for (const auto &rg : ranges) {
+        alert_replay_result want;
+        want.sets.resize(sets.size());
+        for (uint16_t d = 0; d < 4; d++) {
+            std::vector<reading_t> rows;
+            st.read(d, rg[0], rg[1], rows);
+            want.readings += rows.size();
+            want.devices += !rows.empty();
+            for (size_t k = 0; k < sets.size(); k++) {
+                alert_tally t = reference_alerts(rows, sets[k]);
+                want.sets[k].sms += t.sms;
+                want.sets[k].devices += t.devices;
+                for (int kind = 0; kind < ALERT_KINDS; kind++) want.sets[k].kinds[kind] += t.kinds[kind];
+            }
+        }
+        for (work_pool *p : { &pool, &one }) {
+            for (bool prune : { true, false }) {
+                alert_replay_result got = replay_alerts(st, *p, sets, rg[0], rg[1], prune);
+                ok &= got.readings == want.readings && got.devices == want.devices;
+                for (size_t k = 0; k < sets.size(); k++) {
+                    ok &= got.sets[k].sms == want.sets[k].sms && got.sets[k].devices == want.sets[k].devices;
+                    for (int kind = 0; kind < ALERT_KINDS; kind++)
+                        ok &= got.sets[k].kinds[kind] == want.sets[k].kinds[kind];
+                }
+            }
+        }
+        ok &= want.sets[0].kinds[ALERT_HOT_ALERT] > 0 && want.sets[0].kinds[ALERT_COLD_ALERT] > 0;
+        ok &= want.sets[2].devices == 4;
+    }
+    CHECK(ok);
+    alert_replay_result quiet = replay_alerts(st, pool, { sets[0] }, 0, INT64_MAX);
+    CHECK(quiet.decoded < quiet.readings / 2);                      // quiet blocks skipped undecoded
+    remove_dir(dir);
+}
+
+// ---- benchmarks -------------------------------------------------------------
+
+static uint8_t s_pkt[UDPT_READING_LEN];
+static uint8_t s_batch[READING_BATCH_HEADER_LEN + READING_BATCH_MAX * READING_BATCH_RECORD_LEN];
+static size_t  s_batch_len;
+static const char s_post[] = "POST /ingest?device=1234 HTTP/1.1\r\nHost: 192.168.1.10:8090\r\n"
+                             "User-Agent: ESP32 HTTP Client/1.0\r\nContent-Type: application/octet-stream\r\n"
+                             "Content-Length: 2311\r\n\r\n";
+
+static void b_udp_decode(uint64_t n)
+{
+    udp_reading u;
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_pkt[10] = (uint8_t)i;
+        acc += decode_udp_reading(s_pkt, sizeof s_pkt, u) ? u.r.seq : 0;
+    }
+    s_sink = acc;
+}
+
+static void b_http_head(uint64_t n)
+{
+    http_request r;
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += (uint64_t)parse_http_head(s_post, sizeof s_post - 1, r) + r.content_length;
+    s_sink = acc;
+}
+
+static void b_batch_decode_255(uint64_t n)   // one full uplink batch
+{
+    static reading_t out[READING_BATCH_MAX];
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += (uint64_t)reading_batch_decode(s_batch, s_batch_len, out, READING_BATCH_MAX);
+    s_sink = acc;
+}
+
+static void b_seq_in_order(uint64_t n)
+{
+    static seq_tracker t;
+    static uint32_t seq;
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += t.add(seq++);
+    s_sink = acc;
+}
+
+static void b_seq_duplicate(uint64_t n)
+{
+    seq_tracker t;
+    for (uint32_t s = 0; s < 64; s++) t.add(s * 2);
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += t.add((uint32_t)(i & 63) * 2);
+    s_sink = acc;
+}
+
+static void b_ring_handoff(uint64_t n)   // per item, producer and consumer on two threads
+{
+    struct item { uint64_t pad[6]; };    // the size of an ingest_item
+    spsc_ring<item> ring(1 << 16);
+    std::thread consumer([&] {
+        item buf[256];
+        uint64_t got = 0;
+        while (got < n) got += ring.pop(buf, 256);
+    });
+    item it{};
+    for (uint64_t i = 0; i < n;) {
+        it.pad[0] = i;
+        if (ring.push(it)) i++;
+    }
+    consumer.join();
+}
+
+// One device, 30 days at the firmware's 1030 ms interval with a little jitter.
+static std::string s_month_dir;
+static std::unique_ptr<ts_store> s_month;
+static int64_t s_month_t0, s_month_t1;
+static size_t  s_month_rows;
+
+static void build_month()
+{
+    s_month_dir = make_tmp_dir();
+    s_month = std::make_unique<ts_store>(s_month_dir);
+    if (!s_month->open()) exit(1);
+    s_month_t0 = 1760000000000LL;
+    int64_t t = s_month_t0;
+    uint32_t x = 99;
+    for (uint32_t i = 0; t < s_month_t0 + 30 * 86400000LL; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        reading_t r{};
+        r.unix_ms = t;
+        r.t_cC = (int16_t)(2150 + 300 * sin(i * 2 * M_PI / 83883) + (int)(x % 5) - 2);
+        r.h_cRH = (uint16_t)(4500 + (x >> 8) % 40);
+        r.p_dPa = 1013250 + (x >> 16) % 200;
+        s_month->append(1, r);
+        t += 1030 + (int)(x % 5) - 2;
+        s_month_rows++;
+    }
+    s_month_t1 = t;
+    s_month->seal_all();
+}
+
+static std::string s_append_dir;
+static std::unique_ptr<ts_store> s_append;
+
+static void b_store_append(uint64_t n)
+{
+    static int64_t t = 1760000000000LL;
+    reading_t r{};
+    for (uint64_t i = 0; i < n; i++) {
+        r.unix_ms = t += 1000;
+        r.t_cC = (int16_t)(2150 + (i & 15));
+        s_append->append((uint16_t)(i & 1023), r);                  // 1024 devices, round robin
+    }
+}
+
+static void b_month_aggregate(uint64_t n)   // one channel, range cut inside the first and last block
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < n; i++)
+        acc += s_month->aggregate(1, TS_T, s_month_t0 + 3600000, s_month_t1 - 3600000).count;
+    s_sink = acc;
+}
+
+static void b_month_read(uint64_t n)        // every reading decoded, all channels
+{
+    std::vector<reading_t> rows;
+    rows.reserve(s_month_rows);
+    for (uint64_t i = 0; i < n; i++) {
+        rows.clear();
+        s_sink = s_month->read(1, s_month_t0, s_month_t1, rows);
+    }
+}
+
+static work_pool *s_one;
+static const std::vector<alert_rules_t> s_device_rules(1, alert_rules_t ALERT_RULES_DEFAULT);
+
+static void b_month_alert_replay(uint64_t n)   // per month of one device, the device's rules
+{
+    for (uint64_t i = 0; i < n; i++)
+        s_sink = replay_alerts(*s_month, *s_one, s_device_rules, s_month_t0, INT64_MAX).sets[0].sms;
+}
+
+static void b_month_alert_replay_noprune(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+        s_sink = replay_alerts(*s_month, *s_one, s_device_rules, s_month_t0, INT64_MAX, false).sets[0].sms;
+}
+
+static float s_col[TS_BLOCK_ROWS];         // one decoded block column, °C
+
+static void b_minmaxsum(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_col[i & 1023] += 0.0f;
+        acc += k_minmaxsum(s_col, TS_BLOCK_ROWS).sum;
+    }
+    s_sink = (uint64_t)acc;
+}
+
+static void b_minmaxsum_scalar(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_col[i & 1023] += 0.0f;
+        acc += k_minmaxsum_scalar(s_col, TS_BLOCK_ROWS).sum;
+    }
+    s_sink = (uint64_t)acc;
+}
+
+static void b_mask_above(uint64_t n)
+{
+    uint64_t bits[TS_BLOCK_ROWS / 64], acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        k_mask_above(s_col, TS_BLOCK_ROWS, 24.0f + (float)(i & 7), bits);
+        acc += bits[i & 15];
+    }
+    s_sink = acc;
+}
+
+static void b_mask_above_scalar(uint64_t n)
+{
+    uint64_t bits[TS_BLOCK_ROWS / 64], acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        k_mask_above_scalar(s_col, TS_BLOCK_ROWS, 24.0f + (float)(i & 7), bits);
+        acc += bits[i & 15];
+    }
+    s_sink = acc;
+}
+
+struct bench {
+    const char *name;
+    void (*fn)(uint64_t);
+};
+
+static const bench BENCHES[] = {
+    { "udp_decode", b_udp_decode },
+    { "http_head_parse", b_http_head },
+    { "batch_decode_255", b_batch_decode_255 },
+    { "seq_tracker_in_order", b_seq_in_order },
+    { "seq_tracker_duplicate", b_seq_duplicate },
+    { "spsc_ring_handoff", b_ring_handoff },
+    { "store_append", b_store_append },
+    { "store_month_aggregate", b_month_aggregate },
+    { "store_month_read", b_month_read },
+    { "alert_replay_month", b_month_alert_replay },
+    { "alert_replay_month_noprune", b_month_alert_replay_noprune },
+    { "kernel_minmaxsum_1024", b_minmaxsum },
+    { "kernel_minmaxsum_1024_scalar", b_minmaxsum_scalar },
+    { "kernel_mask_above_1024", b_mask_above },
+    { "kernel_mask_above_1024_scalar", b_mask_above_scalar },
+};
+
+int main(int argc, char **argv)
+{
+    int reps = 15;
+    double min_batch_ms = 5;
+    const char *filter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)              reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--min-batch-ms") == 0 && i + 1 < argc) min_batch_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)       filter = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--reps N] [--min-batch-ms MS] [--filter SUBSTR]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (reps < 2) reps = 2;
+
+    check_wire();
+    check_seq_tracker();
+    check_ring();
+    check_http();
+    check_codec();
+    check_store();
+    check_pool();
+    check_kernels();
+    check_query();
+    check_alert_rules();
+    check_alert_replay();
+    if (s_fails) {
+        fprintf(stderr, "%d check(s) failed\n", s_fails);
+        return 1;
+    }
+
+    encode_udp_reading(sample_udp(1), s_pkt);
+    reading_t rs[READING_BATCH_MAX];
+    for (int i = 0; i < READING_BATCH_MAX; i++) rs[i] = sample_udp((uint32_t)i).r;
+    size_t used = 0;
+    s_batch_len = reading_batch_encode(rs, READING_BATCH_MAX, s_batch, sizeof s_batch, &used);
+
+    for (size_t i = 0; i < TS_BLOCK_ROWS; i++) s_col[i] = 22.0f + 8.0f * (float)sin((double)i * 0.05);
+    build_month();
+    work_pool one(1);
+    s_one = &one;
+    s_append_dir = make_tmp_dir();
+    s_append = std::make_unique<ts_store>(s_append_dir);
+    if (!s_append->open()) return 1;
+    ts_store_stats ms = s_month->stats();
+    fprintf(stderr, "month: %zu readings in %llu blocks, %.2f bytes/reading\n", s_month_rows,
+            (unsigned long long)ms.blocks, (double)ms.bytes / (double)s_month_rows);
+
+    printf("{\n  \"benchmarks\": [");
+    std::vector<double> samples((size_t)reps);
+    bool first = true;
+    for (const bench &bn : BENCHES) {
+        if (filter && !strstr(bn.name, filter)) continue;
+        uint64_t iters = 1;
+        for (;;) {                                   // scale the batch to min_batch_ms
+            int64_t t0 = host_now_ns();
+            bn.fn(iters);
+            double ms = (double)(host_now_ns() - t0) / 1e6;
+            if (ms >= min_batch_ms || iters >= (1ULL << 32)) break;
+            iters *= (ms < min_batch_ms / 16) ? 8 : 2;
+        }
+        double sum = 0;
+        for (int r = 0; r < reps; r++) {
+            int64_t t0 = host_now_ns();
+            bn.fn(iters);
+            samples[(size_t)r] = (double)(host_now_ns() - t0) / (double)iters;
+            sum += samples[(size_t)r];
+        }
+        double mean = sum / reps, var = 0;
+        for (double s : samples) var += (s - mean) * (s - mean);
+        double sd = sqrt(var / (reps - 1));
+        std::sort(samples.begin(), samples.end());
+        double median = (reps & 1) ? samples[(size_t)reps / 2]
+                                   : 0.5 * (samples[(size_t)reps / 2 - 1] + samples[(size_t)reps / 2]);
+        printf("%s\n    {\"name\": \"%s\", \"iters_per_rep\": %llu, \"ns_per_op\": "
+               "{\"mean\": %.3f, \"stddev\": %.3f, \"min\": %.3f, \"median\": %.3f}}",
+               first ? "" : ",", bn.name, (unsigned long long)iters, mean, sd, samples[0], median);
+        fprintf(stderr, "%-40s %10.2f ns/op  +- %6.2f  (min %.2f)\n", bn.name, mean, sd, samples[0]);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+    s_month.reset();
+    s_append.reset();
+    remove_dir(s_month_dir);
+    remove_dir(s_append_dir);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Fleet collector entry point.
+ * Runs the ingest server (src/ingest.h) and logs one "STATS: k=v ..." line
+ * per interval, like the firmware's PERF lines.
+ *
+ *   climate_collector [--bind ADDR] [--http-port P] [--udp-port P] [--workers N]
+ *                     [--data DIR] [--query-threads N] [--stats-s S] [--duration S]
+ *
+ * --http-port  uplink POSTs (/ingest?device=N) and GET /stats (default 8090, 0 = any)
+ * --udp-port   UDP telemetry datagrams (default 8091, 0 = any)
+ * --workers    ingest threads (default one per core)
+ * --data       keep the readings in a time-series store in DIR (src/ts_store.h);
+ *              without it only the counters and the newest reading are kept
+ * --query-threads  threads for the /fleet/ queries, counting the query thread (default one per core)
+ * --stats-s    STATS line interval (default 10, 0 = off)
+ * --duration   seconds to run, 0 = until SIGINT/SIGTERM (default 0)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "ingest.h"
+
+static std::atomic<bool> s_stop{false};
+
+static void on_signal(int) { s_stop = true; }
+
+int main(int argc, char **argv)
+{
+    collector::ingest_config cfg;
+    double stats_s = 10, duration_s = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) goto usage;
+        if (!strcmp(a, "--bind")) cfg.bind_addr = v;
+        else if (!strcmp(a, "--http-port")) cfg.http_port = (uint16_t)atoi(v);
+        else if (!strcmp(a, "--udp-port")) cfg.udp_port = (uint16_t)atoi(v);
+        else if (!strcmp(a, "--workers")) cfg.workers = atoi(v);
+        else if (!strcmp(a, "--data")) cfg.data_dir = v;
+        else if (!strcmp(a, "--query-threads")) cfg.query_threads = atoi(v);
+        else if (!strcmp(a, "--stats-s")) stats_s = atof(v);
+        else if (!strcmp(a, "--duration")) duration_s = atof(v);
+        else goto usage;
+        i++;
+    }
+
+    {
+        setvbuf(stdout, nullptr, _IOLBF, 0);
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+        signal(SIGPIPE, SIG_IGN);
+        collector::ingest_server srv(cfg);
+        if (!srv.start()) return 1;
+        printf("collector: http port %u, udp port %u, %d workers\n", srv.http_port(), srv.udp_port(),
+               srv.workers());
+        if (srv.store()) {
+            collector::ts_store_stats st = srv.store()->stats();
+            printf("store: %s, %llu readings of %llu devices in %llu blocks\n", srv.store()->dir().c_str(),
+                   (unsigned long long)st.rows, (unsigned long long)st.devices, (unsigned long long)st.blocks);
+        }
+
+        using clock = std::chrono::steady_clock;
+        auto t0 = clock::now(), next_stats = t0;
+        collector::ingest_stats prev{};
+        while (!s_stop) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            auto now = clock::now();
+            double up = std::chrono::duration<double>(now - t0).count();
+            if (stats_s > 0 && now >= next_stats + std::chrono::duration<double>(stats_s)) {
+                collector::ingest_stats s = srv.stats();
+                double dt = std::chrono::duration<double>(now - next_stats).count();
+                printf("STATS: uptime_s=%.0f devices=%llu readings_per_s=%.0f stored=%llu duplicates=%llu "
+                       "lost=%llu ring_drops=%llu datagrams=%llu http_requests=%llu http_errors=%llu acks=%llu "
+                       "store_blocks=%llu store_bytes=%llu\n",
+                       up, (unsigned long long)s.sink.devices, (s.sink.stored - prev.sink.stored) / dt,
+                       (unsigned long long)s.sink.stored, (unsigned long long)s.sink.duplicates,
+                       (unsigned long long)s.sink.lost, (unsigned long long)s.ring_drops,
+                       (unsigned long long)s.datagrams, (unsigned long long)s.http_requests,
+                       (unsigned long long)s.http_errors, (unsigned long long)s.sink.acks,
+                       (unsigned long long)s.store.blocks, (unsigned long long)s.store.bytes);
+                prev = s;
+                next_stats = now;
+            }
+            if (duration_s > 0 && up >= duration_s) break;
+        }
+        srv.stop();
+        return 0;
+    }
+
+usage:
+    fprintf(stderr,
+            "usage: %s [--bind ADDR] [--http-port P] [--udp-port P] [--workers N] [--data DIR]\n"
+            "       [--query-threads N] [--stats-s S] [--duration S]\n",
+            argv[0]);
+    return 2;
+}
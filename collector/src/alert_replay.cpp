@@ -0,0 +1,169 @@
+/*
+ * Alert rule replay over the fleet's history (implementation).
+ * - Temperatures go through the decision as t_cC / 100.0, the same double
+ *   reading_T_C() gives, so a reading exactly on a threshold counts as the
+ *   device would count it.
+ * - The quiet band is checked on that same double, per reading and for a
+ *   block's summary min and max.
+ */
+
+#include "alert_replay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace collector {
+
+bool parse_alert_rules(std::string_view spec, alert_rules_t &out)
+{
+    out = ALERT_RULES_DEFAULT;
+    if (spec == "device") return true;
+    std::string s(spec);
+    double v[6];
+    int n = 0;
+    for (const char *p = s.c_str();;) {
+        if (n == 6) return false;                       // a seventh number
+        char *end;
+        v[n] = strtod(p, &end);
+        if (end == p) return false;
+        n++;
+        if (*end == '\0') break;
+        if (*end != ',') return false;
+        p = end + 1;
+    }
+    double *fields[] = { &out.alert_low_C, &out.warn_low_C, &out.warn_high_C, &out.alert_high_C };
+    for (int i = 0; i < n && i < 4; i++) *fields[i] = v[i];
+    if (n > 4) out.warn_cooldown_us = (int64_t)(v[4] * 60e6);
+    if (n > 5) out.alert_cooldown_us = (int64_t)(v[5] * 60e6);
+    return out.warn_cooldown_us >= 0 && out.alert_cooldown_us >= 0;
+}
+
+std::string format_alert_rules(const alert_rules_t &r)
+{
+    char buf[128];
+    snprintf(buf, sizeof buf, "%g,%g,%g,%g,%g,%g", r.alert_low_C, r.warn_low_C, r.warn_high_C, r.alert_high_C,
+             r.warn_cooldown_us / 60e6, r.alert_cooldown_us / 60e6);
+    return buf;
+}
+
+namespace {
+
+struct device_replay {
+    const std::vector<alert_rules_t> &sets;
+    std::vector<alert_state_t> state;
+    std::vector<double>        lo, hi;       // quiet band per set
+    std::vector<alert_tally>   tally;
+    uint64_t readings = 0, decoded = 0;
+
+    explicit device_replay(const std::vector<alert_rules_t> &s)
+        : sets(s), state(s.size(), alert_state_t{ 0, 0 }), lo(s.size()), hi(s.size()), tally(s.size())
+    {
+        for (size_t k = 0; k < s.size(); k++) {
+            lo[k] = alert_rules_quiet_lo(&s[k]);
+            hi[k] = alert_rules_quiet_hi(&s[k]);
+        }
+    }
+
+    // Sorted readings t[0..n) with temperatures in centi-°C; skip[k] set for sets known to stay quiet.
+    void rows(const int64_t *t, const int32_t *t_cC, size_t n, const std::vector<char> *skip = nullptr)
+    {
+        decoded += n;
+        for (size_t k = 0; k < sets.size(); k++) {
+            if (skip && (*skip)[k]) continue;
+            for (size_t i = 0; i < n; i++) {
+                double T_C = t_cC[i] / 100.0;
+                if (T_C > lo[k] && T_C < hi[k]) continue;
+                alert_kind_t kind = alert_rules_step(&sets[k], &state[k], T_C, t[i] * 1000);
+                if (kind == ALERT_NONE) continue;
+                tally[k].sms++;
+                tally[k].kinds[kind]++;
+            }
+        }
+    }
+};
+
+void replay_device(const ts_store &store, uint16_t device, int64_t from_ms, int64_t to_ms, bool prune,
+                   device_replay &r)
+{
+    ts_range_view v;
+    store.view(device, from_ms, to_ms, v);
+    int64_t t[TS_BLOCK_ROWS];
+    int32_t raw[TS_BLOCK_ROWS];
+    auto chunks = [&](const std::vector<reading_t> &rows) {
+        for (size_t i = 0; i < rows.size(); i += TS_BLOCK_ROWS) {
+            size_t n = std::min(TS_BLOCK_ROWS, rows.size() - i);
+            for (size_t k = 0; k < n; k++) {
+                t[k] = rows[i + k].unix_ms;
+                raw[k] = rows[i + k].t_cC;
+            }
+            r.readings += n;
+            r.rows(t, raw, n);
+        }
+    };
+    if (!v.ordered) {                                   // overlapping blocks: read back sorted
+        std::vector<reading_t> rows;
+        store.read(device, from_ms, to_ms, rows);
+        chunks(rows);
+        return;
+    }
+    std::vector<char> skip(r.sets.size());
+    for (const ts_block_ref &b : v.blocks) {
+        bool skip_any = false, skip_all = true;
+        if (prune && b.info.t_first >= from_ms && b.info.t_last < to_ms) {
+            double mn = b.info.ch[TS_T].min / 100.0, mx = b.info.ch[TS_T].max / 100.0;
+            for (size_t k = 0; k < r.sets.size(); k++) {
+                skip[k] = mn > r.lo[k] && mx < r.hi[k];
+                skip_any |= skip[k] != 0;
+                skip_all &= skip[k] != 0;
+            }
+            if (skip_all) {
+                r.readings += b.info.rows;
+                continue;
+            }
+        }
+        size_t lo, hi;
+        ts_decode_times(b.data, b.info, t);
+        lo = (size_t)(std::lower_bound(t, t + b.info.rows, from_ms) - t);
+        hi = (size_t)(std::lower_bound(t + lo, t + b.info.rows, to_ms) - t);
+        if (lo == hi) continue;
+        ts_decode_channel(b.data, b.info, TS_T, raw);
+        r.readings += hi - lo;
+        r.rows(t + lo, raw + lo, hi - lo, skip_any ? &skip : nullptr);
+    }
+    chunks(v.head);
+}
+
+} // namespace
+
+/**
+ * @brief Count the SMS each rule set would have sent over a time range.
+ *
+ * Every device starts with no cooldown running at from_ms.
+ */
+alert_replay_result replay_alerts(const ts_store &store, work_pool &pool, const std::vector<alert_rules_t> &sets,
+                                  int64_t from_ms, int64_t to_ms, bool prune)
+{
+    std::vector<uint16_t> devices = store.devices();
+    std::vector<device_replay> per;
+    per.reserve(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) per.emplace_back(sets);
+    pool.parallel_for(devices.size(),
+                      [&](size_t i) { replay_device(store, devices[i], from_ms, to_ms, prune, per[i]); });
+
+    alert_replay_result out;
+    out.sets.resize(sets.size());
+    for (const device_replay &d : per) {
+        out.readings += d.readings;
+        out.decoded += d.decoded;
+        out.devices += d.readings > 0;
+        for (size_t k = 0; k < sets.size(); k++) {
+            alert_tally &s = out.sets[k];
+            s.sms += d.tally[k].sms;
+            for (int kind = 0; kind < ALERT_KINDS; kind++) s.kinds[kind] += d.tally[k].kinds[kind];
+            s.devices += d.tally[k].sms > 0;
+        }
+    }
+    return out;
+}
+
+} // namespace collector
@@ -0,0 +1,57 @@
+/*
+ * Alert rule replay over the fleet's history (public API).
+ * - Feeds every stored temperature reading of every device, in time
+ *   order, through the firmware's own alert decision (main/alert_rules.h)
+ *   under one or more rule sets at once, and counts the SMS each set
+ *   would have sent. The readings' timestamps drive the cooldowns.
+ * - One task per device on a work_pool (work_pool.h); a device's blocks
+ *   are decoded once for all rule sets.
+ * - A block whose summary lies inside a rule set's quiet band (nothing
+ *   can fire there, alert_rules_quiet_lo/hi) is skipped for that set, and
+ *   not decoded at all when that holds for every set; most of a year is
+ *   such blocks.
+ * - The device evaluates its fused estimate once per sensor loop; the
+ *   store holds the reported temperature once per pushed reading, which
+ *   is what gets replayed. Forecast SMS (sms_eval_forecast) are not
+ *   replayed: they depend on the on-device trend fit.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ts_store.h"
+#include "work_pool.h"
+
+extern "C" {
+#include "alert_rules.h"
+}
+
+namespace collector {
+
+// "device" (ALERT_RULES_DEFAULT), or up to six comma-separated numbers in
+// alert_rules_t order with the cooldowns in minutes:
+// "alert_low,warn_low,warn_high,alert_high,warn_cooldown_min,alert_cooldown_min".
+// Numbers left out keep the device's values. false if malformed.
+bool        parse_alert_rules(std::string_view spec, alert_rules_t &out);
+std::string format_alert_rules(const alert_rules_t &r);   // all six numbers, parseable
+
+struct alert_tally {
+    uint64_t sms = 0;
+    uint64_t kinds[ALERT_KINDS] = {};  // by alert_kind_t
+    uint32_t devices = 0;              // devices that sent at least one
+};
+
+struct alert_replay_result {
+    uint64_t readings = 0;             // replayed (in range), all devices
+    uint64_t decoded = 0;              // ... of which had to be decoded
+    uint32_t devices = 0;              // with readings in range
+    std::vector<alert_tally> sets;     // one per rule set, in order
+};
+
+// Readings with from_ms <= unix_ms < to_ms. prune = false decodes every block (for checks and benchmarks).
+alert_replay_result replay_alerts(const ts_store &store, work_pool &pool, const std::vector<alert_rules_t> &sets,
+                                  int64_t from_ms, int64_t to_ms, bool prune = true);
+
+} // namespace collector
@@ -0,0 +1,109 @@
+/*
+ * Minimal HTTP/1.1 request head parser (implementation).
+ */
+
+#include "http_parse.h"
+#include <climits>
+#include <cstring>
+#include <strings.h>
+
+namespace collector {
+
+static bool name_is(std::string_view line, size_t colon, const char *name)
+{
+    return colon == strlen(name) && strncasecmp(line.data(), name, colon) == 0;
+}
+
+static std::string_view trim(std::string_view v)
+{
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    return v;
+}
+
+static bool equals_nocase(std::string_view v, const char *s)
+{
+    return v.size() == strlen(s) && strncasecmp(v.data(), s, v.size()) == 0;
+}
+
+long parse_http_head(const char *buf, size_t len, http_request &req)
+{
+    size_t scan = len < HTTP_HEAD_MAX ? len : HTTP_HEAD_MAX;
+    const char *end = static_cast<const char *>(memmem(buf, scan, "\r\n\r\n", 4));
+    if (!end) return len >= HTTP_HEAD_MAX ? -1 : 0;
+    size_t head_len = (size_t)(end - buf) + 4;
+
+    req = http_request{};
+    std::string_view head(buf, head_len - 2);   // every line ends in CRLF
+    size_t eol = head.find("\r\n");
+    std::string_view line = head.substr(0, eol);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1) return -1;
+    req.method = line.substr(0, sp1);
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = line.substr(sp2 + 1);
+    if (version.substr(0, 5) != "HTTP/" || target.empty() || target[0] != '/') return -1;
+    if (version == "HTTP/1.0") req.keep_alive = false;
+    size_t q = target.find('?');
+    req.path = target.substr(0, q);
+    if (q != std::string_view::npos) req.query = target.substr(q + 1);
+
+    for (size_t pos = eol + 2; pos < head.size();) {
+        size_t next = head.find("\r\n", pos);
+        line = head.substr(pos, next - pos);
+        pos = next + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return -1;
+        std::string_view value = trim(line.substr(colon + 1));
+        if (name_is(line, colon, "Content-Length")) {
+            size_t n = 0;
+            if (value.empty()) return -1;
+            for (char c : value) {
+                if (c < '0' || c > '9' || n > (SIZE_MAX - 9) / 10) return -1;
+                n = n * 10 + (size_t)(c - '0');
+            }
+            req.content_length = n;
+            req.has_length = true;
+        } else if (name_is(line, colon, "Transfer-Encoding")) {
+            req.chunked = !equals_nocase(value, "identity");
+        } else if (name_is(line, colon, "Connection")) {
+            if (equals_nocase(value, "close")) req.keep_alive = false;
+            else if (equals_nocase(value, "keep-alive")) req.keep_alive = true;
+        } else if (name_is(line, colon, "Content-Encoding")) {
+            req.encoded = !equals_nocase(value, "identity");
+        }
+    }
+    return (long)head_len;
+}
+
+long query_number(std::string_view query, std::string_view key)
+{
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view kv = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+        if (kv.size() <= key.size() || kv.substr(0, key.size()) != key || kv[key.size()] != '=') continue;
+        long n = 0;
+        for (char c : kv.substr(key.size() + 1)) {
+            if (c < '0' || c > '9' || n > (LONG_MAX - 9) / 10) return -1;
+            n = n * 10 + (c - '0');
+        }
+        return kv.size() > key.size() + 1 ? n : -1;
+    }
+    return -1;
+}
+
+std::string_view query_value(std::string_view query, std::string_view key)
+{
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view kv = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+        if (kv.size() > key.size() && kv.substr(0, key.size()) == key && kv[key.size()] == '=')
+            return kv.substr(key.size() + 1);
+    }
+    return {};
+}
+
+} // namespace collector
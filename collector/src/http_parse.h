@@ -0,0 +1,39 @@
+/*
+ * Minimal HTTP/1.1 request head parser (public API).
+ * - Enough for the firmware's uplink (esp_http_client POSTs) and the load
+ *   generator: request line, Content-Length, Connection, Content-Encoding.
+ *   No chunked bodies (411), no header continuation lines.
+ * - Views point into the caller's buffer; nothing is copied.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace collector {
+
+constexpr size_t HTTP_HEAD_MAX = 8192;
+
+struct http_request {
+    std::string_view method;
+    std::string_view path;            // without the query
+    std::string_view query;           // after '?', may be empty
+    size_t content_length = 0;
+    bool   has_length = false;
+    bool   chunked = false;
+    bool   keep_alive = true;         // HTTP/1.1 default; "Connection: close" or HTTP/1.0 clear it
+    bool   encoded = false;           // any Content-Encoding (gzip from the Influx profile)
+};
+
+// Parse the head at buf[0..len). Returns its length including the blank
+// line, 0 if more bytes are needed, -1 if malformed or over HTTP_HEAD_MAX.
+long parse_http_head(const char *buf, size_t len, http_request &req);
+
+// Value of key in a query string ("a=1&device=7"), as a number; -1 if absent or not a number.
+long query_number(std::string_view query, std::string_view key);
+
+// Raw value of key in a query string (not URL-decoded); empty if absent.
+std::string_view query_value(std::string_view query, std::string_view key);
+
+} // namespace collector
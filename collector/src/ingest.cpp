@@ -0,0 +1,731 @@
+/*
+ * Fleet ingest server (implementation).
+ * - Level-triggered epoll per worker; UDP is read with recvmmsg() in
+ *   batches of RECV_BATCH, TCP connections are read until EAGAIN or
+ *   INPUT_MAX buffered bytes and every complete request in the buffer is
+ *   answered (pipelining works; the rest is read on the next wakeup).
+ * - A POST is all-or-nothing: the whole batch goes into the ring or the
+ *   request gets 503, so a retried POST never half-duplicates.
+ * - A connection with OUTPUT_MAX unsent answer bytes is neither read nor
+ *   parsed until they drain, so a client that pipelines requests without
+ *   reading the answers holds at most INPUT_MAX + OUTPUT_MAX here.
+ * - While a connection waits for a query answer it is not read (pipelined
+ *   requests behind the query stay buffered, in order); the answer comes
+ *   back as a query_result on the worker's done list and the wake eventfd.
+ */
+
+#include "ingest.h"
+#include "alert_replay.h"
+#include "http_parse.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace collector {
+
+static constexpr int    RECV_BATCH = 64;
+static constexpr size_t BODY_MAX = 64 * 1024;    // a full 255-reading batch is 2311 bytes
+static constexpr size_t READ_CHUNK = 16 * 1024;
+static constexpr size_t INPUT_MAX = HTTP_HEAD_MAX + BODY_MAX;   // per connection: the largest valid request
+static constexpr size_t OUTPUT_MAX = INPUT_MAX;   // unsent answer bytes before a connection stops being read
+static constexpr int    MAX_EVENTS = 64;
+static constexpr size_t REPLAY_SETS = 8;          // rule sets per /fleet/alerts
+static constexpr long   REPLAY_SPAN_MS = 366L * 86400 * 1000;
+
+struct connection {
+    uint64_t    id = 0;
+    std::string in;
+    std::string out;
+    size_t      out_off = 0;
+    bool        close_after = false;  // close once out is flushed
+    bool        waiting = false;      // a query is with the query thread
+    bool        eof = false;          // peer sent FIN while waiting
+    uint32_t    events = EPOLLIN | EPOLLRDHUP;   // as registered with epoll
+
+    // The peer is not reading its answers: parse and read nothing more until they drain.
+    bool backed_up() const { return out.size() - out_off >= OUTPUT_MAX; }
+};
+
+struct query_result {
+    int         fd;
+    uint64_t    conn;
+    int         status;
+    std::string body;
+};
+
+struct ingest_server::worker {
+    ingest_server *srv;
+    int ep = -1, udp = -1, tcp = -1, wake = -1;
+    ingest_ring ring;
+    std::thread th;
+    std::atomic<bool> running{true};
+    std::unordered_map<int, connection> conns;
+    std::vector<reading_t> scratch;   // one POST's readings, decoded before any is queued
+    uint64_t next_conn = 0;
+    std::mutex done_mu;
+    std::vector<query_result> done;   // answers from the query thread, under done_mu
+
+    std::atomic<uint64_t> datagrams{0}, bad_datagrams{0}, http_requests{0}, http_errors{0}, http_busy{0},
+        connections{0}, readings_in{0}, ring_drops{0};
+
+    worker(ingest_server *s, size_t ring_items) : srv(s), ring(ring_items) {}
+    ~worker()
+    {
+        for (auto &c : conns) close(c.first);
+        for (int fd : { ep, udp, tcp, wake })
+            if (fd >= 0) close(fd);
+    }
+
+    void run();
+    void on_udp();
+    void on_accept();
+    void on_readable(int fd, connection &c);
+    void on_writable(int fd, connection &c);
+    void handle_requests(int fd, connection &c, bool eof);
+    int  ingest_batch(const http_request &req, const char *body, std::string &msg);
+    void finish_queries();
+    void respond(connection &c, int status, const char *reason, const std::string &body, const char *type);
+    void flush(int fd, connection &c);
+    void drop(int fd);
+    static void bump(std::atomic<uint64_t> &c, uint64_t n = 1) { c.fetch_add(n, std::memory_order_relaxed); }
+};
+
+static int open_socket(int type, const std::string &addr, uint16_t port, uint16_t *bound)
+{
+    int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof one);
+    if (type == SOCK_DGRAM) {
+        int rcvbuf = 4 << 20;                          // ride out a burst while the worker is busy
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    }
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if (inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1 ||
+        bind(fd, reinterpret_cast<sockaddr *>(&sa), sizeof sa) < 0 ||
+        (type == SOCK_STREAM && listen(fd, 1024) < 0)) {
+        close(fd);
+        return -1;
+    }
+    socklen_t len = sizeof sa;
+    getsockname(fd, reinterpret_cast<sockaddr *>(&sa), &len);
+    *bound = ntohs(sa.sin_port);
+    return fd;
+}
+
+static bool watch(int ep, int fd, uint32_t events)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+ingest_server::ingest_server(const ingest_config &cfg) : cfg_(cfg) {}
+
+ingest_server::~ingest_server() { stop(); }
+
+/**
+ * @brief Open the sockets and start the workers and the storage thread.
+ *
+ * The first worker binds the configured ports (0 = any); the others bind
+ * the same ports with SO_REUSEPORT.
+ *
+ * @return false if a socket or thread could not be set up (nothing left running).
+ */
+bool ingest_server::start()
+{
+    if (!cfg_.data_dir.empty()) {
+        store_ = std::make_unique<ts_store>(cfg_.data_dir);
+        if (!store_->open()) {
+            store_.reset();
+            return false;
+        }
+        pool_ = std::make_unique<work_pool>(cfg_.query_threads);
+        queries_ = std::make_unique<query_engine>(*store_, *pool_);
+    }
+    int n = cfg_.workers > 0 ? cfg_.workers : (int)std::thread::hardware_concurrency();
+    if (n < 1) n = 1;
+    uint16_t http = cfg_.http_port, udp = cfg_.udp_port;
+    for (int i = 0; i < n; i++) {
+        auto w = std::make_unique<worker>(this, cfg_.ring_items);
+        w->ep = epoll_create1(EPOLL_CLOEXEC);
+        w->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        w->tcp = open_socket(SOCK_STREAM, cfg_.bind_addr, http, &http);
+        w->udp = open_socket(SOCK_DGRAM, cfg_.bind_addr, udp, &udp);
+        if (w->ep < 0 || w->wake < 0 || w->tcp < 0 || w->udp < 0 || !watch(w->ep, w->wake, EPOLLIN) ||
+            !watch(w->ep, w->tcp, EPOLLIN) || !watch(w->ep, w->udp, EPOLLIN)) {
+            fprintf(stderr, "collector: worker %d setup failed on %s (http %u, udp %u): %s\n", i,
+                    cfg_.bind_addr.c_str(), http, udp, strerror(errno));
+            workers_.clear();
+            queries_.reset();
+            pool_.reset();
+            store_.reset();
+            return false;
+        }
+        workers_.push_back(std::move(w));
+    }
+    http_port_ = http;
+    udp_port_ = udp;
+
+    std::vector<ingest_ring *> rings;
+    for (auto &w : workers_) rings.push_back(&w->ring);
+    sink_ = std::make_unique<sink>(std::move(rings), workers_[0]->udp, store_.get());   // acks leave from the shared port
+    sink_running_ = true;
+    sink_thread_ = std::thread([this] { sink_->run(sink_running_); });
+    if (queries_) query_thread_ = std::thread([this] { query_loop(); });
+    for (auto &w : workers_) w->th = std::thread([p = w.get()] { p->run(); });
+    return true;
+}
+
+void ingest_server::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(query_mu_);
+        query_stop_ = true;
+    }
+    query_cv_.notify_all();
+    if (query_thread_.joinable()) query_thread_.join();   // finishes the running query; the queued ones are dropped
+    for (auto &w : workers_) {
+        w->running = false;
+        uint64_t one = 1;
+        ssize_t r = write(w->wake, &one, sizeof one);   // wakes epoll_wait; cannot fail short of a full counter
+        (void)r;
+    }
+    for (auto &w : workers_)
+        if (w->th.joinable()) w->th.join();
+    sink_running_ = false;
+    if (sink_thread_.joinable()) sink_thread_.join();
+    if (store_) store_->seal_all();                   // the heads would be lost otherwise
+    workers_.clear();
+}
+
+ingest_stats ingest_server::stats() const
+{
+    ingest_stats s{};
+    for (auto &w : workers_) {
+        s.datagrams += w->datagrams.load(std::memory_order_relaxed);
+        s.bad_datagrams += w->bad_datagrams.load(std::memory_order_relaxed);
+        s.http_requests += w->http_requests.load(std::memory_order_relaxed);
+        s.http_errors += w->http_errors.load(std::memory_order_relaxed);
+        s.http_busy += w->http_busy.load(std::memory_order_relaxed);
+        s.connections += w->connections.load(std::memory_order_relaxed);
+        s.readings_in += w->readings_in.load(std::memory_order_relaxed);
+        s.ring_drops += w->ring_drops.load(std::memory_order_relaxed);
+    }
+    if (sink_) s.sink = sink_->stats();
+    if (store_) s.store = store_->stats();
+    return s;
+}
+
+std::string ingest_server::stats_json() const
+{
+    ingest_stats s = stats();
+    char buf[640];
+    snprintf(buf, sizeof buf,
+             "{\"workers\":%d,\"datagrams\":%llu,\"bad_datagrams\":%llu,\"http_requests\":%llu,"
+             "\"http_errors\":%llu,\"http_busy\":%llu,\"connections\":%llu,\"readings_in\":%llu,"
+             "\"ring_drops\":%llu,\"stored\":%llu,\"duplicates\":%llu,\"lost\":%llu,\"acks\":%llu,"
+             "\"devices\":%llu,\"store_rows\":%llu,\"store_blocks\":%llu,\"store_bytes\":%llu}",
+             workers(), (unsigned long long)s.datagrams, (unsigned long long)s.bad_datagrams,
+             (unsigned long long)s.http_requests, (unsigned long long)s.http_errors,
+             (unsigned long long)s.http_busy, (unsigned long long)s.connections,
+             (unsigned long long)s.readings_in, (unsigned long long)s.ring_drops,
+             (unsigned long long)s.sink.stored, (unsigned long long)s.sink.duplicates,
+             (unsigned long long)s.sink.lost, (unsigned long long)s.sink.acks, (unsigned long long)s.sink.devices,
+             (unsigned long long)s.store.rows, (unsigned long long)s.store.blocks, (unsigned long long)s.store.bytes);
+    return buf;
+}
+
+void ingest_server::worker::run()
+{
+    epoll_event events[MAX_EVENTS];
+    while (running.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, 1000);
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == udp) on_udp();
+            else if (fd == tcp) on_accept();
+            else if (fd == wake) finish_queries();
+            else {
+                auto it = conns.find(fd);
+                if (it == conns.end()) continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) drop(fd);
+                else if (events[i].events & EPOLLOUT) on_writable(fd, it->second);
+                else on_readable(fd, it->second);
+            }
+        }
+    }
+}
+
+void ingest_server::worker::on_udp()
+{
+    uint8_t bufs[RECV_BATCH][64];
+    sockaddr_in peers[RECV_BATCH];
+    iovec iov[RECV_BATCH];
+    mmsghdr msgs[RECV_BATCH];
+    for (int i = 0; i < RECV_BATCH; i++) {
+        iov[i] = { bufs[i], sizeof bufs[i] };
+        msgs[i].msg_hdr = msghdr{};
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &peers[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof peers[i];
+    }
+    int n = recvmmsg(udp, msgs, RECV_BATCH, MSG_DONTWAIT, nullptr);
+    if (n <= 0) return;
+    bump(datagrams, (uint64_t)n);
+    uint64_t in = 0;
+    for (int i = 0; i < n; i++) {
+        udp_reading u;
+        if (!decode_udp_reading(bufs[i], msgs[i].msg_len, u)) {
+            bump(bad_datagrams);
+            continue;
+        }
+        ingest_item it{ u.r, u.device, u.epoch, u.depth, u.type == UDPT_RESENT ? SRC_UDP_RESENT : SRC_UDP, peers[i] };
+        if (ring.push(it)) in++;
+        else bump(ring_drops);
+    }
+    bump(readings_in, in);
+}
+
+void ingest_server::worker::on_accept()
+{
+    for (;;) {
+        int fd = accept4(tcp, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        if (!watch(ep, fd, EPOLLIN | EPOLLRDHUP)) {
+            close(fd);
+            continue;
+        }
+        conns[fd].id = ++next_conn;
+        bump(connections);
+    }
+}
+
+void ingest_server::worker::drop(int fd)
+{
+    epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    conns.erase(fd);
+}
+
+void ingest_server::worker::on_readable(int fd, connection &c)
+{
+    bool eof = false;
+    while (c.in.size() < INPUT_MAX) {                   // level-triggered: the rest waits in the socket
+        size_t old = c.in.size(), want = std::min(READ_CHUNK, INPUT_MAX - old);
+        c.in.resize(old + want);
+        ssize_t r = recv(fd, &c.in[old], want, 0);
+        c.in.resize(old + (r > 0 ? (size_t)r : 0));
+        if (r > 0) continue;
+        if (r == 0) eof = true;                         // answer what came before the FIN, then close
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            drop(fd);
+            return;
+        }
+        break;
+    }
+    handle_requests(fd, c, eof);
+}
+
+void ingest_server::worker::on_writable(int fd, connection &c)
+{
+    bool held = c.backed_up();
+    flush(fd, c);                                       // may close and forget c
+    auto it = conns.find(fd);
+    if (held && it != conns.end() && !it->second.backed_up()) handle_requests(fd, it->second, false);   // resume
+}
+
+void ingest_server::worker::respond(connection &c, int status, const char *reason, const std::string &body,
+                                    const char *type)
+{
+    char head[192];
+    int n = snprintf(head, sizeof head, "HTTP/1.1 %d %s\r\nContent-Length: %zu\r\n%s%s%s%s\r\n", status, reason,
+                     body.size(), type ? "Content-Type: " : "", type ? type : "", type ? "\r\n" : "",
+                     c.close_after ? "Connection: close\r\n" : "");
+    c.out.append(head, (size_t)n);
+    c.out += body;
+    if (status >= 400) bump(http_errors);
+}
+
+void ingest_server::worker::handle_requests(int fd, connection &c, bool eof)
+{
+    size_t pos = 0;
+    while (!c.close_after && !c.waiting && !c.backed_up()) {
+        http_request req;
+        long head = parse_http_head(c.in.data() + pos, c.in.size() - pos, req);
+        if (head == 0) break;
+        if (head < 0 || req.chunked || (req.method == "POST" && !req.has_length) || req.content_length > BODY_MAX) {
+            c.close_after = true;
+            if (head < 0) respond(c, 400, "Bad Request", "malformed request\n", "text/plain");
+            else if (req.content_length > BODY_MAX) respond(c, 413, "Payload Too Large", "", nullptr);
+            else respond(c, 411, "Length Required", "", nullptr);
+            break;
+        }
+        if (c.in.size() - pos < (size_t)head + req.content_length) break;   // body not complete yet
+        const char *body = c.in.data() + pos + head;
+        pos += (size_t)head + req.content_length;
+        bump(http_requests);
+        c.close_after = !req.keep_alive;
+
+        if (req.path == "/ingest") {
+            std::string msg;
+            int status = req.method == "POST" ? ingest_batch(req, body, msg) : 405;
+            switch (status) {
+            case 204: respond(c, 204, "No Content", "", nullptr); break;
+            case 405: respond(c, 405, "Method Not Allowed", "", nullptr); break;
+            case 415: respond(c, 415, "Unsupported Media Type", msg, "text/plain"); break;
+            case 503: respond(c, 503, "Service Unavailable", msg, "text/plain"); break;
+            default:  respond(c, 400, "Bad Request", msg, "text/plain"); break;
+            }
+        } else if (req.path == "/stats" && req.method == "GET") {
+            respond(c, 200, "OK", srv->stats_json() + "\n", "application/json");
+        } else if ((req.path == "/query" || req.path.substr(0, 7) == "/fleet/") && req.method == "GET") {
+            if (!srv->queries()) {
+                respond(c, 404, "Not Found", "no store (start with --data DIR)\n", "text/plain");
+            } else if (srv->submit_query({ this, fd, c.id, std::string(req.path), std::string(req.query) })) {
+                c.waiting = true;
+            } else {
+                bump(http_busy);
+                respond(c, 503, "Service Unavailable", "query queue full, retry\n", "text/plain");
+            }
+        } else {
+            respond(c, 404, "Not Found", "", nullptr);
+        }
+    }
+    c.in.erase(0, pos);
+    if (!c.close_after && !c.waiting && !c.backed_up() && c.in.size() >= INPUT_MAX) {
+        c.close_after = true;                           // no request can be this long: stop reading
+        respond(c, 413, "Payload Too Large", "", nullptr);
+    }
+    if (eof) c.eof = true;
+    if (c.eof && !c.waiting && !c.backed_up()) c.close_after = true;   // backed up: the rest is answered first
+    flush(fd, c);                                       // may close and forget c
+}
+
+// Answers posted by the query thread. A connection dropped (or an fd
+// reused) meanwhile just loses its answer.
+void ingest_server::worker::finish_queries()
+{
+    uint64_t n;
+    ssize_t r = read(wake, &n, sizeof n);               // clears the eventfd; EAGAIN if already read
+    (void)r;
+    std::vector<query_result> ready;
+    {
+        std::lock_guard<std::mutex> lock(done_mu);
+        ready.swap(done);
+    }
+    for (query_result &q : ready) {
+        auto it = conns.find(q.fd);
+        if (it == conns.end() || it->second.id != q.conn) continue;
+        connection &c = it->second;
+        c.waiting = false;
+        if (q.status == 200) respond(c, 200, "OK", q.body, "application/json");
+        else if (q.status == 404) respond(c, 404, "Not Found", q.body, "text/plain");
+        else respond(c, 400, "Bad Request", q.body, "text/plain");
+        handle_requests(q.fd, c, false);                // the requests pipelined behind it; may forget c
+    }
+}
+
+// One uplink POST: the firmware's reading batches, back to back, for
+// ?device=N. Returns the HTTP status.
+int ingest_server::worker::ingest_batch(const http_request &req, const char *body, std::string &msg)
+{
+    long device = query_number(req.query, "device");
+    if (device < 0 || device > 0xFFFF) {
+        msg = "device=<0..65535> required\n";
+        return 400;
+    }
+    if (req.encoded) {
+        msg = "binary reading batches only (no Content-Encoding)\n";
+        return 415;
+    }
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(body);
+    size_t left = req.content_length;
+    scratch.clear();
+    while (left) {
+        size_t len = left >= READING_BATCH_HEADER_LEN ? reading_batch_size(p[3]) : left;
+        size_t at = scratch.size();
+        scratch.resize(at + READING_BATCH_MAX);
+        int n = len <= left ? reading_batch_decode(p, len, &scratch[at], READING_BATCH_MAX) : -1;
+        if (n < 0) {
+            msg = "malformed reading batch\n";
+            return 400;
+        }
+        scratch.resize(at + (size_t)n);
+        p += len;
+        left -= len;
+    }
+    if (!ring.has_room(scratch.size())) {
+        bump(http_busy);
+        msg = "busy, retry\n";
+        return 503;
+    }
+    for (const reading_t &r : scratch) ring.push(ingest_item{ r, (uint16_t)device, 0, 0, SRC_HTTP, {} });
+    bump(readings_in, scratch.size());
+    return 204;
+}
+
+static const struct channel_name { const char *name; ts_channel ch; } CHANNELS[] = {
+    { "t", TS_T }, { "h", TS_H }, { "p", TS_P },
+};
+
+static const channel_name *find_channel(std::string_view name)
+{
+    for (const channel_name &c : CHANNELS)
+        if (name == c.name) return &c;
+    return nullptr;
+}
+
+// Optional ms bound: def if absent, -1 if not a number.
+static long query_ms(std::string_view query, std::string_view key, long def)
+{
+    return query_value(query, key).empty() ? def : query_number(query, key);
+}
+
+// GET /query?device=N&channel=t|h|p[&from=MS][&to=MS]: aggregate over
+// [from, to) in °C, %RH or Pa. Returns the HTTP status.
+int ingest_server::device_query(const http_request &req, std::string &body)
+{
+    long device = query_number(req.query, "device");
+    const channel_name *chan = find_channel(query_value(req.query, "channel"));
+    long from = query_ms(req.query, "from", 0), to = query_ms(req.query, "to", LONG_MAX);
+    if (device < 0 || device > 0xFFFF || !chan || from < 0 || to < 0) {
+        body = "device=<0..65535>&channel=t|h|p[&from=<unix ms>][&to=<unix ms>]\n";
+        return 400;
+    }
+    ts_agg a = store_->aggregate((uint16_t)device, chan->ch, from, to);
+    double scale = ts_scale(chan->ch);
+    char buf[256];
+    if (a.count)
+        snprintf(buf, sizeof buf,
+                 "{\"device\":%ld,\"channel\":\"%s\",\"count\":%llu,\"min\":%.2f,\"max\":%.2f,\"mean\":%.3f}\n",
+                 device, chan->name, (unsigned long long)a.count, a.min * scale, a.max * scale,
+                 a.mean() * scale);
+    else
+        snprintf(buf, sizeof buf, "{\"device\":%ld,\"channel\":\"%s\",\"count\":0}\n", device, chan->name);
+    body = buf;
+    return 200;
+}
+
+// GET /fleet/aggregate?channel=t|h|p[&from=MS][&to=MS]: per device and
+// fleet min/max/mean.
+// GET /fleet/alerts?rules=SPEC[;SPEC...][&from=MS][&to=MS]: SMS each alert
+// rule set (alert_replay.h) would have sent, over at most a year (the year
+// before to, which defaults to now).
+// GET /fleet/threshold?channel=t|h|p&above=X|below=X[&for_s=S][&max_gap_s=S][&from=MS][&to=MS]:
+// devices that stayed beyond X for at least S seconds.
+// Returns the HTTP status.
+int ingest_server::fleet_query(const http_request &req, std::string &body)
+{
+    const channel_name *chan = find_channel(query_value(req.query, "channel"));
+    long from = query_ms(req.query, "from", 0), to = query_ms(req.query, "to", LONG_MAX);
+    char buf[256];
+    if (req.path == "/fleet/aggregate") {
+        if (!chan || from < 0 || to < 0) {
+            body = "channel=t|h|p[&from=<unix ms>][&to=<unix ms>]\n";
+            return 400;
+        }
+        fleet_agg a = queries_->aggregate(chan->ch, from, to);
+        snprintf(buf, sizeof buf, "{\"channel\":\"%s\",\"devices\":%zu,\"count\":%llu", chan->name,
+                 a.devices.size(), (unsigned long long)a.total.count);
+        body = buf;
+        if (a.total.count) {
+            snprintf(buf, sizeof buf, ",\"min\":%.2f,\"max\":%.2f,\"mean\":%.3f", a.total.min, a.total.max,
+                     a.total.mean());
+            body += buf;
+        }
+        body += ",\"per_device\":[";
+        for (size_t i = 0; i < a.devices.size(); i++) {
+            const fleet_agg_row &r = a.devices[i];
+            snprintf(buf, sizeof buf, "%s{\"device\":%u,\"count\":%llu,\"min\":%.2f,\"max\":%.2f,\"mean\":%.3f}",
+                     i ? "," : "", r.device, (unsigned long long)r.count, r.min, r.max, r.mean());
+            body += buf;
+        }
+        body += "]}\n";
+        return 200;
+    }
+    if (req.path == "/fleet/alerts") {
+        to = query_ms(req.query, "to", (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::system_clock::now().time_since_epoch()).count());
+        from = query_ms(req.query, "from", std::max(0L, to - REPLAY_SPAN_MS));
+        return alert_replay(req, from, to, body);
+    }
+    if (req.path != "/fleet/threshold") {
+        body = "/fleet/aggregate, /fleet/threshold or /fleet/alerts\n";
+        return 404;
+    }
+    threshold_query q;
+    std::string above(query_value(req.query, "above")), below(query_value(req.query, "below"));
+    std::string for_s(query_value(req.query, "for_s")), gap_s(query_value(req.query, "max_gap_s"));
+    char *end = nullptr;
+    bool ok = chan && from >= 0 && to >= 0 && above.empty() != below.empty();
+    if (ok) {
+        q.ch = chan->ch;
+        q.above = !above.empty();
+        q.threshold = strtof(q.above ? above.c_str() : below.c_str(), &end);
+        ok = *end == '\0';
+    }
+    if (ok && !for_s.empty()) {
+        q.min_duration_ms = (int64_t)(strtod(for_s.c_str(), &end) * 1000);
+        ok = *end == '\0' && q.min_duration_ms >= 0;
+    }
+    if (ok && !gap_s.empty()) {
+        q.max_gap_ms = (int64_t)(strtod(gap_s.c_str(), &end) * 1000);
+        ok = *end == '\0' && q.max_gap_ms > 0;
+    }
+    if (!ok) {
+        body = "channel=t|h|p&(above|below)=<value>[&for_s=<s>][&max_gap_s=<s>][&from=<unix ms>][&to=<unix ms>]\n";
+        return 400;
+    }
+    q.from_ms = from;
+    q.to_ms = to;
+    std::vector<threshold_hit> hits = queries_->threshold(q);
+    snprintf(buf, sizeof buf, "{\"channel\":\"%s\",\"%s\":%.2f,\"for_s\":%.0f,\"devices\":%zu,\"hits\":[",
+             chan->name, q.above ? "above" : "below", q.threshold, q.min_duration_ms / 1000.0, hits.size());
+    body = buf;
+    for (size_t i = 0; i < hits.size(); i++) {
+        const threshold_hit &h = hits[i];
+        snprintf(buf, sizeof buf,
+                 "%s{\"device\":%u,\"episodes\":%u,\"first_start_ms\":%lld,\"longest_s\":%.0f,\"total_s\":%.0f}",
+                 i ? "," : "", h.device, h.episodes, (long long)h.first_start_ms, h.longest_ms / 1000.0,
+                 h.total_ms / 1000.0);
+        body += buf;
+    }
+    body += "]}\n";
+    return 200;
+}
+
+int ingest_server::alert_replay(const http_request &req, long from, long to, std::string &body)
+{
+    std::vector<alert_rules_t> sets;
+    std::string_view specs = query_value(req.query, "rules");
+    bool ok = !specs.empty() && from >= 0 && to >= 0 && to - from <= REPLAY_SPAN_MS;
+    while (ok && !specs.empty()) {
+        size_t semi = std::min(specs.find(';'), specs.size());
+        alert_rules_t r;
+        ok = sets.size() < REPLAY_SETS && parse_alert_rules(specs.substr(0, semi), r);
+        sets.push_back(r);
+        specs.remove_prefix(std::min(semi + 1, specs.size()));
+    }
+    if (!ok) {
+        body = "rules=device|<alert_low>,<warn_low>,<warn_high>,<alert_high>,<warn_cooldown_min>,<alert_cooldown_min>"
+               "[;...] (at most 8)[&from=<unix ms>][&to=<unix ms>] (at most 366 days apart)\n";
+        return 400;
+    }
+    alert_replay_result res = replay_alerts(*store_, *pool_, sets, from, to);
+    char buf[256];
+    snprintf(buf, sizeof buf, "{\"devices\":%u,\"readings\":%llu,\"rule_sets\":[", res.devices,
+             (unsigned long long)res.readings);
+    body = buf;
+    for (size_t k = 0; k < sets.size(); k++) {
+        const alert_tally &t = res.sets[k];
+        snprintf(buf, sizeof buf,
+                 "%s{\"rules\":\"%s\",\"sms\":%llu,\"devices\":%u,\"cold_warnings\":%llu,\"cold_alerts\":%llu,"
+                 "\"hot_warnings\":%llu,\"hot_alerts\":%llu}",
+                 k ? "," : "", format_alert_rules(sets[k]).c_str(), (unsigned long long)t.sms, t.devices,
+                 (unsigned long long)t.kinds[ALERT_COLD_WARNING], (unsigned long long)t.kinds[ALERT_COLD_ALERT],
+                 (unsigned long long)t.kinds[ALERT_HOT_WARNING], (unsigned long long)t.kinds[ALERT_HOT_ALERT]);
+        body += buf;
+    }
+    body += "]}\n";
+    return 200;
+}
+
+bool ingest_server::submit_query(query_job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(query_mu_);
+        if (query_jobs_.size() >= QUERY_QUEUE) return false;
+        query_jobs_.push_back(std::move(job));
+    }
+    query_cv_.notify_one();
+    return true;
+}
+
+int ingest_server::run_query(const query_job &job, std::string &body)
+{
+    http_request req;
+    req.method = "GET";
+    req.path = job.path;
+    req.query = job.query;
+    return req.path == "/query" ? device_query(req, body) : fleet_query(req, body);
+}
+
+void ingest_server::query_loop()
+{
+    for (;;) {
+        query_job job;
+        {
+            std::unique_lock<std::mutex> lock(query_mu_);
+            query_cv_.wait(lock, [this] { return query_stop_ || !query_jobs_.empty(); });
+            if (query_stop_) return;
+            job = std::move(query_jobs_.front());
+            query_jobs_.pop_front();
+        }
+        query_result res{ job.fd, job.conn, 0, {} };
+        res.status = run_query(job, res.body);
+        {
+            std::lock_guard<std::mutex> lock(job.w->done_mu);
+            job.w->done.push_back(std::move(res));
+        }
+        uint64_t one = 1;
+        ssize_t r = write(job.w->wake, &one, sizeof one);
+        (void)r;
+    }
+}
+
+void ingest_server::worker::flush(int fd, connection &c)
+{
+    while (c.out_off < c.out.size()) {
+        ssize_t w = send(fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+        if (w > 0) {
+            c.out_off += (size_t)w;
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        drop(fd);
+        return;
+    }
+    bool pending = c.out_off < c.out.size();
+    if (!pending) {
+        c.out.clear();
+        c.out_off = 0;
+        if (c.close_after && !c.waiting) {
+            drop(fd);
+            return;
+        }
+    }
+    // a closing, waiting or backed-up connection only waits for EPOLLOUT, if
+    // that (a level-triggered RDHUP would otherwise spin)
+    uint32_t want = c.waiting || c.close_after || c.backed_up() ? (pending ? (uint32_t)EPOLLOUT : 0u)
+                    : pending                  ? EPOLLIN | EPOLLRDHUP | EPOLLOUT
+                                               : EPOLLIN | EPOLLRDHUP;
+    if (want != c.events) {
+        epoll_event ev{};
+        ev.events = want;
+        ev.data.fd = fd;
+        epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+        c.events = want;
+    }
+}
+
+} // namespace collector
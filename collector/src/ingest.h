@@ -0,0 +1,119 @@
+/*
+ * Fleet ingest server (public API).
+ * - Accepts readings pushed by the units in their native formats:
+ *   UDP telemetry datagrams (udp_telemetry.h) and HTTP uplink batches
+ *   (reading_codec.h batches back to back, POST /ingest?device=N, the device's
+ *   CONFIG_APP_UPLINK_URL).
+ * - One worker thread per core. Each has its own epoll instance, its own
+ *   SO_REUSEPORT UDP and TCP sockets on the shared ports (the kernel
+ *   spreads datagrams and connections across them) and does its own
+ *   parsing, so workers share nothing on the hot path.
+ * - Decoded readings go to the storage thread (sink.h) through one
+ *   lock-free SPSC ring per worker. A full ring drops UDP readings (the
+ *   device resends what the next ack lists) and answers 503 to a POST
+ *   (the device retries with backoff).
+ * - GET /stats returns the counters as JSON; GET /query answers
+ *   min/max/mean of one channel of one device over a time range from the
+ *   store; GET /fleet/aggregate and /fleet/threshold run fleet-wide
+ *   queries (query.h) and GET /fleet/alerts replays the history through
+ *   alert rule sets (alert_replay.h), on a shared work_pool.
+ * - Queries run on a query thread, not on the worker that received them:
+ *   the worker hands the request over (503 when QUERY_QUEUE are already
+ *   waiting), stops reading that connection and goes on draining its
+ *   sockets; the query thread posts the answer back through the worker's
+ *   eventfd. Queries are answered one at a time, each on the whole pool.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "query.h"
+#include "sink.h"
+
+namespace collector {
+
+struct http_request;
+
+struct ingest_config {
+    std::string bind_addr = "0.0.0.0";
+    uint16_t    http_port = 8090;     // 0 = any free port
+    uint16_t    udp_port = 8091;      // 0 = any free port
+    int         workers = 0;          // 0 = one per core
+    size_t      ring_items = 1 << 16; // per worker
+    std::string data_dir;             // time-series store (ts_store.h); empty = keep nothing
+    int         query_threads = 0;    // fleet query pool, counting the query thread; 0 = one per core
+};
+
+struct ingest_stats {
+    uint64_t datagrams;               // UDP datagrams received
+    uint64_t bad_datagrams;           // not a reading datagram
+    uint64_t http_requests;
+    uint64_t http_errors;             // answered 4xx/5xx
+    uint64_t http_busy;               // ... of which 503 for a full ring or query queue
+    uint64_t connections;             // accepted
+    uint64_t readings_in;             // decoded and handed to the sink
+    uint64_t ring_drops;              // UDP readings dropped on a full ring
+    sink_stats sink;
+    ts_store_stats store;             // zero without a store
+};
+
+class ingest_server {
+public:
+    explicit ingest_server(const ingest_config &cfg);
+    ~ingest_server();
+
+    bool start();                     // false (with a message on stderr) if a socket cannot be set up
+    void stop();                      // joins every thread; the sink drains the rings first
+
+    uint16_t     http_port() const { return http_port_; }
+    uint16_t     udp_port() const { return udp_port_; }
+    int          workers() const { return (int)workers_.size(); }
+    ingest_stats stats() const;
+    std::string  stats_json() const;
+    const ts_store *store() const { return store_.get(); }
+    const query_engine *queries() const { return queries_.get(); }   // null without a store
+
+    struct worker;
+
+private:
+    static constexpr size_t QUERY_QUEUE = 64;
+
+    // A /query or /fleet/ request handed from a worker to the query thread.
+    struct query_job {
+        worker     *w;
+        int         fd;
+        uint64_t    conn;             // connection id: the fd may be reused by the time the answer is ready
+        std::string path, query;
+    };
+
+    bool submit_query(query_job job); // false: queue full
+    void query_loop();
+    int  run_query(const query_job &job, std::string &body);
+    int  device_query(const http_request &req, std::string &body);
+    int  fleet_query(const http_request &req, std::string &body);
+    int  alert_replay(const http_request &req, long from, long to, std::string &body);
+
+    ingest_config cfg_;
+    uint16_t http_port_ = 0, udp_port_ = 0;
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::unique_ptr<ts_store> store_;
+    std::unique_ptr<work_pool> pool_;
+    std::unique_ptr<query_engine> queries_;
+    std::unique_ptr<sink> sink_;
+    std::thread sink_thread_;
+    std::atomic<bool> sink_running_{false};
+    std::thread query_thread_;
+    std::mutex query_mu_;
+    std::condition_variable query_cv_;
+    std::deque<query_job> query_jobs_;   // under query_mu_
+    bool query_stop_ = false;            // under query_mu_
+};
+
+} // namespace collector
@@ -0,0 +1,139 @@
+/*
+ * Column kernels for fleet queries (implementation).
+ * - The vector loops handle whole groups of 8; the tail goes through the
+ *   scalar code. Sums accumulate per lane in double: a float lane would
+ *   pass 2^24 after ~170 pressure readings (about 1e5 Pa each) and start
+ *   dropping low bits, so each group of 8 is widened before it is added.
+ */
+
+#include "kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KERNEL_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define KERNEL_CLONES
+#endif
+
+namespace collector {
+
+typedef float   v8f __attribute__((vector_size(32)));
+typedef int32_t v8i __attribute__((vector_size(32)));
+typedef float   v4f __attribute__((vector_size(16)));
+typedef double  v4d __attribute__((vector_size(32)));
+
+// Vector values never cross a function boundary here (that would tie the
+// ABI to -mavx); loads are memcpy, which compiles to one unaligned load.
+#define LOAD8(v, p) memcpy(&(v), (p), sizeof(v))
+
+#if defined(__clang__)
+#define SHUFFLE8(v, a, b, c, d, e, f, g, h) __builtin_shufflevector(v, v, a, b, c, d, e, f, g, h)
+#else
+#define SHUFFLE8(v, a, b, c, d, e, f, g, h) __builtin_shuffle(v, (v8i){ a, b, c, d, e, f, g, h })
+#endif
+
+k_minmax k_minmaxsum_scalar(const float *v, size_t n)
+{
+    k_minmax r{ v[0], v[0], 0.0 };
+    for (size_t i = 0; i < n; i++) {
+        if (v[i] < r.min) r.min = v[i];
+        if (v[i] > r.max) r.max = v[i];
+        r.sum += v[i];
+    }
+    return r;
+}
+
+void k_mask_above_scalar(const float *v, size_t n, float thr, uint64_t *bits)
+{
+    memset(bits, 0, (n + 63) / 64 * sizeof *bits);
+    for (size_t i = 0; i < n; i++)
+        if (v[i] > thr) bits[i / 64] |= 1ull << (i % 64);
+}
+
+void k_mask_below_scalar(const float *v, size_t n, float thr, uint64_t *bits)
+{
+    memset(bits, 0, (n + 63) / 64 * sizeof *bits);
+    for (size_t i = 0; i < n; i++)
+        if (v[i] < thr) bits[i / 64] |= 1ull << (i % 64);
+}
+
+KERNEL_CLONES
+void k_to_float(const int32_t *in, size_t n, float scale, float *out)
+{
+    for (size_t i = 0; i < n; i++) out[i] = (float)in[i] * scale;   // auto-vectorises (cvtdq2ps)
+}
+
+KERNEL_CLONES
+k_minmax k_minmaxsum(const float *v, size_t n)
+{
+    size_t i = 0;
+    k_minmax r{ v[0], v[0], 0.0 };
+    if (n >= 8) {
+        v8f mn, mx;
+        v4d sum_lo = {}, sum_hi = {};
+        LOAD8(mn, v);
+        mx = mn;
+        for (; i + 8 <= n; i += 8) {
+            v8f x;
+            v4f lo, hi;
+            LOAD8(x, v + i);
+            memcpy(&lo, v + i, sizeof lo);
+            memcpy(&hi, v + i + 4, sizeof hi);
+            mn = x < mn ? x : mn;
+            mx = x > mx ? x : mx;
+            sum_lo += __builtin_convertvector(lo, v4d);                  // cvtps2pd
+            sum_hi += __builtin_convertvector(hi, v4d);
+        }
+        for (int k = 0; k < 8; k++) {
+            if (mn[k] < r.min) r.min = mn[k];
+            if (mx[k] > r.max) r.max = mx[k];
+        }
+        for (int k = 0; k < 4; k++) r.sum += sum_lo[k] + sum_hi[k];
+    }
+    for (; i < n; i++) {
+        if (v[i] < r.min) r.min = v[i];
+        if (v[i] > r.max) r.max = v[i];
+        r.sum += v[i];
+    }
+    return r;
+}
+
+template <bool ABOVE>
+static inline void mask_cmp(const float *v, size_t n, float thr, uint64_t *bits)
+{
+    memset(bits, 0, (n + 63) / 64 * sizeof *bits);
+    const v8i weight = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    v8f t = thr - (v8f){};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        v8f x;
+        LOAD8(x, v + i);
+        v8i w = (ABOVE ? (v8i)(x > t) : (v8i)(x < t)) & weight;       // lanes are 0 or -1
+        w |= SHUFFLE8(w, 4, 5, 6, 7, 0, 1, 2, 3);                    // OR-reduce in three steps
+        w |= SHUFFLE8(w, 2, 3, 0, 1, 6, 7, 4, 5);
+        w |= SHUFFLE8(w, 1, 0, 3, 2, 5, 4, 7, 6);
+        uint32_t m = (uint32_t)w[0];
+        bits[i / 64] |= (uint64_t)m << (i % 64);                      // i % 8 == 0: never straddles a word
+    }
+    for (; i < n; i++)
+        if (ABOVE ? v[i] > thr : v[i] < thr) bits[i / 64] |= 1ull << (i % 64);
+}
+
+KERNEL_CLONES
+void k_mask_above(const float *v, size_t n, float thr, uint64_t *bits) { mask_cmp<true>(v, n, thr, bits); }
+
+KERNEL_CLONES
+void k_mask_below(const float *v, size_t n, float thr, uint64_t *bits) { mask_cmp<false>(v, n, thr, bits); }
+
+KERNEL_CLONES
+int64_t k_max_step(const int64_t *t, size_t n)
+{
+    int64_t m = 0;
+    for (size_t i = 1; i < n; i++) {
+        int64_t d = t[i] - t[i - 1];
+        m = d > m ? d : m;
+    }
+    return m;
+}
+
+} // namespace collector
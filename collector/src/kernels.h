@@ -0,0 +1,34 @@
+/*
+ * Column kernels for fleet queries (public API).
+ * - Work on one decoded block column at a time (at most TS_BLOCK_ROWS
+ *   values, in physical units as float).
+ * - Written with GCC/Clang vector extensions, 8 floats per step; on
+ *   x86-64 each kernel is also cloned for AVX2 and picked at load time,
+ *   so the build needs no -march flag. The *_scalar versions are the
+ *   plain-loop references the checks and benchmarks compare against.
+ * - Masks are bitmaps, bit i of word i / 64 for value i; bits past n are 0.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace collector {
+
+struct k_minmax {
+    float  min;
+    float  max;
+    double sum;
+};
+
+void     k_to_float(const int32_t *in, size_t n, float scale, float *out);
+k_minmax k_minmaxsum(const float *v, size_t n);                     // n >= 1
+void     k_mask_above(const float *v, size_t n, float thr, uint64_t *bits);   // v > thr
+void     k_mask_below(const float *v, size_t n, float thr, uint64_t *bits);   // v < thr
+int64_t  k_max_step(const int64_t *t, size_t n);                    // largest t[i] - t[i-1]; 0 if n < 2
+
+k_minmax k_minmaxsum_scalar(const float *v, size_t n);
+void     k_mask_above_scalar(const float *v, size_t n, float thr, uint64_t *bits);
+void     k_mask_below_scalar(const float *v, size_t n, float thr, uint64_t *bits);
+
+} // namespace collector
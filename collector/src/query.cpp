@@ -0,0 +1,297 @@
+/*
+ * Fleet-wide queries over the time-series store (implementation).
+ * - A device whose blocks overlap in time (late fills sealed after newer
+ *   readings) cannot be scanned block by block for runs; it is read back
+ *   sorted with ts_store::read() instead. Aggregates do not care.
+ * - Run detection on the vector path works on the match bitmap: within a
+ *   block whose largest time step is below max_gap_ms (k_max_step), runs
+ *   are exactly the stretches of 1 bits, found a word at a time. Blocks
+ *   with a long silence inside fall back to the per-row loop.
+ */
+
+#include "query.h"
+#include <algorithm>
+#include <cmath>
+#include "kernels.h"
+
+namespace collector {
+
+double ts_scale(ts_channel ch)
+{
+    return ch == TS_P ? 0.1 : 0.01;
+}
+
+namespace {
+
+// First index >= i in [0, n) whose bit equals value; n if none.
+size_t next_bit(const uint64_t *bits, size_t n, size_t i, bool value)
+{
+    while (i < n) {
+        uint64_t w = bits[i / 64];
+        if (!value) w = ~w;
+        w >>= i % 64;
+        if (w) return std::min(n, i + (size_t)__builtin_ctzll(w));
+        i = (i / 64 + 1) * 64;
+    }
+    return n;
+}
+
+// Rows [lo, hi) of the sorted times t[0..n) that fall in [from_ms, to_ms).
+void time_slice(const int64_t *t, size_t n, int64_t from_ms, int64_t to_ms, size_t &lo, size_t &hi)
+{
+    lo = (size_t)(std::lower_bound(t, t + n, from_ms) - t);
+    hi = (size_t)(std::lower_bound(t + lo, t + n, to_ms) - t);
+}
+
+struct device_agg {
+    uint64_t count = 0;
+    float    min = INFINITY, max = -INFINITY;
+    double   sum = 0;
+
+    void merge(uint64_t n, float mn, float mx, double s)
+    {
+        count += n;
+        min = std::min(min, mn);
+        max = std::max(max, mx);
+        sum += s;
+    }
+    void add(const float *v, size_t n, bool simd)
+    {
+        if (!n) return;
+        k_minmax m = simd ? k_minmaxsum(v, n) : k_minmaxsum_scalar(v, n);
+        merge(n, m.min, m.max, m.sum);
+    }
+};
+
+fleet_agg_row aggregate_device(const ts_store &store, uint16_t device, ts_channel ch, int64_t from_ms, int64_t to_ms,
+                               const query_options &opt)
+{
+    device_agg a;
+    ts_range_view v;
+    store.view(device, from_ms, to_ms, v);
+    float scale = (float)ts_scale(ch);
+    int64_t t[TS_BLOCK_ROWS];
+    int32_t raw[TS_BLOCK_ROWS];
+    float f[TS_BLOCK_ROWS];
+    for (const ts_block_ref &b : v.blocks) {
+        const ts_summary &s = b.info.ch[ch];
+        if (opt.prune && b.info.t_first >= from_ms && b.info.t_last < to_ms) {
+            a.merge(b.info.rows, (float)s.min * scale, (float)s.max * scale, (double)s.sum * scale);
+            continue;
+        }
+        size_t lo, hi;
+        ts_decode_times(b.data, b.info, t);
+        time_slice(t, b.info.rows, from_ms, to_ms, lo, hi);
+        if (lo == hi) continue;
+        ts_decode_channel(b.data, b.info, ch, raw);
+        k_to_float(raw + lo, hi - lo, scale, f);
+        a.add(f, hi - lo, opt.simd);
+    }
+    for (size_t i = 0; i < v.head.size(); i += TS_BLOCK_ROWS) {
+        size_t n = std::min(TS_BLOCK_ROWS, v.head.size() - i);
+        for (size_t k = 0; k < n; k++) raw[k] = ts_value(v.head[i + k], ch);
+        k_to_float(raw, n, scale, f);
+        a.add(f, n, opt.simd);
+    }
+    return fleet_agg_row{ device, a.count, a.min, a.max, a.sum };
+}
+
+// Episode state of one device, carried across blocks in time order.
+class run_scan {
+public:
+    run_scan(const threshold_query &q, uint16_t device) : q_(q) { hit_ = threshold_hit{ device, 0, 0, 0, 0 }; }
+
+    // Reference path: one reading at a time.
+    void row(int64_t t, bool match)
+    {
+        if (in_run_ && t - prev_ > q_.max_gap_ms) close();
+        if (match) {
+            if (!in_run_) start(t);
+            last_ = t;
+        } else {
+            close();
+        }
+        prev_ = t;
+    }
+    void rows(const int64_t *t, const float *v, size_t n)
+    {
+        for (size_t i = 0; i < n; i++) row(t[i], q_.above ? v[i] > q_.threshold : v[i] < q_.threshold);
+    }
+
+    // Vector path: bit i of bits says whether reading i matched.
+    void bits(const int64_t *t, const uint64_t *bits, size_t n)
+    {
+        if (!n) return;
+        if (k_max_step(t, n) > q_.max_gap_ms) {
+            for (size_t i = 0; i < n; i++) row(t[i], bits[i / 64] >> (i % 64) & 1);
+            return;
+        }
+        if (in_run_ && t[0] - prev_ > q_.max_gap_ms) close();
+        for (size_t i = 0; i < n;) {
+            if (in_run_) {
+                size_t z = next_bit(bits, n, i, false);
+                if (z > i) last_ = t[z - 1];
+                if (z < n) close();
+                i = z;
+            } else {
+                i = next_bit(bits, n, i, true);
+                if (i < n) start(t[i]);
+            }
+        }
+        prev_ = t[n - 1];
+    }
+
+    // A whole block known from its summary to match nowhere, or everywhere
+    // with no step longer than max_gap_ms.
+    void none(int64_t t_last)
+    {
+        close();
+        prev_ = t_last;
+    }
+    void all(int64_t t_first, int64_t t_last)
+    {
+        if (in_run_ && t_first - prev_ > q_.max_gap_ms) close();
+        if (!in_run_) start(t_first);
+        last_ = prev_ = t_last;
+    }
+
+    const threshold_hit &finish()
+    {
+        close();
+        return hit_;
+    }
+
+private:
+    void start(int64_t t)
+    {
+        in_run_ = true;
+        start_ = last_ = t;
+    }
+    void close()
+    {
+        if (!in_run_) return;
+        in_run_ = false;
+        int64_t d = last_ - start_;
+        if (d < q_.min_duration_ms) return;
+        if (!hit_.episodes++) hit_.first_start_ms = start_;
+        hit_.longest_ms = std::max(hit_.longest_ms, d);
+        hit_.total_ms += d;
+    }
+
+    const threshold_query &q_;
+    threshold_hit hit_;
+    bool    in_run_ = false;
+    int64_t start_ = 0, last_ = 0, prev_ = 0;
+};
+
+// Readings t[0..n) with fixed-point values raw[0..n), sorted and in range.
+void scan_rows(run_scan &scan, const threshold_query &q, const int64_t *t, const int32_t *raw, size_t n,
+               const query_options &opt)
+{
+    float f[TS_BLOCK_ROWS];
+    uint64_t bits[TS_BLOCK_ROWS / 64];
+    k_to_float(raw, n, (float)ts_scale(q.ch), f);
+    if (!opt.simd) {
+        scan.rows(t, f, n);
+        return;
+    }
+    if (q.above) k_mask_above(f, n, q.threshold, bits);
+    else k_mask_below(f, n, q.threshold, bits);
+    scan.bits(t, bits, n);
+}
+
+threshold_hit threshold_device(const ts_store &store, uint16_t device, const threshold_query &q,
+                               const query_options &opt)
+{
+    run_scan scan(q, device);
+    ts_range_view v;
+    store.view(device, q.from_ms, q.to_ms, v);
+    int64_t t[TS_BLOCK_ROWS];
+    int32_t raw[TS_BLOCK_ROWS];
+    if (!v.ordered) {
+        std::vector<reading_t> rows;
+        store.read(device, q.from_ms, q.to_ms, rows);
+        for (size_t i = 0; i < rows.size(); i += TS_BLOCK_ROWS) {
+            size_t n = std::min(TS_BLOCK_ROWS, rows.size() - i);
+            for (size_t k = 0; k < n; k++) {
+                t[k] = rows[i + k].unix_ms;
+                raw[k] = ts_value(rows[i + k], q.ch);
+            }
+            scan_rows(scan, q, t, raw, n, opt);
+        }
+        return scan.finish();
+    }
+    float scale = (float)ts_scale(q.ch);
+    for (const ts_block_ref &b : v.blocks) {
+        if (opt.prune && b.info.t_first >= q.from_ms && b.info.t_last < q.to_ms) {
+            float lo = (float)b.info.ch[q.ch].min * scale, hi = (float)b.info.ch[q.ch].max * scale;
+            if (q.above ? hi <= q.threshold : lo >= q.threshold) {
+                scan.none(b.info.t_last);
+                continue;
+            }
+            if (q.above ? lo > q.threshold : hi < q.threshold) {
+                ts_decode_times(b.data, b.info, t);
+                if (k_max_step(t, b.info.rows) <= q.max_gap_ms) {
+                    scan.all(b.info.t_first, b.info.t_last);
+                    continue;
+                }
+            }
+        }
+        size_t lo, hi;
+        ts_decode_times(b.data, b.info, t);
+        time_slice(t, b.info.rows, q.from_ms, q.to_ms, lo, hi);
+        if (lo == hi) continue;
+        ts_decode_channel(b.data, b.info, q.ch, raw);
+        scan_rows(scan, q, t + lo, raw + lo, hi - lo, opt);
+    }
+    for (size_t i = 0; i < v.head.size(); i += TS_BLOCK_ROWS) {
+        size_t n = std::min(TS_BLOCK_ROWS, v.head.size() - i);
+        for (size_t k = 0; k < n; k++) {
+            t[k] = v.head[i + k].unix_ms;
+            raw[k] = ts_value(v.head[i + k], q.ch);
+        }
+        scan_rows(scan, q, t, raw, n, opt);
+    }
+    return scan.finish();
+}
+
+} // namespace
+
+/**
+ * @brief min/max/mean of one channel for every device and the fleet.
+ *
+ * @return Physical units; devices with no readings in range are left out.
+ */
+fleet_agg query_engine::aggregate(ts_channel ch, int64_t from_ms, int64_t to_ms, const query_options &opt) const
+{
+    std::vector<uint16_t> devices = store_.devices();
+    std::vector<fleet_agg_row> rows(devices.size());
+    pool_.parallel_for(devices.size(),
+                       [&](size_t i) { rows[i] = aggregate_device(store_, devices[i], ch, from_ms, to_ms, opt); });
+    fleet_agg out;
+    device_agg total;
+    for (const fleet_agg_row &r : rows) {
+        if (!r.count) continue;
+        out.devices.push_back(r);
+        total.merge(r.count, r.min, r.max, r.sum);
+    }
+    out.total = fleet_agg_row{ 0xFFFF, total.count, total.min, total.max, total.sum };
+    return out;
+}
+
+/**
+ * @brief Devices with at least one episode beyond the threshold.
+ *
+ * @return One entry per such device, in device order.
+ */
+std::vector<threshold_hit> query_engine::threshold(const threshold_query &q, const query_options &opt) const
+{
+    std::vector<uint16_t> devices = store_.devices();
+    std::vector<threshold_hit> hits(devices.size());
+    pool_.parallel_for(devices.size(), [&](size_t i) { hits[i] = threshold_device(store_, devices[i], q, opt); });
+    hits.erase(std::remove_if(hits.begin(), hits.end(), [](const threshold_hit &h) { return h.episodes == 0; }),
+               hits.end());
+    return hits;
+}
+
+} // namespace collector
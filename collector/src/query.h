@@ -0,0 +1,77 @@
+/*
+ * Fleet-wide queries over the time-series store (public API).
+ * - Each query is split into one task per device and run on a work_pool
+ *   (work_pool.h); results come back in device order.
+ * - Blocks are decoded into float columns in physical units (°C, %RH, Pa)
+ *   and scanned with the kernels in kernels.h.
+ * - Block summaries prune work: an aggregate takes every block wholly
+ *   inside the range from its header, and a threshold query skips the
+ *   value column of any block whose min/max rule a match in or out
+ *   entirely (only its times are decoded, to see gaps).
+ * - A threshold episode is a run of consecutive readings on the matching
+ *   side of the threshold with no gap longer than max_gap_ms between
+ *   readings (a unit that went quiet is not assumed to have stayed hot);
+ *   its duration is last minus first matching reading.
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ts_store.h"
+#include "work_pool.h"
+
+namespace collector {
+
+double ts_scale(ts_channel ch);       // fixed point to physical unit: 0.01, 0.01, 0.1
+
+struct query_options {
+    bool prune = true;                // use block summaries (off: decode everything; for benchmarks)
+    bool simd = true;                 // vector kernels and bitmask runs (off: plain per-row loops)
+};
+
+struct fleet_agg_row {
+    uint16_t device;
+    uint64_t count;                   // > 0: devices without readings in range are left out
+    float    min, max;
+    double   sum;
+
+    double mean() const { return count ? sum / (double)count : 0.0; }
+};
+
+struct fleet_agg {
+    std::vector<fleet_agg_row> devices;
+    fleet_agg_row              total;  // device 0xFFFF, count 0 if nothing matched
+};
+
+struct threshold_query {
+    ts_channel ch = TS_T;
+    bool       above = true;           // value > threshold; false: value < threshold
+    float      threshold = 0;          // physical unit
+    int64_t    min_duration_ms = 0;    // episodes at least this long
+    int64_t    max_gap_ms = 60000;     // a longer silence ends an episode
+    int64_t    from_ms = 0;
+    int64_t    to_ms = INT64_MAX;
+};
+
+struct threshold_hit {
+    uint16_t device;
+    uint32_t episodes;                 // >= 1
+    int64_t  first_start_ms;
+    int64_t  longest_ms;
+    int64_t  total_ms;
+};
+
+class query_engine {
+public:
+    query_engine(const ts_store &store, work_pool &pool) : store_(store), pool_(pool) {}
+
+    // Readings with from_ms <= unix_ms < to_ms.
+    fleet_agg aggregate(ts_channel ch, int64_t from_ms, int64_t to_ms, const query_options &opt = {}) const;
+    std::vector<threshold_hit> threshold(const threshold_query &q, const query_options &opt = {}) const;
+
+private:
+    const ts_store &store_;
+    work_pool      &pool_;
+};
+
+} // namespace collector
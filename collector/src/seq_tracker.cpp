@@ -0,0 +1,108 @@
+/*
+ * Per-device sequence tracking (implementation).
+ * - Seqs compare with wrap-around (int32 difference), like the firmware.
+ */
+
+#include "seq_tracker.h"
+
+namespace collector {
+
+static bool seq_lt(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+static bool seq_le(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+void seq_tracker::reset(uint32_t seq)
+{
+    bits_.fill(0);
+    next_ = top_ = seq;
+    started_ = true;
+}
+
+// Move next_ up to seq; holes passed over are lost for good. Only the
+// window can hold arrived seqs, so a long jump costs O(WINDOW), not O(jump).
+void seq_tracker::advance_to(uint32_t seq)
+{
+    if (!seq_lt(next_, seq)) return;
+    uint32_t span = seq - next_;
+    uint32_t scan = span < WINDOW ? span : WINDOW, seen = 0;
+    for (uint32_t i = 0; i < scan; i++) {
+        if (test(next_ + i)) {
+            clear(next_ + i);
+            seen++;
+        }
+    }
+    lost_ += span - seen;
+    next_ = seq;
+    while (test(next_)) {
+        clear(next_);
+        next_++;
+    }
+    if (seq_lt(top_, next_)) top_ = next_;
+}
+
+/**
+ * @brief Apply the epoch and history depth of a UDP reading.
+ *
+ * @param[in] epoch Device boot epoch from the datagram.
+ * @param[in] seq   Its seq.
+ * @param[in] depth How far back the device's history reaches (seq - oldest).
+ */
+void seq_tracker::on_udp(uint16_t epoch, uint32_t seq, uint16_t depth)
+{
+    uint32_t oldest = seq - depth;
+    if (!started_ || epoch != epoch_) {
+        // a reboot keeps our position only if the device can still fill in from there
+        if (!started_ || !(seq_le(oldest, next_) && seq_le(next_, seq + 1))) reset(oldest);
+        epoch_ = epoch;
+    }
+    if (seq_lt(next_, oldest)) advance_to(oldest);   // the device no longer has those
+}
+
+/**
+ * @brief Record one seq.
+ *
+ * @return true the first time a seq is seen, false for a duplicate (or a
+ *         seq below next()).
+ */
+bool seq_tracker::add(uint32_t seq)
+{
+    if (!started_) reset(seq);
+    if (seq_lt(seq, next_)) return false;
+    if (seq - next_ >= WINDOW) advance_to(seq - WINDOW + 1);
+    if (test(seq)) return false;
+    set(seq);
+    if (seq_le(top_, seq)) top_ = seq + 1;
+    while (test(next_)) {
+        clear(next_);
+        next_++;
+    }
+    return true;
+}
+
+/**
+ * @brief Describe what has arrived as a UDP ack (device and epoch are the
+ *        caller's).
+ *
+ * @param[out] a next and up to UDPT_ACK_RANGES_MAX missing ranges between
+ *               next() and top(), oldest first.
+ * @return Number of ranges.
+ */
+int seq_tracker::missing(udp_ack &a) const
+{
+    a.next = next_;
+    a.n = 0;
+    uint32_t s = next_;
+    while (seq_lt(s, top_) && a.n < UDPT_ACK_RANGES_MAX) {
+        if (test(s)) {
+            s++;
+            continue;
+        }
+        uint32_t first = s;
+        while (seq_lt(s, top_) && !test(s) && s - first < 0xFFFF) s++;
+        a.missing[a.n].first = first;
+        a.missing[a.n].count = (uint16_t)(s - first);
+        a.n++;
+    }
+    return a.n;
+}
+
+} // namespace collector
@@ -0,0 +1,51 @@
+/*
+ * Per-device sequence tracking (public API).
+ * - Which seqs of one device have arrived: everything before next() plus a
+ *   bitmap of the WINDOW seqs after it. add() answers new or duplicate in
+ *   O(1); missing() lists the holes for a UDP ack (udp_telemetry.h).
+ * - UDP readings carry an epoch (random per boot) and the device's history
+ *   depth; on_udp() applies the same rules as the reference receiver in
+ *   sim/udp: a new epoch keeps next() if the device can still resend it,
+ *   and next() never stays below the oldest seq the device holds.
+ * - A seq more than WINDOW past next() gives up on the oldest holes
+ *   (counted in lost()).
+ * - HTTP batches carry no epoch; the sink calls reset() when a device's
+ *   seq falls more than WINDOW behind next() (it rebooted).
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include "wire.h"
+
+namespace collector {
+
+class seq_tracker {
+public:
+    static constexpr uint32_t WINDOW = 4096;
+
+    void on_udp(uint16_t epoch, uint32_t seq, uint16_t depth);   // before add() for a UDP reading
+    void reset(uint32_t seq);                                    // forget everything; next() = seq
+    bool add(uint32_t seq);                                      // true = first time seen
+    int  missing(udp_ack &a) const;                              // fills a.next/n/missing; returns n
+
+    bool     started() const { return started_; }
+    uint32_t next() const    { return next_; }
+    uint32_t top() const     { return top_; }                    // one past the highest seq seen
+    uint64_t lost() const    { return lost_; }
+
+private:
+    bool test(uint32_t seq) const { return bits_[(seq % WINDOW) / 64] >> (seq % 64) & 1; }
+    void set(uint32_t seq)        { bits_[(seq % WINDOW) / 64] |= 1ull << (seq % 64); }
+    void clear(uint32_t seq)      { bits_[(seq % WINDOW) / 64] &= ~(1ull << (seq % 64)); }
+    void advance_to(uint32_t seq);
+
+    bool     started_ = false;
+    uint16_t epoch_ = 0;
+    uint32_t next_ = 0;
+    uint32_t top_ = 0;
+    uint64_t lost_ = 0;
+    std::array<uint64_t, WINDOW / 64> bits_{};   // bit seq % WINDOW for seq in [next_, next_ + WINDOW)
+};
+
+} // namespace collector
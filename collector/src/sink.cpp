@@ -0,0 +1,138 @@
+/*
+ * Storage side of the ingest pipeline (implementation).
+ * - Rings are drained round-robin in chunks so one busy worker cannot
+ *   starve the others; when all are empty the thread naps 200 us (a 1 Hz
+ *   fleet does not need lower latency, and polling costs no syscalls).
+ */
+
+#include "sink.h"
+#include <ctime>
+#include <sys/socket.h>
+
+namespace collector {
+
+static constexpr size_t POP_CHUNK = 256;
+static constexpr int    FLUSH_EVERY_MS = 50;
+
+static int64_t mono_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+sink::sink(std::vector<ingest_ring *> rings, int ack_fd, ts_store *store)
+    : rings_(std::move(rings)), ack_fd_(ack_fd), store_(store), devices_(65536)
+{
+}
+
+void sink::send_ack(uint16_t device, device_state &d)
+{
+    d.since_ack = 0;
+    d.unacked_since_ms = -1;
+    if (!d.has_peer) return;
+    udp_ack a;
+    a.device = device;
+    a.epoch = d.epoch;
+    d.seq.missing(a);
+    uint8_t pkt[udpt_ack_len(UDPT_ACK_RANGES_MAX)];
+    size_t len = encode_udp_ack(a, pkt, sizeof pkt);
+    if (sendto(ack_fd_, pkt, len, MSG_DONTWAIT, reinterpret_cast<const sockaddr *>(&d.peer), sizeof d.peer) > 0)
+        acks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void sink::apply(const ingest_item &it, int64_t now_ms)
+{
+    auto &slot = devices_[it.device];
+    if (!slot) {
+        slot = std::make_unique<device_state>();
+        device_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    device_state &d = *slot;
+    uint64_t lost_before = d.seq.lost();
+    bool udp = it.source != SRC_HTTP;
+    bool gap_opened = false;
+    if (udp) {
+        d.seq.on_udp(it.epoch, it.r.seq, it.depth);
+        d.epoch = it.epoch;
+        d.peer = it.peer;
+        d.has_peer = true;
+        gap_opened = d.seq.started() && (int32_t)(it.r.seq - d.seq.top()) > 0;
+    } else if (d.seq.started() && (int32_t)(d.seq.next() - it.r.seq) > (int32_t)seq_tracker::WINDOW) {
+        d.seq.reset(it.r.seq);                          // restarted count: a reboot, not a very old resend
+    }
+    if (d.seq.add(it.r.seq)) {
+        stored_.fetch_add(1, std::memory_order_relaxed);
+        if (store_) store_->append(it.device, it.r);
+        if ((int32_t)(it.r.seq - d.newest.seq) >= 0 || d.newest.unix_ms == 0) d.newest = it.r;
+    } else {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (d.seq.lost() != lost_before) lost_.fetch_add(d.seq.lost() - lost_before, std::memory_order_relaxed);
+    if (!udp) return;
+
+    if (d.unacked_since_ms < 0) {
+        d.unacked_since_ms = now_ms;
+        unacked_.push_back(it.device);
+    }
+    if (++d.since_ack >= ACK_EVERY || gap_opened) send_ack(it.device, d);
+}
+
+void sink::flush_acks(int64_t now_ms)
+{
+    size_t keep = 0;
+    for (uint16_t dev : unacked_) {
+        device_state &d = *devices_[dev];
+        if (d.unacked_since_ms < 0) continue;                 // acked in the meantime
+        if (now_ms - d.unacked_since_ms >= ACK_DELAY_MS) send_ack(dev, d);
+        else unacked_[keep++] = dev;
+    }
+    unacked_.resize(keep);
+}
+
+size_t sink::drain_once()
+{
+    ingest_item batch[POP_CHUNK];
+    size_t total = 0;
+    int64_t now = mono_ms();
+    for (ingest_ring *ring : rings_) {
+        size_t n = ring->pop(batch, POP_CHUNK);
+        for (size_t i = 0; i < n; i++) apply(batch[i], now);
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * @brief Storage thread body.
+ *
+ * @param[in] running Cleared by the owner to stop; whatever is still in the
+ *                    rings is applied before returning.
+ */
+void sink::run(const std::atomic<bool> &running)
+{
+    int64_t last_flush = mono_ms();
+    while (running.load(std::memory_order_relaxed)) {
+        size_t n = drain_once();
+        int64_t now = mono_ms();
+        if (now - last_flush >= FLUSH_EVERY_MS) {
+            flush_acks(now);
+            last_flush = now;
+        }
+        if (!n) {
+            timespec nap = { 0, 200000 };
+            nanosleep(&nap, nullptr);
+        }
+    }
+    while (drain_once()) {
+    }
+}
+
+sink_stats sink::stats() const
+{
+    return sink_stats{ stored_.load(std::memory_order_relaxed), duplicates_.load(std::memory_order_relaxed),
+                       lost_.load(std::memory_order_relaxed), acks_.load(std::memory_order_relaxed),
+                       device_count_.load(std::memory_order_relaxed) };
+}
+
+} // namespace collector
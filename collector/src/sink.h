@@ -0,0 +1,82 @@
+/*
+ * Storage side of the ingest pipeline (public API).
+ * - One thread drains every worker's ring in turn, so per-device state
+ *   (seq_tracker, newest reading, counters) has a single writer and no lock.
+ * - Duplicates (resends, retried POSTs) are dropped here by seq; every
+ *   new reading goes to the time-series store, if there is one.
+ * - Sends the UDP acks the firmware expects: after ACK_EVERY readings of a
+ *   device, when a new gap shows up, and ACK_DELAY_MS after the oldest
+ *   unacknowledged reading - the reference receiver's policy in sim/udp.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <netinet/in.h>
+#include "seq_tracker.h"
+#include "spsc_ring.h"
+#include "ts_store.h"
+#include "wire.h"
+
+namespace collector {
+
+enum : uint8_t { SRC_UDP = 0, SRC_UDP_RESENT, SRC_HTTP };
+
+// One decoded reading on its way from a worker to the sink (48 bytes).
+struct ingest_item {
+    reading_t   r;
+    uint16_t    device;
+    uint16_t    epoch;                // UDP only
+    uint16_t    depth;                // UDP only
+    uint8_t     source;               // SRC_*
+    sockaddr_in peer;                 // UDP: where the ack goes
+};
+
+using ingest_ring = spsc_ring<ingest_item>;
+
+struct sink_stats {
+    uint64_t stored;                  // readings seen for the first time
+    uint64_t duplicates;
+    uint64_t lost;                    // holes given up on (more than seq_tracker::WINDOW behind)
+    uint64_t acks;
+    uint64_t devices;
+};
+
+class sink {
+public:
+    static constexpr int ACK_EVERY = 10;
+    static constexpr int ACK_DELAY_MS = 1000;
+
+    sink(std::vector<ingest_ring *> rings, int ack_fd, ts_store *store = nullptr);
+
+    void       run(const std::atomic<bool> &running);   // until running is false, then drains the rings
+    sink_stats stats() const;
+
+private:
+    struct device_state {
+        seq_tracker seq;
+        reading_t   newest{};
+        sockaddr_in peer{};
+        bool        has_peer = false;
+        uint16_t    epoch = 0;
+        uint16_t    since_ack = 0;
+        int64_t     unacked_since_ms = -1;
+    };
+
+    size_t drain_once();
+    void   apply(const ingest_item &it, int64_t now_ms);
+    void   send_ack(uint16_t device, device_state &d);
+    void   flush_acks(int64_t now_ms);
+
+    std::vector<ingest_ring *> rings_;
+    int ack_fd_;
+    ts_store *store_;
+    std::vector<std::unique_ptr<device_state>> devices_;   // indexed by device id (u16 on the wire)
+    std::vector<uint16_t> unacked_;                        // devices with a reading not yet acked
+
+    std::atomic<uint64_t> stored_{0}, duplicates_{0}, lost_{0}, acks_{0}, device_count_{0};
+};
+
+} // namespace collector
@@ -0,0 +1,73 @@
+/*
+ * Lock-free single-producer / single-consumer ring.
+ * - One per ingest worker: the worker pushes decoded readings, the storage
+ *   thread pops them. No lock and no syscall on either side; head and tail
+ *   sit on their own cache lines and each side caches the other's index,
+ *   so the shared lines only move when the cached value runs out.
+ * - Capacity is rounded up to a power of two.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace collector {
+
+template <typename T>
+class spsc_ring {
+public:
+    explicit spsc_ring(size_t capacity)
+    {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        buf_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Producer: room for at least n more items (for all-or-nothing batches).
+    bool has_room(size_t n)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ + n <= capacity()) return true;
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        return head - tail_cache_ + n <= capacity();
+    }
+
+    // Producer: false if full.
+    bool push(const T &v)
+    {
+        if (!has_room(1)) return false;
+        size_t head = head_.load(std::memory_order_relaxed);
+        buf_[head & mask_] = v;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: up to max items into out, oldest first; returns how many.
+    size_t pop(T *out, size_t max)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_cache_ == tail) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (head_cache_ == tail) return 0;
+        }
+        size_t n = head_cache_ - tail;
+        if (n > max) n = max;
+        for (size_t i = 0; i < n; i++) out[i] = buf_[(tail + i) & mask_];
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};   // next slot to write (producer)
+    size_t tail_cache_ = 0;                     // producer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};   // next slot to read (consumer)
+    size_t head_cache_ = 0;                     // consumer's view of head_
+};
+
+} // namespace collector
@@ -0,0 +1,185 @@
+/*
+ * Time-series block codec (implementation).
+ * - Fixed header fields are copied with memcpy (the collector only runs on
+ *   little-endian hosts; checked at compile time).
+ * - The varint decoders take the one-byte case first: at 1 Hz almost every
+ *   time delta-of-delta and value delta fits in 7 bits.
+ */
+
+#include "ts_codec.h"
+#include <atomic>
+#include <cstring>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "block layout is little-endian");
+
+namespace collector {
+
+template <typename T> static void put(uint8_t *p, T v) { memcpy(p, &v, sizeof v); }
+template <typename T> static T get(const uint8_t *p)
+{
+    T v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static inline const uint8_t *get_varint(const uint8_t *p, uint64_t &v)
+{
+    if (*p < 0x80) {
+        v = *p;
+        return p + 1;
+    }
+    v = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (b < 0x80) return p;
+    }
+}
+
+int32_t ts_value(const reading_t &r, ts_channel ch)
+{
+    switch (ch) {
+    case TS_T: return r.t_cC;
+    case TS_H: return r.h_cRH;
+    default:   return (int32_t)r.p_dPa;
+    }
+}
+
+size_t ts_block_info::size() const
+{
+    size_t n = TS_BLOCK_HEADER;
+    for (uint32_t len : col_len) n += len;
+    return (n + 7) & ~(size_t)7;
+}
+
+const uint8_t *ts_block_info::column(const uint8_t *block, int col) const
+{
+    const uint8_t *p = block + TS_BLOCK_HEADER;
+    for (int i = 0; i < col; i++) p += col_len[i];
+    return p;
+}
+
+/**
+ * @brief Encode one block (everything but the magic, see ts_seal_block()).
+ *
+ * @param[in]  device Device id, kept in the header so a store can rebuild
+ *                    its index from the blocks alone.
+ * @param[in]  rows   Readings sorted by unix_ms; n in 1..TS_BLOCK_ROWS.
+ * @param[out] out    TS_BLOCK_MAX bytes.
+ * @param[out] info   The header as written.
+ * @return Block size in bytes (a multiple of 8).
+ */
+size_t ts_encode_block(uint16_t device, const reading_t *rows, size_t n, uint8_t *out, ts_block_info &info)
+{
+    info = ts_block_info{};
+    info.device = device;
+    info.rows = (uint16_t)n;
+    info.t_first = rows[0].unix_ms;
+    info.t_last = rows[n - 1].unix_ms;
+
+    uint8_t *p = out + TS_BLOCK_HEADER, *col = p;
+    int64_t prev_t = rows[0].unix_ms, prev_d = 0;
+    for (size_t i = 1; i < n; i++) {
+        int64_t d = rows[i].unix_ms - prev_t;
+        p = put_varint(p, zigzag(d - prev_d));
+        prev_t = rows[i].unix_ms;
+        prev_d = d;
+    }
+    info.col_len[0] = (uint32_t)(p - col);
+
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        col = p;
+        ts_summary &s = info.ch[ch];
+        int32_t prev = 0;
+        s.min = INT32_MAX;
+        s.max = INT32_MIN;
+        for (size_t i = 0; i < n; i++) {
+            int32_t v = ts_value(rows[i], (ts_channel)ch);
+            p = put_varint(p, zigzag((int64_t)v - prev));
+            prev = v;
+            if (v < s.min) s.min = v;
+            if (v > s.max) s.max = v;
+            s.sum += v;
+        }
+        info.col_len[1 + ch] = (uint32_t)(p - col);
+    }
+    size_t size = info.size();
+    memset(p, 0, (size_t)(out + size - p));
+
+    put<uint32_t>(out, 0);
+    put<uint16_t>(out + 4, info.device);
+    put<uint16_t>(out + 6, info.rows);
+    put<int64_t>(out + 8, info.t_first);
+    put<int64_t>(out + 16, info.t_last);
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        put<int32_t>(out + 24 + ch * 16, info.ch[ch].min);
+        put<int32_t>(out + 28 + ch * 16, info.ch[ch].max);
+        put<int64_t>(out + 32 + ch * 16, info.ch[ch].sum);
+    }
+    for (int c = 0; c < 1 + TS_CHANNELS; c++) put<uint32_t>(out + 72 + c * 4, info.col_len[c]);
+    return size;
+}
+
+void ts_seal_block(uint8_t *block)
+{
+    std::atomic_thread_fence(std::memory_order_release);
+    put<uint32_t>(block, TS_BLOCK_MAGIC);
+}
+
+bool ts_read_header(const uint8_t *p, size_t room, ts_block_info &info)
+{
+    if (room < TS_BLOCK_HEADER || get<uint32_t>(p) != TS_BLOCK_MAGIC) return false;
+    info.device = get<uint16_t>(p + 4);
+    info.rows = get<uint16_t>(p + 6);
+    info.t_first = get<int64_t>(p + 8);
+    info.t_last = get<int64_t>(p + 16);
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        info.ch[ch].min = get<int32_t>(p + 24 + ch * 16);
+        info.ch[ch].max = get<int32_t>(p + 28 + ch * 16);
+        info.ch[ch].sum = get<int64_t>(p + 32 + ch * 16);
+    }
+    for (int c = 0; c < 1 + TS_CHANNELS; c++) info.col_len[c] = get<uint32_t>(p + 72 + c * 4);
+    return info.rows >= 1 && info.rows <= TS_BLOCK_ROWS && info.t_first <= info.t_last && info.size() <= room &&
+           info.size() <= TS_BLOCK_MAX;
+}
+
+void ts_decode_times(const uint8_t *block, const ts_block_info &info, int64_t *out)
+{
+    const uint8_t *p = info.column(block, 0);
+    int64_t t = info.t_first, d = 0;
+    out[0] = t;
+    for (size_t i = 1; i < info.rows; i++) {
+        uint64_t z;
+        p = get_varint(p, z);
+        d += unzigzag(z);
+        t += d;
+        out[i] = t;
+    }
+}
+
+void ts_decode_channel(const uint8_t *block, const ts_block_info &info, ts_channel ch, int32_t *out)
+{
+    const uint8_t *p = info.column(block, 1 + ch);
+    int32_t v = 0;
+    for (size_t i = 0; i < info.rows; i++) {
+        uint64_t z;
+        p = get_varint(p, z);
+        v += (int32_t)unzigzag(z);
+        out[i] = v;
+    }
+}
+
+} // namespace collector
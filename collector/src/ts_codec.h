@@ -0,0 +1,71 @@
+/*
+ * Time-series block codec (public API).
+ * - One immutable block holds up to TS_BLOCK_ROWS readings of one device,
+ *   sorted by time, as four separately encoded columns: time, T, H, P.
+ *   A query touching one channel decodes only the time column and that
+ *   channel's bytes.
+ * - Values stay in the device's fixed point (reading_codec.h: centi-°C,
+ *   centi-%RH, deci-Pa). The time column is delta-of-delta (a steady
+ *   sample interval is 0), the value columns are deltas; both as zigzag
+ *   varints, so a 1 Hz reading takes about 5 bytes instead of 18.
+ * - The header carries the time range and per channel min, max and sum,
+ *   so an aggregate over a block that lies wholly inside the query range
+ *   needs no decoding at all.
+ *
+ * Block layout (little-endian, 8-byte aligned):
+ *   0  magic u32 (written last: a torn block has none)
+ *   4  device u16, rows u16
+ *   8  t_first i64, t_last i64
+ *   24 per channel T, H, P: min i32, max i32, sum i64
+ *   72 column bytes u32 x 4 (time, T, H, P)
+ *   88 columns, back to back
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "wire.h"
+
+namespace collector {
+
+constexpr uint32_t TS_BLOCK_MAGIC = 0x31535443;   // "CTS1"
+constexpr size_t   TS_BLOCK_ROWS = 1024;
+constexpr size_t   TS_BLOCK_HEADER = 88;
+constexpr int      TS_CHANNELS = 3;
+constexpr size_t   TS_BLOCK_MAX = TS_BLOCK_HEADER + TS_BLOCK_ROWS * (10 + 3 * 5);   // worst case varints
+
+enum ts_channel : int { TS_T = 0, TS_H, TS_P };
+
+struct ts_summary {
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+};
+
+struct ts_block_info {
+    uint16_t   device;
+    uint16_t   rows;
+    int64_t    t_first;
+    int64_t    t_last;
+    ts_summary ch[TS_CHANNELS];
+    uint32_t   col_len[1 + TS_CHANNELS];
+
+    size_t        size() const;                       // header + columns, rounded up to 8
+    const uint8_t *column(const uint8_t *block, int col) const;   // col 0 = time, 1 + ts_channel
+};
+
+int32_t ts_value(const reading_t &r, ts_channel ch);
+
+// Encode rows[0..n) (n <= TS_BLOCK_ROWS, sorted by unix_ms) without the magic.
+// Returns the block size; out needs TS_BLOCK_MAX bytes.
+size_t ts_encode_block(uint16_t device, const reading_t *rows, size_t n, uint8_t *out, ts_block_info &info);
+void   ts_seal_block(uint8_t *block);                 // store the magic (release)
+
+// Header of a block at p with room bytes after it; false if no valid block is there.
+bool ts_read_header(const uint8_t *p, size_t room, ts_block_info &info);
+
+// Decode a whole column into rows values (time as i64, channels as i32).
+void ts_decode_times(const uint8_t *block, const ts_block_info &info, int64_t *out);
+void ts_decode_channel(const uint8_t *block, const ts_block_info &info, ts_channel ch, int32_t *out);
+
+} // namespace collector
@@ -0,0 +1,309 @@
+/*
+ * Columnar time-series store (implementation).
+ * - A head is sorted (usually already is; UDP gap fills arrive late) and
+ *   encoded directly into the current segment's mapping; the next segment
+ *   starts when fewer than TS_BLOCK_MAX bytes are left.
+ * - Late readings older than a sealed block simply go into the head, so
+ *   blocks of one device may overlap in time; the index keeps a prefix
+ *   maximum of t_last next to the t_first order to find the first block a
+ *   range can touch by binary search all the same.
+ */
+
+#include "ts_store.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace collector {
+
+void ts_agg::merge(const ts_agg &o)
+{
+    count += o.count;
+    sum += o.sum;
+    if (o.min < min) min = o.min;
+    if (o.max > max) max = o.max;
+}
+
+ts_store::ts_store(std::string dir) : dir_(std::move(dir)), index_(new std::atomic<series *>[0x10000]()) {}
+
+ts_store::~ts_store()
+{
+    seal_all();
+    for (segment &g : segments_) {
+        munmap(g.base, SEGMENT_BYTES);
+        close(g.fd);
+    }
+}
+
+bool ts_store::map_segment(unsigned n, bool create)
+{
+    char name[32];
+    snprintf(name, sizeof name, "/seg-%06u.cts", n);
+    std::string path = dir_ + name;
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+    if (fd < 0) {
+        if (!create && errno == ENOENT) return false;
+        fprintf(stderr, "store: %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && ((size_t)st.st_size >= SEGMENT_BYTES || ftruncate(fd, SEGMENT_BYTES) == 0))
+        base = mmap(nullptr, SEGMENT_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "store: cannot map %s: %s\n", path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+    segments_.push_back(segment{ fd, static_cast<uint8_t *>(base), 0 });
+    segment_count_.store(segments_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Create or open the store directory and rebuild the index.
+ *
+ * Walks seg-000000.cts, seg-000001.cts, ... block by block; a segment ends
+ * at the first position without a valid header (the rest of a sparse file,
+ * or a block whose writer died before sealing it, which is overwritten).
+ */
+bool ts_store::open()
+{
+    if (mkdir(dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "store: mkdir %s: %s\n", dir_.c_str(), strerror(errno));
+        return false;
+    }
+    for (unsigned n = 0; map_segment(n, false); n++) {
+        segment &g = segments_.back();
+        ts_block_info info;
+        while (ts_read_header(g.base + g.used, SEGMENT_BYTES - g.used, info)) {
+            index_block(get_or_create(info.device), block_ref{ info, g.base + g.used });
+            rows_.fetch_add(info.rows, std::memory_order_relaxed);
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(info.size(), std::memory_order_relaxed);
+            g.used += info.size();
+        }
+    }
+    return !segments_.empty() || map_segment(0, true);
+}
+
+ts_store::series &ts_store::get_or_create(uint16_t device)
+{
+    series *s = get(device);
+    if (s) return *s;
+    owned_.push_back(std::make_unique<series>());
+    s = owned_.back().get();
+    s->head.reserve(TS_BLOCK_ROWS);
+    index_[device].store(s, std::memory_order_release);
+    devices_.fetch_add(1, std::memory_order_relaxed);
+    return *s;
+}
+
+// Insert b in t_first order (normally at the end) and refresh the prefix maxima. Caller holds s.mu.
+void ts_store::index_block(series &s, const block_ref &b)
+{
+    auto pos = std::upper_bound(s.blocks.begin(), s.blocks.end(), b.info.t_first,
+                                [](int64_t t, const block_ref &x) { return t < x.info.t_first; });
+    size_t i = (size_t)(pos - s.blocks.begin());
+    s.blocks.insert(pos, b);
+    s.max_t_last.resize(s.blocks.size());
+    for (; i < s.blocks.size(); i++)
+        s.max_t_last[i] = std::max(i ? s.max_t_last[i - 1] : INT64_MIN, s.blocks[i].info.t_last);
+}
+
+void ts_store::seal(uint16_t device, series &s)
+{
+    if (s.head.empty()) return;
+    if (SEGMENT_BYTES - segments_.back().used < TS_BLOCK_MAX && !map_segment((unsigned)segments_.size(), true)) {
+        std::lock_guard<std::mutex> lock(s.mu);         // out of disk or mappings: drop rather than grow without bound
+        rows_.fetch_sub(s.head.size(), std::memory_order_relaxed);
+        s.head.clear();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(s.mu);         // queries read the head meanwhile; encoding only reads it
+        auto by_time = [](const reading_t &a, const reading_t &b) { return a.unix_ms < b.unix_ms; };
+        if (!std::is_sorted(s.head.begin(), s.head.end(), by_time)) std::stable_sort(s.head.begin(), s.head.end(), by_time);
+    }
+    segment &g = segments_.back();
+    uint8_t *p = g.base + g.used;
+    block_ref b{ {}, p };
+    size_t size = ts_encode_block(device, s.head.data(), s.head.size(), p, b.info);
+    ts_seal_block(p);
+    g.used += size;
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(s.mu);
+    index_block(s, b);
+    s.head.clear();
+}
+
+/**
+ * @brief Store one reading (already deduplicated by the sink).
+ *
+ * Seals the device's head into a block once it holds TS_BLOCK_ROWS readings.
+ */
+void ts_store::append(uint16_t device, const reading_t &r)
+{
+    series &s = get_or_create(device);
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(s.mu);
+        s.head.push_back(r);
+        n = s.head.size();
+    }
+    rows_.fetch_add(1, std::memory_order_relaxed);
+    if (n >= TS_BLOCK_ROWS) seal(device, s);
+}
+
+void ts_store::seal_all()
+{
+    for (uint32_t d = 0; d < 0x10000; d++) {
+        series *s = get((uint16_t)d);
+        if (s) seal((uint16_t)d, *s);
+    }
+}
+
+// Blocks that may hold readings in [from_ms, to_ms). Caller holds s.mu.
+void ts_store::blocks_in(const series &s, int64_t from_ms, int64_t to_ms, std::vector<block_ref> &out) const
+{
+    size_t first = (size_t)(std::lower_bound(s.max_t_last.begin(), s.max_t_last.end(), from_ms) - s.max_t_last.begin());
+    for (size_t i = first; i < s.blocks.size() && s.blocks[i].info.t_first < to_ms; i++)
+        if (s.blocks[i].info.t_last >= from_ms) out.push_back(s.blocks[i]);
+}
+
+/**
+ * @brief min/max/sum/count of one channel over a time range.
+ *
+ * @return Fixed-point values (ts_value()); count 0 if nothing is in range.
+ */
+ts_agg ts_store::aggregate(uint16_t device, ts_channel ch, int64_t from_ms, int64_t to_ms) const
+{
+    ts_agg agg;
+    const series *s = get(device);
+    if (!s || from_ms >= to_ms) return agg;
+    std::vector<block_ref> cut;
+    {
+        std::lock_guard<std::mutex> lock(s->mu);
+        size_t first = (size_t)(std::lower_bound(s->max_t_last.begin(), s->max_t_last.end(), from_ms) -
+                                s->max_t_last.begin());
+        for (size_t i = first; i < s->blocks.size() && s->blocks[i].info.t_first < to_ms; i++) {
+            const ts_block_info &b = s->blocks[i].info;
+            if (b.t_last < from_ms) continue;
+            if (b.t_first >= from_ms && b.t_last < to_ms) {          // wholly inside: the summary will do
+                agg.merge(ts_agg{ b.rows, b.ch[ch].min, b.ch[ch].max, b.ch[ch].sum });
+            } else {
+                cut.push_back(s->blocks[i]);
+            }
+        }
+        for (const reading_t &r : s->head)
+            if (r.unix_ms >= from_ms && r.unix_ms < to_ms) agg.add(ts_value(r, ch));
+    }
+    int64_t t[TS_BLOCK_ROWS];
+    int32_t v[TS_BLOCK_ROWS];
+    for (const block_ref &b : cut) {
+        ts_decode_times(b.data, b.info, t);
+        ts_decode_channel(b.data, b.info, ch, v);
+        for (size_t i = 0; i < b.info.rows; i++)
+            if (t[i] >= from_ms && t[i] < to_ms) agg.add(v[i]);
+    }
+    return agg;
+}
+
+/**
+ * @brief A device's blocks and unsealed readings touching a time range.
+ *
+ * Blocks are referenced, not copied; the head is copied (at most
+ * TS_BLOCK_ROWS readings) so that nothing is scanned under the lock.
+ *
+ * @param[out] out Replaced.
+ */
+bool ts_store::view(uint16_t device, int64_t from_ms, int64_t to_ms, ts_range_view &out) const
+{
+    out.blocks.clear();
+    out.head.clear();
+    out.ordered = true;
+    const series *s = get(device);
+    if (!s) return false;
+    if (from_ms >= to_ms) return true;
+    {
+        std::lock_guard<std::mutex> lock(s->mu);
+        blocks_in(*s, from_ms, to_ms, out.blocks);
+        for (const reading_t &r : s->head) {
+            if (r.unix_ms >= from_ms && r.unix_ms < to_ms) {
+                out.head.push_back(r);
+                out.head.back().seq = 0;
+            }
+        }
+    }
+    auto by_time = [](const reading_t &a, const reading_t &b) { return a.unix_ms < b.unix_ms; };
+    if (!std::is_sorted(out.head.begin(), out.head.end(), by_time))
+        std::stable_sort(out.head.begin(), out.head.end(), by_time);
+    int64_t last = INT64_MIN;
+    for (const block_ref &b : out.blocks) {
+        out.ordered = out.ordered && b.info.t_first >= last;
+        last = std::max(last, b.info.t_last);
+    }
+    out.ordered = out.ordered && (out.head.empty() || out.head.front().unix_ms >= last);
+    return true;
+}
+
+/**
+ * @brief Every reading of a device in a time range, decoded.
+ *
+ * @param[out] out Appended to, sorted by unix_ms (seq is not stored and reads as 0).
+ * @return Number of readings appended.
+ */
+size_t ts_store::read(uint16_t device, int64_t from_ms, int64_t to_ms, std::vector<reading_t> &out) const
+{
+    ts_range_view v;
+    if (!view(device, from_ms, to_ms, v)) return 0;
+    size_t start = out.size();
+    int64_t t[TS_BLOCK_ROWS];
+    int32_t col[TS_CHANNELS][TS_BLOCK_ROWS];
+    size_t n = out.size(), cap = n + v.head.size();
+    for (const block_ref &b : v.blocks) cap += b.info.rows;
+    out.resize(cap);                                    // filled in place, trimmed below
+    for (const block_ref &b : v.blocks) {
+        ts_decode_times(b.data, b.info, t);
+        for (int ch = 0; ch < TS_CHANNELS; ch++) ts_decode_channel(b.data, b.info, (ts_channel)ch, col[ch]);
+        for (size_t i = 0; i < b.info.rows; i++) {
+            reading_t &r = out[n];
+            r.unix_ms = t[i];
+            r.seq = 0;
+            r.t_cC = (int16_t)col[TS_T][i];
+            r.h_cRH = (uint16_t)col[TS_H][i];
+            r.p_dPa = (uint32_t)col[TS_P][i];
+            n += t[i] >= from_ms && t[i] < to_ms;
+        }
+    }
+    std::copy(v.head.begin(), v.head.end(), out.begin() + (long)n);
+    out.resize(n + v.head.size());
+    if (!v.ordered) {                                   // late fills sealed into overlapping blocks
+        auto by_time = [](const reading_t &a, const reading_t &b) { return a.unix_ms < b.unix_ms; };
+        std::stable_sort(out.begin() + (long)start, out.end(), by_time);
+    }
+    return out.size() - start;
+}
+
+std::vector<uint16_t> ts_store::devices() const
+{
+    std::vector<uint16_t> out;
+    for (uint32_t d = 0; d < 0x10000; d++)
+        if (get((uint16_t)d)) out.push_back((uint16_t)d);
+    return out;
+}
+
+ts_store_stats ts_store::stats() const
+{
+    return ts_store_stats{ rows_.load(std::memory_order_relaxed), blocks_.load(std::memory_order_relaxed),
+                           bytes_.load(std::memory_order_relaxed), segment_count_.load(std::memory_order_relaxed),
+                           devices_.load(std::memory_order_relaxed) };
+}
+
+} // namespace collector
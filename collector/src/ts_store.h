@@ -0,0 +1,118 @@
+/*
+ * Columnar time-series store (public API).
+ * - Per device: a head of up to TS_BLOCK_ROWS readings in RAM, sealed into
+ *   an immutable column block (ts_codec.h) when full, plus an index of the
+ *   device's blocks ordered by start time.
+ * - Blocks are written straight into memory-mapped segment files
+ *   (<dir>/seg-NNNNNN.cts, SEGMENT_BYTES each, sparse) and read back from
+ *   the same mapping without copying. Opening a directory walks the
+ *   segments and rebuilds every index from the block headers.
+ * - aggregate() answers min/max/mean from the block summaries for every
+ *   block wholly inside the range and decodes only the (at most two)
+ *   blocks cut by its ends, so a month of 1 Hz data costs microseconds.
+ * - view() hands out a device's block references and a copy of its head
+ *   for a range, which is what the fleet query engine (query.h) scans.
+ * - One writer (the sink thread) appends; any thread may query. A
+ *   per-device mutex covers the head and the index; block bytes are
+ *   immutable once published and are decoded outside the lock.
+ */
+
+#pragma once
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ts_codec.h"
+
+namespace collector {
+
+struct ts_agg {
+    uint64_t count = 0;
+    int32_t  min = INT32_MAX;         // fixed point, as ts_value()
+    int32_t  max = INT32_MIN;
+    int64_t  sum = 0;
+
+    double mean() const { return count ? (double)sum / (double)count : 0.0; }
+    void   add(int32_t v)
+    {
+        count++;
+        sum += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+    void merge(const ts_agg &o);
+};
+
+// A device's data over a time range, for scanning outside the store's locks.
+struct ts_block_ref {
+    ts_block_info  info;
+    const uint8_t *data;              // immutable once published
+};
+
+struct ts_range_view {
+    std::vector<ts_block_ref> blocks; // every block touching the range, by t_first (may be cut by its ends)
+    std::vector<reading_t>    head;   // unsealed readings in the range, sorted (seq = 0)
+    bool ordered = true;              // blocks then head never overlap in time: their rows are sorted end to end
+};
+
+struct ts_store_stats {
+    uint64_t rows;                    // sealed + in heads
+    uint64_t blocks;
+    uint64_t bytes;                   // sealed block bytes
+    uint64_t segments;
+    uint64_t devices;
+};
+
+class ts_store {
+public:
+    static constexpr size_t SEGMENT_BYTES = 64u << 20;
+
+    explicit ts_store(std::string dir);
+    ~ts_store();                                         // seals every head
+
+    bool open();                                         // false (with a message on stderr) on an I/O error
+    void append(uint16_t device, const reading_t &r);    // writer thread only
+    void seal_all();                                     // writer thread only (or after it stopped)
+
+    // Readings with from_ms <= unix_ms < to_ms.
+    ts_agg aggregate(uint16_t device, ts_channel ch, int64_t from_ms, int64_t to_ms) const;
+    size_t read(uint16_t device, int64_t from_ms, int64_t to_ms, std::vector<reading_t> &out) const;   // sorted; seq = 0
+    bool   view(uint16_t device, int64_t from_ms, int64_t to_ms, ts_range_view &out) const;   // false: no such device
+
+    std::vector<uint16_t> devices() const;               // every device with data, ascending
+
+    ts_store_stats stats() const;
+    const std::string &dir() const { return dir_; }
+
+private:
+    using block_ref = ts_block_ref;
+    struct series {
+        mutable std::mutex     mu;
+        std::vector<reading_t> head;
+        std::vector<block_ref> blocks;       // by info.t_first
+        std::vector<int64_t>   max_t_last;   // prefix maximum of blocks[i].info.t_last
+    };
+    struct segment {
+        int      fd;
+        uint8_t *base;
+        size_t   used;
+    };
+
+    series *get(uint16_t device) const { return index_[device].load(std::memory_order_acquire); }
+    series &get_or_create(uint16_t device);
+    bool    map_segment(unsigned n, bool create);
+    void    index_block(series &s, const block_ref &b);
+    void    seal(uint16_t device, series &s);
+    void    blocks_in(const series &s, int64_t from_ms, int64_t to_ms, std::vector<block_ref> &out) const;
+
+    std::string dir_;
+    std::vector<segment> segments_;          // writer side only
+    std::unique_ptr<std::atomic<series *>[]> index_;
+    std::vector<std::unique_ptr<series>> owned_;
+    std::atomic<uint64_t> rows_{0}, blocks_{0}, bytes_{0}, segment_count_{0}, devices_{0};
+};
+
+} // namespace collector
@@ -0,0 +1,79 @@
+/*
+ * Device wire formats, collector side (implementation).
+ * - Byte-for-byte the layout of udpt_encode_reading()/udpt_encode_ack() in
+ *   main/udp_telemetry.c (little-endian, unaligned).
+ */
+
+#include "wire.h"
+
+namespace collector {
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get_u16(const uint8_t *p)   { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p)   { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+bool decode_udp_reading(const uint8_t *in, size_t len, udp_reading &out)
+{
+    if (len != UDPT_READING_LEN || in[0] >> 4 != UDPT_VERSION) return false;
+    out.type = in[0] & 0x0F;
+    if (out.type != UDPT_READING && out.type != UDPT_RESENT) return false;
+    out.device = get_u16(in + 1);
+    out.epoch = get_u16(in + 3);
+    out.depth = get_u16(in + 5);
+    out.r.seq = get_u32(in + 7);
+    out.r.unix_ms = (int64_t)(get_u32(in + 11) | (uint64_t)get_u16(in + 15) << 32);
+    out.r.t_cC = (int16_t)get_u16(in + 17);
+    out.r.h_cRH = get_u16(in + 19);
+    out.r.p_dPa = in[21] | (uint32_t)in[22] << 8 | (uint32_t)in[23] << 16;
+    return true;
+}
+
+void encode_udp_reading(const udp_reading &in, uint8_t out[UDPT_READING_LEN])
+{
+    uint64_t ms = (uint64_t)in.r.unix_ms;
+    out[0] = (uint8_t)(UDPT_VERSION << 4 | in.type);
+    put_u16(out + 1, in.device);
+    put_u16(out + 3, in.epoch);
+    put_u16(out + 5, in.depth);
+    put_u32(out + 7, in.r.seq);
+    put_u32(out + 11, (uint32_t)ms);
+    put_u16(out + 15, (uint16_t)(ms >> 32));
+    put_u16(out + 17, (uint16_t)in.r.t_cC);
+    put_u16(out + 19, in.r.h_cRH);
+    out[21] = (uint8_t)in.r.p_dPa;
+    out[22] = (uint8_t)(in.r.p_dPa >> 8);
+    out[23] = (uint8_t)(in.r.p_dPa >> 16);
+}
+
+size_t encode_udp_ack(const udp_ack &a, uint8_t *out, size_t cap)
+{
+    if (a.n > UDPT_ACK_RANGES_MAX || cap < udpt_ack_len(a.n)) return 0;
+    out[0] = UDPT_VERSION << 4 | UDPT_ACK;
+    put_u16(out + 1, a.device);
+    put_u16(out + 3, a.epoch);
+    out[5] = a.n;
+    put_u32(out + 6, a.next);
+    for (int i = 0; i < a.n; i++) {
+        put_u32(out + 10 + 6 * i, a.missing[i].first);
+        put_u16(out + 14 + 6 * i, a.missing[i].count);
+    }
+    return udpt_ack_len(a.n);
+}
+
+bool decode_udp_ack(const uint8_t *in, size_t len, udp_ack &a)
+{
+    if (len < udpt_ack_len(0) || in[0] != (UDPT_VERSION << 4 | UDPT_ACK)) return false;
+    a.device = get_u16(in + 1);
+    a.epoch = get_u16(in + 3);
+    a.n = in[5];
+    if (a.n > UDPT_ACK_RANGES_MAX || len != udpt_ack_len(a.n)) return false;
+    a.next = get_u32(in + 6);
+    for (int i = 0; i < a.n; i++) {
+        a.missing[i].first = get_u32(in + 10 + 6 * i);
+        a.missing[i].count = get_u16(in + 14 + 6 * i);
+    }
+    return true;
+}
+
+} // namespace collector
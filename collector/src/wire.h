@@ -0,0 +1,50 @@
+/*
+ * Device wire formats, collector side (public API).
+ * - UDP telemetry: 24-byte reading datagrams in, cumulative acks with
+ *   missing ranges out. Layout and semantics in main/udp_telemetry.h; the
+ *   firmware's encoder needs FreeRTOS, so the few put/get lines live here
+ *   again and tests/test_collector.py runs climate_sim against them.
+ * - HTTP uplink bodies are reading_codec.h batches and go through the
+ *   firmware's own reading_batch_decode().
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include "reading_codec.h"
+}
+
+namespace collector {
+
+constexpr uint8_t UDPT_VERSION        = 1;
+constexpr uint8_t UDPT_READING        = 1;   // first transmission
+constexpr uint8_t UDPT_RESENT         = 2;   // gap fill after an ack
+constexpr uint8_t UDPT_ACK            = 3;
+constexpr size_t  UDPT_READING_LEN    = 24;
+constexpr int     UDPT_ACK_RANGES_MAX = 8;
+constexpr size_t  udpt_ack_len(int n) { return 10 + 6 * (size_t)n; }
+
+struct udp_reading {
+    reading_t r;
+    uint16_t  device;
+    uint16_t  epoch;                  // random per device boot
+    uint16_t  depth;                  // seq - oldest seq the device still holds
+    uint8_t   type;                   // UDPT_READING or UDPT_RESENT
+};
+
+struct udp_ack {
+    uint16_t device;
+    uint16_t epoch;
+    uint32_t next;                    // every seq before it has arrived
+    uint8_t  n;                       // missing ranges that follow
+    struct { uint32_t first; uint16_t count; } missing[UDPT_ACK_RANGES_MAX];
+};
+
+bool   decode_udp_reading(const uint8_t *in, size_t len, udp_reading &out);   // false: wrong length/version/type
+void   encode_udp_reading(const udp_reading &in, uint8_t out[UDPT_READING_LEN]);   // load generator, tests
+size_t encode_udp_ack(const udp_ack &a, uint8_t *out, size_t cap);             // 0 if cap is too small
+bool   decode_udp_ack(const uint8_t *in, size_t len, udp_ack &a);
+
+} // namespace collector
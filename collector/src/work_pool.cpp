@@ -0,0 +1,133 @@
+/*
+ * Work-stealing thread pool for fleet queries (implementation).
+ * - queued_ only says whether sleeping is worth it; the deques themselves
+ *   are the truth. It is raised under sleep_mu_ after the tasks are
+ *   pushed, so a worker deciding to sleep cannot miss them.
+ * - A job lives on the caller's stack; its counter and condition variable
+ *   are only touched under its mutex, so the caller cannot return while
+ *   the last task's thread still holds a reference.
+ */
+
+#include "work_pool.h"
+#include <algorithm>
+
+namespace collector {
+
+struct work_pool::job {
+    const std::function<void(size_t)> *fn;
+    size_t                  left;            // indices not finished yet, under mu
+    std::mutex              mu;
+    std::condition_variable done;
+};
+
+work_pool::work_pool(int threads)
+{
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < threads; i++) queues_.push_back(std::make_unique<queue>());
+    for (size_t i = 0; i < queues_.size(); i++) workers_.emplace_back(&work_pool::worker_loop, this, i);
+}
+
+work_pool::~work_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mu_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (std::thread &t : workers_) t.join();
+}
+
+// self == queues_.size() for a calling thread (no deque of its own; not counted as a steal).
+bool work_pool::take(size_t self, task &t)
+{
+    size_t n = queues_.size();
+    if (self < n) {
+        queue &q = *queues_[self];
+        std::lock_guard<std::mutex> lock(q.mu);
+        if (!q.tasks.empty()) {
+            t = q.tasks.back();
+            q.tasks.pop_back();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t k = 1; k <= n; k++) {
+        queue &q = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.mu);
+        if (q.tasks.empty()) continue;
+        t = q.tasks.front();
+        q.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        if (self < n) steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void work_pool::run(const task &t)
+{
+    for (size_t i = t.begin; i < t.end; i++) (*t.j->fn)(i);
+    std::lock_guard<std::mutex> lock(t.j->mu);
+    t.j->left -= t.end - t.begin;
+    if (t.j->left == 0) t.j->done.notify_all();
+}
+
+void work_pool::worker_loop(size_t self)
+{
+    for (;;) {
+        task t;
+        if (take(self, t)) {
+            run(t);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mu_);
+        sleep_cv_.wait(lock, [&] { return stop_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (stop_) return;
+    }
+}
+
+/**
+ * @brief Run fn(0) ... fn(n - 1) across the pool.
+ *
+ * Indices are grouped grain at a time into tasks. With no workers (or a
+ * single task) everything runs on the calling thread.
+ */
+void work_pool::parallel_for(size_t n, const std::function<void(size_t)> &fn, size_t grain)
+{
+    if (n == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    size_t tasks = (n + grain - 1) / grain;
+    if (queues_.empty() || tasks == 1) {
+        for (size_t i = 0; i < n; i++) fn(i);
+        return;
+    }
+    job j;
+    j.fn = &fn;
+    j.left = n;
+    size_t q = next_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t b = 0; b < n; b += grain, q++) {
+        queue &dst = *queues_[q % queues_.size()];
+        std::lock_guard<std::mutex> lock(dst.mu);
+        dst.tasks.push_back(task{ &j, b, std::min(n, b + grain) });
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mu_);
+        queued_.fetch_add((int64_t)tasks, std::memory_order_relaxed);
+    }
+    sleep_cv_.notify_all();
+
+    task t;
+    size_t self = queues_.size();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(j.mu);
+            if (j.left == 0) return;
+        }
+        if (!take(self, t)) break;
+        run(t);                                          // may belong to another caller's job: still progress
+    }
+    std::unique_lock<std::mutex> lock(j.mu);
+    j.done.wait(lock, [&] { return j.left == 0; });
+}
+
+} // namespace collector
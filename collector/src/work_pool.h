@@ -0,0 +1,64 @@
+/*
+ * Work-stealing thread pool for fleet queries (public API).
+ * - One deque per worker. parallel_for() deals its tasks round-robin onto
+ *   the deques; a worker pops from the back of its own and, when that is
+ *   empty, steals from the front of the others, so a device with a month
+ *   of data does not hold up the devices queued behind it.
+ * - The calling thread works too until its job's tasks are all taken,
+ *   then waits for the ones still running. Several threads may run
+ *   parallel_for() at once (one query per HTTP worker); their tasks share
+ *   the deques.
+ * - Tasks must not throw.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace collector {
+
+class work_pool {
+public:
+    explicit work_pool(int threads = 0);    // 0 = one per core; 1 = no workers, the caller runs everything
+    ~work_pool();
+
+    // fn(i) for every i in [0, n), grain indices per task; returns when all are done.
+    void parallel_for(size_t n, const std::function<void(size_t)> &fn, size_t grain = 1);
+
+    int      threads() const { return (int)workers_.size() + 1; }   // counting the caller
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct job;
+    struct task {
+        job   *j;
+        size_t begin, end;
+    };
+    struct queue {
+        std::mutex       mu;
+        std::deque<task> tasks;
+    };
+
+    bool take(size_t self, task &t);         // own deque first, then steal
+    void run(const task &t);
+    void worker_loop(size_t self);
+
+    std::vector<std::unique_ptr<queue>> queues_;   // one per worker
+    std::vector<std::thread> workers_;
+    std::mutex              sleep_mu_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int64_t>    queued_{0};      // tasks in the deques (briefly negative while a push is published)
+    std::atomic<size_t>     next_{0};        // round-robin start for the next job
+    std::atomic<uint64_t>   steals_{0};
+    bool stop_ = false;                      // under sleep_mu_
+};
+
+} // namespace collector
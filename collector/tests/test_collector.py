@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""Fleet collector tests: climate_sim and collector_loadgen -> climate_collector.
+
+    cmake --build build-sim && cmake --build build-collector && pytest collector/tests
+
+The sim pushes real UDP telemetry (its firmware encoder and ack handling)
+at the collector; the load generator checks throughput and that every
+reading pushed over UDP or HTTP is stored exactly once. $COLLECTOR_BUILD and
+$SIM_BUILD point at the build directories (default build-collector and
+build-sim).
+"""
+
+import json
+import os
+import re
+import socket
+import struct
+import subprocess
+import time
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+BUILD = os.environ.get('COLLECTOR_BUILD', os.path.join(ROOT, 'build-collector'))
+COLLECTOR = os.path.join(BUILD, 'climate_collector')
+LOADGEN = os.path.join(BUILD, 'collector_loadgen')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+
+
+def start_collector(log_path, *args):
+    log = open(log_path, 'w+')
+    proc = subprocess.Popen([COLLECTOR, '--bind', '127.0.0.1', '--http-port', '0', '--udp-port', '0',
+                             '--stats-s', '0', *args], stdout=log, stderr=subprocess.STDOUT)
+    for _ in range(100):
+        log.seek(0)
+        m = re.search(r'http port (\d+), udp port (\d+)', log.read())
+        if m:
+            return proc, (int(m.group(1)), int(m.group(2)))
+        time.sleep(0.05)
+    proc.kill()
+    raise AssertionError('collector did not start')
+
+
+def stop_collector(proc):
+    proc.terminate()
+    assert proc.wait(timeout=10) == 0
+
+
+@pytest.fixture
+def collector(tmp_path):
+    proc, ports = start_collector(tmp_path / 'collector.log')
+    yield ports
+    stop_collector(proc)
+
+
+def http(port, raw):
+    """Send raw request bytes, return the raw response bytes (server closes)."""
+    with socket.create_connection(('127.0.0.1', port), timeout=5) as s:
+        s.sendall(raw)
+        s.shutdown(socket.SHUT_WR)
+        out = b''
+        while chunk := s.recv(65536):
+            out += chunk
+    return out
+
+
+def stats(port):
+    resp = http(port, b'GET /stats HTTP/1.1\r\nHost: c\r\nConnection: close\r\n\r\n')
+    return json.loads(resp.split(b'\r\n\r\n', 1)[1])
+
+
+def batch(first_seq, n, base_ms=1760000000000, t_cC=None):
+    """n readings 1 s apart; T = 21.50 °C + 0.01 per reading (or t_cC throughout), P 101325.0 Pa, H 45.00 %RH."""
+    out = b'CR' + struct.pack('<BBIq', 1, n, first_seq, base_ms)
+    for i in range(n):
+        t = 2150 + i if t_cC is None else t_cC
+        out += struct.pack('<Hh', 0 if i == 0 else 1000, t) + (1013250).to_bytes(3, 'little') \
+            + struct.pack('<H', 4500)
+    return out
+
+
+def post(device, body, extra=b''):
+    return (b'POST /ingest?device=%d HTTP/1.1\r\nHost: c\r\nContent-Length: %d\r\n' % (device, len(body))
+            + extra + b'\r\n' + body)
+
+
+def loadgen(ports, *args):
+    out = subprocess.run([LOADGEN, '--http-port', str(ports[0]), '--udp-port', str(ports[1]), '--json', *args],
+                         capture_output=True, text=True, timeout=60, check=True).stdout
+    return json.loads(out)
+
+
+def test_sim_telemetry_stored_once(collector):
+    env = dict(os.environ, SIM_UDP_COLLECTOR=f'127.0.0.1:{collector[1]}', SIM_TIME_SCALE='20',
+               SIM_DURATION_S='120', SIM_HTTP_PORT='0', SIM_LOG_LEVEL='2',
+               SIM_MQTT_URI='mqtt://127.0.0.1:1', SIM_HTTP_REDIRECT='http://127.0.0.1:1')
+    subprocess.run([SIM], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=30)
+    time.sleep(0.2)
+    s = stats(collector[0])
+    assert s['devices'] == 1 and s['stored'] >= 100 and s['bad_datagrams'] == 0
+    # the collector's acks kept the device from resending: no holes, at most the
+    # reading taken before the socket was up arrives twice
+    assert s['lost'] == 0 and s['duplicates'] <= 1
+    assert s['stored'] / 10 - 5 <= s['acks'] <= s['stored'] / 10 + 15
+
+
+def test_http_requests(collector):
+    port = collector[0]
+    # two batches back to back in one body (as the uplink sends them), then an overlapping one
+    resp = http(port, post(12, batch(0, 5) + batch(5, 2)) + post(12, batch(3, 5)) + b'GET /nope HTTP/1.1\r\n\r\n')
+    codes = re.findall(rb'HTTP/1.1 (\d+)', resp)
+    assert codes == [b'204', b'204', b'404']           # pipelined, answered in order
+    s = stats(port)
+    assert s['stored'] == 8 and s['duplicates'] == 4    # seqs 3-6 arrived twice
+
+    # more pipelined requests than one connection buffers at a time: all answered
+    resp = http(port, b'GET /nope HTTP/1.1\r\n\r\n' * 4000)
+    assert resp.count(b'HTTP/1.1 404') == 4000
+
+    assert http(port, post(65536, batch(0, 1))).startswith(b'HTTP/1.1 400')
+    assert http(port, post(12, b'CR\x01\x05garbage')).startswith(b'HTTP/1.1 400')
+    assert http(port, post(12, batch(20, 2) + b'CR')).startswith(b'HTTP/1.1 400')   # truncated second batch
+    assert http(port, post(12, batch(0, 1), b'Content-Encoding: gzip\r\n')).startswith(b'HTTP/1.1 415')
+    assert http(port, b'POST /ingest?device=1 HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n') \
+        .startswith(b'HTTP/1.1 411')
+    assert http(port, b'GET /ingest HTTP/1.1\r\n\r\n').startswith(b'HTTP/1.1 405')
+
+
+def test_loadgen_udp_100k_per_s(collector):
+    r = loadgen(collector, '--mode', 'udp', '--devices', '1000', '--rate', '100000', '--duration', '5')
+    assert r['lost'] == 0 and r['stored'] == r['sent']
+    assert r['stored_per_s'] > 90000
+    assert r['acks'] > r['sent'] / 10 * 0.9
+
+
+def test_loadgen_http_batches(collector):
+    r = loadgen(collector, '--mode', 'http', '--devices', '500', '--threads', '4', '--batch', '60',
+                '--duration', '3')
+    assert r['errors'] == 0 and r['lost'] == 0 and r['stored'] == r['sent']
+    assert r['stored_per_s'] > 100000
+
+
+def test_store_query_survives_restart(tmp_path):
+    data = tmp_path / 'data'
+    base = 1760000000000
+    proc, (port, _) = start_collector(tmp_path / 'a.log', '--data', str(data))
+    # device 21: 2000 readings in 8 POSTs of 250 (two stored blocks plus a head)
+    for k in range(8):
+        body = batch(k * 250, 250, base + k * 250 * 1000)
+        assert http(port, post(21, body)).startswith(b'HTTP/1.1 204')
+    time.sleep(0.2)
+
+    def query(q):
+        resp = http(port, b'GET /query?%s HTTP/1.1\r\nConnection: close\r\n\r\n' % q.encode())
+        status = int(resp.split(b' ', 2)[1])
+        return status, resp.split(b'\r\n\r\n', 1)[1]
+
+    def check_answers():
+        status, body = query('device=21&channel=t')
+        r = json.loads(body)
+        assert status == 200 and r['count'] == 2000
+        assert r['min'] == 21.50 and r['max'] == 23.99 and abs(r['mean'] - 22.745) < 1e-6
+        # readings 300..1299: the range cuts blocks at both ends
+        r = json.loads(query(f'device=21&channel=t&from={base + 300000}&to={base + 1300000}')[1])
+        assert r['count'] == 1000 and r['min'] == 21.50 and r['max'] == 23.99
+        r = json.loads(query('device=21&channel=p')[1])
+        assert r['min'] == r['max'] == 101325.0
+        assert json.loads(query('device=22&channel=h')[1])['count'] == 0
+        assert query('device=21&channel=x')[0] == 400
+
+    check_answers()
+    assert stats(port)['store_blocks'] == 1                # 1024 rows sealed, the rest in the head
+    stop_collector(proc)                                   # seals the head
+
+    proc, (port, _) = start_collector(tmp_path / 'b.log', '--data', str(data))
+    try:
+        assert '2000 readings of 1 devices in 2 blocks' in (tmp_path / 'b.log').read_text()
+        check_answers()
+    finally:
+        stop_collector(proc)
+
+
+def test_fleet_queries(tmp_path):
+    base = 1760000000000
+    proc, (port, _) = start_collector(tmp_path / 'c.log', '--data', str(tmp_path / 'data'))
+    try:
+        # one minute per POST: device 41 is hot (30.00 °C) for 12 minutes, 42 for 5, 43 never
+        for device, hot in ((41, range(20, 32)), (42, range(20, 25)), (43, range(0))):
+            for minute in range(40):
+                body = batch(minute * 60, 60, base + minute * 60000, 3000 if minute in hot else None)
+                assert http(port, post(device, body)).startswith(b'HTTP/1.1 204')
+        time.sleep(0.2)
+
+        def get(path):
+            resp = http(port, b'GET %s HTTP/1.1\r\nConnection: close\r\n\r\n' % path.encode())
+            return int(resp.split(b' ', 2)[1]), resp.split(b'\r\n\r\n', 1)[1]
+
+        status, body = get('/fleet/threshold?channel=t&above=28.5&for_s=600')
+        r = json.loads(body)
+        assert status == 200 and r['devices'] == 1
+        assert r['hits'][0] == {'device': 41, 'episodes': 1, 'first_start_ms': base + 20 * 60000,
+                                'longest_s': 719, 'total_s': 719}
+        r = json.loads(get('/fleet/threshold?channel=t&above=28.5&for_s=60')[1])
+        assert [h['device'] for h in r['hits']] == [41, 42]
+        # the range ends 4 minutes into device 41's episode
+        r = json.loads(get(f'/fleet/threshold?channel=t&above=28.5&for_s=60&to={base + 24 * 60000}')[1])
+        assert [(h['device'], h['longest_s']) for h in r['hits']] == [(41, 239), (42, 239)]
+        assert json.loads(get('/fleet/threshold?channel=t&below=21.5')[1])['hits'] == []
+
+        status, body = get('/fleet/aggregate?channel=t')
+        r = json.loads(body)
+        assert status == 200 and r['devices'] == 3 and r['count'] == 3 * 2400
+        assert r['min'] == 21.50 and r['max'] == 30.00
+        assert [d['device'] for d in r['per_device']] == [41, 42, 43]
+        assert r['per_device'][2]['max'] == 22.09
+        # requests pipelined behind a query are answered after it, in order
+        resp = http(port, b'GET /fleet/aggregate?channel=t HTTP/1.1\r\n\r\nGET /stats HTTP/1.1\r\n\r\n'
+                          b'GET /query?device=42&channel=t HTTP/1.1\r\nConnection: close\r\n\r\n')
+        assert resp.count(b'HTTP/1.1 200') == 3
+        assert resp.index(b'"per_device"') < resp.index(b'"datagrams"') < resp.index(b'{"device":42,"channel"')
+
+        # 30.00 °C is a hot alert under the device's rules, a hot warning once alert_high is 31
+        status, body = get('/fleet/alerts?rules=device;15,16.5,28.5,31;15,16.5,28.5,30,30,60'
+                           f'&from={base}&to={base + 40 * 60000}')
+        r = json.loads(body)
+        assert status == 200 and r['devices'] == 3 and r['readings'] == 3 * 2400
+        dev, warn, same = r['rule_sets']
+        assert dev == {'rules': '15,16.5,28.5,30,30,60', 'sms': 2, 'devices': 2, 'cold_warnings': 0,
+                       'cold_alerts': 0, 'hot_warnings': 0, 'hot_alerts': 2}
+        assert (warn['sms'], warn['hot_warnings'], warn['hot_alerts']) == (2, 2, 0)
+        assert same == dev
+        r = json.loads(get(f'/fleet/alerts?rules=device&to={base + 20 * 60000}')[1])
+        assert r['rule_sets'][0]['sms'] == 0
+        assert get('/fleet/alerts?rules=15,16.5,x')[0] == 400
+        assert get('/fleet/alerts')[0] == 400
+        assert get('/fleet/alerts?rules=' + ';'.join(['device'] * 9))[0] == 400
+        assert get(f'/fleet/alerts?rules=device&from=0&to={base}')[0] == 400
+
+        assert get('/fleet/threshold?channel=t&above=1&below=2')[0] == 400
+        assert get('/fleet/threshold?channel=t&above=warm')[0] == 400
+        assert get('/fleet/aggregate?channel=q')[0] == 400
+        assert get('/fleet/nope')[0] == 404
+    finally:
+        stop_collector(proc)
+
+
+def test_query_without_store(collector):
+    assert http(collector[0], b'GET /query?device=1&channel=t HTTP/1.1\r\n\r\n').startswith(b'HTTP/1.1 404')
+    assert http(collector[0], b'GET /fleet/aggregate?channel=t HTTP/1.1\r\n\r\n').startswith(b'HTTP/1.1 404')
+    assert http(collector[0], b'GET /fleet/alerts?rules=device HTTP/1.1\r\n\r\n').startswith(b'HTTP/1.1 404')
+
+
+def test_client_that_does_not_read(collector):
+    """Pipelining without reading the answers stalls the sender instead of growing the server."""
+    req = b'GET /nope HTTP/1.1\r\n\r\n'
+    chunk = req * (1 << 16)                              # 1.5 MB
+    sent = 0
+    with socket.create_connection(('127.0.0.1', collector[0]), timeout=1) as s:
+        try:
+            while sent < 256 << 20:
+                sent += s.send(chunk[sent % len(chunk):])
+        except socket.timeout:
+            pass
+        assert sent < 64 << 20                           # socket buffers and OUTPUT_MAX, not everything
+        s.shutdown(socket.SHUT_WR)                       # a partial last request is dropped at the FIN
+        s.settimeout(10)
+        out = b''
+        while data := s.recv(1 << 20):
+            out += data
+    assert out.count(b'HTTP/1.1 404') == sent // len(req)
@@ -0,0 +1,235 @@
+/*
+ * Alert rule replay (host tool).
+ * Replays a collector store's temperature history through the firmware's
+ * alert decision (main/alert_rules.h) under several rule sets in parallel
+ * and reports how many SMS each would have sent (src/alert_replay.h).
+ *
+ *   alert_replay --data DIR [--rules SPEC]... [--from MS] [--to MS]
+ *                [--threads N] [--check] [--json]
+ *   alert_replay --synth-devices 1000 [--synth-days 365] [--interval-s 60] ...
+ *
+ * SPEC is "device" (the firmware's rule set) or
+ * "alert_low,warn_low,warn_high,alert_high,warn_cooldown_min,alert_cooldown_min",
+ * trailing numbers optional. Without --rules the device's set is compared
+ * with a few variations of it.
+ *
+ * --synth-devices fills a store first (in --data DIR, or a temporary
+ * directory removed afterwards) with a year of a synthetic fleet: seasonal
+ * and daily curves, some rooms that overheat on summer afternoons, some
+ * that get cold on winter nights and the odd heating failure.
+ * --check replays again without block pruning and on one thread, and
+ * exits 1 unless every count matches.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include "alert_replay.h"
+
+using namespace collector;
+
+static constexpr int64_t T0_MS = 1735689600000;   // 2025-01-01T00:00:00Z
+static constexpr int64_t DAY_S = 86400;
+
+static double now_s()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+static void remove_dir(const std::string &dir)
+{
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *e = readdir(d))
+            if (e->d_name[0] != '.') unlink((dir + "/" + e->d_name).c_str());
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+// One device's year: setpoint +-1.5 °C, summer afternoons up to +3 °C
+// (+8.5 for every eighth room), winter night setback of 1 °C (5 for every
+// twelfth), and for every fifth device two 12-hour heating failures in
+// winter that sag towards 12 °C.
+static void synth_device(ts_store &store, int device, int days, int interval_s)
+{
+    int64_t per_day = DAY_S / interval_s;
+    std::vector<float> afternoon((size_t)per_day), night((size_t)per_day);
+    for (int64_t k = 0; k < per_day; k++) {
+        double m = (double)(k * interval_s) / 60;                          // minute of the day
+        afternoon[(size_t)k] = (float)std::max(0.0, sin(2 * M_PI * (m - 540) / 1440));   // peaks at 15:00
+        night[(size_t)k] = m < 6 * 60 || m >= 22 * 60 ? 1.0f : 0.0f;
+    }
+    uint32_t h = mix((uint32_t)device);
+    double setpoint = 21.0 + (int)(h % 301 - 150) / 100.0;
+    double summer_gain = device % 8 == 0 ? 8.5 : 3.0;
+    double setback = device % 12 == 0 ? 5.0 : 1.0;
+    int fail_day[2] = { (int)(mix(h) % 60), 320 + (int)(mix(h + 1) % 40) };   // Jan/Feb and Nov/Dec
+    uint32_t seq = 0;
+    for (int day = 0; day < days; day++) {
+        double season = sin(2 * M_PI * (day % 365 - 80) / 365.0);           // +1 midsummer, -1 midwinter
+        bool failing = device % 5 == 0 && (day % 365 == fail_day[0] || day % 365 == fail_day[1]);
+        for (int64_t k = 0; k < per_day; k++) {
+            double t = setpoint + summer_gain * std::max(0.0, season) * afternoon[(size_t)k] -
+                       setback * std::max(0.0, -season) * night[(size_t)k];
+            double hour = (double)(k * interval_s) / 3600;
+            if (failing && hour >= 6 && hour < 18) t -= std::min(t - 12.0, (hour - 6) * 1.5);
+            t += (int)(mix((uint32_t)device * 7919u + seq) % 31 - 15) / 100.0;   // +-0.15 °C
+            reading_t r{};
+            r.unix_ms = T0_MS + ((int64_t)day * DAY_S + k * interval_s) * 1000;
+            r.seq = seq++;
+            r.t_cC = (int16_t)lrint(t * 100);
+            r.h_cRH = 4500;
+            r.p_dPa = 1013250;
+            store.append((uint16_t)device, r);
+        }
+    }
+}
+
+static bool same(const alert_replay_result &a, const alert_replay_result &b)
+{
+    if (a.readings != b.readings || a.devices != b.devices || a.sets.size() != b.sets.size()) return false;
+    for (size_t k = 0; k < a.sets.size(); k++) {
+        if (a.sets[k].sms != b.sets[k].sms || a.sets[k].devices != b.sets[k].devices) return false;
+        for (int kind = 0; kind < ALERT_KINDS; kind++)
+            if (a.sets[k].kinds[kind] != b.sets[k].kinds[kind]) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data;
+    std::vector<alert_rules_t> sets;
+    int synth_devices = 0, synth_days = 365, interval_s = 60, threads = 0;
+    long long from = 0, to = INT64_MAX;
+    bool check = false, json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--data") == 0 && i + 1 < argc)               data = argv[++i];
+        else if (strcmp(argv[i], "--synth-devices") == 0 && i + 1 < argc) synth_devices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--synth-days") == 0 && i + 1 < argc)    synth_days = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--interval-s") == 0 && i + 1 < argc)    interval_s = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)       threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc)          from = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc)            to = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--check") == 0)                         check = true;
+        else if (strcmp(argv[i], "--json") == 0)                          json = true;
+        else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            alert_rules_t r;
+            if (!parse_alert_rules(argv[++i], r)) {
+                fprintf(stderr, "bad rule set '%s'\n", argv[i]);
+                return 2;
+            }
+            sets.push_back(r);
+        } else {
+            fprintf(stderr, "usage: %s [--data DIR] [--synth-devices N] [--synth-days D] [--interval-s S]\n"
+                            "       [--rules SPEC]... [--from MS] [--to MS] [--threads N] [--check] [--json]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (data.empty() && synth_devices <= 0) {
+        fprintf(stderr, "need --data DIR, --synth-devices N, or both\n");
+        return 2;
+    }
+    if (synth_devices > 0x10000 || synth_days < 1 || interval_s < 1 || DAY_S % interval_s) {
+        fprintf(stderr, "need at most 65536 devices, days >= 1 and an interval that divides a day\n");
+        return 2;
+    }
+    if (sets.empty()) {
+        for (const char *spec : { "device", "15,16.5,29,30.5", "15,16.5,28.5,30,60,120", "14,16,29.5,31,30,60" }) {
+            alert_rules_t r;
+            parse_alert_rules(spec, r);
+            sets.push_back(r);
+        }
+    }
+    bool temp = data.empty();
+    if (temp) {
+        char tmpl[] = "/tmp/alert_replay.XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        data = tmpl;
+    }
+
+    auto store = std::make_unique<ts_store>(data);
+    if (!store->open()) return 1;
+    double build_s = 0;
+    if (synth_devices > 0) {
+        if (store->stats().rows) {
+            fprintf(stderr, "%s already holds a store; point --data at an empty directory\n", data.c_str());
+            return 2;
+        }
+        build_s = now_s();
+        for (int d = 0; d < synth_devices; d++) synth_device(*store, d, synth_days, interval_s);
+        store->seal_all();
+        build_s = now_s() - build_s;
+    }
+    ts_store_stats st = store->stats();
+
+    work_pool pool(threads);
+    double t = now_s();
+    alert_replay_result res = replay_alerts(*store, pool, sets, from, to);
+    double secs = now_s() - t;
+    const char *verdict = "skipped";
+    if (check) {
+        work_pool one(1);
+        bool ok = same(res, replay_alerts(*store, pool, sets, from, to, false)) &&
+                  same(res, replay_alerts(*store, one, sets, from, to));
+        verdict = ok ? "ok" : "MISMATCH";
+    }
+
+    if (json) {
+        printf("{\"devices\": %u, \"readings\": %llu, \"decoded\": %llu, \"store_bytes\": %llu, \"threads\": %d, "
+               "\"build_s\": %.2f, \"replay_s\": %.3f, \"readings_per_s\": %.0f, \"check\": \"%s\", \"rule_sets\": [",
+               res.devices, (unsigned long long)res.readings, (unsigned long long)res.decoded,
+               (unsigned long long)st.bytes, pool.threads(), build_s, secs, res.readings / secs, verdict);
+        for (size_t k = 0; k < sets.size(); k++) {
+            const alert_tally &a = res.sets[k];
+            printf("%s{\"rules\": \"%s\", \"sms\": %llu, \"devices\": %u, \"cold_warnings\": %llu, "
+                   "\"cold_alerts\": %llu, \"hot_warnings\": %llu, \"hot_alerts\": %llu}",
+                   k ? ", " : "", format_alert_rules(sets[k]).c_str(), (unsigned long long)a.sms, a.devices,
+                   (unsigned long long)a.kinds[ALERT_COLD_WARNING], (unsigned long long)a.kinds[ALERT_COLD_ALERT],
+                   (unsigned long long)a.kinds[ALERT_HOT_WARNING], (unsigned long long)a.kinds[ALERT_HOT_ALERT]);
+        }
+        printf("]}\n");
+    } else {
+        if (synth_devices > 0)
+            printf("built %d devices x %d days at %d s in %.1f s (%.1f MB)\n", synth_devices, synth_days, interval_s,
+                   build_s, st.bytes / 1e6);
+        printf("%u devices, %llu readings (%llu decoded) replayed in %.3f s on %d threads: %.0f readings/s\n",
+               res.devices, (unsigned long long)res.readings, (unsigned long long)res.decoded, secs, pool.threads(),
+               res.readings / secs);
+        printf("%-28s %8s %8s %10s %10s %10s %10s\n", "rules", "sms", "devices", "cold_warn", "cold_alert",
+               "hot_warn", "hot_alert");
+        for (size_t k = 0; k < sets.size(); k++) {
+            const alert_tally &a = res.sets[k];
+            printf("%-28s %8llu %8u %10llu %10llu %10llu %10llu\n", format_alert_rules(sets[k]).c_str(),
+                   (unsigned long long)a.sms, a.devices, (unsigned long long)a.kinds[ALERT_COLD_WARNING],
+                   (unsigned long long)a.kinds[ALERT_COLD_ALERT], (unsigned long long)a.kinds[ALERT_HOT_WARNING],
+                   (unsigned long long)a.kinds[ALERT_HOT_ALERT]);
+        }
+        if (check) printf("check: %s\n", verdict);
+    }
+    store.reset();
+    if (temp) remove_dir(data);
+    return strcmp(verdict, "MISMATCH") == 0 ? 1 : 0;
+}
@@ -0,0 +1,366 @@
+/*
+ * Collector load generator (host tool).
+ * Plays a fleet of virtual units pushing 1 Hz-style readings at the
+ * collector in the firmware's formats and checks that every one was stored.
+ *
+ *   collector_loadgen [--host H] [--http-port P] [--udp-port P] [--mode udp|http]
+ *                     [--devices N] [--first-device ID] [--threads T] [--rate R]
+ *                     [--batch B] [--duration S] [--json]
+ *
+ * Modes:
+ *   udp   each thread owns a slice of the devices and sends one 24-byte
+ *         reading datagram per device per round with sendmmsg(); acks coming
+ *         back are counted, nothing is resent (depth 0: "no history")
+ *   http  each thread keeps one keep-alive connection and POSTs
+ *         /ingest?device=N with a reading batch of --batch readings per
+ *         request, round-robin over its devices; a 503 is retried
+ *
+ * --rate is readings per second over all threads (0 = as fast as possible).
+ * The collector's "stored" counter is read from GET /stats before and after
+ * (once it stops moving), so "lost" = sent - newly stored.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "wire.h"
+
+using namespace collector;
+
+struct config {
+    sockaddr_in http{}, udp{};
+    bool     http_mode = false;
+    int      devices = 1000;
+    int      first_device = 1000;
+    int      threads = 1;
+    double   rate = 0;                // readings/s, 0 = unthrottled
+    int      batch = 10;
+    double   duration_s = 10;
+};
+
+struct client {
+    const config *cfg;
+    int      index;
+    int      dev_lo, dev_hi;          // [lo, hi)
+    uint64_t sent = 0;                // readings the collector accepted (UDP: handed to the kernel)
+    uint64_t requests = 0, busy = 0, errors = 0, acks = 0;
+};
+
+static double now_s()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t wall_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+static reading_t fake_reading(uint32_t seq, int64_t unix_ms, int device)
+{
+    reading_t r{};
+    r.unix_ms = unix_ms;
+    r.seq = seq;
+    r.t_cC = (int16_t)(2150 + (device % 200) - 100 + (int)(seq % 50));
+    r.h_cRH = (uint16_t)(4500 + (seq % 300));
+    r.p_dPa = 1013250 + (seq % 100);
+    return r;
+}
+
+// Sleep until this thread is back on its share of --rate.
+static void pace(const config &cfg, double t0, uint64_t done)
+{
+    if (cfg.rate <= 0) return;
+    double due = t0 + done / (cfg.rate / cfg.threads);
+    double wait = due - now_s();
+    if (wait > 0) std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+}
+
+static void udp_client(client &c)
+{
+    const config &cfg = *c.cfg;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int sndbuf = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&cfg.udp), sizeof cfg.udp) < 0) {
+        perror("loadgen: udp connect");
+        close(fd);
+        return;
+    }
+    int n_dev = c.dev_hi - c.dev_lo;
+    std::vector<uint32_t> seq((size_t)n_dev, 0);
+    std::vector<uint16_t> epoch((size_t)n_dev);
+    for (int i = 0; i < n_dev; i++) epoch[(size_t)i] = (uint16_t)(rand() ^ (c.index << 8) ^ i);
+
+    constexpr int BATCH = 64;
+    uint8_t pkts[BATCH][UDPT_READING_LEN];
+    iovec iov[BATCH];
+    mmsghdr msgs[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        iov[i] = { pkts[i], UDPT_READING_LEN };
+        msgs[i].msg_hdr = msghdr{};
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    uint8_t ack[udpt_ack_len(UDPT_ACK_RANGES_MAX)];
+    double t0 = now_s(), t_end = t0 + cfg.duration_s;
+    int dev = 0;
+    while (now_s() < t_end) {
+        int64_t ms = wall_ms();
+        int n = 0;
+        for (; n < BATCH; n++, dev = (dev + 1) % n_dev) {
+            udp_reading u;
+            u.device = (uint16_t)(c.dev_lo + dev);
+            u.epoch = epoch[(size_t)dev];
+            u.depth = 0;
+            u.type = UDPT_READING;
+            u.r = fake_reading(seq[(size_t)dev]++, ms, u.device);
+            encode_udp_reading(u, pkts[n]);
+        }
+        int sent = sendmmsg(fd, msgs, (unsigned)n, 0);
+        if (sent > 0) c.sent += (uint64_t)sent;
+        for (int k = sent < 0 ? 0 : sent; k < n; k++) {   // socket buffer full: take the unsent tail back
+            dev = (dev + n_dev - 1) % n_dev;
+            seq[(size_t)dev]--;
+        }
+        while (recv(fd, ack, sizeof ack, MSG_DONTWAIT) > 0) c.acks++;
+        pace(cfg, t0, c.sent);
+    }
+    close(fd);
+}
+
+static int open_tcp(const sockaddr_in &sa)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&sa), sizeof sa) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const void *p, size_t n)
+{
+    const char *b = static_cast<const char *>(p);
+    while (n) {
+        ssize_t w = send(fd, b, n, MSG_NOSIGNAL);
+        if (w <= 0) return false;
+        b += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+// Read one response (status line + Content-Length body). Returns the status, -1 on a closed socket.
+static int read_response(int fd, std::string &buf, std::string *body)
+{
+    for (;;) {
+        size_t end = buf.find("\r\n\r\n");
+        if (end != std::string::npos) {
+            int status = 0;
+            sscanf(buf.c_str(), "HTTP/1.%*d %d", &status);
+            size_t len = 0;
+            const char *cl = strcasestr(buf.c_str(), "content-length:");
+            if (cl && cl < buf.c_str() + end) len = strtoul(cl + 15, nullptr, 10);
+            if (buf.size() >= end + 4 + len) {
+                if (body) body->assign(buf, end + 4, len);
+                buf.erase(0, end + 4 + len);
+                return status;
+            }
+        }
+        char tmp[4096];
+        ssize_t r = recv(fd, tmp, sizeof tmp, 0);
+        if (r <= 0) return -1;
+        buf.append(tmp, (size_t)r);
+    }
+}
+
+static void http_client(client &c)
+{
+    const config &cfg = *c.cfg;
+    int n_dev = c.dev_hi - c.dev_lo;
+    std::vector<uint32_t> seq((size_t)n_dev, 0);
+    std::vector<reading_t> rs((size_t)cfg.batch);
+    std::vector<uint8_t> body(reading_batch_size((size_t)cfg.batch));
+    std::string in;
+    int fd = -1;
+    double t0 = now_s(), t_end = t0 + cfg.duration_s;
+    int dev = 0;
+    while (now_s() < t_end) {
+        if (fd < 0 && (fd = open_tcp(cfg.http)) < 0) {
+            c.errors++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        int device = c.dev_lo + dev;
+        int64_t ms = wall_ms() - cfg.batch * 1000LL;
+        for (int i = 0; i < cfg.batch; i++) rs[(size_t)i] = fake_reading(seq[(size_t)dev] + (uint32_t)i, ms + i * 1000LL, device);
+        size_t used = 0;
+        size_t len = reading_batch_encode(rs.data(), rs.size(), body.data(), body.size(), &used);
+        char head[160];
+        int hn = snprintf(head, sizeof head,
+                          "POST /ingest?device=%d HTTP/1.1\r\nHost: collector\r\n"
+                          "Content-Type: application/octet-stream\r\nContent-Length: %zu\r\n\r\n",
+                          device, len);
+        int status = -1;
+        if (send_all(fd, head, (size_t)hn) && send_all(fd, body.data(), len)) status = read_response(fd, in, nullptr);
+        if (status < 0) {                                 // connection lost: reconnect and resend the batch
+            close(fd);
+            fd = -1;
+            in.clear();
+            c.errors++;
+            continue;
+        }
+        c.requests++;
+        if (status == 204) {
+            c.sent += used;
+            seq[(size_t)dev] += (uint32_t)used;
+            dev = (dev + 1) % n_dev;
+        } else if (status == 503) {
+            c.busy++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } else {
+            c.errors++;
+            dev = (dev + 1) % n_dev;
+        }
+        pace(cfg, t0, c.sent);
+    }
+    if (fd >= 0) close(fd);
+}
+
+// The collector's "stored" counter, -1 if GET /stats fails.
+static long long stored_count(const sockaddr_in &http)
+{
+    int fd = open_tcp(http);
+    if (fd < 0) return -1;
+    static const char req[] = "GET /stats HTTP/1.1\r\nHost: collector\r\nConnection: close\r\n\r\n";
+    std::string in, body;
+    long long v = -1;
+    if (send_all(fd, req, sizeof req - 1) && read_response(fd, in, &body) == 200) {
+        const char *p = strstr(body.c_str(), "\"stored\":");
+        if (p) v = atoll(p + 9);
+    }
+    close(fd);
+    return v;
+}
+
+static bool resolve(const char *host, int port, sockaddr_in &out)
+{
+    addrinfo hints{}, *ai = nullptr;
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(host, nullptr, &hints, &ai) != 0 || !ai) return false;
+    out = *reinterpret_cast<sockaddr_in *>(ai->ai_addr);
+    out.sin_port = htons((uint16_t)port);
+    freeaddrinfo(ai);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    config cfg;
+    const char *host = "127.0.0.1", *mode = "udp";
+    int http_port = 8090, udp_port = 8091;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)              host = argv[++i];
+        else if (strcmp(argv[i], "--http-port") == 0 && i + 1 < argc)    http_port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--udp-port") == 0 && i + 1 < argc)     udp_port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)         mode = argv[++i];
+        else if (strcmp(argv[i], "--devices") == 0 && i + 1 < argc)      cfg.devices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--first-device") == 0 && i + 1 < argc) cfg.first_device = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)      cfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)         cfg.rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)        cfg.batch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc)     cfg.duration_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0)                         json = true;
+        else {
+            fprintf(stderr, "usage: %s [--host H] [--http-port P] [--udp-port P] [--mode udp|http]\n"
+                            "       [--devices N] [--first-device ID] [--threads T] [--rate R]\n"
+                            "       [--batch B] [--duration S] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (strcmp(mode, "http") == 0) cfg.http_mode = true;
+    else if (strcmp(mode, "udp") != 0) { fprintf(stderr, "unknown mode %s\n", mode); return 2; }
+    if (cfg.threads < 1) cfg.threads = 1;
+    if (cfg.devices < cfg.threads) cfg.devices = cfg.threads;
+    if (cfg.batch < 1 || cfg.batch > READING_BATCH_MAX) { fprintf(stderr, "--batch is 1..%d\n", READING_BATCH_MAX); return 2; }
+    if (cfg.first_device < 0 || cfg.first_device + cfg.devices > 0x10000) {
+        fprintf(stderr, "device ids must fit in 0..65535\n");
+        return 2;
+    }
+    if (!resolve(host, http_port, cfg.http) || !resolve(host, udp_port, cfg.udp)) {
+        fprintf(stderr, "cannot resolve %s\n", host);
+        return 2;
+    }
+
+    long long stored0 = stored_count(cfg.http);
+    std::vector<client> cl((size_t)cfg.threads);
+    std::vector<std::thread> th;
+    for (int i = 0; i < cfg.threads; i++) {
+        client &c = cl[(size_t)i];
+        c.cfg = &cfg;
+        c.index = i;
+        c.dev_lo = cfg.first_device + (int)((long long)cfg.devices * i / cfg.threads);
+        c.dev_hi = cfg.first_device + (int)((long long)cfg.devices * (i + 1) / cfg.threads);
+    }
+    double t_start = now_s();
+    for (auto &c : cl) th.emplace_back(cfg.http_mode ? http_client : udp_client, std::ref(c));
+    for (auto &t : th) t.join();
+    double elapsed = now_s() - t_start;
+
+    client sum{};
+    for (auto &c : cl) {
+        sum.sent += c.sent;
+        sum.requests += c.requests;
+        sum.busy += c.busy;
+        sum.errors += c.errors;
+        sum.acks += c.acks;
+    }
+    // wait for the sink to catch up: "stored" unchanged for 300 ms (at most 5 s)
+    long long stored1 = stored_count(cfg.http);
+    for (int i = 0; i < 50 && stored1 >= 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        long long s = stored_count(cfg.http);
+        if (s == stored1 && stored1 - stored0 >= (long long)sum.sent) break;
+        if (s == stored1 && i >= 3) break;
+        stored1 = s;
+    }
+    long long stored = stored0 >= 0 && stored1 >= 0 ? stored1 - stored0 : -1;
+    long long lost = stored >= 0 ? (long long)sum.sent - stored : -1;
+    double rate = sum.sent / elapsed, stored_rate = stored >= 0 ? stored / elapsed : 0;
+
+    if (json) {
+        printf("{\"mode\": \"%s\", \"devices\": %d, \"threads\": %d, \"batch\": %d, \"duration_s\": %.2f, "
+               "\"sent\": %llu, \"stored\": %lld, \"lost\": %lld, \"sent_per_s\": %.0f, \"stored_per_s\": %.0f, "
+               "\"requests\": %llu, \"busy\": %llu, \"errors\": %llu, \"acks\": %llu}\n",
+               mode, cfg.devices, cfg.threads, cfg.http_mode ? cfg.batch : 1, elapsed,
+               (unsigned long long)sum.sent, stored, lost, rate, stored_rate, (unsigned long long)sum.requests,
+               (unsigned long long)sum.busy, (unsigned long long)sum.errors, (unsigned long long)sum.acks);
+    } else {
+        printf("mode %-4s devices=%d threads=%d  %.1f s\n", mode, cfg.devices, cfg.threads, elapsed);
+        printf("  sent %llu readings  %.0f/s\n", (unsigned long long)sum.sent, rate);
+        printf("  stored %lld  %.0f/s  lost %lld\n", stored, stored_rate, lost);
+        if (cfg.http_mode)
+            printf("  requests %llu (batch %d)  busy %llu  errors %llu\n", (unsigned long long)sum.requests,
+                   cfg.batch, (unsigned long long)sum.busy, (unsigned long long)sum.errors);
+        else
+            printf("  acks %llu\n", (unsigned long long)sum.acks);
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * Fleet query benchmark (host tool).
+ * Fills a time-series store with a synthetic fleet, runs the fleet
+ * queries (src/query.h) in every variant at several pool sizes, and checks
+ * each answer against the ground truth the generator knows.
+ *
+ *   query_bench [--devices N] [--days D] [--interval-s S] [--threads 1,2,4]
+ *               [--reps R] [--data DIR] [--json]
+ *
+ * Data: every unit follows its own daily temperature curve between about
+ * 17 and 27 °C. Every tenth unit overheats once a day, flat at 30 °C, for
+ * 15 to 40 minutes; every tenth unit offset by five does so for only 5
+ * minutes. So "above 28.5 °C for 10 minutes" must find exactly the first
+ * group, with one episode per day each.
+ *
+ * Queries (each timed as the median of --reps runs):
+ *   agg_full    fleet min/max/mean of T over everything (summaries only)
+ *   agg_cut     the same over a range cut mid-block at both ends
+ *   threshold   the question above
+ * in the variants prune/noprune (block summaries on/off) x simd/scalar.
+ *
+ * --data keeps the store in DIR (default: a temporary directory, removed
+ * afterwards). Exits 1 if any answer is wrong.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include "query.h"
+
+using namespace collector;
+
+static constexpr int64_t T0_MS = 1767225600000;   // 2026-01-01T00:00:00Z
+static constexpr int64_t DAY_MS = 86400000;
+static constexpr float   HOT_C = 30.0f;
+static constexpr float   THRESHOLD_C = 28.5f;
+static constexpr int64_t FOR_MS = 10 * 60000;
+
+struct config {
+    int      devices = 1000;
+    int      days = 1;
+    int      interval_s = 1;
+    int      reps = 5;
+    std::vector<int> threads;
+};
+
+static double now_s()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// One overheating event of a device on a day, in readings from the day's start.
+struct event {
+    int64_t start, len;
+};
+
+static event hot_event(const config &cfg, int device, int day)
+{
+    int64_t per_day = DAY_MS / 1000 / cfg.interval_s;
+    uint32_t h = mix((uint32_t)(device * 131 + day));
+    int64_t minutes = device % 10 == 0 ? 15 + h % 26 : device % 10 == 5 ? 5 : 0;
+    int64_t len = minutes * 60 / cfg.interval_s + 1;                // minutes from first to last reading
+    int64_t start = per_day / 24 + (int64_t)(h >> 8) % (per_day * 20 / 24);   // 01:00 .. 21:00
+    return event{ start, minutes ? len : 0 };
+}
+
+static reading_t synth(const config &cfg, int device, int64_t i)
+{
+    int64_t per_day = DAY_MS / 1000 / cfg.interval_s;
+    int day = (int)(i / per_day);
+    int64_t k = i % per_day;
+    double phase = (mix((uint32_t)device) % 628) / 100.0;
+    double offset = (int)(mix((uint32_t)device + 7) % 401 - 200) / 100.0;       // +-2 °C
+    double noise = (int)(mix((uint32_t)(device * 977 + i)) % 41 - 20) / 100.0;  // +-0.2 °C
+    double t = 22.0 + offset + 2.5 * sin(2 * M_PI * (double)k / (double)per_day + phase) + noise;
+    event e = hot_event(cfg, device, day);
+    if (k >= e.start && k < e.start + e.len) t = HOT_C;
+    reading_t r{};
+    r.unix_ms = T0_MS + i * cfg.interval_s * 1000;
+    r.t_cC = (int16_t)lrint(t * 100);
+    r.h_cRH = (uint16_t)(4500 + 800 * sin(2 * M_PI * (double)k / (double)per_day + phase + 1));
+    r.p_dPa = (uint32_t)(1013250 + (int)(mix((uint32_t)(device + i)) % 200));
+    return r;
+}
+
+struct truth {
+    ts_agg full, cut;
+    std::vector<threshold_hit> hits;
+};
+
+static bool same_agg(const fleet_agg &a, const ts_agg &want)
+{
+    double scale = ts_scale(TS_T);
+    return a.total.count == want.count && fabs(a.total.min - want.min * scale) < 0.006 &&
+           fabs(a.total.max - want.max * scale) < 0.006 && fabs(a.total.mean() - want.mean() * scale) < 1e-3;
+}
+
+static bool same_hits(const std::vector<threshold_hit> &a, const std::vector<threshold_hit> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a[i].device != b[i].device || a[i].episodes != b[i].episodes || a[i].longest_ms != b[i].longest_ms ||
+            a[i].first_start_ms != b[i].first_start_ms || a[i].total_ms != b[i].total_ms)
+            return false;
+    return true;
+}
+
+static void remove_dir(const std::string &dir)
+{
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *e = readdir(d))
+            if (e->d_name[0] != '.') unlink((dir + "/" + e->d_name).c_str());
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    config cfg;
+    std::string data;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--devices") == 0 && i + 1 < argc)         cfg.devices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc)       cfg.days = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--interval-s") == 0 && i + 1 < argc) cfg.interval_s = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)       cfg.reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc)       data = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            for (char *p = argv[++i]; *p;) {
+                cfg.threads.push_back((int)strtol(p, &p, 10));
+                if (*p == ',') p++;
+                else if (*p) break;
+            }
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else {
+            fprintf(stderr, "usage: %s [--devices N] [--days D] [--interval-s S] [--threads 1,2,4]\n"
+                            "       [--reps R] [--data DIR] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.devices < 1 || cfg.devices > 0xFFFF || cfg.days < 1 || cfg.interval_s < 1 || cfg.interval_s > 60 ||
+        cfg.reps < 1) {
+        fprintf(stderr, "need 1..65535 devices, days >= 1, interval 1..60 s, reps >= 1\n");
+        return 2;
+    }
+    if (cfg.threads.empty()) {
+        cfg.threads.push_back(1);
+        int n = (int)std::thread::hardware_concurrency();
+        if (n > 1) cfg.threads.push_back(n);
+    }
+    for (int t : cfg.threads)
+        if (t < 1) {
+            fprintf(stderr, "--threads takes a list of counts >= 1\n");
+            return 2;
+        }
+    bool temp = data.empty();
+    if (temp) {
+        char tmpl[] = "/tmp/query_bench.XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        data = tmpl;
+    }
+
+    // build the store, keeping score of the answers on the way
+    int64_t per_day = DAY_MS / 1000 / cfg.interval_s, rows = per_day * cfg.days;
+    int64_t end_ms = T0_MS + rows * cfg.interval_s * 1000;
+    int64_t cut_from = T0_MS + 3600000 + 17000, cut_to = end_ms - 3 * 3600000 - 5000;
+    truth want;
+    double t_build = now_s();
+    auto store = std::make_unique<ts_store>(data);
+    if (!store->open()) return 1;
+    if (store->stats().rows) {
+        fprintf(stderr, "%s already holds a store; point --data at an empty directory\n", data.c_str());
+        return 2;
+    }
+    for (int d = 0; d < cfg.devices; d++) {
+        for (int64_t i = 0; i < rows; i++) {
+            reading_t r = synth(cfg, d, i);
+            store->append((uint16_t)d, r);
+            want.full.add(r.t_cC);
+            if (r.unix_ms >= cut_from && r.unix_ms < cut_to) want.cut.add(r.t_cC);
+        }
+        if (d % 10 != 0) continue;
+        threshold_hit h{ (uint16_t)d, 0, 0, 0, 0 };
+        for (int day = 0; day < cfg.days; day++) {
+            event e = hot_event(cfg, d, day);
+            int64_t dur = (e.len - 1) * cfg.interval_s * 1000;
+            if (!h.episodes++) h.first_start_ms = T0_MS + (day * per_day + e.start) * cfg.interval_s * 1000;
+            h.longest_ms = std::max(h.longest_ms, dur);
+            h.total_ms += dur;
+        }
+        want.hits.push_back(h);
+    }
+    store->seal_all();
+    t_build = now_s() - t_build;
+    ts_store_stats st = store->stats();
+
+    threshold_query tq;
+    tq.ch = TS_T;
+    tq.above = true;
+    tq.threshold = THRESHOLD_C;
+    tq.min_duration_ms = FOR_MS;
+
+    struct result {
+        const char *query, *variant;
+        int         threads;
+        double      ms;
+        uint64_t    steals;
+        bool        ok;
+    };
+    std::vector<result> results;
+    static const struct { const char *name; query_options opt; } VARIANTS[] = {
+        { "prune+simd", { true, true } },
+        { "prune+scalar", { true, false } },
+        { "noprune+simd", { false, true } },
+        { "noprune+scalar", { false, false } },
+    };
+    bool all_ok = true;
+    for (int threads : cfg.threads) {
+        work_pool pool(threads);
+        query_engine q(*store, pool);
+        for (const auto &v : VARIANTS) {
+            for (const char *name : { "agg_full", "agg_cut", "threshold" }) {
+                std::vector<double> ms;
+                uint64_t steals0 = pool.steals();
+                bool ok = true;
+                for (int rep = 0; rep < cfg.reps; rep++) {
+                    double t = now_s();
+                    if (!strcmp(name, "threshold")) {
+                        std::vector<threshold_hit> hits = q.threshold(tq, v.opt);
+                        ms.push_back((now_s() - t) * 1e3);
+                        ok = ok && same_hits(hits, want.hits);
+                    } else {
+                        bool full = !strcmp(name, "agg_full");
+                        fleet_agg a = q.aggregate(TS_T, full ? 0 : cut_from, full ? INT64_MAX : cut_to, v.opt);
+                        ms.push_back((now_s() - t) * 1e3);
+                        ok = ok && same_agg(a, full ? want.full : want.cut);
+                    }
+                }
+                std::sort(ms.begin(), ms.end());
+                results.push_back(result{ name, v.name, threads, ms[ms.size() / 2], pool.steals() - steals0, ok });
+                all_ok = all_ok && ok;
+            }
+        }
+    }
+
+    if (json) {
+        printf("{\"devices\": %d, \"days\": %d, \"interval_s\": %d, \"rows\": %llu, \"store_bytes\": %llu, "
+               "\"blocks\": %llu, \"build_s\": %.2f, \"ok\": %s, \"results\": [",
+               cfg.devices, cfg.days, cfg.interval_s, (unsigned long long)st.rows, (unsigned long long)st.bytes,
+               (unsigned long long)st.blocks, t_build, all_ok ? "true" : "false");
+        for (size_t i = 0; i < results.size(); i++) {
+            const result &r = results[i];
+            printf("%s{\"query\": \"%s\", \"variant\": \"%s\", \"threads\": %d, \"ms\": %.3f, "
+                   "\"rows_per_s\": %.0f, \"steals\": %llu, \"ok\": %s}",
+                   i ? ", " : "", r.query, r.variant, r.threads, r.ms, st.rows / (r.ms / 1e3),
+                   (unsigned long long)r.steals, r.ok ? "true" : "false");
+        }
+        printf("]}\n");
+    } else {
+        printf("%d devices x %d days at %d s: %llu readings, %llu blocks, %.1f MB, built in %.1f s\n", cfg.devices,
+               cfg.days, cfg.interval_s, (unsigned long long)st.rows, (unsigned long long)st.blocks, st.bytes / 1e6,
+               t_build);
+        printf("%-10s %-15s %7s %10s %14s %8s\n", "query", "variant", "threads", "ms", "readings/s", "steals");
+        for (const result &r : results)
+            printf("%-10s %-15s %7d %10.3f %14.0f %8llu%s\n", r.query, r.variant, r.threads, r.ms,
+                   st.rows / (r.ms / 1e3), (unsigned long long)r.steals, r.ok ? "" : "  WRONG");
+        printf("%s\n", all_ok ? "all answers match" : "WRONG ANSWERS");
+    }
+    store.reset();
+    if (temp) remove_dir(data);
+    return all_ok ? 0 : 1;
+}
@@ -1,7 +1,8 @@
 /*
  * Temperature alert evaluation (implementation).
- * - Evaluates °C readings against warn/alert thresholds.
- * - Enforces cooldowns with esp_timer one-shot timers (30m warn, 60m alert).
+ * - Evaluates °C readings against warn/alert thresholds (alert_rules.c).
+ * - Enforces cooldowns as esp_timer deadlines (30m warn, 60m alert, 60m
+ *   forecast, 60m stuck sensor).
  * - Sends SMS via sms_send_alert() when conditions are met.
  * Author: Wael Hamid  |  Date: 2025-08-18
  */
@@ -12,150 +13,121 @@
 #include "esp_err.h"
 #include "sdkconfig.h"
 #include <stdbool.h> 
+#include <math.h>
 #include "esp_timer.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 
-// -----------------------------------------------------------------------------
-// Duration helpers
-// esp_timer APIs accept time values in microseconds (µs). Use 64-bit constants
-// (ULL) to avoid overflow during compile-time arithmetic.
-// -----------------------------------------------------------------------------
-#define THIRTY_MIN_US  (30ULL * 60ULL * 1000000ULL)   // 30 min (1,800,000,000 µs)
-#define ONE_HOUR_US    (60ULL * 60ULL * 1000000ULL)   // 60 min (3,600,000,000 µs)
+// The device's rule set and cooldown state. The forecast's 60-minute
+// cooldown is a deadline on the same clock.
+static const alert_rules_t s_rules = ALERT_RULES_DEFAULT;
+static alert_state_t s_state;
+#if CONFIG_APP_ALERT_FORECAST_MIN > 0
+static int64_t s_forecast_until_us;
+#endif
+static bool    s_stuck;               // in a stuck episode (already warned, or within the cooldown)
+static int64_t s_stuck_until_us;
 
-// -----------------------------------------------------------------------------
-// Cooldown flags
-// 0 = alert allowed (no cooldown active)
-// 1 = alert suppressed (cooldown active)
-// A: 30-minute cooldown (warnings)
-// B: 60-minute cooldown (alerts)
-// -----------------------------------------------------------------------------
-static volatile bool a_tick = 0;
-static volatile bool b_tick = 0;
+// Application-specific stub: send an SMS. Replace with your real function.
+extern esp_err_t sms_send_alert(const char *msg);
 
-// Timer handles are opaque references returned by esp_timer_create() and
-// required to start/stop/delete timers.
-static esp_timer_handle_t a_handle = NULL;  // 30-minute cooldown timer
-static esp_timer_handle_t b_handle = NULL;  // 60-minute cooldown timer
+// Forecasts need a clear, real trend: a fit this good and at least this steep
+#define FORECAST_MIN_R2       0.6f
+#define FORECAST_MIN_C_PER_H  0.5f
 
 /**
- * @brief Cooldown expiry for warnings (30 minutes).
+ * @brief Evaluate temperature and send SMS subject to cooldowns.
+ *
+ * Sends warnings when Cold < T_C <= Cold_Warn or Hot_Warn <= T_C < Hot
+ * (30-minute cooldown). Sends alerts when T_C <= Cold or T_C >= Hot
+ * (60-minute cooldown). The decision is alert_rules_step() with
+ * ALERT_RULES_DEFAULT, the rule set the collector replays history against.
  *
- * Timer A callback: clears the warning cooldown flag to re-enable warnings.
+ * @param[in] T_C Temperature in degrees Celsius.
  *
- * @param arg Unused.
+ * @return ESP_OK if no send was needed or after a successful send;
+ *         error code from sms_send_alert() on failure.
  */
+esp_err_t sms_eval_alert(double T_C) {
+    if (T_C > alert_rules_quiet_lo(&s_rules) && T_C < alert_rules_quiet_hi(&s_rules)) {
+        return ESP_OK;                       // in range: not even the clock is needed
+    }
+    alert_kind_t kind = alert_rules_step(&s_rules, &s_state, T_C, esp_timer_get_time());
+    if (kind == ALERT_NONE) return ESP_OK;   // suppressed by cooldown
 
-static void callback_timer_A(void *arg) { a_tick = 0; }  // Re-enable warnings
+    char msg[120];
+    alert_rules_message(&s_rules, kind, T_C, msg, sizeof msg);
+    return sms_send_alert(msg);
+}
 
 /**
- * @brief Cooldown expiry for alerts (60 minutes).
+ * @brief Warn before the temperature reaches an alert threshold.
  *
- * Timer B callback: clears the alert cooldown flag to re-enable alerts.
+ * Sends one forecast when the fitted line is below Hot (above Cold), heading
+ * towards it at >= FORECAST_MIN_C_PER_H with r² >= FORECAST_MIN_R2, and is
+ * projected to cross within CONFIG_APP_ALERT_FORECAST_MIN minutes. Skipped
+ * while an alert's 60-minute cooldown runs (the alert already went out), and
+ * when the room's heat balance (fusion.h) says the threshold lies beyond the
+ * temperature it is settling at, or is not reached within twice the horizon.
  *
- * @param arg Unused.
- */
-static void callback_timer_B(void *arg) { b_tick = 0; }  // Re-enable alerts
-
-/**
- * @brief Create one-shot cooldown timers.
+ * @param[in] tr Current fit from trend_get().
+ * @param[in] fu Current fusion estimate, or NULL.
  *
- * Initializes Timer A (30m) and Timer B (60m) with task-dispatched callbacks.
- * Safe to call once before first use.
+ * @return ESP_OK if no send was needed or after a successful send;
+ *         error code from sms_send_alert() on failure.
  */
-static void timers_init(void) {
-    const esp_timer_create_args_t a_args = {
-        .callback = &callback_timer_A,
-        .arg = NULL,
-        .dispatch_method = ESP_TIMER_TASK,  // Task context: safer API surface
-        .name = "TimerA_30min"
-    };
-    const esp_timer_create_args_t b_args = {
-        .callback = &callback_timer_B,
-        .arg = NULL,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "TimerB_60min"
-    };
+esp_err_t sms_eval_forecast(const trend_t *tr, const fusion_t *fu) {
+#if CONFIG_APP_ALERT_FORECAST_MIN > 0
+    int64_t now_us = esp_timer_get_time();
+    if (now_us < s_forecast_until_us || now_us < s_state.alert_until_us) return ESP_OK;
+    if (tr->r2_T < FORECAST_MIN_R2 || fabsf(tr->dT_per_h) < FORECAST_MIN_C_PER_H) return ESP_OK;
+
+    const bool rising = tr->dT_per_h > 0;
+    const float limit = rising ? ALERT_HIGH_C : ALERT_LOW_C;
+    if (rising ? tr->T_C >= limit : tr->T_C <= limit) return ESP_OK;   // sms_eval_alert's case
+    float eta_s = trend_eta_s(tr->T_C, tr->dT_per_h, limit);
+    if (!(eta_s <= CONFIG_APP_ALERT_FORECAST_MIN * 60.0f)) return ESP_OK;
+    if (fu && !isnan(fu->T_eq_C) && !(fusion_eta_s(fu, limit) <= 2 * CONFIG_APP_ALERT_FORECAST_MIN * 60.0f)) {
+        return ESP_OK;                   // the line overshoots where the room levels off
+    }
 
-    ESP_ERROR_CHECK(esp_timer_create(&a_args, &a_handle));
-    ESP_ERROR_CHECK(esp_timer_create(&b_args, &b_handle));
+    char msg[120];
+    snprintf(msg, sizeof msg, "%s Forecast: Inside temperature %.1fC %s %.1fC/h, expected %s %.1fC in ~%.0f min.",
+             rising ? "Hot" : "Cold", tr->T_C, rising ? "rising" : "falling", fabsf(tr->dT_per_h),
+             rising ? "above" : "below", limit, ceilf(eta_s / 60.0f));
+    s_forecast_until_us = now_us + ALERT_ALERT_COOLDOWN_US;  // Enter 60-minute cooldown for forecasts
+    return sms_send_alert(msg);
+#else
+    (void)tr;
+    (void)fu;
+    return ESP_OK;
+#endif
 }
 
-// Application-specific stub: send an SMS. Replace with your real function.
-extern esp_err_t sms_send_alert(const char *msg);
-
-// Thresholds 
-#define ALERT_LOW_C   15.0
-#define WARN_LOW_C    16.5
-#define WARN_HIGH_C   28.5
-#define ALERT_HIGH_C  30.0
-
 /**
- * @brief Evaluate temperature and send SMS subject to cooldowns.
+ * @brief Warn when the temperature sensor is stuck.
  *
- * Sends warnings when Cold < T_C <= Cold_Warn or Hot_Warn <= T_C < Hot
- * (30-minute cooldown). Sends alerts when T_C <= Cold or T_C >= Hot
- * (60-minute cooldown). Starts the appropriate one-shot timer after send.
+ * A frozen reading can sit in the comfortable band while the room is not,
+ * so the threshold checks go on and this sends its own warning: once when
+ * an episode starts, and not again within the 60-minute cooldown if the
+ * sensor recovers and sticks again.
  *
- * @param[in] T_C Temperature in degrees Celsius.
+ * @param[in] stuck The sample's temperature is flagged ANOM_STUCK.
+ * @param[in] T_C   The reading it is stuck at.
  *
  * @return ESP_OK if no send was needed or after a successful send;
- *         error code from sms_send_alert() or timer APIs on failure.
+ *         error code from sms_send_alert() on failure.
  */
-esp_err_t sms_eval_alert(double T_C) {
-
-    // Ensure timers are created before first use.
-    if (a_handle == NULL || b_handle == NULL) {
-        timers_init();
+esp_err_t sms_eval_stuck(bool stuck, double T_C) {
+    if (!stuck || s_stuck) {
+        s_stuck = stuck;
+        return ESP_OK;
     }
-
-    const double Cold = ALERT_LOW_C ;           // Low temp alert at 15.0 deg
-    const double Cold_Warn  = WARN_LOW_C ;     // Low temp warning 16.5 deg
-    const double Hot_Warn = WARN_HIGH_C;      // High Temp Warning 28.5
-    const double Hot  = ALERT_HIGH_C;        // High Temp Threshold 30.0 
+    s_stuck = true;
+    int64_t now_us = esp_timer_get_time();
+    if (now_us < s_stuck_until_us) return ESP_OK;
+    s_stuck_until_us = now_us + ALERT_ALERT_COOLDOWN_US;
 
     char msg[120];
-
-    // Cold warning: (Cold < T_C <= Cold_Warn) AND not on 30-min cooldown
-    if ((!a_tick) && (T_C > Cold) && (T_C <= Cold_Warn)) {
-        snprintf(msg, sizeof msg, "Cold Warning: Inside temperature %.1fC is below %.1fC.", T_C, Cold_Warn);
-        a_tick = 1;  // Enter 30-minute cooldown for warnings
-        ESP_ERROR_CHECK(esp_timer_start_once(a_handle, THIRTY_MIN_US));
-        return sms_send_alert(msg);
-    }
-
-    // Cold alert: (T_C <= Cold) AND not on 60-min cooldown
-    if ((!b_tick) && (T_C <= Cold)) {
-        snprintf(msg, sizeof msg, "Cold Alert: Inside temperature %.1fC is below %.1fC.", T_C, Cold);
-        b_tick = 1;  // Enter 60-minute cooldown for alerts
-        ESP_ERROR_CHECK(esp_timer_start_once(b_handle, ONE_HOUR_US));
-        return sms_send_alert(msg);
-    }
-
-    // Hot warning: (Hot_Warn <= T_C < Hot) AND not on 30-min cooldown
-    if ((!a_tick) && (T_C >= Hot_Warn) && (T_C < Hot)) {
-        snprintf(msg, sizeof msg, "Hot Warning: Inside temperature %.1fC is above %.1fC.", T_C, Hot_Warn);
-        a_tick = 1;  // Enter 30-minute cooldown for warnings
-        ESP_ERROR_CHECK(esp_timer_start_once(a_handle, THIRTY_MIN_US));
-        return sms_send_alert(msg);
-    }
-
-    // Hot alert: (T_C >= Hot) AND not on 60-min cooldown
-    if ((!b_tick) && (T_C >= Hot)) {
-        snprintf(msg, sizeof msg, "Hot Alert: Inside temperature %.1fC is above %.1fC.", T_C, Hot);
-        b_tick = 1;  // Enter 60-minute cooldown for alerts
-        ESP_ERROR_CHECK(esp_timer_start_once(b_handle, ONE_HOUR_US));
-        return sms_send_alert(msg);
-    }
-
-    // In-range or suppressed by cooldown: nothing to do.
-    return ESP_OK;
+    snprintf(msg, sizeof msg, "Sensor Warning: Inside temperature stuck at %.2fC for %d min; check the sensor.",
+             T_C, CONFIG_APP_ANOMALY_STUCK_S / 60);
+    return sms_send_alert(msg);
 }
-
-
-
-
-
-
-
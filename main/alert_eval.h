@@ -1,11 +1,25 @@
 /*
  * Temperature alert evaluation (public API).
  * - sms_eval_alert(): evaluates temperature against thresholds.
- * - Enforces 30-minute warning and 60-minute alert cooldowns via esp_timer.
+ * - Enforces 30-minute warning and 60-minute alert cooldowns on esp_timer time.
+ * - The thresholds, cooldowns and decision live in alert_rules.h, which
+ *   builds on any host; this file adds the clock and the SMS.
  * - Calls sms_send_alert() when a condition is triggered.
+ * - sms_eval_forecast(): warns ahead of time when the temperature trend
+ *   (trend.h) will reach an alert threshold within
+ *   CONFIG_APP_ALERT_FORECAST_MIN minutes (own 60-minute cooldown), unless
+ *   the room's heat balance (fusion.h) shows it levelling off short of it.
+ * - sms_eval_stuck(): warns once per episode when the temperature channel
+ *   is stuck (anomaly.h), since a frozen reading hides any real change.
  * Author: Wael Hamid  |  Date: 2025-08-18
  */
 
 #pragma once
 #include "esp_err.h"
-esp_err_t sms_eval_alert(double T_C);
\ No newline at end of file
+#include "trend.h"
+#include "fusion.h"
+#include "alert_rules.h"      // thresholds (ALERT_LOW_C ... ALERT_HIGH_C)
+
+esp_err_t sms_eval_alert(double T_C);
+esp_err_t sms_eval_forecast(const trend_t *tr, const fusion_t *fu);   // fu may be NULL
+esp_err_t sms_eval_stuck(bool stuck, double T_C);
@@ -0,0 +1,71 @@
+/*
+ * Alert rules (implementation).
+ * - A cooldown that the firmware used to run as an esp_timer one-shot is a
+ *   deadline here: "on cooldown" is now_us < until. Same behaviour, and a
+ *   replay can drive it with the readings' own timestamps.
+ */
+
+#include "alert_rules.h"
+#include <stdio.h>
+
+/**
+ * @brief Decide whether T_C warrants an SMS under rule set r.
+ *
+ * @param[in]     r      Thresholds and cooldowns.
+ * @param[in,out] st     Cooldown deadlines; only written when something is sent.
+ * @param[in]     T_C    Temperature in degrees Celsius.
+ * @param[in]     now_us Current time, µs.
+ *
+ * @return The kind to send, or ALERT_NONE (in range, or on cooldown).
+ */
+alert_kind_t alert_rules_step(const alert_rules_t *r, alert_state_t *st, double T_C, int64_t now_us)
+{
+    bool warn_ok = now_us >= st->warn_until_us;
+    bool alert_ok = now_us >= st->alert_until_us;
+
+    if (warn_ok && T_C > r->alert_low_C && T_C <= r->warn_low_C) {
+        st->warn_until_us = now_us + r->warn_cooldown_us;
+        return ALERT_COLD_WARNING;
+    }
+    if (alert_ok && T_C <= r->alert_low_C) {
+        st->alert_until_us = now_us + r->alert_cooldown_us;
+        return ALERT_COLD_ALERT;
+    }
+    if (warn_ok && T_C >= r->warn_high_C && T_C < r->alert_high_C) {
+        st->warn_until_us = now_us + r->warn_cooldown_us;
+        return ALERT_HOT_WARNING;
+    }
+    if (alert_ok && T_C >= r->alert_high_C) {
+        st->alert_until_us = now_us + r->alert_cooldown_us;
+        return ALERT_HOT_ALERT;
+    }
+    return ALERT_NONE;
+}
+
+int alert_rules_message(const alert_rules_t *r, alert_kind_t kind, double T_C, char *buf, size_t len)
+{
+    switch (kind) {
+    case ALERT_COLD_WARNING:
+        return snprintf(buf, len, "Cold Warning: Inside temperature %.1fC is below %.1fC.", T_C, r->warn_low_C);
+    case ALERT_COLD_ALERT:
+        return snprintf(buf, len, "Cold Alert: Inside temperature %.1fC is below %.1fC.", T_C, r->alert_low_C);
+    case ALERT_HOT_WARNING:
+        return snprintf(buf, len, "Hot Warning: Inside temperature %.1fC is above %.1fC.", T_C, r->warn_high_C);
+    case ALERT_HOT_ALERT:
+        return snprintf(buf, len, "Hot Alert: Inside temperature %.1fC is above %.1fC.", T_C, r->alert_high_C);
+    default:
+        if (len) buf[0] = '\0';
+        return 0;
+    }
+}
+
+// Every check needs T <= warn_low, T <= alert_low, T >= warn_high or T >= alert_high.
+double alert_rules_quiet_lo(const alert_rules_t *r)
+{
+    return r->warn_low_C > r->alert_low_C ? r->warn_low_C : r->alert_low_C;
+}
+
+double alert_rules_quiet_hi(const alert_rules_t *r)
+{
+    return r->warn_high_C < r->alert_high_C ? r->warn_high_C : r->alert_high_C;
+}
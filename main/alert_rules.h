@@ -0,0 +1,64 @@
+/*
+ * Alert rules (public API).
+ * - The decision behind sms_eval_alert() (alert_eval.h) as a pure
+ *   function of a rule set, a cooldown state and the time: no timers, no
+ *   RTOS, no I/O. The firmware runs it with ALERT_RULES_DEFAULT on
+ *   esp_timer time; the fleet collector replays stored history through
+ *   other rule sets with the same code to see how many SMS each would
+ *   have sent (collector/src/alert_replay.h).
+ * - Checks in this order, each only outside its cooldown:
+ *   cold warning  alert_low < T <= warn_low    (warning cooldown)
+ *   cold alert    T <= alert_low               (alert cooldown)
+ *   hot warning   warn_high <= T < alert_high  (warning cooldown)
+ *   hot alert     T >= alert_high              (alert cooldown)
+ *   Warnings and alerts each share one cooldown for both directions.
+ * - A step that sends nothing leaves the state untouched, so readings
+ *   strictly between the quiet band's edges (alert_rules_quiet_lo/hi) can
+ *   be skipped without changing any later decision.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Thresholds
+#define ALERT_LOW_C   15.0
+#define WARN_LOW_C    16.5
+#define WARN_HIGH_C   28.5
+#define ALERT_HIGH_C  30.0
+
+#define ALERT_WARN_COOLDOWN_US   (30LL * 60 * 1000000)
+#define ALERT_ALERT_COOLDOWN_US  (60LL * 60 * 1000000)
+
+typedef struct {
+    double  alert_low_C, warn_low_C, warn_high_C, alert_high_C;
+    int64_t warn_cooldown_us, alert_cooldown_us;
+} alert_rules_t;
+
+#define ALERT_RULES_DEFAULT \
+    { ALERT_LOW_C, WARN_LOW_C, WARN_HIGH_C, ALERT_HIGH_C, ALERT_WARN_COOLDOWN_US, ALERT_ALERT_COOLDOWN_US }
+
+typedef struct {
+    int64_t warn_until_us;            // cooldowns end here; zero-initialised = none running
+    int64_t alert_until_us;
+} alert_state_t;
+
+typedef enum {
+    ALERT_NONE = 0,
+    ALERT_COLD_WARNING,
+    ALERT_COLD_ALERT,
+    ALERT_HOT_WARNING,
+    ALERT_HOT_ALERT,
+    ALERT_KINDS
+} alert_kind_t;
+
+// What to send for T_C at now_us (any monotonic µs clock); starts the cooldown if anything.
+alert_kind_t alert_rules_step(const alert_rules_t *r, alert_state_t *st, double T_C, int64_t now_us);
+
+// The SMS text for a kind alert_rules_step() returned; length as snprintf().
+int alert_rules_message(const alert_rules_t *r, alert_kind_t kind, double T_C, char *buf, size_t len);
+
+// Nothing is ever sent for quiet_lo < T_C < quiet_hi, whatever the state.
+double alert_rules_quiet_lo(const alert_rules_t *r);
+double alert_rules_quiet_hi(const alert_rules_t *r);
@@ -0,0 +1,138 @@
+/*
+ * Sensor anomaly detection (implementation).
+ * - EWMA mean/variance per channel (West's incremental form). The z-score is
+ *   taken against the state before the sample; an outlier updates the state
+ *   with its value clipped to the z limit, so a spike barely moves the
+ *   baseline while a real level change is absorbed within a few minutes.
+ * - Noise floors keep z finite on a very quiet signal; no outliers or jumps
+ *   are reported until WARMUP samples have primed the state (the sensor's
+ *   IIR filter is still settling then).
+ * - Called from the sensor loop only; anomaly_get() readers get a consistent
+ *   enough copy (floats, no torn fields on the ESP32).
+ */
+
+#include "anomaly.h"
+#include "sdkconfig.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define ALPHA   (1.0f / 32.0f)        // EWMA weight: ~32 samples (~half a minute) of memory
+#define WARMUP  32
+
+typedef struct {
+    float sd_floor;                   // sensor noise; z never divides by less
+    float max_per_s;                  // fastest real change
+    const char *name;
+} chan_cfg_t;
+
+static const chan_cfg_t cfg[ANOM_CHANNELS] = {
+    [ANOM_CH_T] = { 0.02f, 0.5f,  "t" },   // °C
+    [ANOM_CH_H] = { 0.10f, 3.0f,  "h" },   // %RH
+    [ANOM_CH_P] = { 2.0f,  50.0f, "p" },   // Pa
+};
+
+typedef struct {
+    float    mean, var, z;
+    double   last;                    // previous value (exact, for stuck detection)
+    float    ref;                     // last value that was not a jump
+    int64_t  ref_us;
+    uint32_t n;                       // samples seen
+    int64_t  since_us;                // when the value last changed
+} chan_state_t;
+
+static chan_state_t st[ANOM_CHANNELS];
+
+static uint16_t check_channel(anomaly_channel_t ch, double v, int64_t ts_us)
+{
+    chan_state_t *c = &st[ch];
+    const chan_cfg_t *k = &cfg[ch];
+    const float z_max = CONFIG_APP_ANOMALY_Z_X10 / 10.0f;
+    uint16_t kind = 0;
+    float x = (float)v;
+
+    if (c->n == 0) {
+        c->mean = x;
+        c->var = k->sd_floor * k->sd_floor;
+        c->last = v;
+        c->since_us = c->ref_us = ts_us;
+        c->ref = x;
+        c->n = 1;
+        return 0;
+    }
+
+    // stuck: bit-identical compensated values (the ADC noise always moves an LSB)
+    if (v != c->last) c->since_us = ts_us;
+    if (CONFIG_APP_ANOMALY_STUCK_S > 0 && ts_us - c->since_us >= CONFIG_APP_ANOMALY_STUCK_S * 1000000LL) {
+        kind |= ANOM_STUCK;
+    }
+    c->last = v;
+
+    float sd = sqrtf(c->var + k->sd_floor * k->sd_floor);
+    bool primed = c->n >= WARMUP;
+
+    // jump: further from the last good value than the channel can move in the
+    // time since, plus the noise band. A one-sample glitch is flagged once
+    // and not again on the way back.
+    if (primed && fabsf(x - c->ref) > k->max_per_s * (float)(ts_us - c->ref_us) / 1e6f + z_max * sd) {
+        kind |= ANOM_JUMP;
+    } else {
+        c->ref = x;
+        c->ref_us = ts_us;
+    }
+
+    // outlier: z against the state before this sample
+    float d = x - c->mean;
+    c->z = d / sd;
+    if (primed && fabsf(c->z) > z_max) {
+        kind |= ANOM_OUTLIER;
+        d = copysignf(z_max * sd, d);               // clipped update
+    }
+    c->mean += ALPHA * d;
+    c->var = (1.0f - ALPHA) * (c->var + ALPHA * d * d);
+    c->n++;
+    return ANOM_FLAG(ch, kind);
+}
+
+/**
+ * @brief Run all detectors on one sample.
+ *
+ * @param[in] s Sample from sample_pipeline_process().
+ * @return ANOM_FLAG() bits for this sample, 0 if it looks normal.
+ */
+uint16_t anomaly_check(const sample_t *s)
+{
+    return check_channel(ANOM_CH_T, s->T_C, s->ts_us)
+         | check_channel(ANOM_CH_H, s->H_RH, s->ts_us)
+         | check_channel(ANOM_CH_P, s->P_Pa, s->ts_us);
+}
+
+void anomaly_get(anomaly_chan_t out[ANOM_CHANNELS])
+{
+    for (int ch = 0; ch < ANOM_CHANNELS; ch++) {
+        out[ch].mean = st[ch].mean;
+        out[ch].sd = sqrtf(st[ch].var + cfg[ch].sd_floor * cfg[ch].sd_floor);
+        out[ch].z = st[ch].z;
+    }
+}
+
+/**
+ * @brief Name the set flags, comma separated ("t_outlier,p_jump").
+ *
+ * @return Length written (truncated to cap - 1).
+ */
+size_t anomaly_describe(uint16_t flags, char *out, size_t cap)
+{
+    static const char *kinds[] = { "outlier", "jump", "stuck" };
+    size_t n = 0;
+    if (cap) out[0] = '\0';
+    for (int ch = 0; ch < ANOM_CHANNELS; ch++) {
+        for (int k = 0; k < 3; k++) {
+            if (!(flags & ANOM_FLAG(ch, 1u << k)) || n + 1 >= cap) continue;
+            int w = snprintf(out + n, cap - n, "%s%s_%s", n ? "," : "", cfg[ch].name, kinds[k]);
+            n += (w > 0) ? (size_t)w : 0;
+            if (n >= cap) n = cap - 1;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,38 @@
+/*
+ * Sensor anomaly detection (public API).
+ * - Runs in the sampling path, O(1) per sample and channel (T, RH, P):
+ *   - outlier: |z| against an EWMA mean/variance above CONFIG_APP_ANOMALY_Z_X10 / 10
+ *     (a door opening, a hand on the sensor, a glitch);
+ *   - jump: change since the previous sample faster than the channel can
+ *     physically move (bus or conversion errors);
+ *   - stuck: the same value for CONFIG_APP_ANOMALY_STUCK_S seconds (frozen
+ *     sensor, or humidity pinned at 0/100 %).
+ * - Result is a bit mask per sample, 3 bits per channel. The sensor loop
+ *   marks it in the history (rollup_t.anomalies), counts it in perf_metrics
+ *   and, with CONFIG_APP_ALERT_SUPPRESS_ANOMALIES, skips alerting on an
+ *   outlier or jump. A stuck temperature sends its own SMS warning
+ *   (sms_eval_stuck) and never suppresses alerts.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "sample_pipeline.h"
+
+typedef enum { ANOM_CH_T = 0, ANOM_CH_H, ANOM_CH_P, ANOM_CHANNELS } anomaly_channel_t;
+
+#define ANOM_OUTLIER  1u
+#define ANOM_JUMP     2u
+#define ANOM_STUCK    4u
+#define ANOM_FLAG(ch, kind)   ((uint16_t)((kind) << (3 * (ch))))
+#define ANOM_CHANNEL(ch)      ANOM_FLAG(ch, 7u)          // any kind on one channel
+#define ANOM_KIND(kind)       (ANOM_FLAG(ANOM_CH_T, kind) | ANOM_FLAG(ANOM_CH_H, kind) | ANOM_FLAG(ANOM_CH_P, kind))
+
+typedef struct {
+    float mean, sd;                   // EWMA state (sd includes the channel's noise floor)
+    float z;                          // of the last sample
+} anomaly_chan_t;
+
+uint16_t anomaly_check(const sample_t *s);                       // flags for this sample; updates the state
+void     anomaly_get(anomaly_chan_t out[ANOM_CHANNELS]);
+size_t   anomaly_describe(uint16_t flags, char *out, size_t cap);   // "t_outlier,h_stuck"; "" if none
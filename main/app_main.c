@@ -5,7 +5,10 @@
  * - Spawns a background task to fetch outside weather (Open-Meteo API).
  * - Scans the I2C bus, initializes the BME280, and reads T/P/H once per second.
  * - Publishes readings to the web page and evaluates SMS alerts via Twilio.
- * Uses vTaskDelayUntil() for drift-free timing in FreeRTOS.
+ * Uses vTaskDelayUntil() for drift-free timing in FreeRTOS. The sensor loop
+ * is its own task on APP_CPU; network tasks share PRO_CPU with Wi-Fi
+ * (sched_plan.h). Anything that may block (backlog submits that spill to
+ * flash, the UDP send, SMS over HTTPS) is queued to net_task on PRO_CPU.
  *
  * Author: Wael Hamid  |  Date: 2025-08-09
  */
@@ -15,27 +18,101 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "driver/i2c.h"    // scan done in main 
 
 #include "bme280.h"       // driver public API (macros + prototypes)
+#include "sample_pipeline.h"
+#include "trace.h"
+#include "perf_metrics.h"
+#include "mqtt_pub.h"
+#include "http_uplink.h"
+#include "udp_telemetry.h"
 #include "alert_eval.h"
 #include "sms_client.h"
 
 #include "wifi.h"
 #include "http_server.h"
+#include "snapshot.h"
+#include "history.h"
+#include "trend.h"
+#include "fusion.h"
+#include "selfheat.h"
+#include "anomaly.h"
 #include "http_client_ext.h"
+#include "net_pool.h"
+#include "mem_budget.h"
+#include "sched_plan.h"
 #include <math.h>   // for NAN
 
 #include <time.h>
+#include <sys/time.h>
 #include "esp_sntp.h"
 #include "esp_netif.h" //netword interface 
+#include "esp_timer.h"
+#include "sdkconfig.h"
 
 static const char *TAG = "APP_MAIN"; // for logs inside app_main.c
 
+#if CONFIG_APP_OVERSAMPLE
+#define SAMPLE_PERIOD_MS 1000           // one decimated sample per second
+#if (1000 / CONFIG_APP_OVERSAMPLE_HZ) % (1000 / CONFIG_FREERTOS_HZ) || 1000 % CONFIG_APP_OVERSAMPLE_HZ
+#error "APP_OVERSAMPLE_HZ must split 1000 ms into whole FreeRTOS ticks"
+#endif
+#if CONFIG_APP_DECIM_MEDIAN
+#define DECIM_FILTER DECIM_MEDIAN
+#elif CONFIG_APP_DECIM_HANN
+#define DECIM_FILTER DECIM_HANN
+#else
+#define DECIM_FILTER DECIM_MEAN
+#endif
+#define SENSOR_RATE_HZ (1000.0f / 29.3f)   // conversions/s of the fast setting (self-heating)
+#else
+#define SAMPLE_PERIOD_MS 1030           // t_standby (1000 ms) + conversion (~30 ms)
+#define SENSOR_RATE_HZ (1000.0f / SAMPLE_PERIOD_MS)
+#endif
+
+#if CONFIG_APP_SAMPLE_ADAPTIVE
+// "steady" for the slow sampling mode
+#define STEADY_C_PER_H   0.5f
+#define STEADY_RH_PER_H  2.0f
+#define STEADY_HOLD_US   (300LL * 1000000)
+#endif
+
+#define OUTSIDE_TASK_STACK 4096
+#define SENSOR_TASK_STACK  4096          // the loop only: submits are net_task's, SMS alert_task's
+#define NET_TASK_STACK     4096          // backlog submits and the UDP (DTLS) send
+#define NET_QUEUE_LEN      32            // sensor passes net_task may fall behind by (a flash spill)
+#define ALERT_TASK_STACK   6144          // an SMS send: the HTTPS request runs in this task
+#define ALERT_QUEUE_LEN    8             // passes alert_task may fall behind by; later ones are checked anyway
+
+// One sensor-loop pass for net_task: the reading for the uplinks.
+typedef struct {
+    sample_t smp;
+    int64_t  unix_ms;                    // wall time of the read, taken in the sensor loop
+} net_item_t;
+
+// One sensor-loop pass for alert_task: the inputs of the SMS checks.
+typedef struct {
+    double   T_C;                        // the sample's temperature (stuck warning)
+    bool     t_suspect;                  // outlier/jump (CONFIG_APP_ALERT_SUPPRESS_ANOMALIES): no threshold checks
+    bool     t_stuck;                    // frozen temperature: its own warning
+    double   alert_T_C;                  // judged by sms_eval_alert() (fused or raw)
+    bool     have_trend, have_fusion;
+    trend_t  tr;
+    fusion_t fu;
+} alert_item_t;
+
 // start here 
 static weather_t g_outside = { NAN, NAN };
+static volatile bool s_net_ready = 0;    // set true after IP acquired
+static volatile bool s_time_ready = 0;   // set true after SNTP time valid
+static QueueHandle_t s_net_q;            // sensor_task -> net_task
+static QueueHandle_t s_alert_q;          // sensor_task -> alert_task
+static uint32_t s_net_drops;             // passes dropped on a full queue (sensor_task only)
+static uint32_t s_alert_drops;           // passes not checked for alerts (sensor_task only)
 
 /**
  * @brief Background task that fetches outside temperature and humidity.
@@ -50,70 +127,101 @@ static void outside_temp_task(void *arg)
 {
     while (1) {
         g_outside = fetch_outside_current();      // HTTPS API call (Open-Meteo)
+        snapshot_set_outside(g_outside.temp, g_outside.humid);   // web/API derive dew point etc. from it
+        http_uplink_set_outside(g_outside.temp, g_outside.humid);
         vTaskDelay(pdMS_TO_TICKS(6000));         // update every 6 sec
     }
 }
 
 
 /**
- * @brief ESP-IDF application entry point.
- *
- * Main system startup routine that:
- * - Initializes Wi-Fi and SNTP time.
- * - Starts the HTTP web server and outside-weather fetch task.
- * - Scans the I2C bus for devices and initializes the BME280 sensor.
- * - Reads temperature, pressure, and humidity every ~1 second.
- * - Publishes readings to the web page and evaluates SMS alerts.
+ * @brief Uplink side of the sensor loop, pinned to SCHED_NET_CORE at SCHED_NET_PRIO.
  *
- * This function never returns; it runs an infinite loop after initialization.
+ * Takes each reading off s_net_q into the backlogs (a full RAM ring
+ * spills to flash) and sends the UDP datagram. Nothing here waits on a
+ * server, so a slow SMS (alert_task) cannot cost a reading.
  *
- * @return None (does not return).
+ * @param arg Unused.
+ * @return None (task runs indefinitely).
  */
-void app_main(void)
+static void net_task(void *arg)
 {
-    
-    static volatile bool s_net_ready= 0;    // set true after IP acquired
-    static volatile bool s_time_ready= 0;  // set true after SNTP time valid 
-    esp_err_t sms; 
-
-    // 0. Bring up Wi-Fi, time, and web server ===
-    ESP_ERROR_CHECK(wifi_start_station());    // connect to router (logs GOT_IP)
-
-    // 0.1 Start SNTP (do this once)
-    start_sntp_once();
-
-    // 0.1 Start HTTP server at "/"
-    web_start();                          
-
-    // 0.2 Start the background task that fetches outside temperature
-    xTaskCreate(outside_temp_task, "outside_temp_task", 4096, NULL, 5, NULL);
-
-    // 0.3 Give Wi-Fi/SNTP a moment (tiny, simple polls)
-    for (int i = 0; i < 100 && !have_ip();i++) vTaskDelay(pdMS_TO_TICKS(100)); // up to 10s
-    for (int i = 0; i < 150 && !time_is_set();i++) vTaskDelay(pdMS_TO_TICKS(150)); // up to 15s
-    //set the time & Ip flags 
-    s_net_ready  = have_ip();
-    s_time_ready = time_is_set();
+    net_item_t it;
+    while (1) {
+        if (xQueueReceive(s_net_q, &it, portMAX_DELAY) != pdTRUE) continue;
+        mqtt_pub_submit(&it.smp, it.unix_ms);        // queued for the broker (batched, survives outages)
+        http_uplink_submit(&it.smp, it.unix_ms);     // queued for the collector (same idea over HTTP POST)
+        udp_telemetry_submit(&it.smp, it.unix_ms);   // sent now as one datagram; gaps resent on request
+    }
+}
 
+/**
+ * @brief SMS checks of the sensor loop, pinned to SCHED_NET_CORE at SCHED_NET_PRIO.
+ *
+ * Takes each pass off s_alert_q and runs the stuck, threshold and forecast
+ * checks. sms_send_alert() is an HTTPS request that can take seconds; the
+ * passes that queue up meanwhile are checked late or, past ALERT_QUEUE_LEN,
+ * skipped (the next pass sees the same room).
+ *
+ * @param arg Unused.
+ * @return None (task runs indefinitely).
+ */
+static void alert_task(void *arg)
+{
+    alert_item_t it;
+    while (1) {
+        if (xQueueReceive(s_alert_q, &it, portMAX_DELAY) != pdTRUE) continue;
 
-    // send a quick sms to verify twilo API works 
-    /*ESP_LOGI(TAG, "net_ready=%d time_ready=%d", s_net_ready, s_time_ready);
-    if (s_net_ready && s_time_ready) {
-        ESP_LOGI(TAG, "Sending Twilio self-test…");
-        esp_err_t e = sms_send_alert("ESP32 self-test");
-        ESP_LOGI(TAG, "Twilio self-test result: %s", esp_err_to_name(e));
+        //alert the user by sending an sms if needed
+        esp_err_t sms = sms_eval_stuck(it.t_stuck, it.T_C);   // a frozen sensor cannot see the room
+        if (sms != ESP_OK) {
+            ESP_LOGW("ALERT", "sms_eval_stuck failed: %s", esp_err_to_name(sms));
+        }
+        if (it.t_suspect) continue;         // don't text about a glitch
+        sms = sms_eval_alert(it.alert_T_C);
+        if (sms != ESP_OK) {
+            ESP_LOGW("ALERT", "sms_eval_alert failed: %s", esp_err_to_name(sms));
+        }
+        if (it.have_trend) {                // early warning: threshold reached within the forecast horizon
+            sms = sms_eval_forecast(&it.tr, it.have_fusion ? &it.fu : NULL);
+            if (sms != ESP_OK) {
+                ESP_LOGW("ALERT", "sms_eval_forecast failed: %s", esp_err_to_name(sms));
+            }
+        }
     }
-    */
+}
 
+/**
+ * @brief Sensor loop, pinned to SCHED_SENSOR_CORE at SCHED_SENSOR_PRIO.
+ *
+ * - Scans the I2C bus for devices and initializes the BME280 sensor
+ *   (the I2C interrupt lands on this core with it).
+ * - Reads temperature, pressure, and humidity every ~1 second.
+ * - Publishes readings to the web page and hands each pass to net_task
+ *   (uplinks) and alert_task (SMS checks) without waiting on either.
+ *
+ * @param arg Unused.
+ * @return None (task runs indefinitely).
+ */
+static void sensor_task(void *arg)
+{
     // 1. Call the i2c initilaizer 
     ESP_ERROR_CHECK(bme_i2c_master_init());
+#if CONFIG_BME280_SIM
+    ESP_LOGI(TAG, "I2C scan skipped (simulated sensor)");
+#else
     ESP_LOGI(TAG, "Starting I2C scan...");
 
     // iterate through the addresses until u get back the sensor address
      for (uint8_t address= 0x03; address <= 0x77; address++){
 
         //create an empty command for setup 
+#if CONFIG_APP_STATIC_ALLOC
+        uint8_t link[I2C_LINK_RECOMMENDED_SIZE(2)];   // 3 commands, on the stack (no heap)
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof link);
+#else
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+#endif
         //add a start condition ( SDA H -> L)
         i2c_master_start(cmd);
         // send address with start bit 0 (write)
@@ -121,7 +229,11 @@ void app_main(void)
         i2c_master_stop(cmd);
         // run the transaction for short time 
         esp_err_t ret= i2c_master_cmd_begin(I2C_PORT,cmd,pdMS_TO_TICKS(50));
+#if CONFIG_APP_STATIC_ALLOC
+        i2c_cmd_link_delete_static(cmd);
+#else
         i2c_cmd_link_delete(cmd);
+#endif
 
         if (ret == ESP_OK){
 
@@ -129,6 +241,7 @@ void app_main(void)
         }
     }
     ESP_LOGI(TAG, "I2C scan complete.");
+#endif
 
     // 2. Call rhe bme2800 sensor initializer
     ESP_ERROR_CHECK(bme280_init());
@@ -137,34 +250,252 @@ void app_main(void)
     ESP_ERROR_CHECK(bme280_read_calibration());
 
     // 4. configure control registes to set measuremnt standards 
-    ESP_ERROR_CHECK(bme280_config_normal());
+#if CONFIG_APP_OVERSAMPLE
+    // fast x1 conversions, filtered in software (sample_pipeline.h decimator)
+    const uint8_t ctrl_hum = CTRL_VAL1_FAST, ctrl_meas = CTRL_VAL2_FAST, ctrl_conf = CTRL_VAL3_FAST;
+#else
+    const uint8_t ctrl_hum = CTRL_VAL1, ctrl_meas = CTRL_VAL2, ctrl_conf = CTRL_VAL3;
+#endif
+    ESP_ERROR_CHECK(bme280_configure(ctrl_hum, ctrl_meas, ctrl_conf));
+    if (bme280_wait_first_conversion(200) != ESP_OK) {   // the reset value must not prime anything
+        ESP_LOGW(TAG, "BME280: no conversion within 200 ms of configuring");
+    }
+
+    // 4.1 keep a RAM trace of raw readings (served at /trace for host replay)
+    uint8_t calib_88[BME280_CALIB_88_LEN], calib_E1[BME280_CALIB_E1_LEN];
+    bme280_get_calib_raw(calib_88, calib_E1);
+    if (trace_init(CONFIG_APP_TRACE_RECORDS, SAMPLE_PERIOD_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "trace buffer allocation failed; recording disabled");
+    }
+    trace_set_sensor_info(calib_88, calib_E1, ctrl_hum, ctrl_meas, ctrl_conf);
+    if (history_init(CONFIG_APP_HISTORY_MINUTES) != ESP_OK) {
+        ESP_LOGW(TAG, "history allocation failed; pressure tendency disabled");
+    }
+    if (trend_init(CONFIG_APP_TREND_WINDOW_S) != ESP_OK) {
+        ESP_LOGW(TAG, "trend window allocation failed; forecasts disabled");
+    }
+#if CONFIG_APP_SELFHEAT
+    selfheat_init(&(selfheat_model_t){ CONFIG_APP_SELFHEAT_OFFSET_MC / 1000.0f,
+                                       CONFIG_APP_SELFHEAT_MC_PER_HZ / 1000.0f, CONFIG_APP_SELFHEAT_TAU_S });
+    selfheat_set_rate(SENSOR_RATE_HZ);
+#endif
+    mem_budget_report();                // long-lived RAM per subsystem + heap left ("MEM:" lines)
 
     /* 5. start polling and allow the sensor to send the data... 
     -operating in normal mode */
 
+#if CONFIG_APP_OVERSAMPLE
+    // read every 1000/HZ ms, publish one decimated sample per second
+    const TickType_t period_ticks = pdMS_TO_TICKS(1000 / CONFIG_APP_OVERSAMPLE_HZ);
+    static decimator_t decim;
+    decimator_init(&decim, CONFIG_APP_OVERSAMPLE_HZ, DECIM_FILTER);
+#else
     // period = t_standby (1000 ms) + conv time (~30 ms) ≈ 1030 ms
     const TickType_t period_ticks = pdMS_TO_TICKS(1030);
+#endif
+#if CONFIG_APP_SAMPLE_ADAPTIVE
+    const TickType_t slow_ticks = pdMS_TO_TICKS(CONFIG_APP_SAMPLE_SLOW_S * 1000);
+    bool slow = false;                      // forced mode every CONFIG_APP_SAMPLE_SLOW_S
+    int64_t steady_since_us = -1;
+#endif
+    perf_metrics_init(SAMPLE_PERIOD_MS);
     TickType_t last_wake = xTaskGetTickCount();
     while(1){
 
-        int32_t raw_T,raw_P,raw_H;
-        ESP_ERROR_CHECK(bme280_read_raw(&raw_T, &raw_P, &raw_H)); //read the raw data
+        raw_sample_t raw;
+#if CONFIG_APP_OVERSAMPLE
+        raw_sample_t fast;
+        do {
+            vTaskDelayUntil(&last_wake, period_ticks);
+            ESP_ERROR_CHECK(bme280_read_raw(&fast.adc_T, &fast.adc_P, &fast.adc_H));
+            fast.ts_us = esp_timer_get_time();
+        } while (!decimator_push(&decim, &fast, &raw));   // one filtered raw sample per second
+#else
+#if CONFIG_APP_SAMPLE_ADAPTIVE
+        if (slow) {
+            vTaskDelayUntil(&last_wake, slow_ticks);
+            ESP_ERROR_CHECK(bme280_force_measurement(ctrl_meas));
+            vTaskDelay(pdMS_TO_TICKS(BME280_FORCED_WAIT_MS));
+        }
+#endif
+        ESP_ERROR_CHECK(bme280_read_raw(&raw.adc_T, &raw.adc_P, &raw.adc_H)); //read the raw data
+        raw.ts_us = esp_timer_get_time();
+#endif
+        trace_record(&raw);                 // raw copy for /trace (replayable on the host)
+        perf_metrics_on_sample(raw.ts_us);  // first-sample time, jitter, heap (PERF log lines)
 
         //float path (datasheet-style double) — simpler to print:
-        double T_C  = BME280_compensate_T_double(raw_T);   // °C
-        double P_Pa = BME280_compensate_P_double(raw_P);  // Pa
-        double H_RH = bme280_compensate_H_double(raw_H); // %RH
+        sample_t smp;
+        sample_pipeline_process(&raw, &smp);
+#if CONFIG_APP_SELFHEAT
+        selfheat_apply(&smp);               // minus the sensor's own warming; RH to match
+#endif
+        double T_C  = smp.T_C;    // °C
+        double P_Pa = smp.P_Pa;  // Pa
+        double H_RH = smp.H_RH; // %RH
         printf("T=%.2f °C  P=%.2f hPa  H=%.1f %%RH\n", T_C, P_Pa/100.0, H_RH);
-        //publish latest readings to the web page ===
-        web_set_readings((float)T_C, g_outside.temp,(float)H_RH, g_outside.humid);
+        uint16_t anom = anomaly_check(&smp);   // outlier / jump / stuck per channel, O(1)
+        perf_metrics_on_anomaly(anom);
+        baro_tendency_t tend;
+        bool minute_closed = history_add(&smp, anom);   // a minute closed: 3 h pressure tendency moved
+        if (minute_closed) history_tendency(&tend);
+        trend_t tr;
+        trend_add(&smp);                    // O(1) sliding-window fit of T and RH
+        bool have_trend = trend_get(&tr);
+        fusion_t fu;
+        bool have_fusion = false;
+#if CONFIG_APP_FUSION
+        fusion_update(&smp, g_outside.temp, (anom & ANOM_CHANNEL(ANOM_CH_T)) != 0);   // inside + outside heat balance
+        have_fusion = fusion_get(&fu);
+#endif
+        //publish this pass to the web page / API in one go (derived metrics computed on first read) ===
+        snapshot_set_inside(&smp, minute_closed ? &tend : NULL, have_trend ? &tr : NULL, have_fusion ? &fu : NULL);
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        int64_t unix_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - (esp_timer_get_time() - smp.ts_us) / 1000;
+        net_item_t it = { .smp = smp, .unix_ms = unix_ms };
+        if (xQueueSend(s_net_q, &it, 0) != pdTRUE && s_net_drops++ % 60 == 0) {   // never wait on the network
+            ESP_LOGW(TAG, "net_task behind: %u passes dropped", (unsigned)s_net_drops);
+        }
+        if (s_time_ready && s_net_ready) {
+            alert_item_t al = { .T_C = T_C, .t_stuck = (anom & ANOM_FLAG(ANOM_CH_T, ANOM_STUCK)) != 0,
+                                .alert_T_C = T_C, .have_trend = have_trend, .have_fusion = have_fusion };
+#if CONFIG_APP_ALERT_SUPPRESS_ANOMALIES
+            al.t_suspect = (anom & (ANOM_FLAG(ANOM_CH_T, ANOM_OUTLIER) | ANOM_FLAG(ANOM_CH_T, ANOM_JUMP))) != 0;
+#endif
+#if CONFIG_APP_ALERT_USE_FUSED
+            if (have_fusion) al.alert_T_C = fu.T_C;   // alert on the smoothed estimate
+#endif
+            if (have_trend) al.tr = tr;
+            if (have_fusion) al.fu = fu;
+            if (xQueueSend(s_alert_q, &al, 0) != pdTRUE && s_alert_drops++ % 60 == 0) {
+                ESP_LOGW(TAG, "alert_task behind (SMS in flight): %u passes not checked", (unsigned)s_alert_drops);
+            }
+        }
+#if CONFIG_APP_SAMPLE_ADAPTIVE
+        bool steady = have_trend && fabsf(tr.dT_per_h) < STEADY_C_PER_H && fabsf(tr.dRH_per_h) < STEADY_RH_PER_H
+                      && T_C > WARN_LOW_C + 1.0 && T_C < WARN_HIGH_C - 1.0 && anom == 0;
+        if (!steady) steady_since_us = -1;
+        else if (steady_since_us < 0) steady_since_us = smp.ts_us;
+        bool want_slow = steady_since_us >= 0 && smp.ts_us - steady_since_us >= STEADY_HOLD_US;
+        if (want_slow != slow) {
+            slow = want_slow;
+            if (!slow) ESP_ERROR_CHECK(bme280_configure(ctrl_hum, ctrl_meas, ctrl_conf));   // normal mode again
+#if CONFIG_APP_SELFHEAT
+            selfheat_set_rate(slow ? 1.0f / CONFIG_APP_SAMPLE_SLOW_S : SENSOR_RATE_HZ);
+#endif
+            perf_metrics_set_period(slow ? CONFIG_APP_SAMPLE_SLOW_S * 1000 : SAMPLE_PERIOD_MS);
+            last_wake = xTaskGetTickCount();
+            ESP_LOGI(TAG, "sampling: %s", slow ? "slow (forced mode)" : "1 Hz (normal mode)");
+        }
+        if (!slow) vTaskDelayUntil(&last_wake, period_ticks);
+#elif !CONFIG_APP_OVERSAMPLE
         vTaskDelayUntil(&last_wake, period_ticks); // wait until last_wake + period_ticks, adjusting for time already spent
+#endif
+    }
+}
 
-        //finally, alert the user by sending an sms if needed 
-        if(s_time_ready && s_net_ready){
-            sms= sms_eval_alert(T_C);  //alert here if temp above or below threshold
-            if(sms != ESP_OK){
-                ESP_LOGW("ALERT", "sms_eval_alert failed: %s", esp_err_to_name(sms));
-            }
-        } 
+/**
+ * @brief ESP-IDF application entry point.
+ *
+ * Main system startup routine that:
+ * - Initializes Wi-Fi and SNTP time.
+ * - Starts the HTTP web server, the uplinks and the outside-weather fetch task.
+ * - Starts sensor_task() on its own core and returns (the main task ends).
+ *
+ * @return None.
+ */
+void app_main(void)
+{
+    // 0. Bring up Wi-Fi, time, and web server ===
+    net_pool_init();                          // network buffers, before anything that fetches or serves
+    ESP_ERROR_CHECK(wifi_start_station());    // connect to router (logs GOT_IP)
+
+    // 0.1 Start SNTP (do this once)
+    start_sntp_once();
+
+    // 0.1 Start HTTP server at "/"
+    web_start();                          
+
+    // 0.1 Start the MQTT publisher / HTTP uplink / UDP telemetry (retry on their own; readings queue meanwhile)
+    if (mqtt_pub_start() != ESP_OK) {
+        ESP_LOGW(TAG, "MQTT publisher failed to start");
+    }
+    if (http_uplink_start() != ESP_OK) {
+        ESP_LOGW(TAG, "HTTP uplink failed to start");
+    }
+    if (udp_telemetry_start() != ESP_OK) {
+        ESP_LOGW(TAG, "UDP telemetry failed to start");
+    }
+
+    // 0.2 Start the background task that fetches outside temperature
+#if CONFIG_APP_STATIC_ALLOC
+    static StackType_t outside_stack[OUTSIDE_TASK_STACK];
+    static StaticTask_t outside_tcb;
+    xTaskCreateStaticPinnedToCore(outside_temp_task, "outside_temp_task", OUTSIDE_TASK_STACK, NULL, SCHED_NET_PRIO,
+                                  outside_stack, &outside_tcb, SCHED_NET_CORE);
+#else
+    xTaskCreatePinnedToCore(outside_temp_task, "outside_temp_task", OUTSIDE_TASK_STACK, NULL, SCHED_NET_PRIO, NULL,
+                            SCHED_NET_CORE);
+#endif
+    mem_budget_add("weather", OUTSIDE_TASK_STACK);
+
+    // 0.3 Give Wi-Fi/SNTP a moment (tiny, simple polls)
+    for (int i = 0; i < 100 && !have_ip();i++) vTaskDelay(pdMS_TO_TICKS(100)); // up to 10s
+    for (int i = 0; i < 150 && !time_is_set();i++) vTaskDelay(pdMS_TO_TICKS(150)); // up to 15s
+    //set the time & Ip flags 
+    s_net_ready  = have_ip();
+    s_time_ready = time_is_set();
+
+
+    // send a quick sms to verify twilo API works 
+    /*ESP_LOGI(TAG, "net_ready=%d time_ready=%d", s_net_ready, s_time_ready);
+    if (s_net_ready && s_time_ready) {
+        ESP_LOGI(TAG, "Sending Twilio self-test…");
+        esp_err_t e = sms_send_alert("ESP32 self-test");
+        ESP_LOGI(TAG, "Twilio self-test result: %s", esp_err_to_name(e));
     }
+    */
+
+    ESP_LOGI(TAG, "tasks: sensor core %d prio %d; network/web core %d prio %d/%d",
+             SCHED_SENSOR_CORE, SCHED_SENSOR_PRIO, SCHED_NET_CORE == tskNO_AFFINITY ? -1 : (int)SCHED_NET_CORE,
+             SCHED_NET_PRIO, SCHED_WEB_PRIO);
+    mem_budget_add("net", NET_TASK_STACK + NET_QUEUE_LEN * sizeof(net_item_t));
+#if CONFIG_APP_STATIC_ALLOC
+    static uint8_t net_q_items[NET_QUEUE_LEN * sizeof(net_item_t)];
+    static StaticQueue_t net_q_buf;
+    static StackType_t net_stack[NET_TASK_STACK];
+    static StaticTask_t net_tcb;
+    s_net_q = xQueueCreateStatic(NET_QUEUE_LEN, sizeof(net_item_t), net_q_items, &net_q_buf);
+    xTaskCreateStaticPinnedToCore(net_task, "net_task", NET_TASK_STACK, NULL, SCHED_NET_PRIO, net_stack, &net_tcb,
+                                  SCHED_NET_CORE);
+#else
+    s_net_q = xQueueCreate(NET_QUEUE_LEN, sizeof(net_item_t));
+    ESP_ERROR_CHECK(s_net_q ? ESP_OK : ESP_ERR_NO_MEM);
+    xTaskCreatePinnedToCore(net_task, "net_task", NET_TASK_STACK, NULL, SCHED_NET_PRIO, NULL, SCHED_NET_CORE);
+#endif
+    mem_budget_add("alerts", ALERT_TASK_STACK + ALERT_QUEUE_LEN * sizeof(alert_item_t));
+#if CONFIG_APP_STATIC_ALLOC
+    static uint8_t alert_q_items[ALERT_QUEUE_LEN * sizeof(alert_item_t)];
+    static StaticQueue_t alert_q_buf;
+    static StackType_t alert_stack[ALERT_TASK_STACK];
+    static StaticTask_t alert_tcb;
+    s_alert_q = xQueueCreateStatic(ALERT_QUEUE_LEN, sizeof(alert_item_t), alert_q_items, &alert_q_buf);
+    xTaskCreateStaticPinnedToCore(alert_task, "alert_task", ALERT_TASK_STACK, NULL, SCHED_NET_PRIO, alert_stack,
+                                  &alert_tcb, SCHED_NET_CORE);
+#else
+    s_alert_q = xQueueCreate(ALERT_QUEUE_LEN, sizeof(alert_item_t));
+    ESP_ERROR_CHECK(s_alert_q ? ESP_OK : ESP_ERR_NO_MEM);
+    xTaskCreatePinnedToCore(alert_task, "alert_task", ALERT_TASK_STACK, NULL, SCHED_NET_PRIO, NULL, SCHED_NET_CORE);
+#endif
+    mem_budget_add("sensor", SENSOR_TASK_STACK);
+#if CONFIG_APP_STATIC_ALLOC
+    static StackType_t sensor_stack[SENSOR_TASK_STACK];
+    static StaticTask_t sensor_tcb;
+    xTaskCreateStaticPinnedToCore(sensor_task, "sensor_task", SENSOR_TASK_STACK, NULL, SCHED_SENSOR_PRIO,
+                                  sensor_stack, &sensor_tcb, SCHED_SENSOR_CORE);
+#else
+    xTaskCreatePinnedToCore(sensor_task, "sensor_task", SENSOR_TASK_STACK, NULL, SCHED_SENSOR_PRIO, NULL,
+                            SCHED_SENSOR_CORE);
+#endif
 }
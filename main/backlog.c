@@ -0,0 +1,353 @@
+/*
+ * Reading backlog (implementation).
+ * - RAM: circular array of reading_t (oldest at ram_head).
+ * - Flash: the partition is a ring of 4 KB sectors, each holding up to
+ *   REC_PER_SECTOR readings written in one go: records first, then a 16-byte
+ *   header {magic, sector seq, count, crc32}. A sector without a valid header
+ *   (never written, or power lost mid-write) is free. Pending sectors form one
+ *   contiguous run rd_sector .. rd_sector + flash_sectors_pending - 1.
+ * - Flash always holds the oldest readings, so peek/ack look there first.
+ * - Sectors are packed, checksummed and verified REC_CHUNK records at a time
+ *   through a stack buffer (the CRC chains), so flash I/O needs no heap.
+ * - backlog_create_static() takes the struct from a fixed pool and the RAM
+ *   ring from the caller, for CONFIG_APP_STATIC_ALLOC.
+ */
+
+#include "backlog.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "backlog";
+
+#define SECTOR_LEN      4096
+#define HDR_LEN         16
+#define REC_LEN         20
+#define REC_PER_SECTOR  ((SECTOR_LEN - HDR_LEN) / REC_LEN)   // 204
+#define SECTOR_MAGIC    0x474C4B42u                         // "BKLG"
+#define REC_CHUNK       12                                  // records per flash read/write (240 B of stack)
+
+struct backlog {
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_mem;    // backlog_create_static() only
+    reading_t *ram;
+    size_t     ram_cap, ram_head, ram_count;
+    uint32_t   next_seq;
+
+    const esp_partition_t *part;
+    uint32_t   n_sectors;
+    uint32_t   rd_sector;          // oldest pending sector
+    uint32_t   rd_idx;             // next unsent record in rd_sector
+    uint32_t   rd_count;           // records in rd_sector
+    uint32_t   sectors_pending;
+    uint32_t   sector_seq;         // seq for the next sector written
+    uint32_t   flash_records;      // unsent records in flash
+
+    backlog_stats_t st;
+};
+
+// Partitions already owned by a backlog (two owners would erase each other's data).
+static const esp_partition_t *claimed[2];
+
+static struct backlog pool[BACKLOG_STATIC_MAX];            // backlog_create_static()
+static size_t         pool_used;
+
+// ---- record/sector encoding (little-endian) ----
+
+static void put_u32(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24); }
+static uint32_t get_u32(const uint8_t *p)   { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static void rec_pack(uint8_t *p, const reading_t *r)
+{
+    put_u32(p, (uint32_t)r->unix_ms);
+    put_u32(p + 4, (uint32_t)((uint64_t)r->unix_ms >> 32));
+    put_u32(p + 8, r->seq);
+    put_u32(p + 12, (uint32_t)(uint16_t)r->t_cC | ((uint32_t)r->h_cRH << 16));
+    put_u32(p + 16, r->p_dPa);
+}
+
+static void rec_unpack(const uint8_t *p, reading_t *r)
+{
+    r->unix_ms = (int64_t)(get_u32(p) | ((uint64_t)get_u32(p + 4) << 32));
+    r->seq = get_u32(p + 8);
+    uint32_t th = get_u32(p + 12);
+    r->t_cC = (int16_t)(th & 0xFFFF);
+    r->h_cRH = (uint16_t)(th >> 16);
+    r->p_dPa = get_u32(p + 16);
+}
+
+static bool seq_le(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+// Read a sector header; true if it is a complete, checksummed sector.
+static bool sector_valid(backlog_t *b, uint32_t sector, uint32_t *seq, uint32_t *count)
+{
+    uint8_t hdr[HDR_LEN];
+    size_t off = (size_t)sector * SECTOR_LEN;
+    if (esp_partition_read(b->part, off, hdr, HDR_LEN) != ESP_OK) return false;
+    if (get_u32(hdr) != SECTOR_MAGIC) return false;
+    uint32_t n = get_u32(hdr + 8);
+    if (n == 0 || n > REC_PER_SECTOR) return false;
+
+    uint8_t recs[REC_CHUNK * REC_LEN];
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < n; i += REC_CHUNK) {
+        uint32_t len = (n - i < REC_CHUNK ? n - i : REC_CHUNK) * REC_LEN;
+        if (esp_partition_read(b->part, off + HDR_LEN + i * REC_LEN, recs, len) != ESP_OK) return false;
+        crc = esp_rom_crc32_le(crc, recs, len);
+    }
+    bool ok = crc == get_u32(hdr + 12);
+    *seq = get_u32(hdr + 4);
+    *count = n;
+    return ok;
+}
+
+static esp_err_t read_flash_rec(backlog_t *b, uint32_t sector, uint32_t idx, reading_t *r)
+{
+    uint8_t p[REC_LEN];
+    esp_err_t err = esp_partition_read(b->part, (size_t)sector * SECTOR_LEN + HDR_LEN + idx * REC_LEN, p, REC_LEN);
+    if (err == ESP_OK) rec_unpack(p, r);
+    return err;
+}
+
+static void load_rd_sector(backlog_t *b)
+{
+    uint32_t seq;
+    b->rd_idx = 0;
+    b->rd_count = 0;
+    if (b->sectors_pending && !sector_valid(b, b->rd_sector, &seq, &b->rd_count)) b->rd_count = 0;
+}
+
+// Erase the oldest pending sector and move to the next one.
+static void retire_rd_sector(backlog_t *b)
+{
+    esp_partition_erase_range(b->part, (size_t)b->rd_sector * SECTOR_LEN, SECTOR_LEN);
+    b->flash_records -= (b->rd_count - b->rd_idx);
+    b->rd_sector = (b->rd_sector + 1) % b->n_sectors;
+    b->sectors_pending--;
+    load_rd_sector(b);
+}
+
+// Find pending sectors left by a previous boot.
+static void flash_scan(backlog_t *b)
+{
+    uint32_t best_seq = 0, newest_seq = 0, newest_sector = 0;
+    bool any = false;
+    for (uint32_t s = 0; s < b->n_sectors; s++) {
+        uint32_t seq, n;
+        if (!sector_valid(b, s, &seq, &n)) continue;
+        if (!any || !seq_le(best_seq, seq)) { best_seq = seq; b->rd_sector = s; }
+        if (!any || seq_le(newest_seq, seq)) { newest_seq = seq; newest_sector = s; }
+        b->sectors_pending++;
+        b->flash_records += n;
+        any = true;
+    }
+    if (!any) return;
+
+    b->sector_seq = newest_seq + 1;
+    load_rd_sector(b);
+    uint32_t n_last, seq_unused;
+    reading_t last;
+    if (sector_valid(b, newest_sector, &seq_unused, &n_last) &&
+        read_flash_rec(b, newest_sector, n_last - 1, &last) == ESP_OK) {
+        b->next_seq = last.seq + 1;           // keep numbering across the reboot
+    }
+    ESP_LOGI(TAG, "%s: %lu readings pending from before reboot", b->part->label, (unsigned long)b->flash_records);
+}
+
+// Move up to one sector of the oldest RAM readings to flash.
+static bool spill(backlog_t *b)
+{
+    if (b->sectors_pending == b->n_sectors) {         // flash full: lose the oldest sector
+        b->st.dropped += b->rd_count - b->rd_idx;
+        retire_rd_sector(b);
+    }
+    uint32_t n = b->ram_count < REC_PER_SECTOR ? (uint32_t)b->ram_count : REC_PER_SECTOR;
+    uint32_t wr = (b->rd_sector + b->sectors_pending) % b->n_sectors;
+    size_t off = (size_t)wr * SECTOR_LEN;
+    esp_err_t err = esp_partition_erase_range(b->part, off, SECTOR_LEN);
+
+    uint8_t buf[REC_CHUNK * REC_LEN];
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < n && err == ESP_OK; i += REC_CHUNK) {
+        uint32_t k = n - i < REC_CHUNK ? n - i : REC_CHUNK;
+        for (uint32_t j = 0; j < k; j++) rec_pack(buf + j * REC_LEN, &b->ram[(b->ram_head + i + j) % b->ram_cap]);
+        crc = esp_rom_crc32_le(crc, buf, k * REC_LEN);
+        err = esp_partition_write(b->part, off + HDR_LEN + i * REC_LEN, buf, k * REC_LEN);
+    }
+    put_u32(buf, SECTOR_MAGIC);
+    put_u32(buf + 4, b->sector_seq);
+    put_u32(buf + 8, n);
+    put_u32(buf + 12, crc);
+    if (err == ESP_OK) err = esp_partition_write(b->part, off, buf, HDR_LEN);   // header last = commit
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "spill failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    b->sector_seq++;
+    b->sectors_pending++;
+    b->flash_records += n;
+    if (b->sectors_pending == 1) { b->rd_sector = wr; b->rd_idx = 0; b->rd_count = n; }
+    b->ram_head = (b->ram_head + n) % b->ram_cap;
+    b->ram_count -= n;
+    b->st.spilled += n;
+    return true;
+}
+
+// Claim the partition (if any) and pick up what a previous boot left there.
+static void attach_flash(backlog_t *b, const char *flash_label)
+{
+    if (!flash_label) return;
+    b->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, flash_label);
+    size_t slot = 0;
+    while (slot < 2 && claimed[slot] && claimed[slot] != b->part) slot++;
+    if (!b->part || b->part->size < SECTOR_LEN) {
+        ESP_LOGW(TAG, "partition '%s' not found; backlog is RAM-only", flash_label);
+        b->part = NULL;
+    } else if (slot == 2 || claimed[slot]) {
+        ESP_LOGW(TAG, "partition '%s' already in use; backlog is RAM-only", flash_label);
+        b->part = NULL;
+    } else {
+        claimed[slot] = b->part;
+        b->n_sectors = b->part->size / SECTOR_LEN;
+        flash_scan(b);
+    }
+}
+
+/**
+ * @brief Create a backlog with a RAM ring and an optional flash partition.
+ *
+ * @param[in] ram_records Readings kept in RAM before spilling.
+ * @param[in] flash_label Data partition label, or NULL for RAM-only. A partition
+ *                        already used by another backlog is not shared.
+ * @return New backlog, or NULL if out of memory.
+ */
+backlog_t *backlog_create(size_t ram_records, const char *flash_label)
+{
+    if (ram_records == 0) return NULL;
+    backlog_t *b = calloc(1, sizeof *b);
+    if (!b) return NULL;
+    b->ram = calloc(ram_records, sizeof(reading_t));
+    b->lock = xSemaphoreCreateMutex();
+    if (!b->ram || !b->lock) { free(b->ram); free(b); return NULL; }
+    b->ram_cap = ram_records;
+    attach_flash(b, flash_label);
+    return b;
+}
+
+/**
+ * @brief Create a backlog without touching the heap.
+ *
+ * The backlog comes from a pool of BACKLOG_STATIC_MAX; it is never freed.
+ *
+ * @param[in] ram         Caller-owned ring (e.g. a static array) of ram_records readings.
+ * @param[in] ram_records Readings kept in RAM before spilling.
+ * @param[in] flash_label As backlog_create().
+ * @return New backlog, or NULL if the pool is used up.
+ */
+backlog_t *backlog_create_static(reading_t *ram, size_t ram_records, const char *flash_label)
+{
+    if (!ram || ram_records == 0 || pool_used == BACKLOG_STATIC_MAX) return NULL;
+    backlog_t *b = &pool[pool_used++];
+    b->ram = ram;
+    b->ram_cap = ram_records;
+    b->lock = xSemaphoreCreateMutexStatic(&b->lock_mem);
+    attach_flash(b, flash_label);
+    return b;
+}
+
+/**
+ * @brief Queue one sample. Never blocks on the network; may write flash.
+ *
+ * @return The seq assigned to the reading.
+ */
+uint32_t backlog_push(backlog_t *b, const sample_t *s, int64_t unix_ms)
+{
+    if (!b) return 0;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    if (b->ram_count == b->ram_cap && !(b->part && spill(b))) {
+        b->ram_head = (b->ram_head + 1) % b->ram_cap;     // no flash: drop the oldest
+        b->ram_count--;
+        b->st.dropped++;
+    }
+    uint32_t seq = b->next_seq++;
+    reading_from_sample(s, unix_ms, seq, &b->ram[(b->ram_head + b->ram_count) % b->ram_cap]);
+    b->ram_count++;
+    b->st.pushed++;
+    xSemaphoreGive(b->lock);
+    return seq;
+}
+
+/**
+ * @brief Copy out the oldest pending readings without removing them.
+ *
+ * Returns at most one flash sector's worth at a time.
+ *
+ * @return Number of readings written to out.
+ */
+size_t backlog_peek(backlog_t *b, reading_t *out, size_t max)
+{
+    if (!b) return 0;
+    size_t n = 0;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    if (b->sectors_pending) {
+        while (n < max && b->rd_idx + n < b->rd_count &&
+               read_flash_rec(b, b->rd_sector, b->rd_idx + (uint32_t)n, &out[n]) == ESP_OK) {
+            n++;
+        }
+    } else {
+        for (; n < max && n < b->ram_count; n++) out[n] = b->ram[(b->ram_head + n) % b->ram_cap];
+    }
+    xSemaphoreGive(b->lock);
+    return n;
+}
+
+/**
+ * @brief Remove every pending reading with seq <= last_seq (server acknowledged).
+ */
+void backlog_ack(backlog_t *b, uint32_t last_seq)
+{
+    if (!b) return;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    reading_t r;
+    while (b->sectors_pending) {
+        if (b->rd_idx >= b->rd_count) { retire_rd_sector(b); continue; }
+        if (read_flash_rec(b, b->rd_sector, b->rd_idx, &r) != ESP_OK || !seq_le(r.seq, last_seq)) goto done;
+        b->rd_idx++;
+        b->flash_records--;
+        b->st.acked++;
+        if (b->rd_idx >= b->rd_count) { b->rd_idx = b->rd_count; retire_rd_sector(b); }
+    }
+    while (b->ram_count && seq_le(b->ram[b->ram_head].seq, last_seq)) {
+        b->ram_head = (b->ram_head + 1) % b->ram_cap;
+        b->ram_count--;
+        b->st.acked++;
+    }
+done:
+    xSemaphoreGive(b->lock);
+}
+
+size_t backlog_count(backlog_t *b)
+{
+    if (!b) return 0;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    size_t n = b->ram_count + b->flash_records;
+    xSemaphoreGive(b->lock);
+    return n;
+}
+
+void backlog_get_stats(backlog_t *b, backlog_stats_t *out)
+{
+    memset(out, 0, sizeof *out);
+    if (!b) return;
+    xSemaphoreTake(b->lock, portMAX_DELAY);
+    *out = b->st;
+    out->ram_pending = (uint32_t)b->ram_count;
+    out->flash_pending = b->flash_records;
+    out->flash_sectors = b->n_sectors;
+    xSemaphoreGive(b->lock);
+}
@@ -0,0 +1,44 @@
+/*
+ * Reading backlog (public API).
+ * FIFO of readings waiting for an uplink (MQTT, HTTP), filled by the sensor
+ * loop and drained by the uplink task once the server has acknowledged them.
+ * - RAM ring of a fixed number of readings; when it is full the oldest chunk
+ *   spills to a flash data partition (4 KB sectors used as a ring), so data
+ *   survives long outages and reboots. Without a partition the oldest RAM
+ *   reading is dropped instead.
+ * - The backlog numbers readings (reading_t.seq) and keeps numbering across
+ *   reboots when flash still holds unsent data.
+ * - Delivery is at-least-once: readings leave only through backlog_ack(), and
+ *   a flash sector that was half-sent before a reboot is sent again in full.
+ * - backlog_create_static() allocates nothing (CONFIG_APP_STATIC_ALLOC).
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "reading_codec.h"
+
+typedef struct backlog backlog_t;
+
+typedef struct {
+    uint32_t pushed;           // readings accepted
+    uint32_t acked;            // readings removed by backlog_ack()
+    uint32_t dropped;          // readings lost to overflow (RAM without flash, or flash full)
+    uint32_t spilled;          // readings moved RAM -> flash
+    uint32_t ram_pending;
+    uint32_t flash_pending;
+    uint32_t flash_sectors;    // 0 when running RAM-only
+} backlog_stats_t;
+
+#define BACKLOG_STATIC_MAX 3          // MQTT, HTTP uplink, UDP
+
+// ram_records > 0; flash_label may be NULL (or not found) for RAM-only.
+backlog_t *backlog_create(size_t ram_records, const char *flash_label);
+backlog_t *backlog_create_static(reading_t *ram, size_t ram_records, const char *flash_label);   // no heap
+
+uint32_t backlog_push(backlog_t *b, const sample_t *s, int64_t unix_ms);  // returns the assigned seq
+size_t   backlog_peek(backlog_t *b, reading_t *out, size_t max);          // oldest first, consecutive
+void     backlog_ack(backlog_t *b, uint32_t last_seq);                    // drop readings up to last_seq
+size_t   backlog_count(backlog_t *b);
+void     backlog_get_stats(backlog_t *b, backlog_stats_t *out);
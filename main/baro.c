@@ -0,0 +1,73 @@
+/*
+ * Barometry (implementation).
+ * - Sea level: hypsometric reduction with the standard lapse rate,
+ *   P0 = P * (1 - L*h / (T + L*h + 273.15))^-g*M/(R*L). With T unknown the
+ *   station is assumed to sit in the ISA atmosphere (T = 15 - L*h).
+ * - Tendency: the 3 h window is split into two 90 min halves; each half and
+ *   the whole is rising, falling or steady (BARO_STEADY_PA), and the
+ *   combination picks the WMO 0200 code.
+ */
+
+#include "baro.h"
+#include "psychro.h"     // psy_expf / psy_logf
+#include <math.h>
+
+#define LAPSE_K_PER_M  0.0065f
+#define BARO_EXPONENT  5.25588f       // g*M / (R*L)
+
+/**
+ * @brief Reduce station pressure to mean sea level.
+ *
+ * @param P_Pa       Station pressure (Pa).
+ * @param altitude_m Station height above sea level (m).
+ * @param T_C        Outside air temperature at the station (°C), NAN if unknown.
+ * @return Sea-level pressure (Pa), NAN if P_Pa is NAN.
+ */
+float baro_sea_level_Pa(float P_Pa, float altitude_m, float T_C)
+{
+    float lh = LAPSE_K_PER_M * altitude_m;
+    float T_K = isnan(T_C) ? 288.15f : T_C + lh + 273.15f;   // sea-level temperature
+    return P_Pa * psy_expf(-BARO_EXPONENT * psy_logf(1.0f - lh / T_K));   // single precision, as psychro.c
+}
+
+static int sign_of(float d) { return d >= BARO_STEADY_PA ? 1 : d <= -BARO_STEADY_PA ? -1 : 0; }
+
+/**
+ * @brief Classify a 3 h station-pressure history into amount and WMO code.
+ *
+ * @param p_3h_Pa    Pressure 3 h ago.
+ * @param p_90min_Pa Pressure 90 min ago.
+ * @param p_now_Pa   Pressure now.
+ * @param[out] out   Change, WMO 0200 characteristic and coarse trend.
+ */
+void baro_tendency_classify(float p_3h_Pa, float p_90min_Pa, float p_now_Pa, baro_tendency_t *out)
+{
+    float d1 = p_90min_Pa - p_3h_Pa, d2 = p_now_Pa - p_90min_Pa, d = p_now_Pa - p_3h_Pa;
+    int s1 = sign_of(d1), s2 = sign_of(d2), s = sign_of(d);
+
+    out->dp_Pa = d;
+    out->trend = (int8_t)s;
+    if (s > 0) {
+        if (s1 > 0 && s2 < 0)       out->code = 0;
+        else if (s1 > 0 && s2 > 0)  out->code = d2 < 0.5f * d1 ? 1 : d2 > 2.0f * d1 ? 3 : 2;
+        else if (s1 > 0)            out->code = 1;   // then steady
+        else if (s2 > 0)            out->code = 3;   // falling or steady, then rising
+        else                        out->code = 2;   // two small rises
+    } else if (s < 0) {
+        if (s1 < 0 && s2 > 0)       out->code = 5;
+        else if (s1 < 0 && s2 < 0)  out->code = d2 > 0.5f * d1 ? 6 : d2 < 2.0f * d1 ? 8 : 7;
+        else if (s1 < 0)            out->code = 6;   // then steady
+        else if (s2 < 0)            out->code = 8;   // rising or steady, then falling
+        else                        out->code = 7;   // two small falls
+    } else {
+        if (s1 > 0 || (s1 == 0 && s2 < 0))       out->code = 0;   // up, then back down
+        else if (s1 < 0 || (s1 == 0 && s2 > 0))  out->code = 5;   // down, then back up
+        else                                     out->code = 4;
+    }
+}
+
+const char *baro_trend_name(const baro_tendency_t *t)
+{
+    if (t->code == BARO_TENDENCY_UNKNOWN) return "unknown";
+    return t->trend > 0 ? "rising" : t->trend < 0 ? "falling" : "steady";
+}
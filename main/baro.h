@@ -0,0 +1,36 @@
+/*
+ * Barometry (public API).
+ * - Sea-level reduction of the station pressure for a configured altitude
+ *   (CONFIG_APP_STATION_ALTITUDE_M).
+ * - 3-hour pressure tendency: the amount (WMO ppp) and the characteristic
+ *   (WMO code table 0200, "a"), classified from three station-pressure
+ *   values: 3 h ago, 90 min ago and now. history.c supplies them from its
+ *   per-minute rollups.
+ *
+ *   a  3 h change  shape
+ *   0  >= 0        increasing, then decreasing
+ *   1  > 0         increasing, then steady or increasing more slowly
+ *   2  > 0         increasing (steadily or unsteadily)
+ *   3  > 0         decreasing or steady, then increasing; or increasing more rapidly
+ *   4  0           steady
+ *   5  <= 0        decreasing, then increasing
+ *   6  < 0         decreasing, then steady or decreasing more slowly
+ *   7  < 0         decreasing (steadily or unsteadily)
+ *   8  < 0         steady or increasing, then decreasing; or decreasing more rapidly
+ */
+
+#pragma once
+#include <stdint.h>
+
+#define BARO_STEADY_PA        10      // |change| below 0.1 hPa (ppp resolution) counts as steady
+#define BARO_TENDENCY_UNKNOWN 0xFF    // code until 3 h of history exist
+
+typedef struct {
+    float   dp_Pa;                    // station pressure now minus 3 h ago (NAN if unknown)
+    uint8_t code;                     // WMO 0200 characteristic, or BARO_TENDENCY_UNKNOWN
+    int8_t  trend;                    // +1 rising, 0 steady, -1 falling
+} baro_tendency_t;
+
+float       baro_sea_level_Pa(float P_Pa, float altitude_m, float T_C);   // T_C NAN = ISA temperature
+void        baro_tendency_classify(float p_3h_Pa, float p_90min_Pa, float p_now_Pa, baro_tendency_t *out);
+const char *baro_trend_name(const baro_tendency_t *t);                    // "rising" / "steady" / "falling" / "unknown"
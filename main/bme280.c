@@ -10,12 +10,19 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 #include <stdio.h>
+#include <string.h>
+#if CONFIG_BME280_SIM
+#include "bme280_sim.h"     // register model stands in for the bus (QEMU / CI)
+#endif
 
 static const char *TAG = "BME280"; // for logs inside bme280.c
 
 static bme280_calib_t calib;         // private globals stay static in .c
 static BME280_S32_t t_fine = 0;
+static uint8_t calib_raw_88[BME280_CALIB_88_LEN];   // raw blocks kept for trace headers
+static uint8_t calib_raw_E1[BME280_CALIB_E1_LEN];
 
 // ---- private helpers ----
 static esp_err_t i2c_write_u8(uint8_t device_addr, uint8_t register_addr, uint8_t val);
@@ -32,6 +39,9 @@ static int16_t   sign_extend_12(uint16_t v);
  */
 esp_err_t bme_i2c_master_init (void){
 
+#if CONFIG_BME280_SIM
+    ESP_LOGI(TAG, "Simulated BME280 at 0x%02X (CONFIG_BME280_SIM); I2C driver not installed", BME280_ADDR);
+#else
     i2c_config_t conf = {
 
         .mode = I2C_MODE_MASTER,
@@ -43,6 +53,7 @@ esp_err_t bme_i2c_master_init (void){
     };
     ESP_ERROR_CHECK(i2c_param_config(I2C_PORT,&conf));
     ESP_ERROR_CHECK(i2c_driver_install(I2C_PORT,conf.mode,0,0,0));
+#endif
     return ESP_OK;
     
 }
@@ -60,8 +71,19 @@ esp_err_t bme_i2c_master_init (void){
  */
 static esp_err_t i2c_write_u8(uint8_t device_addr, uint8_t register_addr,uint8_t val){
 
+#if CONFIG_BME280_SIM
+    if (device_addr != BME280_ADDR) return ESP_FAIL;      // nothing else on the simulated bus
+    const uint8_t frame[2] = { register_addr, val };
+    bme280_sim_i2c_write(frame, sizeof frame);
+    return ESP_OK;
+#else
     //create an empty command for setup 
+#if CONFIG_APP_STATIC_ALLOC
+    uint8_t link[I2C_LINK_RECOMMENDED_SIZE(3)];           // 5 commands, on the stack (no heap)
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof link);
+#else
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+#endif
     i2c_master_start(cmd); // satrt the i2c message 
     i2c_master_write_byte(cmd, (device_addr<<1) | I2C_MASTER_WRITE, true); // write device addr & expect ACK
     i2c_master_write_byte(cmd,register_addr,true);    // send register index, expect ACK
@@ -69,9 +91,14 @@ static esp_err_t i2c_write_u8(uint8_t device_addr, uint8_t register_addr,uint8_t
     i2c_master_stop(cmd);
 
     esp_err_t ret= i2c_master_cmd_begin(I2C_PORT,cmd, pdMS_TO_TICKS(100)); // actaully beigin writting
+#if CONFIG_APP_STATIC_ALLOC
+    i2c_cmd_link_delete_static(cmd);
+#else
     i2c_cmd_link_delete(cmd);                                             // free the command list
+#endif
 
     return ret;
+#endif
 }
 
 /**
@@ -88,8 +115,19 @@ static esp_err_t i2c_write_u8(uint8_t device_addr, uint8_t register_addr,uint8_t
  */
 static esp_err_t i2c_read_bytes(uint8_t device_addr, uint8_t register_addr, uint8_t *buffer, size_t len){
 
+#if CONFIG_BME280_SIM
+    if (device_addr != BME280_ADDR) return ESP_FAIL;
+    bme280_sim_i2c_write(&register_addr, 1);   // set register pointer, then burst read
+    bme280_sim_i2c_read(buffer, len);
+    return ESP_OK;
+#else
     //create an empty command for setup 
+#if CONFIG_APP_STATIC_ALLOC
+    uint8_t link[I2C_LINK_RECOMMENDED_SIZE(4)];           // 8 commands, on the stack (no heap)
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof link);
+#else
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+#endif
     i2c_master_start(cmd); // satrt the i2c message 
     i2c_master_write_byte(cmd, (device_addr<<1) | I2C_MASTER_WRITE, true); // write device addr & expect ACK
     i2c_master_write_byte(cmd,register_addr,true);    // send register index, expect ACK
@@ -106,9 +144,14 @@ static esp_err_t i2c_read_bytes(uint8_t device_addr, uint8_t register_addr, uint
     i2c_master_stop(cmd);
     
     esp_err_t ret= i2c_master_cmd_begin(I2C_PORT,cmd, pdMS_TO_TICKS(100)); // actaully beigin writting
+#if CONFIG_APP_STATIC_ALLOC
+    i2c_cmd_link_delete_static(cmd);
+#else
     i2c_cmd_link_delete(cmd);                                             // free the command list
+#endif
 
     return ret;
+#endif
 }
 
 /**
@@ -171,8 +214,34 @@ static esp_err_t i2c_read_bytes(uint8_t device_addr, uint8_t register_addr, uint
     //   - 0x88..0x9F → Temp & Pressure calibration (T1..T3, P1..P9)
     //   - 0xA0       → Reserved
     //   - 0xA1       → Humidity calibration H1
-    uint8_t buf1[26];
-    ESP_ERROR_CHECK(i2c_read_bytes(BME280_ADDR, 0x88, buf1, 26));
+    uint8_t buf1[BME280_CALIB_88_LEN];
+    ESP_ERROR_CHECK(i2c_read_bytes(BME280_ADDR, 0x88, buf1, BME280_CALIB_88_LEN));
+
+    // -------- Humidity calibration (part 2) --------
+    uint8_t buf2[BME280_CALIB_E1_LEN];
+    ESP_ERROR_CHECK(i2c_read_bytes(BME280_ADDR, 0xE1, buf2, BME280_CALIB_E1_LEN));
+
+    return bme280_set_calib_raw(buf1, buf2);
+    }
+
+/**
+ * @brief Load calibration constants from the two raw register blocks.
+ *
+ * Decodes the 0x88..0xA1 and 0xE1..0xE7 blocks exactly as read from the sensor
+ * and keeps a copy of the raw bytes so they can be saved with recorded traces.
+ * Used by bme280_read_calibration() and by trace replay on the host.
+ *
+ * @param blk88 26 bytes from register 0x88.
+ * @param blkE1 7 bytes from register 0xE1.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL input.
+ */
+esp_err_t bme280_set_calib_raw(const uint8_t *blk88, const uint8_t *blkE1){
+
+    if (!blk88 || !blkE1) return ESP_ERR_INVALID_ARG;
+    memcpy(calib_raw_88, blk88, sizeof calib_raw_88);
+    memcpy(calib_raw_E1, blkE1, sizeof calib_raw_E1);
+    const uint8_t *buf1 = blk88;
+    const uint8_t *buf2 = blkE1;
 
     // -------- Temperature calibration --------
     calib.dig_T1= (uint16_t)((buf1[1]<<8) | buf1[0]);  // 0x88 (LSB), 0x89 (MSB), unsigned
@@ -195,10 +264,7 @@ static esp_err_t i2c_read_bytes(uint8_t device_addr, uint8_t register_addr, uint
     // buf1[24] = 0xA0 → reserved (ignore)
     calib.dig_H1 = buf1[25];
     // -------- Humidity calibration (part 2) --------
-    uint8_t buf2[7];
-    ESP_ERROR_CHECK(i2c_read_bytes(BME280_ADDR, 0xE1, buf2, 7));
-
-    calib.dig_H2= (int16_t)((buf2[1]<<8) | buf2[0]);    // 0x8A (LSB), 0x8B (MSB), signed
+    calib.dig_H2= (int16_t)((buf2[1]<<8) | buf2[0]);    // 0xE1 (LSB), 0xE2 (MSB), signed
     calib.dig_H3= buf2[2];                             // 0xE3, unsigned
     // ^ Shift E4 left by 4 to make room for the low nibble of E5,
     //   then OR in E5's lowest 4 bits to form a 12-bit number in bits 11..0.
@@ -213,7 +279,18 @@ static esp_err_t i2c_read_bytes(uint8_t device_addr, uint8_t register_addr, uint
     calib.dig_H6 = (int8_t)buf2[6]; // 0xE7, signed char
 
     return ESP_OK;
-    }
+}
+
+/**
+ * @brief Copy out the raw calibration blocks last loaded.
+ *
+ * @param blk88 Destination for 26 bytes (0x88..0xA1).
+ * @param blkE1 Destination for 7 bytes (0xE1..0xE7).
+ */
+void bme280_get_calib_raw(uint8_t *blk88, uint8_t *blkE1){
+    memcpy(blk88, calib_raw_88, sizeof calib_raw_88);
+    memcpy(blkE1, calib_raw_E1, sizeof calib_raw_E1);
+}
 
 
 /**
@@ -245,18 +322,70 @@ static int16_t sign_extend_12(uint16_t v)
  * @return ESP_OK on success, or an error code on failure.
  */
  esp_err_t bme280_config_normal(void){
+        return bme280_configure(CTRL_VAL1, CTRL_VAL2, CTRL_VAL3);
+    }
 
+/**
+ * @brief Write the three control registers in the order the datasheet needs.
+ *
+ * ctrl_hum only takes effect with the following ctrl_meas write.
+ *
+ * @param ctrl_hum  Humidity oversampling (0xF2).
+ * @param ctrl_meas T/P oversampling and mode (0xF4).
+ * @param config    Standby time and IIR filter (0xF5).
+ * @return ESP_OK on success.
+ */
+esp_err_t bme280_configure(uint8_t ctrl_hum, uint8_t ctrl_meas, uint8_t config)
+{
         // 1.Start by configuring Humidity measuremnt
-        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_HUM,  CTRL_VAL1));   
+        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_HUM,  ctrl_hum));   
         
         // 2.Next  configure pressure & temp & set sensor in normal mode 
-        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_MEAS, CTRL_VAL2)); 
+        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_MEAS, ctrl_meas)); 
 
         // 3. select the standby time (off time)
-        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_CONF, CTRL_VAL3)); 
+        ESP_ERROR_CHECK(i2c_write_u8(BME280_ADDR, CTRL_CONF, config)); 
 
        return ESP_OK;
-    }
+}
+
+/**
+ * @brief Wait until the first conversion after bme280_configure() is readable.
+ *
+ * Until then the data registers hold their reset value (adc_T 0x80000, which
+ * compensates to a plausible-looking ~26 °C / ~820 hPa), so a read straight
+ * after configuring feeds filters and history a sample that never happened.
+ * Polls the temperature registers every 10 ms (one tick at 100 Hz).
+ *
+ * @param timeout_ms Give up after this long (t_meas is ~30 ms at x4).
+ * @return ESP_OK once a measured value is there, ESP_ERR_TIMEOUT otherwise.
+ */
+esp_err_t bme280_wait_first_conversion(int timeout_ms)
+{
+        for (int waited = 0; waited <= timeout_ms; waited += 10) {
+            uint8_t d[3];
+            ESP_ERROR_CHECK(i2c_read_bytes(BME280_ADDR, 0xFA, d, sizeof(d)));   // T_msb, T_lsb, T_xlsb
+            uint32_t adc_T = ((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4);
+            if (adc_T != 0x80000) return ESP_OK;
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief Start one forced-mode conversion.
+ *
+ * Writes ctrl_meas with the mode bits set to forced; the sensor converts once
+ * with the latched settings and returns to sleep. Results are readable after
+ * BME280_FORCED_WAIT_MS (for the x4 settings).
+ *
+ * @param ctrl_meas T/P oversampling (mode bits are replaced).
+ * @return ESP_OK on success.
+ */
+esp_err_t bme280_force_measurement(uint8_t ctrl_meas)
+{
+        return i2c_write_u8(BME280_ADDR, CTRL_MEAS, (uint8_t)((ctrl_meas & ~0x03) | 0x01));
+}
 
 /**
  * @brief Read raw ADC values for temperature, pressure, and humidity.
@@ -34,6 +34,19 @@
 #define CTRL_CONF 0xF5      // config register to select stand by time and enable IRR Filter 
 #define CTRL_VAL3 0xA8     // 500ms stanby time, ebnable IRR and disable SPI
 
+// oversampled mode (CONFIG_APP_OVERSAMPLE): x1 everywhere, 20 ms standby, IIR off
+// -> a fresh conversion every 29.3 ms (34 Hz); filtering is done in software
+#define CTRL_VAL1_FAST 0x01     // x1 humidity
+#define CTRL_VAL2_FAST 0x27     // x1 temp and press, normal mode
+#define CTRL_VAL3_FAST 0xE0     // 20 ms standby, IIR off, SPI off
+
+// forced mode (CONFIG_APP_SAMPLE_ADAPTIVE): one conversion at the normal-mode settings;
+// x4 T/P/H takes at most 1.25 + 2.3*4 + 2 * (2.3*4 + 0.575) = 30 ms
+#define BME280_FORCED_WAIT_MS 40
+
+#define BME280_CALIB_88_LEN 26   // calibration block 0x88..0xA1
+#define BME280_CALIB_E1_LEN 7    // calibration block 0xE1..0xE7
+
 //structure to store temp,press, & humididty calibration coeffs (Table#16 in BME280 Datasheet)
  typedef struct {
     
@@ -53,7 +66,12 @@ typedef int32_t BME280_S32_t;
 esp_err_t bme_i2c_master_init(void);
 esp_err_t bme280_init(void);
 esp_err_t bme280_read_calibration(void);
+esp_err_t bme280_set_calib_raw(const uint8_t *blk88, const uint8_t *blkE1);
+void      bme280_get_calib_raw(uint8_t *blk88, uint8_t *blkE1);
 esp_err_t bme280_config_normal(void);
+esp_err_t bme280_configure(uint8_t ctrl_hum, uint8_t ctrl_meas, uint8_t config);
+esp_err_t bme280_force_measurement(uint8_t ctrl_meas);   // one conversion, then sleep
+esp_err_t bme280_wait_first_conversion(int timeout_ms);  // data registers past their reset value
 
 esp_err_t bme280_read_raw(int32_t *adc_T, int32_t *adc_P, int32_t *adc_H);
 
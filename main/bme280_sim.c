@@ -0,0 +1,442 @@
+/*
+ * BME280 simulated device (implementation)
+ * Register map and measurement engine modelled on the Bosch datasheet:
+ * - 0x88..0xA1 / 0xE1..0xE7 calibration (datasheet example coefficients),
+ *   0xD0 chip ID, 0xE0 soft reset, 0xF3 status (measuring, im_update).
+ * - ctrl_hum only takes effect on the next ctrl_meas write; ctrl_meas selects
+ *   osrs_t/osrs_p and sleep/forced/normal; config selects t_sb and the IIR filter.
+ * - Conversions take the datasheet's max t_measure for the current oversampling,
+ *   normal mode repeats every t_measure + t_standby, forced mode runs once and
+ *   returns to sleep. The state is advanced lazily on every bus access.
+ * - 0xF7..0xFE hold the last completed conversion; a burst read is served in
+ *   one piece, so it never mixes two conversions (datasheet "shadowing").
+ * - Optional die self-heating that follows the conversion rate with a thermal
+ *   lag (bme280_sim_set_selfheat()), so duty-cycle changes show up as bias.
+ * Data values come from per-channel waveforms and are turned back into raw ADC
+ * counts by inverting the compensation formulas against the model's own calibration.
+ */
+
+#include "bme280_sim.h"
+#include "bme280.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REG_DATA_FIRST 0xF7
+#define REG_DATA_LAST  0xFE
+#define NVM_COPY_US    2000      // im_update stays set this long after reset
+
+static uint8_t regs[256];        // whole register map, addressed by register index
+static uint8_t reg_ptr;          // auto-incrementing read pointer
+static bool    powered;          // false until the first bus access
+static uint8_t osrs_h_latched;   // ctrl_hum value in effect (latched by ctrl_meas)
+
+static bme280_sim_clock_t clock_fn = esp_timer_get_time;
+static int64_t  nvm_busy_until;  // soft reset NVM copy window
+static int64_t  mode_t0;         // start of the first conversion in the current mode
+static uint64_t published;       // conversions published since mode_t0 (normal mode)
+static uint32_t conv_seq;        // id of the conversion now in 0xF7..0xFE
+static uint32_t last_read_seq;
+static bool     conv_read;       // current conversion has been read at least once
+static double   iir[2];          // filtered T and P
+static bool     iir_primed;
+static uint32_t rng = 0x2545F491u;
+static bme280_sim_selfheat_t heat_cfg;
+static double   heat_C;          // die above air, °C
+static int64_t  heat_last_us;    // previous conversion (0 = none yet)
+static bme280_sim_stats_t stats;
+
+static bme280_sim_wave_t waves[BME280_SIM_CHANNELS] = {
+    [BME280_SIM_CH_T] = { 22.5,   1.5,  86400.0, 0.0, 0.02 },
+    [BME280_SIM_CH_P] = { 101325.0, 150.0, 43200.0, 0.0, 2.0 },
+    [BME280_SIM_CH_H] = { 45.0,   5.0,  86400.0, 0.0, 0.3 },
+};
+
+// Calibration block 0x88..0xA1 (T1..T3, P1..P9, reserved, H1), little-endian
+static const uint8_t calib_88[26] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,                         // T1=27504 T2=26435 T3=-1000
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,             // P1=36477 P2=-10685 P3=3024 P4=2855
+    0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17, // P5=140 P6=-7 P7=15500 P8=-14600 P9=6000
+    0x00, 0x4B                                                  // reserved, H1=75
+};
+
+// Calibration block 0xE1..0xE7 (H2..H6, H4/H5 packed 12-bit)
+static const uint8_t calib_E1[7] = {
+    0x6A, 0x01, 0x00,   // H2=362 H3=0
+    0x13, 0x29, 0x03,   // H4=313 (0x13<<4 | 0x9), H5=50 (0x03<<4 | 0x2)
+    0x1E                // H6=30
+};
+
+// Same coefficients in decoded form for the inverse compensation
+static const double T1 = 27504, T2 = 26435, T3 = -1000;
+static const double P1 = 36477, P2 = -10685, P3 = 3024, P4 = 2855, P5 = 140,
+                    P6 = -7, P7 = 15500, P8 = -14600, P9 = 6000;
+static const double H1 = 75, H2 = 362, H3 = 0, H4 = 313, H5 = 50, H6 = 30;
+
+// ---- datasheet tables ----
+
+static const uint8_t  os_count[8]  = { 0, 1, 2, 4, 8, 16, 16, 16 };
+static const uint32_t t_sb_us[8]   = { 500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
+static const uint8_t  iir_coeff[8] = { 1, 2, 4, 8, 16, 16, 16, 16 };
+
+static uint8_t osrs_t(void) { return os_count[(regs[CTRL_MEAS] >> 5) & 7]; }
+static uint8_t osrs_p(void) { return os_count[(regs[CTRL_MEAS] >> 2) & 7]; }
+static uint8_t osrs_h(void) { return os_count[osrs_h_latched & 7]; }
+static uint8_t mode(void)   { return regs[CTRL_MEAS] & 3; }
+
+/**
+ * @brief Maximum measurement time for the current oversampling (datasheet 9.1).
+ *
+ * t = 1.25 + 2.3*T + (2.3*P + 0.575) + (2.3*H + 0.575) ms, skipped channels add 0.
+ */
+uint32_t bme280_sim_measure_time_us(void)
+{
+    double ms = 1.25 + 2.3 * osrs_t();
+    if (osrs_p()) ms += 2.3 * osrs_p() + 0.575;
+    if (osrs_h()) ms += 2.3 * osrs_h() + 0.575;
+    return (uint32_t)(ms * 1000.0 + 0.5);
+}
+
+uint32_t bme280_sim_period_us(void)
+{
+    return bme280_sim_measure_time_us() + t_sb_us[(regs[CTRL_CONF] >> 5) & 7];
+}
+
+// ---- compensation (forward, model-side copy) and its inverse ----
+
+static double comp_T(int32_t adc, double *t_fine)
+{
+    double v1 = ((double)adc / 16384.0 - T1 / 1024.0) * T2;
+    double v2 = ((double)adc / 131072.0 - T1 / 8192.0);
+    v2 = v2 * v2 * T3;
+    *t_fine = (double)(int32_t)(v1 + v2);
+    return (v1 + v2) / 5120.0;
+}
+
+static double comp_P(int32_t adc, double t_fine)
+{
+    double v1 = t_fine / 2.0 - 64000.0;
+    double v2 = v1 * v1 * P6 / 32768.0;
+    v2 = v2 + v1 * P5 * 2.0;
+    v2 = v2 / 4.0 + P4 * 65536.0;
+    v1 = (P3 * v1 * v1 / 524288.0 + P2 * v1) / 524288.0;
+    v1 = (1.0 + v1 / 32768.0) * P1;
+    double p = 1048576.0 - (double)adc;
+    p = (p - v2 / 4096.0) * 6250.0 / v1;
+    v1 = P9 * p * p / 2147483648.0;
+    v2 = p * P8 / 32768.0;
+    return p + (v1 + v2 + P7) / 16.0;
+}
+
+static double comp_H(int32_t adc, double t_fine)
+{
+    double h = t_fine - 76800.0;
+    h = (adc - (H4 * 64.0 + H5 / 16384.0 * h)) *
+        (H2 / 65536.0 * (1.0 + H6 / 67108864.0 * h * (1.0 + H3 / 67108864.0 * h)));
+    return h * (1.0 - H1 * h / 524288.0);
+}
+
+// Smallest raw code whose compensated value reaches the target (monotonic searches).
+static int32_t invert_T(double target, double *t_fine)
+{
+    int32_t lo = 0, hi = (1 << 20) - 1;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (comp_T(mid, t_fine) < target) lo = mid + 1; else hi = mid;
+    }
+    comp_T(lo, t_fine);
+    return lo;
+}
+
+static int32_t invert_P(double target, double t_fine)
+{
+    int32_t lo = 0, hi = (1 << 20) - 1;     // pressure falls as the raw code rises
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (comp_P(mid, t_fine) > target) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static int32_t invert_H(double target, double t_fine)
+{
+    int32_t lo = 0, hi = 0xFFFF;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (comp_H(mid, t_fine) < target) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// ---- waveforms ----
+
+static double gauss(void)
+{
+    // xorshift32 + Box-Muller; deterministic for a given seed
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    double u1 = ((rng >> 8) + 1.0) / 16777217.0;
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    double u2 = (rng >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double wave_at(bme280_sim_channel_t ch, double t_s, uint8_t os)
+{
+    const bme280_sim_wave_t *w = &waves[ch];
+    double v = w->base + w->slope_per_h * t_s / 3600.0;
+    if (w->period_s > 0.0) v += w->amplitude * sin(2.0 * M_PI * t_s / w->period_s);
+    if (w->noise_sd > 0.0) v += w->noise_sd / sqrt(os ? os : 1) * gauss();
+    return v;
+}
+
+// ---- measurement engine ----
+
+static void put20(uint8_t *d, int32_t v)
+{
+    d[0] = (uint8_t)(v >> 12);
+    d[1] = (uint8_t)(v >> 4);
+    d[2] = (uint8_t)((v & 0x0F) << 4);
+}
+
+// Complete one conversion that ended at time t_us and latch it into 0xF7..0xFE.
+static void publish(int64_t t_us)
+{
+    double t_s = (double)t_us / 1e6;
+    uint8_t ot = osrs_t(), op = osrs_p(), oh = osrs_h();
+    uint8_t coeff = iir_coeff[(regs[CTRL_CONF] >> 2) & 7];
+    uint8_t *d = &regs[REG_DATA_FIRST];
+
+    double T = wave_at(BME280_SIM_CH_T, t_s, ot);
+    double P = wave_at(BME280_SIM_CH_P, t_s, op);
+    double H = wave_at(BME280_SIM_CH_H, t_s, oh);
+    if (heat_cfg.tau_s > 0.0) {
+        double dt = heat_last_us ? (double)(t_us - heat_last_us) / 1e6 : 0.0;
+        if (dt > 0.0) {
+            double target = heat_cfg.offset_C + heat_cfg.C_per_hz / dt;
+            heat_C += (target - heat_C) * (1.0 - exp(-dt / heat_cfg.tau_s));
+        }
+        heat_last_us = t_us;
+        // Magnus: same vapour pressure over a warmer die reads as lower RH
+        H *= exp(17.62 * T / (243.12 + T) - 17.62 * (T + heat_C) / (243.12 + T + heat_C));
+        T += heat_C;
+    }
+    if (H < 0.0) H = 0.0;
+    if (H > 100.0) H = 100.0;
+
+    // IIR filter on T and P: x = (x_prev * (c - 1) + x_new) / c
+    if (!iir_primed || coeff == 1) { iir[0] = T; iir[1] = P; iir_primed = true; }
+    else {
+        iir[0] = (iir[0] * (coeff - 1) + T) / coeff;
+        iir[1] = (iir[1] * (coeff - 1) + P) / coeff;
+    }
+
+    double t_fine;
+    int32_t adc_T = invert_T(iir[0], &t_fine);
+    int32_t adc_P = invert_P(iir[1], t_fine);
+    int32_t adc_H = invert_H(H, t_fine);
+
+    // Unfiltered resolution is 16 + (osrs - 1) bits; the filter gives full 20 bits.
+    if (coeff == 1) {
+        int drop_t = 4 - (ot > 1 ? __builtin_ctz(ot) : 0);
+        int drop_p = 4 - (op > 1 ? __builtin_ctz(op) : 0);
+        adc_T &= ~((1 << drop_t) - 1);
+        adc_P &= ~((1 << drop_p) - 1);
+    }
+
+    put20(&d[0], op ? adc_P : 0x80000);   // skipped channels read back their reset value
+    put20(&d[3], ot ? adc_T : 0x80000);
+    if (!oh) adc_H = 0x8000;
+    d[6] = (uint8_t)(adc_H >> 8);
+    d[7] = (uint8_t)adc_H;
+
+    if (conv_seq > 0 && !conv_read) stats.missed++;
+    conv_seq++;
+    conv_read = false;
+    stats.conversions++;
+}
+
+// Bring the data registers up to time `now`; returns true while a conversion runs.
+static bool advance(int64_t now)
+{
+    uint32_t t_meas = bme280_sim_measure_time_us();
+    switch (mode()) {
+    case 1:
+    case 2:   // forced: one conversion, then back to sleep
+        if (now < mode_t0 + t_meas) return true;
+        publish(mode_t0 + t_meas);
+        regs[CTRL_MEAS] &= (uint8_t)~3;
+        return false;
+    case 3: { // normal: conversion k runs over [t0 + k*period, t0 + k*period + t_meas)
+        uint32_t period = bme280_sim_period_us();
+        if (now < mode_t0 + t_meas) return true;
+        uint64_t done = (uint64_t)((now - mode_t0 - t_meas) / period) + 1;
+        if (done - published > 64) {   // long gap: older conversions are invisible, skip ahead
+            stats.missed += (uint32_t)(done - published - 64);
+            published = done - 64;
+        }
+        while (published < done) {
+            publish(mode_t0 + (int64_t)published * period + t_meas);
+            published++;
+        }
+        return (now - mode_t0) % period < t_meas;
+    }
+    default:
+        return false;
+    }
+}
+
+// ---- public API ----
+
+void bme280_sim_reset(void)
+{
+    memset(regs, 0, sizeof regs);
+    memcpy(&regs[0x88], calib_88, sizeof calib_88);
+    memcpy(&regs[0xE1], calib_E1, sizeof calib_E1);
+    static const uint8_t data_reset[8] = { 0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00 };
+    memcpy(&regs[REG_DATA_FIRST], data_reset, sizeof data_reset);
+    regs[BME280_REG_ID] = BME280_CHIP_ID;
+
+    reg_ptr = 0;
+    osrs_h_latched = 0;
+    nvm_busy_until = clock_fn() + NVM_COPY_US;
+    mode_t0 = 0;
+    published = 0;
+    conv_seq = last_read_seq = 0;
+    conv_read = false;
+    iir_primed = false;
+    memset(&stats, 0, sizeof stats);
+    powered = true;
+}
+
+void bme280_sim_i2c_write(const uint8_t *buf, size_t len)
+{
+    if (!powered) bme280_sim_reset();
+    int64_t now = clock_fn();
+    advance(now);
+
+    reg_ptr = buf[0];
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = buf[i], val = buf[i + 1];
+        if (reg == BME280_REG_RESET) {
+            if (val == BME280_RESET_CMD) bme280_sim_reset();
+        } else if (reg == CTRL_HUM) {
+            regs[reg] = val & 0x07;                       // effective after the next ctrl_meas write
+        } else if (reg == CTRL_MEAS) {
+            regs[reg] = val;
+            osrs_h_latched = regs[CTRL_HUM];
+            if (val & 3) {
+                mode_t0 = now;                            // a conversion starts right away
+                published = 0;
+            }
+        } else if (reg == CTRL_CONF) {
+            regs[reg] = val & 0xFD;                       // bit 1 is reserved
+            if (mode() == 3) {                            // new t_sb: restart the normal-mode cycle
+                mode_t0 = now;
+                published = 0;
+            }
+        }
+    }
+}
+
+void bme280_sim_i2c_read(uint8_t *buf, size_t len)
+{
+    if (!powered) bme280_sim_reset();
+    int64_t now = clock_fn();
+    bool measuring = advance(now);
+    regs[BME280_REG_STATUS] = (uint8_t)((measuring ? 0x08 : 0) | (now < nvm_busy_until ? 0x01 : 0));
+
+    unsigned first = reg_ptr, last = reg_ptr + (unsigned)len - 1;
+    if (first <= REG_DATA_LAST && last >= REG_DATA_FIRST) {
+        stats.data_reads++;
+        if (measuring) stats.reads_measuring++;
+        if (conv_seq == last_read_seq) stats.stale_reads++;
+        if (first > REG_DATA_FIRST || last < REG_DATA_LAST) stats.split_reads++;
+        last_read_seq = conv_seq;
+        conv_read = true;
+    }
+
+    for (size_t i = 0; i < len; i++) buf[i] = regs[(uint8_t)(reg_ptr + i)];
+    reg_ptr = (uint8_t)(reg_ptr + len);
+}
+
+void bme280_sim_set_clock(bme280_sim_clock_t now_us)
+{
+    clock_fn = now_us ? now_us : esp_timer_get_time;
+}
+
+void bme280_sim_set_wave(bme280_sim_channel_t ch, const bme280_sim_wave_t *w)
+{
+    if (ch < BME280_SIM_CHANNELS && w) waves[ch] = *w;
+}
+
+/**
+ * @brief Set the die self-heating model (NULL = off).
+ */
+void bme280_sim_set_selfheat(const bme280_sim_selfheat_t *h)
+{
+    heat_cfg = h ? *h : (bme280_sim_selfheat_t){ 0 };
+    heat_C = 0.0;
+    heat_last_us = 0;
+}
+
+/**
+ * @brief Parse "offset_C,C_per_hz,tau_s" and install it as the self-heating model.
+ *
+ * @return 0, or -1 if the spec is malformed (model unchanged).
+ */
+int bme280_sim_parse_selfheat(const char *spec)
+{
+    bme280_sim_selfheat_t h;
+    if (sscanf(spec, "%lf,%lf,%lf", &h.offset_C, &h.C_per_hz, &h.tau_s) != 3 || h.tau_s <= 0.0) return -1;
+    bme280_sim_set_selfheat(&h);
+    return 0;
+}
+
+/**
+ * @brief Parse waveform overrides of the form "T=base,amp,period,slope,noise;P=...".
+ *
+ * Missing trailing fields keep their current values.
+ *
+ * @return Number of channels updated, or -1 on a malformed spec.
+ */
+int bme280_sim_parse_waves(const char *spec)
+{
+    int updated = 0;
+    const char *p = spec;
+    while (p && *p) {
+        bme280_sim_channel_t ch;
+        switch (*p) {
+        case 'T': ch = BME280_SIM_CH_T; break;
+        case 'P': ch = BME280_SIM_CH_P; break;
+        case 'H': ch = BME280_SIM_CH_H; break;
+        default:  return -1;
+        }
+        if (p[1] != '=') return -1;
+        p += 2;
+        double *fields[5] = { &waves[ch].base, &waves[ch].amplitude, &waves[ch].period_s,
+                              &waves[ch].slope_per_h, &waves[ch].noise_sd };
+        for (int i = 0; i < 5 && *p && *p != ';'; i++) {
+            char *end;
+            double v = strtod(p, &end);
+            if (end == p) return -1;
+            *fields[i] = v;
+            p = (*end == ',') ? end + 1 : end;
+        }
+        updated++;
+        if (*p == ';') p++;
+    }
+    return updated;
+}
+
+void bme280_sim_set_seed(uint32_t seed)
+{
+    rng = seed ? seed : 0x2545F491u;
+}
+
+void bme280_sim_get_stats(bme280_sim_stats_t *out)
+{
+    if (out) *out = stats;
+}
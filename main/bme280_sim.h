@@ -0,0 +1,67 @@
+/*
+ * BME280 simulated device (public API)
+ * Register-level model of the sensor behind the I2C bus: calibration blocks,
+ * ID/reset/status, ctrl_hum/ctrl_meas/config semantics, sleep/forced/normal
+ * timing per oversampling setting, IIR filter, and data registers generated
+ * from configurable T/P/H waveforms. Bus transactions arrive as raw bytes.
+ */
+
+#ifndef BME280_SIM_H
+#define BME280_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+    BME280_SIM_CH_T = 0,   // °C
+    BME280_SIM_CH_P,       // Pa
+    BME280_SIM_CH_H,       // %RH
+    BME280_SIM_CHANNELS
+} bme280_sim_channel_t;
+
+// value(t) = base + amplitude*sin(2*pi*t/period_s) + slope_per_h*t/3600 + N(0, noise_sd)
+typedef struct {
+    double base;
+    double amplitude;
+    double period_s;     // 0 = no oscillation
+    double slope_per_h;
+    double noise_sd;     // per x1 conversion; shrinks with sqrt(oversampling)
+} bme280_sim_wave_t;
+
+// Die self-heating: the sensor sits offset_C + C_per_hz * (conversions per
+// second) above the air, reached with time constant tau_s. Humidity reads low
+// accordingly (same vapour pressure, warmer die). All zero = off.
+typedef struct {
+    double offset_C;     // board warmth independent of the sample rate
+    double C_per_hz;     // per conversion per second
+    double tau_s;
+} bme280_sim_selfheat_t;
+
+// Counters for timing/coherency benchmarks (cleared by bme280_sim_reset()).
+typedef struct {
+    uint32_t conversions;       // measurements completed
+    uint32_t data_reads;        // read transactions touching 0xF7..0xFE
+    uint32_t reads_measuring;   // data reads issued while a conversion was running
+    uint32_t stale_reads;       // data reads returning the same conversion as the previous read
+    uint32_t missed;            // conversions overwritten before anyone read them
+    uint32_t split_reads;       // T/P/H fetched by more than one transaction (can tear)
+} bme280_sim_stats_t;
+
+typedef int64_t (*bme280_sim_clock_t)(void);   // microseconds, monotonic
+
+void bme280_sim_reset(void);                                // power-on register state
+void bme280_sim_i2c_write(const uint8_t *buf, size_t len); // [reg, data, reg, data, ...]
+void bme280_sim_i2c_read(uint8_t *buf, size_t len);       // burst read from register pointer
+
+void bme280_sim_set_clock(bme280_sim_clock_t now_us);     // default: esp_timer_get_time
+void bme280_sim_set_wave(bme280_sim_channel_t ch, const bme280_sim_wave_t *w);
+int  bme280_sim_parse_waves(const char *spec);            // "T=22.5,1.5,86400,0,0.02;H=..."
+void bme280_sim_set_seed(uint32_t seed);
+void bme280_sim_set_selfheat(const bme280_sim_selfheat_t *h);
+int  bme280_sim_parse_selfheat(const char *spec);         // "offset_C,C_per_hz,tau_s"
+void bme280_sim_get_stats(bme280_sim_stats_t *out);
+
+uint32_t bme280_sim_measure_time_us(void);   // max conversion time for current settings
+uint32_t bme280_sim_period_us(void);         // normal-mode period (measure + t_standby)
+
+#endif // BME280_SIM_H
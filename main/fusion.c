@@ -0,0 +1,205 @@
+/*
+ * Inside/outside temperature fusion (implementation).
+ * - Extended Kalman filter, state x = [T, T_out, ln k, q], time in hours.
+ *   k is carried as its logarithm: it stays positive (heat flows from warm to
+ *   cold) without clamping, which would leave the covariance inconsistent
+ *   and let q run away.
+ *   Prediction integrates the heat balance over the sample interval (Euler;
+ *   k * dt is ~1e-4 at 1 Hz); only the first row of the Jacobian differs
+ *   from the identity.
+ * - Measurements are scalar (one state each), so an update is a division,
+ *   no matrix inverse: the inside sample every loop, the outside value when
+ *   it changes or every OUT_REFRESH_US (Open-Meteo repeats one value for
+ *   15 min; feeding it every 6 s would count one reading many times).
+ * - Samples flagged by anomaly.c only advance the prediction.
+ * - The filter only starts from a temperature inside the sensor's range, and
+ *   starts over when REPRIME_N inside samples in a row land more than GATE_SD
+ *   off the prediction (those are not folded in): a bad first value, such as
+ *   the BME280 reset reading, would otherwise be explained away as a huge k
+ *   and a wrong equilibrium that take hours to unlearn.
+ * - Called from the sensor loop only; fusion_get() readers get a consistent
+ *   enough copy (floats, no torn fields on the ESP32), as anomaly.c.
+ */
+
+#include "fusion.h"
+#include <math.h>
+
+enum { S_T = 0, S_OUT, S_LNK, S_Q, NS };
+
+// Noise, per hour for the random walks: the sensor is good to a few hundredths,
+// the forecast to half a degree; the room's k changes with doors and windows,
+// its heat input with the heating cycle and the sun.
+#define R_IN       (0.03f * 0.03f)    // °C², inside sample
+#define R_OUT      (0.5f * 0.5f)      // °C², Open-Meteo value
+#define Q_T        (0.05f * 0.05f)    // °C²/h, unmodelled inside change
+#define Q_OUT      (1.0f * 1.0f)      // °C²/h, outside drift between fetches
+#define Q_LNK      (0.02f * 0.02f)    // per h: k drifts ~2 % per sqrt(hour)
+#define Q_Q        (0.1f * 0.1f)      // (°C/h)²/h
+#define K0         0.2f               // 1/h: a 5 h time constant, typical for a house
+#define OUT_REFRESH_US  (900LL * 1000000)
+#define MAX_DT_H   (60.0f / 3600.0f)  // a longer gap is predicted as one minute (stalled loop)
+#define T_MIN_C    (-40.0f)           // BME280 operating range: anything outside is not a room
+#define T_MAX_C    85.0f
+#define GATE_SD    10.0f              // innovation beyond this many sd: the state, not the sample, is off ...
+#define REPRIME_N  3                  // ... once it happens this many times in a row
+
+static float    x[NS];
+static float    P[NS][NS];
+static bool     primed, have_out;
+static int64_t  last_us, out_us;
+static float    last_out = NAN;
+static uint32_t n_used;
+static uint8_t  n_far;
+
+static void predict(float dt_h)
+{
+    float k = expf(x[S_LNK]), d = x[S_T] - x[S_OUT];
+    float f[NS] = { 1.0f - k * dt_h, k * dt_h, -k * d * dt_h, dt_h };   // Jacobian row 0
+    x[S_T] += dt_h * (x[S_Q] - k * d);
+
+    // P = F P F' + Q dt with F = I except row 0
+    float r[NS];
+    for (int j = 0; j < NS; j++) {
+        r[j] = 0.0f;
+        for (int m = 0; m < NS; m++) r[j] += f[m] * P[m][j];
+    }
+    float p00 = 0.0f;
+    for (int m = 0; m < NS; m++) p00 += r[m] * f[m];
+    for (int j = 1; j < NS; j++) P[0][j] = P[j][0] = r[j];
+    P[0][0] = p00 + Q_T * dt_h;
+    P[S_OUT][S_OUT] += Q_OUT * dt_h;
+    P[S_LNK][S_LNK] += Q_LNK * dt_h;
+    P[S_Q][S_Q] += Q_Q * dt_h;
+}
+
+// Scalar update of state i. The outside temperature is a "consider" state
+// (Schmidt-Kalman): inside samples never move it, or the filter would explain
+// the room's changes by bending the outside temperature. Its uncertainty still
+// reaches k and q through the covariance. Joseph-style terms, valid for any gain.
+static void measure(int i, float z, float R)
+{
+    float s = P[i][i] + R;
+    float y = z - x[i];
+    float k[NS], pi[NS];
+    for (int j = 0; j < NS; j++) {
+        pi[j] = P[i][j];
+        k[j] = (j == S_OUT && i != S_OUT) ? 0.0f : pi[j] / s;
+        x[j] += k[j] * y;
+    }
+    for (int a = 0; a < NS; a++) {
+        for (int b = a; b < NS; b++) {
+            P[a][b] = P[b][a] = P[a][b] - k[a] * pi[b] - pi[a] * k[b] + k[a] * k[b] * s;
+        }
+    }
+}
+
+static bool prime(float T, float out, int64_t ts_us)
+{
+    if (!(T >= T_MIN_C && T <= T_MAX_C)) return false;   // also rejects NAN
+    have_out = !isnan(out);
+    x[S_T] = T;
+    x[S_OUT] = have_out ? out : T;
+    x[S_LNK] = logf(K0);
+    x[S_Q] = have_out ? K0 * (T - out) : 0.0f;  // assume the room starts in equilibrium
+    for (int a = 0; a < NS; a++) {
+        for (int b = 0; b < NS; b++) P[a][b] = 0.0f;
+    }
+    P[S_T][S_T] = R_IN;
+    P[S_OUT][S_OUT] = have_out ? R_OUT : 25.0f;
+    P[S_LNK][S_LNK] = 1.0f;                   // k within a factor e of K0
+    P[S_Q][S_Q] = 4.0f;
+    out_us = last_us = ts_us;
+    last_out = out;
+    n_used = 1;
+    n_far = 0;
+    primed = true;
+    return true;
+}
+
+/**
+ * @brief Advance the filter to an inside sample and fold in the measurements.
+ *
+ * @param s       Inside sample (T_C used).
+ * @param out_T_C Latest outside temperature, NAN if not fetched yet.
+ * @param suspect True if anomaly.c flagged the temperature: predict only.
+ */
+void fusion_update(const sample_t *s, float out_T_C, bool suspect)
+{
+    if (!primed) {
+        if (!suspect) prime((float)s->T_C, out_T_C, s->ts_us);
+        return;
+    }
+    float dt_h = (float)(s->ts_us - last_us) / 3.6e9f;
+    last_us = s->ts_us;
+    if (dt_h > MAX_DT_H) dt_h = MAX_DT_H;
+    if (dt_h > 0.0f) predict(dt_h);
+
+    if (!isnan(out_T_C) && (out_T_C != last_out || s->ts_us - out_us >= OUT_REFRESH_US)) {
+        if (!have_out) {                         // first fetch: start from equilibrium with it
+            x[S_OUT] = out_T_C;
+            x[S_Q] = expf(x[S_LNK]) * (x[S_T] - out_T_C);
+            P[S_OUT][S_OUT] = R_OUT;
+            have_out = true;
+        } else {
+            measure(S_OUT, out_T_C, R_OUT);
+        }
+        last_out = out_T_C;
+        out_us = s->ts_us;
+    }
+    if (!suspect) {
+        float y = (float)s->T_C - x[S_T];
+        if (y * y > GATE_SD * GATE_SD * (P[S_T][S_T] + R_IN)) {
+            if (++n_far >= REPRIME_N) prime((float)s->T_C, have_out ? last_out : NAN, s->ts_us);
+            return;
+        }
+        n_far = 0;
+        measure(S_T, (float)s->T_C, R_IN);
+        n_used++;
+    }
+}
+
+/**
+ * @brief Copy out the current estimate.
+ *
+ * @param[out] out Estimate; T_eq_C is NAN until k is known to within a
+ *                 factor of ~1.6 (needs outside data and a few hours of
+ *                 change).
+ * @return false before the first sample.
+ */
+bool fusion_get(fusion_t *out)
+{
+    if (!primed) return false;
+    float k = expf(x[S_LNK]), lnk_sd = sqrtf(P[S_LNK][S_LNK]);
+    out->n = n_used;
+    out->T_C = x[S_T];
+    out->T_sd = sqrtf(P[S_T][S_T]);
+    out->out_T_C = have_out ? x[S_OUT] : NAN;
+    out->k_per_h = k;
+    out->k_sd = k * lnk_sd;                  // first order
+    out->heat_C_per_h = x[S_Q];
+    out->rate_C_per_h = x[S_Q] - k * (x[S_T] - x[S_OUT]);
+    out->T_eq_C = (have_out && lnk_sd < 0.5f) ? x[S_OUT] + x[S_Q] / k : NAN;
+    return true;
+}
+
+/**
+ * @brief Time until the model reaches a temperature.
+ *
+ * With a known equilibrium the approach is exponential,
+ * T(t) = T_eq + (T - T_eq) * e^(-k t), and thresholds beyond T_eq are never
+ * reached; otherwise the current model rate is extrapolated linearly.
+ *
+ * @return Seconds (0 if already there), NAN if not heading there.
+ */
+float fusion_eta_s(const fusion_t *f, float threshold)
+{
+    float gap = threshold - f->T_C;
+    if (gap == 0.0f) return 0.0f;
+    if (isnan(f->T_eq_C)) {
+        if (f->rate_C_per_h == 0.0f || (gap > 0) != (f->rate_C_per_h > 0)) return NAN;
+        return gap / f->rate_C_per_h * 3600.0f;
+    }
+    float from = f->T_C - f->T_eq_C, to = threshold - f->T_eq_C;
+    if (from == 0.0f || (from > 0) != (to > 0) || fabsf(to) >= fabsf(from)) return NAN;
+    return logf(from / to) / f->k_per_h * 3600.0f;
+}
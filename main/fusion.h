@@ -0,0 +1,36 @@
+/*
+ * Inside/outside temperature fusion (public API).
+ * - Kalman filter over a one-zone heat balance of the room:
+ *       dT/dt = -k * (T - T_out) + q
+ *   T inside temperature, T_out outside temperature, k heat-exchange
+ *   coefficient (1/h, inverse of the room's time constant), q net heat
+ *   input (heating, sun, people; °C/h).
+ * - The BME280 measures T every second; Open-Meteo measures T_out every
+ *   15 min and late, so T_out is a state of its own that only drifts
+ *   between fetches. k and q are slow random walks.
+ * - Outputs a smoothed inside temperature that follows ramps without lag,
+ *   k, q and the equilibrium temperature T_out + q/k the room is heading
+ *   to. The forecast alert uses the latter to drop linear projections that
+ *   the room cannot actually reach; threshold alerts can use the smoothed
+ *   value (CONFIG_APP_ALERT_USE_FUSED).
+ * - Fixed 4-state filter in single-precision float, no allocation.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "sample_pipeline.h"
+
+typedef struct {
+    uint32_t n;                       // inside samples used
+    float    T_C, T_sd;               // smoothed inside temperature and its standard deviation
+    float    out_T_C;                 // filtered outside temperature (NAN until the first fetch)
+    float    k_per_h, k_sd;           // heat-exchange coefficient
+    float    heat_C_per_h;            // net heat input q
+    float    rate_C_per_h;            // dT/dt now, from the model
+    float    T_eq_C;                  // T_out + q/k; NAN while k is not yet known
+} fusion_t;
+
+void  fusion_update(const sample_t *s, float out_T_C, bool suspect);   // sensor loop; out_T_C NAN if unknown
+bool  fusion_get(fusion_t *out);                                         // false before the first sample
+float fusion_eta_s(const fusion_t *f, float threshold);                 // seconds; NAN if not heading there
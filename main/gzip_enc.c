@@ -0,0 +1,139 @@
+/*
+ * Small gzip encoder (implementation).
+ * - LZ77: a hash of the next 3 bytes indexes the last position with that
+ *   hash; a match (3..258 bytes, distance <= 32768) is taken greedily.
+ * - A single final block with the fixed Huffman tables (RFC 1951 3.2.6),
+ *   written LSB-first; Huffman codes are emitted bit-reversed.
+ * - Header: no name, mtime 0, OS unknown; trailer: CRC-32 and size.
+ */
+
+#include "gzip_enc.h"
+#include "esp_rom_crc.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define HASH_BITS  12
+#define MIN_MATCH  3
+#define MAX_MATCH  258
+#define MAX_DIST   32768
+
+static const uint16_t LEN_BASE[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t  LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                        8193, 12289, 16385, 24577 };
+static const uint8_t  DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                         7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+typedef struct {
+    uint8_t *out;
+    size_t   cap, len;
+    uint32_t bits;
+    unsigned nbits;
+    bool     overflow;
+} bitw_t;
+
+static void put_bits(bitw_t *w, uint32_t v, unsigned n)
+{
+    w->bits |= v << w->nbits;
+    w->nbits += n;
+    while (w->nbits >= 8) {
+        if (w->len < w->cap) w->out[w->len++] = (uint8_t)w->bits;
+        else w->overflow = true;
+        w->bits >>= 8;
+        w->nbits -= 8;
+    }
+}
+
+static void put_huff(bitw_t *w, uint32_t code, unsigned n)
+{
+    uint32_t r = 0;
+    for (unsigned i = 0; i < n; i++) { r = (r << 1) | (code & 1); code >>= 1; }
+    put_bits(w, r, n);
+}
+
+// Fixed literal/length code for symbol 0..287.
+static void put_litlen(bitw_t *w, unsigned sym)
+{
+    if (sym < 144)      put_huff(w, 0x30 + sym, 8);
+    else if (sym < 256) put_huff(w, 0x190 + sym - 144, 9);
+    else if (sym < 280) put_huff(w, sym - 256, 7);
+    else                put_huff(w, 0xC0 + sym - 280, 8);
+}
+
+static void put_match(bitw_t *w, unsigned len, unsigned dist)
+{
+    unsigned i = 28;
+    while (LEN_BASE[i] > len) i--;
+    put_litlen(w, 257 + i);
+    put_bits(w, len - LEN_BASE[i], LEN_EXTRA[i]);
+    unsigned d = 29;
+    while (DIST_BASE[d] > dist) d--;
+    put_huff(w, d, 5);
+    put_bits(w, dist - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+static uint32_t hash3(const uint8_t *p)
+{
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void put_u32le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief Compress a buffer into a complete gzip member.
+ *
+ * @param[in]  in   Input bytes.
+ * @param[in]  len  Input length (< 65535).
+ * @param[out] out  Destination; GZIP_BOUND(len) bytes always suffice.
+ * @param[in]  cap  Size of out.
+ * @return Bytes written, or 0 if out is too small.
+ */
+size_t gzip_compress(const uint8_t *in, size_t len, uint8_t *out, size_t cap)
+{
+    static uint16_t head[1u << HASH_BITS];   // last position + 1 per hash (0 = none)
+    static const uint8_t HDR[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+    if (cap < sizeof HDR + 8 || len >= UINT16_MAX) return 0;
+    memcpy(out, HDR, sizeof HDR);
+    memset(head, 0, sizeof head);
+
+    bitw_t w = { .out = out, .cap = cap - 8, .len = sizeof HDR };
+    put_bits(&w, 1, 1);        // BFINAL
+    put_bits(&w, 1, 2);        // BTYPE = fixed Huffman
+
+    size_t i = 0;
+    while (i < len && !w.overflow) {
+        unsigned best = 0;
+        size_t cand = 0;
+        if (i + MIN_MATCH <= len) {
+            uint32_t h = hash3(in + i);
+            cand = head[h];
+            head[h] = (uint16_t)(i + 1);
+            if (cand && i - (cand - 1) <= MAX_DIST) {
+                const uint8_t *a = in + cand - 1, *b = in + i;
+                size_t max = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+                while (best < max && a[best] == b[best]) best++;
+            }
+        }
+        if (best >= MIN_MATCH) {
+            put_match(&w, best, (unsigned)(i - (cand - 1)));
+            for (size_t k = i + 1; k < i + best && k + MIN_MATCH <= len; k++) head[hash3(in + k)] = (uint16_t)(k + 1);
+            i += best;
+        } else {
+            put_litlen(&w, in[i++]);
+        }
+    }
+    put_litlen(&w, 256);       // end of block
+    if (w.nbits) put_bits(&w, 0, 8 - w.nbits);
+    if (w.overflow) return 0;
+
+    put_u32le(out + w.len, esp_rom_crc32_le(0, in, (uint32_t)len));
+    put_u32le(out + w.len + 4, (uint32_t)len);
+    return w.len + 8;
+}
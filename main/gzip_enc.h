@@ -0,0 +1,19 @@
+/*
+ * Small gzip encoder (public API).
+ * One-shot, in-memory gzip (RFC 1952) of a buffer for Content-Encoding: gzip
+ * uploads. Deflate uses greedy LZ77 over the whole input with a 4096-entry
+ * hash table (8 KB, static rather than on the caller's stack) and
+ * the fixed Huffman code, which suits short, repetitive text such as line
+ * protocol without miniz's ~300 KB compressor state.
+ * Not reentrant: one caller at a time.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Output never exceeds this for len input bytes (constant expression for static buffers).
+#define GZIP_BOUND(len) ((len) + (len) / 8 + 32)
+
+// Compress in[len] (len < 65535) into out[cap] (GZIP_BOUND(len) always fits). Returns gzip size, 0 if cap is too small.
+size_t gzip_compress(const uint8_t *in, size_t len, uint8_t *out, size_t cap);
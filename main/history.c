@@ -0,0 +1,164 @@
+/*
+ * Rollup history (implementation).
+ * - The open minute is accumulated in plain sums; closing it writes one slot
+ *   and, when 90 and 180 minutes back are both present, reclassifies the
+ *   pressure tendency. Adding a sample is O(1) either way.
+ * - The ring and the cached tendency sit behind a mutex for the httpd task.
+ * - CONFIG_APP_STATIC_ALLOC: static ring of CONFIG_APP_HISTORY_MINUTES slots.
+ */
+
+#include "history.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include <math.h>
+#include <stdlib.h>
+
+static rollup_t         *ring;
+static size_t            cap;
+static uint32_t          last_closed;   // newest minute written
+static bool              any_closed;
+static baro_tendency_t   tend = { NAN, BARO_TENDENCY_UNKNOWN, 0 };
+static SemaphoreHandle_t lock;
+#if CONFIG_APP_STATIC_ALLOC
+static rollup_t          ring_mem[CONFIG_APP_HISTORY_MINUTES + 1];   // +1: CONFIG may be 0
+static StaticSemaphore_t lock_mem;
+#endif
+
+static struct {                         // minute being accumulated (sensor loop only)
+    uint32_t minute;
+    uint16_t n;
+    uint16_t anomalies;
+    double   t_sum, h_sum, p_sum, t_min, t_max;
+} open_min;
+
+/**
+ * @brief Allocate the ring.
+ *
+ * @param minutes Slots (minutes) to keep; 0 disables the history.
+ * @return ESP_OK, or ESP_ERR_NO_MEM (ESP_ERR_INVALID_SIZE above the static ring).
+ */
+esp_err_t history_init(size_t minutes)
+{
+    if (minutes == 0) return ESP_OK;
+#if CONFIG_APP_STATIC_ALLOC
+    if (minutes > CONFIG_APP_HISTORY_MINUTES) return ESP_ERR_INVALID_SIZE;
+    lock = xSemaphoreCreateMutexStatic(&lock_mem);
+    ring = ring_mem;
+#else
+    lock = xSemaphoreCreateMutex();
+    ring = calloc(minutes, sizeof(rollup_t));
+    if (!ring || !lock) return ESP_ERR_NO_MEM;
+#endif
+    mem_budget_add("history", minutes * sizeof(rollup_t));
+    cap = minutes;
+    return ESP_OK;
+}
+
+static const rollup_t *slot_for(uint32_t minute)
+{
+    const rollup_t *r = &ring[minute % cap];
+    return (r->n && r->minute == minute) ? r : NULL;
+}
+
+static int16_t to_cC(double v) { return (int16_t)lround(v * 100.0); }
+
+// Write the open minute into its slot and refresh the tendency (lock held).
+static void close_minute(void)
+{
+    rollup_t *r = &ring[open_min.minute % cap];
+    r->minute = open_min.minute;
+    r->n = open_min.n;
+    r->t_min_cC = to_cC(open_min.t_min);
+    r->t_max_cC = to_cC(open_min.t_max);
+    r->t_mean_cC = to_cC(open_min.t_sum / open_min.n);
+    r->h_mean_cRH = (uint16_t)lround(open_min.h_sum / open_min.n * 100.0);
+    r->p_mean_dPa = (uint32_t)lround(open_min.p_sum / open_min.n * 10.0);
+    r->anomalies = open_min.anomalies;
+    last_closed = open_min.minute;
+    any_closed = true;
+
+    const rollup_t *half = NULL, *full = NULL;
+    if (cap > HISTORY_TENDENCY_MIN && open_min.minute >= HISTORY_TENDENCY_MIN) {
+        half = slot_for(open_min.minute - HISTORY_TENDENCY_MIN / 2);
+        full = slot_for(open_min.minute - HISTORY_TENDENCY_MIN);
+    }
+    if (half && full) {
+        baro_tendency_classify(full->p_mean_dPa / 10.0f, half->p_mean_dPa / 10.0f,
+                               r->p_mean_dPa / 10.0f, &tend);
+    } else {
+        tend = (baro_tendency_t){ NAN, BARO_TENDENCY_UNKNOWN, 0 };
+    }
+}
+
+/**
+ * @brief Add one compensated sample to the open minute.
+ *
+ * @param[in] s         Sample from sample_pipeline_process().
+ * @param     anomalies Its anomaly_check() flags (marked on the minute).
+ * @return true if the sample started a new minute (the previous one closed).
+ */
+bool history_add(const sample_t *s, uint16_t anomalies)
+{
+    if (!ring) return false;
+    uint32_t minute = (uint32_t)(s->ts_us / 60000000);
+    bool closed = false;
+
+    if (open_min.n && minute != open_min.minute) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        close_minute();
+        xSemaphoreGive(lock);
+        open_min.n = 0;
+        closed = true;
+    }
+    if (open_min.n == 0) {
+        open_min.minute = minute;
+        open_min.t_sum = open_min.h_sum = open_min.p_sum = 0;
+        open_min.t_min = open_min.t_max = s->T_C;
+        open_min.anomalies = 0;
+    }
+    open_min.anomalies |= anomalies;
+    open_min.n++;
+    open_min.t_sum += s->T_C;
+    open_min.h_sum += s->H_RH;
+    open_min.p_sum += s->P_Pa;
+    if (s->T_C < open_min.t_min) open_min.t_min = s->T_C;
+    if (s->T_C > open_min.t_max) open_min.t_max = s->T_C;
+    return closed;
+}
+
+/**
+ * @brief Copy out the newest closed minutes.
+ *
+ * @param[out] out Rollups, oldest first.
+ * @param max      Capacity of out.
+ * @return Number of rollups written (gaps in the record are skipped).
+ */
+size_t history_get(rollup_t *out, size_t max)
+{
+    if (!ring) return 0;
+    size_t n = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (any_closed) {
+        size_t span = cap < max ? cap : max;
+        uint32_t first = last_closed + 1 > span ? last_closed + 1 - (uint32_t)span : 0;
+        for (uint32_t m = first; m <= last_closed; m++) {
+            const rollup_t *r = slot_for(m);
+            if (r) out[n++] = *r;
+        }
+    }
+    xSemaphoreGive(lock);
+    return n;
+}
+
+void history_tendency(baro_tendency_t *out)
+{
+    if (!ring) {
+        *out = (baro_tendency_t){ NAN, BARO_TENDENCY_UNKNOWN, 0 };
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = tend;
+    xSemaphoreGive(lock);
+}
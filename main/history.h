@@ -0,0 +1,36 @@
+/*
+ * Rollup history (public API).
+ * - Per-minute rollups of the inside samples (min/mean/max temperature, mean
+ *   humidity and pressure) in a RAM ring of CONFIG_APP_HISTORY_MINUTES slots,
+ *   in the fixed-point units of reading_codec.h.
+ * - The slot for minute m is m % capacity, so "the rollup N minutes ago" is
+ *   one index away; the 3 h pressure tendency (baro.h) is refreshed from three
+ *   such lookups whenever a minute closes.
+ * - Each rollup also ORs the anomaly flags (anomaly.h) of its samples.
+ * - Minutes count esp_timer time, so the ring does not care about SNTP steps.
+ *   Minutes without samples are simply missing.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+#include "baro.h"
+
+#define HISTORY_TENDENCY_MIN  180     // window of the pressure tendency
+
+typedef struct {
+    uint32_t minute;                  // esp_timer minutes since boot
+    uint16_t n;                       // samples in this minute (0 = empty slot)
+    int16_t  t_min_cC, t_mean_cC, t_max_cC;
+    uint16_t h_mean_cRH;
+    uint16_t anomalies;               // OR of the samples' anomaly flags
+    uint32_t p_mean_dPa;
+} rollup_t;
+
+esp_err_t history_init(size_t minutes);        // > HISTORY_TENDENCY_MIN for the tendency
+bool      history_add(const sample_t *s, uint16_t anomalies);   // sensor loop; true when a minute closed
+size_t    history_get(rollup_t *out, size_t max);   // closed minutes among the last `max`, oldest first
+void      history_tendency(baro_tendency_t *out);  // as of the last closed minute
@@ -1,6 +1,6 @@
 /*
  * HTTP client (implementation) for Open-Meteo current weather.
- * Handles HTTPS GET with CRT bundle, dynamic buffer read, and minimal JSON scan.
+ * Handles HTTPS GET with CRT bundle, a pooled read buffer (net_pool.h), and minimal JSON scan.
  * Exposes fetch_outside_current(); includes a string-skipping numeric finder.
  * Author: Wael Hamid  |  Date: 2025-08-12
  */
@@ -10,11 +10,14 @@
 #include "app_config.h"        // Contains config macros like OPEN_METEO_URL
 #include "esp_http_client.h"   // ESP-IDF's HTTP client library
 #include "esp_crt_bundle.h"    // Built-in SSL/TLS CA certificate bundle (for HTTPS)
-#include <stdlib.h>            // malloc, realloc, free, strtod
+#include "net_pool.h"          // response buffer
+#include "sdkconfig.h"         // CONFIG_APP_STATIC_ALLOC
+#include <stdlib.h>            // strtod
 #include <string.h>            // strstr, strchr, strcmp etc.
 #include <math.h>              // NAN, isnan
 #include <errno.h>             // errno for error checking with strtod
 #include <ctype.h>             // for isspace
+#include <stdbool.h>
 
 /**
  * @brief Search for a numeric value in a JSON-like string by key, skipping strings.
@@ -29,7 +32,7 @@
  *
  */
 
-static double find_key_number_skip_strings(const char *text, const char *key)
+double find_key_number_skip_strings(const char *text, const char *key)
 {
     // if no data to search for was passed in, return nan
     if (!text || !key)
@@ -73,105 +76,128 @@ static double find_key_number_skip_strings(const char *text, const char *key)
 
 
 /**
- * @brief Fetch outside temperature and humidity from Open-Meteo API.
- *
- * Performs an HTTPS GET request using the ESP-IDF HTTP client. Reads the
- * response into a dynamically allocated buffer, parses JSON, and extracts
- * temperature_2m (°C) and relative_humidity_2m (%RH).
+ * @brief Create an HTTP(S) client for repeated requests to one server.
  *
- * @return weather_t struct with temp and humid fields set, or NAN values on error.
+ * HTTPS is verified against the built-in CA bundle. The connection is kept
+ * open between requests (esp_http_client_perform() reuses it), with TCP
+ * keep-alive probes so a dead peer is noticed.
  *
+ * @param url        Full URL of the endpoint.
+ * @param timeout_ms Network timeout per operation.
+ * @return Client handle (free with esp_http_client_cleanup()), or NULL.
  */
 
-weather_t fetch_outside_current(void)
+esp_http_client_handle_t http_ext_client_new(const char *url, int timeout_ms)
 {
-    weather_t out = { NAN, NAN };   // starting clean, safe to return on any error
-
-
-    double temp,humid;
-
-    // HTTP config client 
     esp_http_client_config_t cfg = {
-        .url = OPEN_METEO_URL,                // API endpoint defined in app_config.h
-        .timeout_ms = 8000,                  // 8s timeout
+        .url = url,
+        .timeout_ms = timeout_ms,
         .crt_bundle_attach = esp_crt_bundle_attach, // attach default CA bundle for HTTPS
-        .method = HTTP_METHOD_GET,          // GET request
+        .method = HTTP_METHOD_GET,
+        .keep_alive_enable = true,                  // TCP keep-alive on the reused socket
     };
+    return esp_http_client_init(&cfg);
+}
 
-    esp_http_client_handle_t c = esp_http_client_init(&cfg); // create client
-
-    if (!c){ 
-    return out; // failed → return NAN                  
-        }
-
-    esp_err_t err = esp_http_client_open(c, 0); // open connection, 0 used because we are recieving only 
-
-    // Clean up if a connection cant be opened properly 
-    if (err != ESP_OK) 
-    { 
-        esp_http_client_cleanup(c);
-         return out;
-        }
-
-    int content_len = esp_http_client_fetch_headers(c); //stores the # of bytes the server sends back, if it doesnt, returns -1. 
-    // If server uses "chunked transfer encoding", this might be -1.
 
-    const int CHUNK = 1024; //1KB                     
-    int cap=0; 
+/**
+ * @brief POST a body on a client from http_ext_client_new().
+ *
+ * Runs the whole exchange with esp_http_client_perform() so the connection
+ * stays open for the next call. A transport error is retried once, because
+ * the server may have closed the idle keep-alive socket since the last post.
+ *
+ * @param c            Client handle.
+ * @param content_type Content-Type header value.
+ * @param body         Request body.
+ * @param len          Body length in bytes.
+ * @param[out] status  HTTP status code (0 if no response).
+ * @return ESP_OK if a response was received (check *status), else the transport error.
+ */
 
-    // if the number of bytes returned is <64kB
-    if (content_len > 0 && content_len < 64*1024){
-        cap= content_len + 1; // +1 for null terminator 
-    }
-    // Otherwise, default to 8 KB buffer
-    else{
-        cap = CHUNK * 8; 
+esp_err_t http_ext_post(esp_http_client_handle_t c, const char *content_type,
+                        const char *body, int len, int *status)
+{
+    *status = 0;
+    esp_http_client_set_method(c, HTTP_METHOD_POST);
+    esp_http_client_set_header(c, "Content-Type", content_type);
+    esp_http_client_set_post_field(c, body, len);
+
+    esp_err_t err = esp_http_client_perform(c);
+    if (err != ESP_OK) {
+        esp_http_client_close(c);                      // drop the stale socket, reconnect once
+        err = esp_http_client_perform(c);
     }
+    if (err == ESP_OK) *status = esp_http_client_get_status_code(c);
+    return err;
+}
 
-    char *buf = (char*)malloc(cap); //Allocates a block of memory of size cap bytes on the heap.
-    if (!buf) { 
-        esp_http_client_close(c);
-        esp_http_client_cleanup(c);
-        return out; }
-
-    int total = 0;
-    while (1) {
-        // Ensure buffer has enough room for next chunk
-        if (total + CHUNK + 1 > cap) {
-            int new_cap = cap * 2;
-            char *nb = (char*)realloc(buf, new_cap);
-
-            if (!nb) { free(buf); esp_http_client_close(c);
-                 esp_http_client_cleanup(c);
-                  return out; }
-            buf = nb;
-            cap = new_cap;
-        }
-        int r = esp_http_client_read(c, buf + total, CHUNK);  // read HTTP data
-        //returns the number of bytes that got read
 
-        if (r <= 0){
-            break;  // 0=end of data, <0=error
-        }                                  
-        total += r;                                           // accumulate bytes read
+// Send the GET and read the response headers. A reused keep-alive socket
+// the server has closed since the last fetch fails here; reconnect once.
+static bool open_get(esp_http_client_handle_t c)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (esp_http_client_open(c, 0) == ESP_OK && esp_http_client_fetch_headers(c) >= 0) return true;
+        esp_http_client_close(c);
     }
+    return false;
+}
 
-    buf[total] = '\0';                                       // null terminate buffer (make it valid string)
 
-    int status = esp_http_client_get_status_code(c);        // get HTTP response status
-    if (status == 200 && total > 0) {                      // if OK and data received
+/**
+ * @brief Fetch outside temperature and humidity from Open-Meteo API.
+ *
+ * Performs an HTTPS GET request using the ESP-IDF HTTP client. Reads the
+ * response into one net_pool block (a longer response is dropped), parses
+ * JSON, and extracts temperature_2m (°C) and relative_humidity_2m (%RH).
+ * With CONFIG_APP_STATIC_ALLOC the client is created on the first call and
+ * kept, and so is its connection once a response has been read to the end
+ * (a failed request or an oversized body closes it; a stale socket is
+ * reopened once). Otherwise the client is created and freed per fetch.
+ *
+ * @return weather_t struct with temp and humid fields set, or NAN values on error.
+ *
+ */
 
-        //Fetch outside temperature (Celsius) & Humididty(%RH)
-        temp = find_key_number_skip_strings(buf, "\"temperature_2m\"");
-        if (!isnan(temp)) out.temp = (float)temp;                  // if valid number, set as output (Non NAN)
+weather_t fetch_outside_current(void)
+{
+    weather_t out = { NAN, NAN };   // starting clean, safe to return on any error
 
-        humid= find_key_number_skip_strings(buf, "\"relative_humidity_2m\"");
-        if (!isnan(humid)) out.humid = (float)humid;              // if valid number, set as output (NOT NAN)
-    
+#if CONFIG_APP_STATIC_ALLOC
+    static esp_http_client_handle_t c;
+    if (!c) c = http_ext_client_new(OPEN_METEO_URL, 8000);
+#else
+    esp_http_client_handle_t c = http_ext_client_new(OPEN_METEO_URL, 8000);
+#endif
+    if (!c) return out;
+
+    char *buf = net_pool_get();     // NET_BLOCK_BYTES, no heap
+    bool keep = false;
+    esp_http_client_set_method(c, HTTP_METHOD_GET);
+    if (buf && open_get(c)) {
+        int total = 0, r;
+        while (total < NET_BLOCK_BYTES - 1 && (r = esp_http_client_read(c, buf + total, NET_BLOCK_BYTES - 1 - total)) > 0) {
+            total += r;
+        }
+        char extra;
+        bool too_long = total == NET_BLOCK_BYTES - 1 && esp_http_client_read(c, &extra, 1) > 0;
+        buf[total] = '\0';
+
+        if (!too_long && esp_http_client_get_status_code(c) == 200 && total > 0) {
+            double temp = find_key_number_skip_strings(buf, "\"temperature_2m\"");
+            if (!isnan(temp)) out.temp = (float)temp;
+            double humid = find_key_number_skip_strings(buf, "\"relative_humidity_2m\"");
+            if (!isnan(humid)) out.humid = (float)humid;
+        }
+        keep = !too_long && esp_http_client_is_complete_data_received(c);
     }
-
-    free(buf);                                        // free buffer
-    esp_http_client_close(c);                        // close connection
-    esp_http_client_cleanup(c);                     // free client
-    return out;                                    // return temperature (or NAN on failure)
+    net_pool_put(buf);
+#if CONFIG_APP_STATIC_ALLOC
+    if (!keep) esp_http_client_close(c);   // unread body or error: the socket cannot be reused
+#else
+    (void)keep;
+    esp_http_client_cleanup(c);
+#endif
+    return out;
 }
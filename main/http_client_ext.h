@@ -1,6 +1,9 @@
 /*
  * HTTP client (public API) for outside weather fetch.
  * Defines weather_t {temp, humid} and fetch_outside_current() using Open-Meteo.
+ * find_key_number_skip_strings() is exported for host benchmarks.
+ * http_ext_client_new()/http_ext_post() keep one connection open for repeated
+ * uploads (HTTP uplink).
  * Consumers include app_main task that updates the web page.
  * Author: Wael Hamid  |  Date: 2025-08-12
  */
@@ -9,6 +12,8 @@
 #define HTTP_CLIENT_EXT_H
 
 #include <math.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
 
 typedef struct {
     float temp;   // °C
@@ -16,4 +21,9 @@ typedef struct {
 } weather_t;
 
 weather_t fetch_outside_current(void);
+double find_key_number_skip_strings(const char *text, const char *key);  // NAN if missing
+
+esp_http_client_handle_t http_ext_client_new(const char *url, int timeout_ms);  // CA bundle, keep-alive
+esp_err_t http_ext_post(esp_http_client_handle_t c, const char *content_type,
+                        const char *body, int len, int *status);            // retries a stale socket once
 #endif
@@ -1,47 +1,61 @@
 /*
  * Minimal HTTP server (implementation).
- * Serves a compact HTML dashboard with inside/outside T/H and deltas.
- * Uses module-local storage updated via web_set_readings().
+ * Serves a compact HTML dashboard with inside/outside T/H, deltas and derived
+ * psychrometrics, station/sea-level pressure with its 3 h tendency and the
+ * temperature/humidity trend with time to the alert thresholds, the
+ * inside/outside fusion estimate, plus the same data as JSON on /api/current.
+ * GET /api/snapshot bundles that with health counters and the last minutes of
+ * history for scrapers, rendered once per sample and revalidated by ETag.
+ * POST /api/calibrate feeds a reference temperature to the self-heating fit
+ * (CONFIG_APP_SELFHEAT_CALIBRATE_API only: it has no authentication).
+ * Reads everything from the climate snapshot (snapshot_get()).
  * Author: Wael Hamid  |  Date: 2025-08-12
  */
 
 
-#include "http_server.h"         // our header: web_start(), web_set_readings()
+#include "http_server.h"         // our header: web_start()
+#include "snapshot.h"            // latest readings + derived metrics
+#include "alert_eval.h"          // ALERT_HIGH_C / ALERT_LOW_C for time-to-threshold
 #include "app_config.h"          // USE_HTTPS_SERVER flag
 #include "esp_http_server.h"     // HTTP server API (httpd_start, handlers)
 #include "esp_log.h"             // ESP_LOGI
+#include "trace.h"               // trace_export_*() for GET /trace
+#include "net_pool.h"            // /trace chunk buffer
+#include "perf_metrics.h"        // "/" handler latency
+#include "selfheat.h"            // self-heating model for /api/current and /api/calibrate
+#include "esp_timer.h"           // esp_timer_get_time
+#include "sched_plan.h"          // server task core and priority
+#include "sdkconfig.h"           // CONFIG_APP_HTTPD_* profile
+#include "history.h"             // per-minute rollups for /api/snapshot
+#include "http_uplink.h"         // uplink counters for /api/snapshot
+#include "mqtt_pub.h"
+#include "udp_telemetry.h"
+#include "mem_budget.h"          // /api/snapshot document buffer
+#include "esp_random.h"          // boot id in the /api/snapshot ETag
 #include <math.h>                // NAN, isnan
+#include <stdlib.h>              // strtof, strtoul
+#include <stdio.h>               // snprintf
+#include <stdarg.h>              // appendf
+#include <string.h>              // strstr
 
 
 static const char *TAG = "http_server";
 
-// Latest readings shown on the page.
-// Set from app code via web_set_readings().
-static float t_in  = NAN;         // inside temperature (°C)
-static float t_out = NAN;        // outside temperature (°C)
-static float h_in  = NAN;       // inside humidity (%RH)
-static float h_out = NAN;      // outside humidity (%RH)
-
-/**
- * @brief Update the stored sensor values for web display.
- *
- * Stores inside/outside temperature and humidity in static variables
- * so the HTTP handler can display them on the served web page.
- *
- */
-
-void web_set_readings(float in_c, float out_c,float in_h, float out_h) {
-    t_in = in_c;
-    t_out = out_c;
-    h_in = in_h;
-    h_out = out_h;
-     }
+#if CONFIG_APP_HTTPD_TUNED && defined(CONFIG_LWIP_MAX_SOCKETS)
+#if CONFIG_APP_HTTPD_MAX_SOCKETS + 3 > CONFIG_LWIP_MAX_SOCKETS
+#error "APP_HTTPD_MAX_SOCKETS needs LWIP_MAX_SOCKETS >= APP_HTTPD_MAX_SOCKETS + 3"
+#endif
+#endif
 
 /**
  * @brief HTTP handler for GET "/".
  *
  * Generates and returns an HTML page showing inside/outside temperature,
- * humidity, their differences, and a note about recommended ranges.
+ * humidity, their differences, dew point, absolute humidity, humidity ratio,
+ * heat index, station and sea-level pressure, the 3 h pressure tendency,
+ * the T/RH trend with the time until an alert threshold, the room model
+ * (smoothed temperature, where it is settling and its time constant) and a
+ * note about recommended ranges.
  * Auto-refreshes every 10 seconds using a meta tag.
  *
  * @return ESP_OK on success, or an error code on failure.
@@ -49,10 +63,15 @@ void web_set_readings(float in_c, float out_c,float in_h, float out_h) {
  */
 
 static esp_err_t root_get(httpd_req_t *req) {
+    int64_t t0 = esp_timer_get_time();
     httpd_resp_set_type(req, "text/html"); //html style here...
 
-    // declare a 4kB nuffer to store the html string 
-        char  buf[1024];
+    climate_snapshot_t snap;
+    snapshot_get(&snap);
+    float t_in = snap.in_T_C, t_out = snap.out_T_C, h_in = snap.in_RH, h_out = snap.out_RH;
+
+    // page buffer; static is fine, httpd runs every handler on its one task
+    static char buf[2048];
     //calculate the outside vs inside temperature and humididty difference
     //if either outside or insdie temp is not a num -> set to NAN, otherwise, calculate the difference 
     float t_diff = (isnan(t_in) || isnan(t_out)) ? NAN : (fabs(t_in - t_out));  
@@ -62,6 +81,37 @@ static esp_err_t root_get(httpd_req_t *req) {
     bool temp_ok  = (!isnan(t_in) && t_in >= 15.0f && t_in <= 30.0f);
     bool humid_ok = (!isnan(h_in) && h_in >= 30.0f && h_in <= 60.0f);
 
+    char tend[64];
+    if (snap.tendency.code == BARO_TENDENCY_UNKNOWN) {
+        snprintf(tend, sizeof(tend), "collecting (needs 3 h)");
+    } else {
+        snprintf(tend, sizeof(tend), "%+.1f hPa, %s (WMO %u)", snap.tendency.dp_Pa / 100.0f,
+                 baro_trend_name(&snap.tendency), snap.tendency.code);
+    }
+
+    char trend[96];
+    if (!snap.trend_valid) {
+        snprintf(trend, sizeof(trend), "collecting");
+    } else {
+        const trend_t *tr = &snap.trend;
+        float limit = tr->dT_per_h > 0 ? ALERT_HIGH_C : ALERT_LOW_C;
+        float eta = trend_eta_s(tr->T_C, tr->dT_per_h, limit);
+        int m = snprintf(trend, sizeof(trend), "%+.1f &deg;C/h, %+.1f %%RH/h", tr->dT_per_h, tr->dRH_per_h);
+        if (!isnan(eta) && eta < 24 * 3600.0f) {
+            snprintf(trend + m, sizeof(trend) - m, "; %.0f &deg;C in ~%.0f min", limit, ceilf(eta / 60.0f));
+        }
+    }
+
+    char model[96];
+    if (!snap.fusion_valid) {
+        snprintf(model, sizeof(model), "off");
+    } else if (isnan(snap.fusion.T_eq_C)) {
+        snprintf(model, sizeof(model), "%.2f &deg;C smoothed; learning", snap.fusion.T_C);
+    } else {
+        snprintf(model, sizeof(model), "%.2f &deg;C smoothed; settling at %.1f &deg;C (&tau; %.1f h)",
+                 snap.fusion.T_C, snap.fusion.T_eq_C, 1.0f / snap.fusion.k_per_h);
+    }
+
     const char *note = (temp_ok && humid_ok)
         ? "Inside conditions are within the recommended range (15\u201330\u00B0C, 30\u201360 %RH)."
         : "Inside conditions are outside the recommended range (15\u201330\u00B0C, 30\u201360 %RH).";
@@ -86,14 +136,455 @@ static esp_err_t root_get(httpd_req_t *req) {
     "<div class=row><b>Inside Humidity:</b><span>%.0f %%RH</span></div>"
     "<div class=row><b>Outside Humidity:</b><span>%.0f %%RH</span></div>"
     "<div class=row><b>Humidity &Delta;:</b><span>%.2f %%RH</span></div>"
+    "<hr>"
+    "<div class=row><b>Dew Point (in / out):</b><span>%.1f / %.1f &deg;C</span></div>"
+    "<div class=row><b>Abs. Humidity (in / out):</b><span>%.1f / %.1f g/m&sup3;</span></div>"
+    "<div class=row><b>Humidity Ratio (in / out):</b><span>%.1f / %.1f g/kg</span></div>"
+    "<div class=row><b>Heat Index (in / out):</b><span>%.1f / %.1f &deg;C</span></div>"
+    "<hr>"
+    "<div class=row><b>Pressure (station / sea level):</b><span>%.1f / %.1f hPa</span></div>"
+    "<div class=row><b>3 h Tendency:</b><span>%s</span></div>"
+    "<hr>"
+    "<div class=row><b>Trend (%u min):</b><span>%s</span></div>"
+    "<div class=row><b>Room Model:</b><span>%s</span></div>"
     "<p class=note>%s</p>",
-    t_in, t_out, t_diff, h_in, h_out, h_diff, note
+    t_in, t_out, t_diff, h_in, h_out, h_diff,
+    snap.in.dew_C, snap.out.dew_C, snap.in.abs_g_m3, snap.out.abs_g_m3,
+    snap.in.ratio_g_kg, snap.out.ratio_g_kg, snap.in.heat_index_C, snap.out.heat_index_C,
+    snap.in_P_Pa / 100.0f, snap.sea_level_Pa / 100.0f, tend,
+    (unsigned)(CONFIG_APP_TREND_WINDOW_S / 60), trend, model, note
     );
 
     if (n < 0) n = 0;
     if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;  // safety clamp
 
-    return httpd_resp_send(req, buf, n); // return the page...
+    esp_err_t err = httpd_resp_send(req, buf, n); // return the page...
+    perf_metrics_on_http(esp_timer_get_time() - t0);
+    return err;
+}
+
+// snprintf that returns what it actually stored: at most cap - 1, so the
+// n += appendf(buf + n, cap - n, ...) chains below never step past cap.
+// A document that reaches cap - 1 was truncated (see json_full()).
+static int appendf(char *out, size_t cap, const char *fmt, ...) {
+    if (cap == 0) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int r = vsnprintf(out, cap, fmt, ap);
+    va_end(ap);
+    if (r < 0) return 0;
+    return r < (int)cap ? r : (int)cap - 1;
+}
+
+// True when an appendf() chain filled buf of size cap (the document is cut short).
+static bool json_full(int n, size_t cap) {
+    return (size_t)n + 1 >= cap;
+}
+
+// Append "name":value (or null for NAN) with the given decimals.
+static int json_num(char *out, size_t cap, const char *name, float v, int decimals) {
+    if (isnan(v)) return appendf(out, cap, "\"%s\":null,", name);
+    return appendf(out, cap, "\"%s\":%.*f,", name, decimals, v);
+}
+
+// One side ("inside"/"outside") of /api/current; p_Pa NAN = not measured.
+static int json_side(char *out, size_t cap, const char *name, float t, float rh, float p_Pa,
+                     const psychro_t *d) {
+    int n = appendf(out, cap, "\"%s\":{", name);
+    n += json_num(out + n, cap - n, "t", t, 2);
+    n += json_num(out + n, cap - n, "rh", rh, 2);
+    if (!isnan(p_Pa)) n += json_num(out + n, cap - n, "p", p_Pa, 1);
+    n += json_num(out + n, cap - n, "dew_point", d->dew_C, 2);
+    n += json_num(out + n, cap - n, "abs_humidity", d->abs_g_m3, 2);
+    n += json_num(out + n, cap - n, "humidity_ratio", d->ratio_g_kg, 2);
+    n += json_num(out + n, cap - n, "heat_index", d->heat_index_C, 2);
+    if (n) out[n - 1] = '}';             // replaces the last comma
+    return n;
+}
+
+#if CONFIG_APP_SELFHEAT
+// "selfheat":{...} of /api/current and the /api/calibrate reply.
+static int selfheat_json(char *out, size_t cap, const selfheat_t *sh) {
+    int n = appendf(out, cap, "\"selfheat\":{");
+    n += json_num(out + n, cap - n, "bias", sh->bias_C, 3);
+    n += json_num(out + n, cap - n, "rate_hz", sh->rate_hz, 3);
+    n += json_num(out + n, cap - n, "rate_eff_hz", sh->rate_eff_hz, 3);
+    n += json_num(out + n, cap - n, "offset", sh->model.offset_C, 3);
+    n += json_num(out + n, cap - n, "c_per_hz", sh->model.C_per_hz, 3);
+    n += json_num(out + n, cap - n, "tau_s", sh->model.tau_s, 0);
+    n += appendf(out + n, cap - n, "\"points\":%u}", sh->cal_points);
+    return n;
+}
+#endif
+
+// Everything /api/current and /api/snapshot's "current" share: from "inside" to "selfheat", no braces.
+static int current_json(char *buf, size_t cap, const climate_snapshot_t *snap) {
+    int n = json_side(buf, cap, "inside", snap->in_T_C, snap->in_RH, snap->in_P_Pa, &snap->in);
+    n += appendf(buf + n, cap - n, ",");
+    n += json_side(buf + n, cap - n, "outside", snap->out_T_C, snap->out_RH, NAN, &snap->out);
+    n += appendf(buf + n, cap - n, ",\"pressure\":{\"altitude_m\":%d,", CONFIG_APP_STATION_ALTITUDE_M);
+    n += json_num(buf + n, cap - n, "station", snap->in_P_Pa, 1);
+    n += json_num(buf + n, cap - n, "sea_level", snap->sea_level_Pa, 1);
+    n += json_num(buf + n, cap - n, "tendency_3h", snap->tendency.dp_Pa, 1);
+    if (snap->tendency.code == BARO_TENDENCY_UNKNOWN) n += appendf(buf + n, cap - n, "\"tendency_code\":null,");
+    else n += appendf(buf + n, cap - n, "\"tendency_code\":%u,", snap->tendency.code);
+    n += appendf(buf + n, cap - n, "\"trend\":\"%s\"},", baro_trend_name(&snap->tendency));
+    if (!snap->trend_valid) {
+        n += appendf(buf + n, cap - n, "\"trend\":null");
+    } else {
+        const trend_t *tr = &snap->trend;
+        n += appendf(buf + n, cap - n, "\"trend\":{\"span_s\":%.0f,", tr->span_s);
+        n += json_num(buf + n, cap - n, "t_per_h", tr->dT_per_h, 3);
+        n += json_num(buf + n, cap - n, "rh_per_h", tr->dRH_per_h, 3);
+        n += json_num(buf + n, cap - n, "r2_t", tr->r2_T, 3);
+        n += json_num(buf + n, cap - n, "r2_rh", tr->r2_RH, 3);
+        n += appendf(buf + n, cap - n, "\"eta_s\":{");
+        n += json_num(buf + n, cap - n, "hot", trend_eta_s(tr->T_C, tr->dT_per_h, ALERT_HIGH_C), 0);
+        n += json_num(buf + n, cap - n, "cold", trend_eta_s(tr->T_C, tr->dT_per_h, ALERT_LOW_C), 0);
+        n += json_num(buf + n, cap - n, "humid", trend_eta_s(tr->RH, tr->dRH_per_h, 60.0f), 0);
+        n += json_num(buf + n, cap - n, "dry", trend_eta_s(tr->RH, tr->dRH_per_h, 30.0f), 0);
+        if (n) buf[n - 1] = '}';         // replaces the last comma
+        n += appendf(buf + n, cap - n, "}");
+    }
+    if (!snap->fusion_valid) {
+        n += appendf(buf + n, cap - n, ",\"fusion\":null,");
+    } else {
+        const fusion_t *fu = &snap->fusion;
+        n += appendf(buf + n, cap - n, ",\"fusion\":{");
+        n += json_num(buf + n, cap - n, "t", fu->T_C, 3);
+        n += json_num(buf + n, cap - n, "t_sd", fu->T_sd, 3);
+        n += json_num(buf + n, cap - n, "outside", fu->out_T_C, 2);
+        n += json_num(buf + n, cap - n, "k_per_h", fu->k_per_h, 4);
+        n += json_num(buf + n, cap - n, "k_sd", fu->k_sd, 4);
+        n += json_num(buf + n, cap - n, "heat_per_h", fu->heat_C_per_h, 3);
+        n += json_num(buf + n, cap - n, "rate_per_h", fu->rate_C_per_h, 3);
+        n += json_num(buf + n, cap - n, "t_eq", fu->T_eq_C, 2);
+        n += appendf(buf + n, cap - n, "\"eta_s\":{");
+        n += json_num(buf + n, cap - n, "hot", fusion_eta_s(fu, ALERT_HIGH_C), 0);
+        n += json_num(buf + n, cap - n, "cold", fusion_eta_s(fu, ALERT_LOW_C), 0);
+        if (n) buf[n - 1] = '}';         // replaces the last comma
+        n += appendf(buf + n, cap - n, "},");
+    }
+#if CONFIG_APP_SELFHEAT
+    selfheat_t sh;
+    selfheat_get(&sh);
+    n += selfheat_json(buf + n, cap - n, &sh);
+#else
+    n += appendf(buf + n, cap - n, "\"selfheat\":null");
+#endif
+    return n;
+}
+
+/**
+ * @brief HTTP handler for GET "/api/current".
+ *
+ * Returns the snapshot as JSON: inside T/RH/P, outside T/RH and the derived
+ * metrics for both (°C, %RH, Pa, g/m³, g/kg; null when unknown), and a
+ * "pressure" object: station and sea-level pressure (Pa), altitude (m) and
+ * the 3 h tendency (Pa, WMO 0200 code, trend word), and a "trend" object
+ * (null until the window is half full): slopes per hour, r² and seconds
+ * until the temperature alert thresholds and the 30/60 %RH range bounds
+ * (null when the trend heads away), and a "fusion" object (null when off):
+ * smoothed inside and filtered outside temperature, k and the net heat
+ * input per hour, the equilibrium temperature and the model's time to the
+ * alert thresholds, and a "selfheat" object (null when off): the bias
+ * subtracted from the last sample (°C), the sensor rate and its lagged value
+ * (Hz), the model and the number of reference points in its fit.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ *
+ */
+
+static esp_err_t api_current_get(httpd_req_t *req) {
+    climate_snapshot_t snap;
+    snapshot_get(&snap);
+
+    static char buf[1536];                  // off the httpd stack; one handler runs at a time
+    int n = appendf(buf, sizeof buf, "{\"version\":%lu,\"age_ms\":%lld,", (unsigned long)snap.version,
+                    snap.version ? (long long)((esp_timer_get_time() - snap.ts_us) / 1000) : -1LL);
+    n += current_json(buf + n, sizeof buf - n, &snap);
+    n += appendf(buf + n, sizeof buf - n, "}");
+    if (json_full(n, sizeof buf)) {
+        ESP_LOGE(TAG, "/api/current does not fit %u bytes", (unsigned)sizeof buf);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "response too large");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, buf, n);
+}
+
+#define SNAP_MAX_MIN  CONFIG_APP_SNAPSHOT_MAX_MINUTES
+#define SNAP_DEF_MIN  (CONFIG_APP_SNAPSHOT_MINUTES < SNAP_MAX_MIN ? CONFIG_APP_SNAPSHOT_MINUTES : SNAP_MAX_MIN)
+#define SNAP_DOC_BASE 3072                  // everything but the history columns
+#define SNAP_DOC_MIN  64                    // one history minute: 8 integers, worst case
+#define SNAP_DOC_COLS 128                   // of SNAP_DOC_BASE: column names, brackets, closing braces
+
+// /api/snapshot's last rendered document (server task only).
+static struct {
+    uint32_t version;                       // snapshot version it was rendered from
+    uint16_t minutes;
+    size_t   len;                           // 0 = nothing rendered yet
+    char     etag[40];
+    char     body[SNAP_DOC_BASE + SNAP_DOC_MIN * SNAP_MAX_MIN];
+} s_doc;
+static rollup_t s_rollups[SNAP_MAX_MIN > 0 ? SNAP_MAX_MIN : 1];
+static uint32_t s_boot_id;                  // tells this boot's documents from the last boot's
+
+// Append v and a comma; the caller has reserved the room.
+static char *put_int(char *p, long v) {
+    char tmp[12];
+    int k = 0;
+    unsigned long u = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+    do {
+        tmp[k++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) *p++ = '-';
+    while (k) *p++ = tmp[--k];
+    *p++ = ',';
+    return p;
+}
+
+static long rollup_field(const rollup_t *r, int col) {
+    switch (col) {
+    case 0:  return (long)r->minute;
+    case 1:  return r->n;
+    case 2:  return r->t_min_cC;
+    case 3:  return r->t_mean_cC;
+    case 4:  return r->t_max_cC;
+    case 5:  return r->h_mean_cRH;
+    case 6:  return (long)r->p_mean_dPa;
+    default: return r->anomalies;
+    }
+}
+
+// "health":{...}: the PERF counters that tell a scraper whether a unit is well, and each uplink's state.
+static int health_json(char *buf, size_t cap, int64_t now_us) {
+    perf_metrics_t m;
+    perf_metrics_get(&m);
+    http_uplink_stats_t up;
+    mqtt_pub_stats_t mq;
+    udp_telemetry_stats_t ud;
+    http_uplink_get_stats(&up);
+    mqtt_pub_get_stats(&mq);
+    udp_telemetry_get_stats(&ud);
+    return appendf(buf, cap,
+        "\"health\":{\"uptime_s\":%lld,\"samples\":%lu,\"jitter_avg_us\":%lu,\"jitter_max_us\":%lu,"
+        "\"heap_free\":%lu,\"heap_min\":%lu,\"heap_largest\":%lu,\"anomalies\":%lu,\"net_fails\":%lu,"
+        "\"uplink\":{\"sent\":%lu,\"failures\":%lu,\"last_status\":%d,\"pending\":%lu,\"dropped\":%lu},"
+        "\"mqtt\":{\"sent\":%lu,\"failures\":%lu,\"pending\":%lu,\"dropped\":%lu},"
+        "\"udp\":{\"sent\":%lu,\"acks\":%lu,\"pending\":%lu,\"dropped\":%lu}}",
+        (long long)(now_us / 1000000), (unsigned long)m.samples, (unsigned long)m.jitter_avg_us,
+        (unsigned long)m.jitter_max_us, (unsigned long)m.heap_free, (unsigned long)m.heap_min,
+        (unsigned long)m.heap_largest, (unsigned long)m.anomalies, (unsigned long)m.net_fails,
+        (unsigned long)up.readings, (unsigned long)up.failures, up.last_status,
+        (unsigned long)(up.backlog.ram_pending + up.backlog.flash_pending), (unsigned long)(up.backlog.dropped + up.unencodable),
+        (unsigned long)mq.readings, (unsigned long)mq.failures,
+        (unsigned long)(mq.backlog.ram_pending + mq.backlog.flash_pending), (unsigned long)mq.backlog.dropped,
+        (unsigned long)ud.sent, (unsigned long)ud.acks,
+        (unsigned long)(ud.backlog.ram_pending + ud.backlog.flash_pending), (unsigned long)ud.backlog.dropped);
+}
+
+// v rounded to 1/scale for the ETag; NAN gets a value of its own.
+static int32_t etag_q(float v, float scale) {
+    return isnan(v) ? INT32_MIN : (int32_t)lrintf(v * scale);
+}
+
+// Hash of what a scraper reads off /api/snapshot, at the precision it acts
+// on: the newest closed minute, inside and outside readings (0.1 °C, 1 %RH,
+// 10 Pa), the tendency and whether trend and fusion are up. Health counters
+// and the trend/fusion/self-heat numbers are left out: they move with every
+// sample, and the next closed minute brings them fresh anyway.
+static uint32_t snapshot_content_hash(const climate_snapshot_t *snap) {
+    rollup_t last;
+    int32_t key[] = {
+        history_get(&last, 1) ? (int32_t)last.minute + 1 : 0,
+        etag_q(snap->in_T_C, 10.0f), etag_q(snap->in_RH, 1.0f), etag_q(snap->in_P_Pa, 0.1f),
+        etag_q(snap->out_T_C, 10.0f), etag_q(snap->out_RH, 1.0f),
+        snap->tendency.code, etag_q(snap->tendency.dp_Pa, 0.1f),
+        snap->trend_valid, snap->fusion_valid,
+    };
+    uint32_t h = 2166136261u;                   // FNV-1a
+    const uint8_t *p = (const uint8_t *)key;
+    for (size_t i = 0; i < sizeof key; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+// Render /api/snapshot for snap and the newest `minutes` closed minutes into
+// s_doc. False (s_doc left empty) if the fields before the history overflow.
+static bool snapshot_doc_render(const climate_snapshot_t *snap, unsigned minutes) {
+    static const char *const cols[] = { "minute", "n", "t_min_cC", "t_mean_cC", "t_max_cC", "rh_cRH", "p_dPa",
+                                        "anomalies" };
+    char *buf = s_doc.body;
+    size_t cap = SNAP_DOC_BASE - SNAP_DOC_COLS;   // the column names and the history get the rest
+    int64_t now_us = esp_timer_get_time();
+    int n = appendf(buf, cap, "{\"boot\":\"%08lx\",\"version\":%lu,\"sample_ms\":%lld,\"current\":{",
+                    (unsigned long)s_boot_id, (unsigned long)snap->version,
+                    snap->version ? (long long)(snap->ts_us / 1000) : -1LL);
+    n += current_json(buf + n, cap - n, snap);
+    n += appendf(buf + n, cap - n, "},");
+    n += health_json(buf + n, cap - n, now_us);
+    n += appendf(buf + n, cap - n, ",\"history\":{\"minutes\":%u,", minutes);
+    s_doc.len = 0;
+    if (json_full(n, cap)) {
+        ESP_LOGE(TAG, "/api/snapshot fields do not fit %u bytes", (unsigned)cap);
+        return false;
+    }
+    size_t rows = minutes ? history_get(s_rollups, minutes) : 0;
+    char *p = buf + n;
+    for (int c = 0; c < 8; c++) {
+        p += sprintf(p, "\"%s\":[", cols[c]);
+        for (size_t i = 0; i < rows; i++) p = put_int(p, rollup_field(&s_rollups[i], c));
+        if (rows) p--;                      // the last comma
+        *p++ = ']';
+        *p++ = ',';
+    }
+    p[-1] = '}';
+    *p++ = '}';
+    s_doc.len = (size_t)(p - buf);
+    s_doc.version = snap->version;
+    s_doc.minutes = (uint16_t)minutes;
+    snprintf(s_doc.etag, sizeof s_doc.etag, "W/\"%08lx-%08lx-%u\"", (unsigned long)s_boot_id,
+             (unsigned long)snapshot_content_hash(snap), minutes);
+    return true;
+}
+
+/**
+ * @brief HTTP handler for GET "/api/snapshot[?minutes=N]".
+ *
+ * One document for scrapers: boot id, snapshot version and the sample's
+ * esp_timer time, "current" (the /api/current fields), "health" (uptime,
+ * samples, loop jitter, heap, anomalies, network pool failures and each
+ * uplink's sent/failed/pending/dropped readings) and "history": the newest
+ * N closed minutes (default CONFIG_APP_SNAPSHOT_MINUTES) as columns in the
+ * fixed-point units of history.h, minutes counted from boot.
+ * The document is rendered once per snapshot version and served from
+ * s_doc until the next sample. Its ETag is boot id, N and a hash of the
+ * content a scraper acts on (snapshot_content_hash()), not the version, so
+ * a scraper polling an unchanged room every 10 s gets a 304 without a body
+ * until the next minute closes or a reading moves.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ *
+ */
+
+static esp_err_t api_snapshot_get(httpd_req_t *req) {
+    unsigned minutes = SNAP_DEF_MIN;
+    char q[32], val[8], *end;
+    if (httpd_req_get_url_query_str(req, q, sizeof q) == ESP_OK
+        && httpd_query_key_value(q, "minutes", val, sizeof val) == ESP_OK) {
+        unsigned long m = strtoul(val, &end, 10);
+        if (end == val || *end || m > SNAP_MAX_MIN) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "minutes out of range");
+        }
+        minutes = (unsigned)m;
+    }
+    climate_snapshot_t snap;
+    snapshot_get(&snap);
+    if ((!s_doc.len || s_doc.version != snap.version || s_doc.minutes != minutes)
+        && !snapshot_doc_render(&snap, minutes)) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "response too large");
+    }
+    httpd_resp_set_hdr(req, "ETag", s_doc.etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    char inm[96];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof inm) == ESP_OK
+        && (strstr(inm, s_doc.etag + 2) || strcmp(inm, "*") == 0)) {   // weak comparison: W/ optional
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, s_doc.body, s_doc.len);
+}
+
+#if CONFIG_APP_SELFHEAT_CALIBRATE_API
+/**
+ * @brief HTTP handler for POST "/api/calibrate?t=<°C>".
+ *
+ * Adds a reference air temperature taken next to the device to the
+ * self-heating fit and returns the refitted model as {"selfheat":{...}}.
+ * A reading whose fit is implausible (selfheat.h) gets 400 and changes
+ * nothing. Copy offset and c_per_hz into CONFIG_APP_SELFHEAT_* to keep them.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ *
+ */
+
+static esp_err_t api_calibrate_post(httpd_req_t *req) {
+    char q[32], val[16], *end;
+    if (httpd_req_get_url_query_str(req, q, sizeof q) != ESP_OK
+        || httpd_query_key_value(q, "t", val, sizeof val) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "t=<reference °C> required");
+    }
+    float ref = strtof(val, &end);
+    if (end == val || *end || !(ref > -40.0f && ref < 85.0f)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "t out of range");
+    }
+    esp_err_t err = selfheat_calibrate(ref);
+    if (err == ESP_ERR_INVALID_ARG) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "fit out of range; reading discarded");
+    }
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "no sample yet", HTTPD_RESP_USE_STRLEN);
+    }
+    selfheat_t sh;
+    selfheat_get(&sh);
+    ESP_LOGI(TAG, "self-heating: offset %.3f °C, %.3f °C/Hz (%u points)",
+             sh.model.offset_C, sh.model.C_per_hz, sh.cal_points);
+    char buf[256];
+    int n = appendf(buf, sizeof buf, "{");
+    n += selfheat_json(buf + n, sizeof buf - n, &sh);
+    n += appendf(buf + n, sizeof buf - n, "}");
+    if (json_full(n, sizeof buf)) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "response too large");
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, buf, n);
+}
+#endif
+
+/**
+ * @brief HTTP handler for GET "/trace".
+ *
+ * Downloads the recent raw sensor readings as a binary trace file
+ * (format in trace.h) for replay on the host. The file is streamed in
+ * chunks through one net_pool block, so its size does not reach the heap.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ *
+ */
+
+static esp_err_t trace_get(httpd_req_t *req) {
+    uint8_t *blk = net_pool_get();
+    if (!blk) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "busy, try again", HTTPD_RESP_USE_STRLEN);
+    }
+    trace_cursor_t cur;
+    if (trace_export_begin(&cur, blk) != ESP_OK) {
+        net_pool_put(blk);
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "trace recording disabled");
+    }
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=sensor.btrc");
+    size_t len = TRACE_HEADER_LEN;
+    esp_err_t err = ESP_OK;
+    int n;
+    while (err == ESP_OK && (n = trace_export_next(&cur, blk + len, NET_BLOCK_BYTES - len)) != 0) {
+        if (n < 0) {                                  // fell behind the recorder: cut the file short
+            ESP_LOGW(TAG, "trace export overrun");
+            err = ESP_FAIL;
+            break;
+        }
+        err = httpd_resp_send_chunk(req, (const char *)blk, len + n);
+        len = 0;
+    }
+    if (err == ESP_OK && len) err = httpd_resp_send_chunk(req, (const char *)blk, len);   // header only
+    if (err == ESP_OK) err = httpd_resp_send_chunk(req, NULL, 0);
+    net_pool_put(blk);
+    return err;
 }
 
 /**
@@ -107,6 +598,21 @@ static esp_err_t root_get(httpd_req_t *req) {
  */
 static httpd_handle_t start_http(void) {
     httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();  // sensible defaults
+#if CONFIG_APP_HTTPD_TUNED
+    // tuned profile (Kconfig "Web Server" menu): more sockets, LRU purge, short timeouts
+    cfg.max_open_sockets  = CONFIG_APP_HTTPD_MAX_SOCKETS;
+#if CONFIG_APP_HTTPD_LRU_PURGE
+    cfg.lru_purge_enable  = true;
+#endif
+    cfg.recv_wait_timeout = CONFIG_APP_HTTPD_RECV_TIMEOUT_S;
+    cfg.send_wait_timeout = CONFIG_APP_HTTPD_RECV_TIMEOUT_S;
+    cfg.stack_size        = CONFIG_APP_HTTPD_STACK;
+#endif
+    cfg.core_id           = SCHED_NET_CORE;      // with Wi-Fi/lwIP, away from the sensor task
+    cfg.task_priority     = SCHED_WEB_PRIO;
+    ESP_LOGI(TAG, "httpd: %u sockets, lru_purge=%d, timeout %u s, stack %u, prio %u",
+             (unsigned)cfg.max_open_sockets, cfg.lru_purge_enable,
+             (unsigned)cfg.recv_wait_timeout, (unsigned)cfg.stack_size, (unsigned)cfg.task_priority);
     httpd_handle_t s = NULL;
 
     if (httpd_start(&s, &cfg) == ESP_OK) {
@@ -117,6 +623,40 @@ static httpd_handle_t start_http(void) {
             .user_ctx = NULL
         };
         httpd_register_uri_handler(s, &root);
+
+        httpd_uri_t trace = {
+            .uri     = "/trace",
+            .method  = HTTP_GET,
+            .handler = trace_get,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(s, &trace);
+
+        httpd_uri_t api_current = {
+            .uri     = "/api/current",
+            .method  = HTTP_GET,
+            .handler = api_current_get,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(s, &api_current);
+
+        httpd_uri_t api_snapshot = {
+            .uri     = "/api/snapshot",
+            .method  = HTTP_GET,
+            .handler = api_snapshot_get,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(s, &api_snapshot);
+
+#if CONFIG_APP_SELFHEAT_CALIBRATE_API
+        httpd_uri_t api_calibrate = {
+            .uri     = "/api/calibrate",
+            .method  = HTTP_POST,
+            .handler = api_calibrate_post,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(s, &api_calibrate);
+#endif
     }
     return s;  // (unused, but returned in case server is stopped later)
 }
@@ -130,6 +670,8 @@ static httpd_handle_t start_http(void) {
  */
 
 void web_start(void) {
+    s_boot_id = esp_random();
+    mem_budget_add("web", sizeof s_doc + sizeof s_rollups);
     start_http();
     ESP_LOGI(TAG, "Web server started");
 }
@@ -0,0 +1,259 @@
+/*
+ * HTTP uplink (implementation).
+ * - The sensor loop only pushes into the backlog. The uplink task wakes once
+ *   per period, POSTs the oldest readings (up to CONFIG_APP_UPLINK_MAX_BATCH
+ *   per request) until the backlog is empty, and acks each request's
+ *   readings after a 2xx, so an outage drains back-to-back on one connection.
+ * - On failure the next attempt backs off 5 s, 10 s, ... up to
+ *   CONFIG_APP_UPLINK_RETRY_MAX_S instead of waiting a full period.
+ * - CONFIG_APP_UPLINK_FORMAT_INFLUX swaps the binary body for line protocol
+ *   (one line per reading + one outside-weather line), gzipped unless
+ *   CONFIG_APP_UPLINK_GZIP is off.
+ */
+
+#include "http_uplink.h"
+#include "http_client_ext.h"
+#include "line_protocol.h"
+#include "gzip_enc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "mem_budget.h"
+#include "sched_plan.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <math.h>
+#include <stdio.h>
+
+static const char *TAG = "UPLINK";
+
+#define RETRY_FIRST_S 5
+#define TASK_STACK    6144
+
+static esp_http_client_handle_t client;
+static backlog_t *backlog;
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static http_uplink_stats_t st;
+static float outside_temp = NAN, outside_humid = NAN;
+
+#if CONFIG_APP_UPLINK_FORMAT_INFLUX
+#define CONTENT_TYPE   "text/plain; charset=utf-8"
+#define TEXT_CAP       ((CONFIG_APP_UPLINK_MAX_BATCH + 1) * 96)     // typical line ~65 bytes
+#if CONFIG_APP_UPLINK_GZIP
+#define BODY_CAP       GZIP_BOUND(TEXT_CAP)
+#define BUF_BYTES      (TEXT_CAP + BODY_CAP)
+#else
+#define BODY_CAP       TEXT_CAP
+#define BUF_BYTES      BODY_CAP
+#endif
+static char series[64];         // "measurement,device=..."
+#else
+#define CONTENT_TYPE   HTTP_UPLINK_CONTENT_TYPE
+#define BODY_CAP       (CONFIG_APP_UPLINK_MAX_BATCH * (READING_BATCH_HEADER_LEN + READING_BATCH_RECORD_LEN))
+#define BUF_BYTES      BODY_CAP
+#endif
+
+/**
+ * @brief Encode readings as back-to-back batches (a batch ends at a seq gap,
+ *        a >65 s time gap or READING_BATCH_MAX readings).
+ *
+ * @param[in]  r    Readings, oldest first.
+ * @param[in]  n    Number of readings.
+ * @param[out] out  Body buffer (http_uplink_body_cap(n) always suffices).
+ * @param[in]  cap  Size of out.
+ * @param[out] used Readings encoded.
+ * @return Body length in bytes.
+ */
+size_t http_uplink_encode_body(const reading_t *r, size_t n, uint8_t *out, size_t cap, size_t *used)
+{
+    size_t len = 0, done = 0;
+    while (done < n) {
+        size_t k;
+        size_t b = reading_batch_encode(r + done, n - done, out + len, cap - len, &k);
+        if (b == 0) break;
+        len += b;
+        done += k;
+    }
+    *used = done;
+    return len;
+}
+
+#if CONFIG_APP_UPLINK_FORMAT_INFLUX
+/**
+ * @brief Encode readings as line protocol plus the latest outside weather.
+ *
+ * @return Text length; *used = readings encoded.
+ */
+static size_t encode_lines(const reading_t *r, size_t n, char *out, size_t cap, size_t *used)
+{
+    size_t len = 0, k = 0;
+    for (; k < n; k++) {
+        size_t l = lp_append_reading(out + len, cap - len, series, &r[k]);
+        if (l == 0) break;
+        len += l;
+    }
+    portENTER_CRITICAL(&mux);
+    float t = outside_temp, h = outside_humid;
+    portEXIT_CRITICAL(&mux);
+    if (k) len += lp_append_outside(out + len, cap - len, series, t, h, r[k - 1].unix_ms);
+    *used = k;
+    return len;
+}
+#endif
+
+// POST the oldest readings until the backlog is empty; false on failure.
+static bool upload_pending(void)
+{
+    static reading_t batch[CONFIG_APP_UPLINK_MAX_BATCH];
+    static uint8_t body[BODY_CAP];
+#if CONFIG_APP_UPLINK_FORMAT_INFLUX && CONFIG_APP_UPLINK_GZIP
+    static char text[TEXT_CAP];
+#endif
+
+    size_t n;
+    while ((n = backlog_peek(backlog, batch, CONFIG_APP_UPLINK_MAX_BATCH)) > 0) {
+        size_t used, len;
+#if CONFIG_APP_UPLINK_FORMAT_INFLUX && CONFIG_APP_UPLINK_GZIP
+        size_t text_len = encode_lines(batch, n, text, sizeof text, &used);
+        len = gzip_compress((const uint8_t *)text, text_len, body, sizeof body);
+#elif CONFIG_APP_UPLINK_FORMAT_INFLUX
+        len = encode_lines(batch, n, (char *)body, sizeof body, &used);
+#else
+        len = http_uplink_encode_body(batch, n, body, sizeof body, &used);
+#endif
+        if (used == 0 || len == 0) {                   // retrying would never succeed: skip it
+            ESP_LOGE(TAG, "cannot encode reading seq %lu; dropped", (unsigned long)batch[0].seq);
+            portENTER_CRITICAL(&mux);
+            st.unencodable++;
+            portEXIT_CRITICAL(&mux);
+            backlog_ack(backlog, batch[0].seq);
+            continue;
+        }
+        int status;
+        esp_err_t err = http_ext_post(client, CONTENT_TYPE, (const char *)body, (int)len, &status);
+
+        portENTER_CRITICAL(&mux);
+        st.last_status = status;
+        bool ok = err == ESP_OK && status >= 200 && status < 300;
+        if (ok) {
+            st.posts++;
+            st.readings += used;
+            st.bytes += len;
+        } else {
+            st.failures++;
+        }
+        portEXIT_CRITICAL(&mux);
+
+        if (!ok) {
+            ESP_LOGW(TAG, "upload of %u readings failed: %s, status %d", (unsigned)used, esp_err_to_name(err), status);
+            return false;
+        }
+        backlog_ack(backlog, batch[used - 1].seq);
+    }
+    return true;
+}
+
+/**
+ * @brief Uplink task: uploads once per period, backing off after failures.
+ *
+ * @param arg Unused.
+ */
+static void http_uplink_task(void *arg)
+{
+    uint32_t retry_s = 0;      // 0 = last upload succeeded
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS((retry_s ? retry_s : CONFIG_APP_UPLINK_PERIOD_S) * 1000U));
+        if (upload_pending()) {
+            retry_s = 0;
+        } else {
+            retry_s = retry_s ? retry_s * 2 : RETRY_FIRST_S;
+            if (retry_s > CONFIG_APP_UPLINK_RETRY_MAX_S) retry_s = CONFIG_APP_UPLINK_RETRY_MAX_S;
+        }
+    }
+}
+
+/**
+ * @brief Create the backlog and collector client and start the uplink task.
+ *
+ * Does nothing when CONFIG_APP_UPLINK_URL is empty.
+ *
+ * @return ESP_OK, or an error if the client/backlog could not be created.
+ */
+esp_err_t http_uplink_start(void)
+{
+    if (CONFIG_APP_UPLINK_URL[0] == '\0') {
+        ESP_LOGI(TAG, "no collector configured; HTTP uplink off");
+        return ESP_OK;
+    }
+
+    const char *part = CONFIG_APP_UPLINK_BACKLOG_PARTITION;
+#if CONFIG_APP_STATIC_ALLOC
+    static reading_t ram[CONFIG_APP_UPLINK_BACKLOG_RAM];
+    backlog = backlog_create_static(ram, CONFIG_APP_UPLINK_BACKLOG_RAM, part[0] ? part : NULL);
+#else
+    backlog = backlog_create(CONFIG_APP_UPLINK_BACKLOG_RAM, part[0] ? part : NULL);
+#endif
+    client = http_ext_client_new(CONFIG_APP_UPLINK_URL, 10000);
+    if (!backlog || !client) return ESP_ERR_NO_MEM;
+    if (CONFIG_APP_UPLINK_AUTH[0]) esp_http_client_set_header(client, "Authorization", CONFIG_APP_UPLINK_AUTH);
+#if CONFIG_APP_UPLINK_FORMAT_INFLUX
+    if (!lp_series_prefix(series, sizeof series, CONFIG_APP_UPLINK_MEASUREMENT, "device", CONFIG_APP_UPLINK_DEVICE)) {
+        ESP_LOGE(TAG, "measurement/device name too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+#if CONFIG_APP_UPLINK_GZIP
+    esp_http_client_set_header(client, "Content-Encoding", "gzip");
+#endif
+#endif
+
+#if CONFIG_APP_STATIC_ALLOC
+    static StackType_t stack[TASK_STACK];
+    static StaticTask_t tcb;
+    if (!xTaskCreateStaticPinnedToCore(http_uplink_task, "http_uplink", TASK_STACK, NULL, SCHED_NET_PRIO, stack, &tcb,
+                                       SCHED_NET_CORE)) return ESP_ERR_NO_MEM;
+#else
+    if (xTaskCreatePinnedToCore(http_uplink_task, "http_uplink", TASK_STACK, NULL, SCHED_NET_PRIO, NULL,
+                                SCHED_NET_CORE) != pdPASS) return ESP_ERR_NO_MEM;
+#endif
+    mem_budget_add("uplink", TASK_STACK + (CONFIG_APP_UPLINK_BACKLOG_RAM + CONFIG_APP_UPLINK_MAX_BATCH) * sizeof(reading_t)
+                             + BUF_BYTES);
+    ESP_LOGI(TAG, "posting to %s every %d s (up to %d readings per request)", CONFIG_APP_UPLINK_URL,
+             CONFIG_APP_UPLINK_PERIOD_S, CONFIG_APP_UPLINK_MAX_BATCH);
+    return ESP_OK;
+}
+
+/**
+ * @brief Queue one compensated sample for the next upload.
+ *
+ * @param[in] s Sample from sample_pipeline_process().
+ */
+void http_uplink_submit(const sample_t *s, int64_t unix_ms)
+{
+    if (!backlog) return;
+    backlog_push(backlog, s, unix_ms);
+}
+
+/**
+ * @brief Latest outside weather, written with the next line-protocol upload.
+ *
+ * @param[in] temp_C   Outside temperature (NAN = unknown).
+ * @param[in] humid_RH Outside humidity (NAN = unknown).
+ */
+void http_uplink_set_outside(float temp_C, float humid_RH)
+{
+    portENTER_CRITICAL(&mux);
+    outside_temp = temp_C;
+    outside_humid = humid_RH;
+    portEXIT_CRITICAL(&mux);
+}
+
+void http_uplink_get_stats(http_uplink_stats_t *out)
+{
+    backlog_stats_t b;
+    backlog_get_stats(backlog, &b);
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+    out->backlog = b;
+}
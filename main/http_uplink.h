@@ -0,0 +1,42 @@
+/*
+ * HTTP uplink (public API).
+ * - For sites without MQTT: every CONFIG_APP_UPLINK_PERIOD_S seconds POSTs
+ *   the readings accumulated since the last upload to CONFIG_APP_UPLINK_URL,
+ *   over one kept-alive connection (http_ext_client_new/http_ext_post).
+ * - Body: one or more reading_codec.h batches back to back, Content-Type
+ *   HTTP_UPLINK_CONTENT_TYPE; or, with CONFIG_APP_UPLINK_FORMAT_INFLUX, gzipped
+ *   InfluxDB line protocol (line_protocol.h). Any 2xx acknowledges the body.
+ * - Readings wait in a backlog (RAM, spilling to flash) until acknowledged;
+ *   failed uploads back off up to CONFIG_APP_UPLINK_RETRY_MAX_S.
+ * - Disabled when CONFIG_APP_UPLINK_URL is empty.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+#include "reading_codec.h"
+#include "backlog.h"
+
+#define HTTP_UPLINK_CONTENT_TYPE "application/x-climate-batch"
+
+typedef struct {
+    uint32_t posts;               // acknowledged uploads
+    uint32_t readings;            // readings in those uploads
+    uint32_t bytes;               // body bytes in those uploads
+    uint32_t failures;            // transport errors and non-2xx answers
+    uint32_t unencodable;         // readings skipped because they did not fit a body
+    int      last_status;         // HTTP status of the last attempt (0 = no response)
+    backlog_stats_t backlog;
+} http_uplink_stats_t;
+
+esp_err_t http_uplink_start(void);                 // ESP_OK when disabled
+void      http_uplink_submit(const sample_t *s, int64_t unix_ms);     // from net_task (unix_ms: wall time of the read)
+void      http_uplink_set_outside(float temp_C, float humid_RH);   // line protocol only
+void      http_uplink_get_stats(http_uplink_stats_t *out);
+
+// Encode n readings (oldest first) as consecutive batches. Returns body bytes;
+// *used = readings encoded (all n unless cap runs out). Exported for uplink_bench.
+size_t http_uplink_encode_body(const reading_t *r, size_t n, uint8_t *out, size_t cap, size_t *used);
+static inline size_t http_uplink_body_cap(size_t n) { return n * reading_batch_size(1); }   // worst case
@@ -0,0 +1,142 @@
+/*
+ * InfluxDB line protocol encoder (implementation).
+ * - Integer formatting: digits are produced right-to-left into a small stack
+ *   buffer and copied once; a decimal point is inserted at a fixed position.
+ * - Lines are built into a stack buffer first so a line never ends up half
+ *   written when the caller's buffer is full.
+ */
+
+#include "line_protocol.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+static size_t fmt_u64(char *out, uint64_t v)
+{
+    char tmp[20];
+    size_t n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    for (size_t i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+/**
+ * @brief Print v / 10^decimals, e.g. (2251, 2) -> "22.51", (-5, 2) -> "-0.05".
+ *
+ * @param[out] out      Destination (at least 13 bytes for int32 input).
+ * @param[in]  v        Fixed-point value.
+ * @param[in]  decimals Digits after the point (0 = integer).
+ * @return Characters written.
+ */
+size_t lp_format_fixed(char *out, int32_t v, unsigned decimals)
+{
+    char tmp[16];
+    size_t n = 0;
+    uint32_t u = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+    for (unsigned d = 0; d < decimals; d++) { tmp[n++] = (char)('0' + u % 10); u /= 10; }
+    if (decimals) tmp[n++] = '.';
+    do { tmp[n++] = (char)('0' + u % 10); u /= 10; } while (u);
+    if (v < 0) tmp[n++] = '-';
+    for (size_t i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+// Copy s escaping the characters line protocol reserves in names and tags.
+static size_t put_escaped(char *out, size_t cap, const char *s, const char *special)
+{
+    size_t n = 0;
+    for (; *s; s++) {
+        bool esc = strchr(special, *s) != NULL;
+        if (n + 1 + esc > cap) return 0;
+        if (esc) out[n++] = '\\';
+        out[n++] = *s;
+    }
+    return n;
+}
+
+/**
+ * @brief Build the "measurement,tag=value" series key shared by every line.
+ *
+ * @return Length written (NUL-terminated), 0 if it does not fit in cap.
+ */
+size_t lp_series_prefix(char *out, size_t cap, const char *measurement, const char *tag_key, const char *tag_value)
+{
+    size_t n = put_escaped(out, cap, measurement, ", ");
+    if (n == 0) return 0;
+    if (tag_key && tag_key[0] && tag_value && tag_value[0]) {
+        size_t k, v;
+        if (n + 1 >= cap) return 0;
+        out[n++] = ',';
+        if (!(k = put_escaped(out + n, cap - n, tag_key, ",= "))) return 0;
+        n += k;
+        if (n + 1 >= cap) return 0;
+        out[n++] = '=';
+        if (!(v = put_escaped(out + n, cap - n, tag_value, ",= "))) return 0;
+        n += v;
+    }
+    if (n >= cap) return 0;
+    out[n] = '\0';
+    return n;
+}
+
+static size_t finish_line(char *out, size_t cap, const char *line, size_t len)
+{
+    if (len > cap) return 0;
+    memcpy(out, line, len);
+    return len;
+}
+
+/**
+ * @brief Append "prefix t=..,p=..,h=.. unix_ms\n" for one reading.
+ *
+ * @return Bytes written, 0 if the line does not fit in cap.
+ */
+size_t lp_append_reading(char *out, size_t cap, const char *prefix, const reading_t *r)
+{
+    char line[LP_LINE_MAX];
+    size_t pl = strlen(prefix);
+    if (pl > LP_LINE_MAX - 96) return 0;
+    memcpy(line, prefix, pl);
+    size_t n = pl;
+    memcpy(line + n, " t=", 3);  n += 3;
+    n += lp_format_fixed(line + n, r->t_cC, 2);
+    memcpy(line + n, ",p=", 3);  n += 3;
+    n += lp_format_fixed(line + n, (int32_t)r->p_dPa, 1);
+    memcpy(line + n, ",h=", 3);  n += 3;
+    n += lp_format_fixed(line + n, r->h_cRH, 2);
+    line[n++] = ' ';
+    n += fmt_u64(line + n, r->unix_ms > 0 ? (uint64_t)r->unix_ms : 0);
+    line[n++] = '\n';
+    return finish_line(out, cap, line, n);
+}
+
+/**
+ * @brief Append "prefix out_t=..,out_h=.. unix_ms\n" (0.1 resolution, NaN fields left out).
+ *
+ * @return Bytes written, 0 if both values are NaN or the line does not fit.
+ */
+size_t lp_append_outside(char *out, size_t cap, const char *prefix, float temp_C, float humid_RH, int64_t unix_ms)
+{
+    if (isnan(temp_C) && isnan(humid_RH)) return 0;
+    char line[LP_LINE_MAX];
+    size_t pl = strlen(prefix);
+    if (pl > LP_LINE_MAX - 96) return 0;
+    memcpy(line, prefix, pl);
+    size_t n = pl;
+    char sep = ' ';
+    if (!isnan(temp_C)) {
+        line[n++] = sep;
+        memcpy(line + n, "out_t=", 6);  n += 6;
+        n += lp_format_fixed(line + n, (int32_t)lroundf(temp_C * 10.0f), 1);
+        sep = ',';
+    }
+    if (!isnan(humid_RH)) {
+        line[n++] = sep;
+        memcpy(line + n, "out_h=", 6);  n += 6;
+        n += lp_format_fixed(line + n, (int32_t)lroundf(humid_RH * 10.0f), 1);
+    }
+    line[n++] = ' ';
+    n += fmt_u64(line + n, unix_ms > 0 ? (uint64_t)unix_ms : 0);
+    line[n++] = '\n';
+    return finish_line(out, cap, line, n);
+}
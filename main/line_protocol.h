@@ -0,0 +1,25 @@
+/*
+ * InfluxDB line protocol encoder (public API).
+ * Formats readings as "<measurement>,<tags> t=..,p=..,h=.. <unix_ms>" lines
+ * (write with precision=ms). Values come from the fixed-point reading_t and
+ * are printed with integer arithmetic only: no %f, no doubles.
+ *   t  °C   2 decimals      p  Pa   1 decimal      h  %RH  2 decimals
+ * Outside weather is written as its own line (fields out_t, out_h).
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "reading_codec.h"
+
+#define LP_LINE_MAX 160        // longest line for a prefix of up to 64 bytes
+
+// "<measurement>,<tag_key>=<tag_value>" with line-protocol escaping. Returns length, 0 if it does not fit.
+size_t lp_series_prefix(char *out, size_t cap, const char *measurement, const char *tag_key, const char *tag_value);
+
+// Append one line (with '\n'). Return bytes written, 0 if cap is too small.
+size_t lp_append_reading(char *out, size_t cap, const char *prefix, const reading_t *r);
+size_t lp_append_outside(char *out, size_t cap, const char *prefix, float temp_C, float humid_RH, int64_t unix_ms);
+
+// Signed fixed-point value v / 10^decimals as text (no terminator). Returns length (<= 12 for int32).
+size_t lp_format_fixed(char *out, int32_t v, unsigned decimals);
@@ -0,0 +1,61 @@
+/*
+ * Boot-time RAM budget (implementation).
+ * - A fixed table of (name, bytes); names are compared by string so callers
+ *   can pass literals from different translation units.
+ * - The report ends with the free heap at that point; in static mode the
+ *   PERF lines' heap_min should stay there.
+ */
+
+#include "mem_budget.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "MEM";
+
+typedef struct {
+    const char *name;
+    size_t      bytes;
+} entry_t;
+
+static entry_t entries[MEM_BUDGET_MAX];
+static int     n_entries;
+
+void mem_budget_add(const char *subsystem, size_t bytes)
+{
+    int i = 0;
+    while (i < n_entries && strcmp(entries[i].name, subsystem) != 0) i++;
+    if (i == n_entries) {
+        if (n_entries == MEM_BUDGET_MAX) i = MEM_BUDGET_MAX - 1;      // table full: the last slot is "other"
+        else entries[n_entries++].name = subsystem;
+        if (i == MEM_BUDGET_MAX - 1) entries[i].name = "other";
+    }
+    entries[i].bytes += bytes;
+}
+
+size_t mem_budget_total(void)
+{
+    size_t total = 0;
+    for (int i = 0; i < n_entries; i++) total += entries[i].bytes;
+    return total;
+}
+
+/**
+ * @brief Log the budget per subsystem, the total and the heap left.
+ */
+void mem_budget_report(void)
+{
+#if CONFIG_APP_STATIC_ALLOC
+    const char *kind = "static";
+#else
+    const char *kind = "heap";
+#endif
+    for (int i = 0; i < n_entries; i++) {
+        ESP_LOGI(TAG, "%-10s %7u B", entries[i].name, (unsigned)entries[i].bytes);
+    }
+    ESP_LOGI(TAG, "total=%u (%s) heap_free=%lu heap_min=%lu heap_largest=%u", (unsigned)mem_budget_total(), kind,
+             (unsigned long)esp_get_free_heap_size(), (unsigned long)esp_get_minimum_free_heap_size(),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
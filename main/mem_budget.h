@@ -0,0 +1,20 @@
+/*
+ * Boot-time RAM budget (public API).
+ * - Each subsystem declares the long-lived RAM it sets up at start-up (task
+ *   stacks and control blocks, rings, backlogs, buffers) with
+ *   mem_budget_add(); mem_budget_report() logs one line per subsystem, the
+ *   total and what the heap has left once everything is running.
+ * - With CONFIG_APP_STATIC_ALLOC the same memory is static (.bss) and the
+ *   heap stays flat after the report; without it the figures are what the
+ *   subsystems took from the heap.
+ * - Called from app_main() during start-up only (no locking).
+ */
+
+#pragma once
+#include <stddef.h>
+
+#define MEM_BUDGET_MAX 12             // subsystems tracked; further names are folded into "other"
+
+void   mem_budget_add(const char *subsystem, size_t bytes);   // adds to an existing entry of that name
+size_t mem_budget_total(void);
+void   mem_budget_report(void);
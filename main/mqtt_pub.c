@@ -0,0 +1,219 @@
+/*
+ * MQTT telemetry publisher (implementation).
+ * - The sensor loop only pushes into the backlog; a separate task peeks the
+ *   oldest readings, publishes one batch, waits for its PUBACK and only then
+ *   acks them out of the backlog (at-least-once; receivers dedupe by seq).
+ * - A batch goes out when CONFIG_APP_MQTT_BATCH readings are pending or the
+ *   oldest has waited CONFIG_APP_MQTT_BATCH_MAX_AGE_S; after an outage the
+ *   backlog drains back-to-back on the same connection.
+ */
+
+#include "mqtt_pub.h"
+#include "reading_codec.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "mqtt_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mem_budget.h"
+#include "sched_plan.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "MQTT_PUB";
+
+#define PUBACK_TIMEOUT_MS 10000
+#define TASK_STACK        4096
+
+static esp_mqtt_client_handle_t client;
+static backlog_t *backlog;
+static SemaphoreHandle_t wake;            // new batch ready / (re)connected
+static SemaphoreHandle_t ack_sem;         // PUBLISHED or DISCONNECTED seen
+static volatile bool connected;
+static volatile int  acked_msg_id;
+static char topic_readings[96];
+static char topic_status[96];
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_pub_stats_t st;
+
+static int64_t unix_ms_now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static void mqtt_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    esp_mqtt_event_handle_t ev = data;
+    switch ((esp_mqtt_event_id_t)id) {
+    case MQTT_EVENT_CONNECTED:
+        connected = true;
+        portENTER_CRITICAL(&mux);
+        st.connects++;
+        portEXIT_CRITICAL(&mux);
+        ESP_LOGI(TAG, "connected (session_present=%d, %u readings queued)",
+                 ev->session_present, (unsigned)backlog_count(backlog));
+        esp_mqtt_client_publish(client, topic_status, "online", 0, 1, 1);
+        xSemaphoreGive(wake);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        connected = false;
+        xSemaphoreGive(ack_sem);          // stop waiting for a PUBACK that will not come
+        break;
+    case MQTT_EVENT_PUBLISHED:
+        acked_msg_id = ev->msg_id;
+        xSemaphoreGive(ack_sem);
+        break;
+    default:
+        break;
+    }
+}
+
+// Wait for the PUBACK of msg_id; false on disconnect or timeout.
+static bool wait_puback(int msg_id)
+{
+    int64_t deadline = esp_timer_get_time() + PUBACK_TIMEOUT_MS * 1000LL;
+    while (esp_timer_get_time() < deadline) {
+        if (!xSemaphoreTake(ack_sem, pdMS_TO_TICKS(500))) continue;
+        if (acked_msg_id == msg_id) return true;
+        if (!connected) return false;
+    }
+    return false;
+}
+
+/**
+ * @brief Publisher task: turns backlog contents into acknowledged batches.
+ *
+ * @param arg Unused.
+ */
+static void mqtt_pub_task(void *arg)
+{
+    static reading_t batch[CONFIG_APP_MQTT_BATCH];
+    static uint8_t payload[READING_BATCH_HEADER_LEN + CONFIG_APP_MQTT_BATCH * READING_BATCH_RECORD_LEN];
+
+    while (1) {
+        xSemaphoreTake(wake, pdMS_TO_TICKS(1000));   // also re-checks batch age once a second
+
+        while (connected) {
+            size_t n = backlog_peek(backlog, batch, CONFIG_APP_MQTT_BATCH);
+            if (n == 0) break;
+            if (n < CONFIG_APP_MQTT_BATCH && backlog_count(backlog) < CONFIG_APP_MQTT_BATCH &&
+                unix_ms_now() - batch[0].unix_ms < CONFIG_APP_MQTT_BATCH_MAX_AGE_S * 1000LL) {
+                break;                                // not full and not old yet
+            }
+
+            size_t used;
+            size_t len = reading_batch_encode(batch, n, payload, sizeof payload, &used);
+            int msg_id = esp_mqtt_client_publish(client, topic_readings, (const char *)payload, (int)len,
+                                                 CONFIG_APP_MQTT_QOS, 0);
+            bool ok = msg_id >= 0 && (CONFIG_APP_MQTT_QOS == 0 || wait_puback(msg_id));
+            if (!ok) {
+                portENTER_CRITICAL(&mux);
+                st.failures++;
+                portEXIT_CRITICAL(&mux);
+                ESP_LOGW(TAG, "batch seq %lu..%lu not acknowledged; kept for retry",
+                         (unsigned long)batch[0].seq, (unsigned long)batch[used - 1].seq);
+                break;
+            }
+
+            backlog_ack(backlog, batch[used - 1].seq);
+            portENTER_CRITICAL(&mux);
+            st.batches++;
+            st.readings += used;
+            st.bytes += len;
+            portEXIT_CRITICAL(&mux);
+        }
+    }
+}
+
+/**
+ * @brief Create the backlog and MQTT client and start publishing.
+ *
+ * Does nothing when CONFIG_APP_MQTT_BROKER_URI is empty. The client
+ * reconnects on its own; readings queue in the backlog meanwhile.
+ *
+ * @return ESP_OK, or an error if the client/backlog could not be created.
+ */
+esp_err_t mqtt_pub_start(void)
+{
+    if (CONFIG_APP_MQTT_BROKER_URI[0] == '\0') {
+        ESP_LOGI(TAG, "no broker configured; MQTT publishing off");
+        return ESP_OK;
+    }
+
+    const char *part = CONFIG_APP_MQTT_BACKLOG_PARTITION;
+#if CONFIG_APP_STATIC_ALLOC
+    static reading_t ram[CONFIG_APP_MQTT_BACKLOG_RAM];
+    static StaticSemaphore_t wake_mem, ack_mem;
+    backlog = backlog_create_static(ram, CONFIG_APP_MQTT_BACKLOG_RAM, part[0] ? part : NULL);
+    wake = xSemaphoreCreateBinaryStatic(&wake_mem);
+    ack_sem = xSemaphoreCreateBinaryStatic(&ack_mem);
+#else
+    backlog = backlog_create(CONFIG_APP_MQTT_BACKLOG_RAM, part[0] ? part : NULL);
+    wake = xSemaphoreCreateBinary();
+    ack_sem = xSemaphoreCreateBinary();
+#endif
+    if (!backlog || !wake || !ack_sem) return ESP_ERR_NO_MEM;
+
+    snprintf(topic_readings, sizeof topic_readings, "%s/readings", CONFIG_APP_MQTT_TOPIC);
+    snprintf(topic_status, sizeof topic_status, "%s/status", CONFIG_APP_MQTT_TOPIC);
+
+    esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = CONFIG_APP_MQTT_BROKER_URI,
+        .credentials.client_id = CONFIG_APP_MQTT_CLIENT_ID,
+        .credentials.username = CONFIG_APP_MQTT_USERNAME[0] ? CONFIG_APP_MQTT_USERNAME : NULL,
+        .credentials.authentication.password = CONFIG_APP_MQTT_PASSWORD[0] ? CONFIG_APP_MQTT_PASSWORD : NULL,
+        .session.disable_clean_session = true,         // broker keeps our session across reconnects
+        .session.keepalive = CONFIG_APP_MQTT_KEEPALIVE_S,
+        .session.last_will.topic = topic_status,
+        .session.last_will.msg = "offline",
+        .session.last_will.qos = 1,
+        .session.last_will.retain = 1,
+        .task.priority = SCHED_NET_PRIO,               // core: CONFIG_MQTT_USE_CORE_0 (sdkconfig)
+    };
+    client = esp_mqtt_client_init(&cfg);
+    if (!client) return ESP_FAIL;
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+
+#if CONFIG_APP_STATIC_ALLOC
+    static StackType_t stack[TASK_STACK];
+    static StaticTask_t tcb;
+    if (!xTaskCreateStaticPinnedToCore(mqtt_pub_task, "mqtt_pub", TASK_STACK, NULL, SCHED_NET_PRIO, stack, &tcb,
+                                       SCHED_NET_CORE)) return ESP_ERR_NO_MEM;
+#else
+    if (xTaskCreatePinnedToCore(mqtt_pub_task, "mqtt_pub", TASK_STACK, NULL, SCHED_NET_PRIO, NULL,
+                                SCHED_NET_CORE) != pdPASS) return ESP_ERR_NO_MEM;
+#endif
+    mem_budget_add("mqtt", TASK_STACK + CONFIG_APP_MQTT_BACKLOG_RAM * sizeof(reading_t));
+    ESP_LOGI(TAG, "publishing to %s on %s (batch %d, QoS %d)", topic_readings, CONFIG_APP_MQTT_BROKER_URI,
+             CONFIG_APP_MQTT_BATCH, CONFIG_APP_MQTT_QOS);
+    return esp_mqtt_client_start(client);
+}
+
+/**
+ * @brief Queue one compensated sample for publishing.
+ *
+ * @param[in] s Sample from sample_pipeline_process().
+ */
+void mqtt_pub_submit(const sample_t *s, int64_t unix_ms)
+{
+    if (!backlog) return;
+    backlog_push(backlog, s, unix_ms);
+    if (backlog_count(backlog) >= CONFIG_APP_MQTT_BATCH) xSemaphoreGive(wake);
+}
+
+void mqtt_pub_get_stats(mqtt_pub_stats_t *out)
+{
+    backlog_stats_t b;
+    backlog_get_stats(backlog, &b);
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+    out->backlog = b;
+}
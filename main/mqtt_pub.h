@@ -0,0 +1,29 @@
+/*
+ * MQTT telemetry publisher (public API).
+ * - Sends readings to <CONFIG_APP_MQTT_TOPIC>/readings as binary batches
+ *   (reading_codec.h layout) of up to CONFIG_APP_MQTT_BATCH readings, QoS 1
+ *   by default, over one long-lived connection with a persistent session.
+ * - Readings wait in a backlog (RAM, spilling to the "backlog" flash
+ *   partition) until the broker acknowledges them, so outages and reboots
+ *   do not lose data; retained "online"/"offline" (will) on <topic>/status.
+ * - Disabled when CONFIG_APP_MQTT_BROKER_URI is empty.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+#include "backlog.h"
+
+typedef struct {
+    uint32_t connects;
+    uint32_t batches;              // batches acknowledged (or sent, QoS 0)
+    uint32_t readings;             // readings in those batches
+    uint32_t bytes;                // payload bytes in those batches
+    uint32_t failures;             // publish errors and missing PUBACKs
+    backlog_stats_t backlog;
+} mqtt_pub_stats_t;
+
+esp_err_t mqtt_pub_start(void);              // after the network is up; ESP_OK when disabled
+void      mqtt_pub_submit(const sample_t *s, int64_t unix_ms);   // from net_task (unix_ms: wall time of the read)
+void      mqtt_pub_get_stats(mqtt_pub_stats_t *out);
@@ -0,0 +1,94 @@
+/*
+ * Fixed-block pool for network I/O buffers (implementation).
+ * - The blocks are one static array; a bit per block marks it free, so get
+ *   and put are a few instructions under the spinlock and the pool itself
+ *   cannot fragment.
+ * - Blocks are 4-byte aligned (the array is uint32_t) for the codecs that
+ *   write words.
+ */
+
+#include "net_pool.h"
+#include "mem_budget.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <stdbool.h>
+
+#if CONFIG_APP_NET_POOL_BLOCKS > 32
+#error "APP_NET_POOL_BLOCKS: the free mask holds 32 blocks"
+#endif
+
+#define BLOCK_WORDS ((NET_BLOCK_BYTES + 3) / 4)
+
+static const char *TAG = "net_pool";
+
+static portMUX_TYPE     mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t         mem[CONFIG_APP_NET_POOL_BLOCKS][BLOCK_WORDS];
+static uint32_t         free_mask;
+static net_pool_stats_t st;
+
+/**
+ * @brief Mark every block free, reset the counters and declare the pool in
+ *        the boot RAM budget.
+ */
+void net_pool_init(void)
+{
+    portENTER_CRITICAL(&mux);
+    free_mask = CONFIG_APP_NET_POOL_BLOCKS == 32 ? UINT32_MAX : (1u << CONFIG_APP_NET_POOL_BLOCKS) - 1u;
+    st = (net_pool_stats_t){ .blocks = CONFIG_APP_NET_POOL_BLOCKS };
+    portEXIT_CRITICAL(&mux);
+    mem_budget_add("netpool", sizeof mem);
+}
+
+/**
+ * @brief Take one block.
+ *
+ * @return NET_BLOCK_BYTES of storage, or NULL if every block is out (counted
+ *         in net_pool_stats_t.fails).
+ */
+void *net_pool_get(void)
+{
+    void *blk = NULL;
+    portENTER_CRITICAL(&mux);
+    if (free_mask) {
+        int i = __builtin_ctz(free_mask);
+        free_mask &= ~(1u << i);
+        blk = mem[i];
+        st.gets++;
+        if (++st.in_use > st.peak) st.peak = st.in_use;
+    } else {
+        st.fails++;
+    }
+    portEXIT_CRITICAL(&mux);
+    if (!blk) ESP_LOGW(TAG, "all %d blocks in use", CONFIG_APP_NET_POOL_BLOCKS);
+    return blk;
+}
+
+/**
+ * @brief Return a block from net_pool_get().
+ *
+ * A pointer that is not a block in use (foreign, offset or already returned)
+ * is logged and ignored.
+ */
+void net_pool_put(void *blk)
+{
+    if (!blk) return;
+    uintptr_t off = (uintptr_t)blk - (uintptr_t)mem;
+    size_t i = off / sizeof mem[0];
+    bool ok = off < sizeof mem && off % sizeof mem[0] == 0;
+    portENTER_CRITICAL(&mux);
+    if (ok && !(free_mask & (1u << i))) {
+        free_mask |= 1u << i;
+        st.in_use--;
+    } else {
+        ok = false;
+    }
+    portEXIT_CRITICAL(&mux);
+    if (!ok) ESP_LOGE(TAG, "put of %p: not a block in use", blk);
+}
+
+void net_pool_stats(net_pool_stats_t *out)
+{
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+}
@@ -0,0 +1,30 @@
+/*
+ * Fixed-block pool for network I/O buffers (public API).
+ * - CONFIG_APP_NET_POOL_BLOCKS blocks of CONFIG_APP_NET_BLOCK_BYTES, set
+ *   aside once; the weather fetch reads its response into one and the web
+ *   server streams /trace through one. Short-lived buffers then never touch
+ *   the heap and cannot leave holes between long-lived allocations.
+ * - Whole blocks only, no fallback to malloc: NULL means every block is
+ *   out and the caller fails that request.
+ * - Any task; a spinlock guards the free mask.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define NET_BLOCK_BYTES CONFIG_APP_NET_BLOCK_BYTES
+
+typedef struct {
+    uint8_t  blocks;                  // pool size
+    uint8_t  in_use;
+    uint8_t  peak;                    // most blocks out at once since init
+    uint32_t gets;                    // successful net_pool_get() calls
+    uint32_t fails;                   // ... and the ones that found the pool empty
+} net_pool_stats_t;
+
+void  net_pool_init(void);            // app_main, at start-up
+void *net_pool_get(void);             // NET_BLOCK_BYTES, or NULL when all are out
+void  net_pool_put(void *blk);        // NULL is ignored
+void  net_pool_stats(net_pool_stats_t *out);
@@ -0,0 +1,174 @@
+/*
+ * Runtime performance metrics (implementation).
+ * - Loop timestamps come from the caller (same esp_timer value stored with the
+ *   sample), so jitter measures the real wake-up spread of vTaskDelayUntil().
+ * - HTTP counters are updated from the httpd task, loop counters from the
+ *   sensor task; a spinlock keeps the two consistent for perf_metrics_get().
+ * - CONFIG_APP_PERF_REPORT_S = 0 keeps collecting but never logs.
+ */
+
+#include "perf_metrics.h"
+#include "anomaly.h"
+#include "net_pool.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const char *TAG = "PERF";
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t period_us = 1000000;
+static perf_metrics_t m = { .first_sample_ms = -1 };
+static int64_t  last_ts_us;
+static int64_t  next_report_us;
+static uint64_t win_jitter_sum_us;      // current report window
+static uint32_t win_intervals;
+static uint32_t win_jitter_max_us;
+static uint64_t http_sum_us;
+static bool     skip_interval;          // next interval straddles a period change
+
+/**
+ * @brief Set the expected loop period and reset all counters.
+ *
+ * @param[in] period_ms Nominal sensor loop period in milliseconds.
+ */
+void perf_metrics_init(uint32_t period_ms)
+{
+    portENTER_CRITICAL(&mux);
+    period_us = period_ms * 1000U;
+    m = (perf_metrics_t){ .first_sample_ms = -1 };
+    last_ts_us = 0;
+    next_report_us = 0;
+    win_jitter_sum_us = 0;
+    win_intervals = 0;
+    win_jitter_max_us = 0;
+    http_sum_us = 0;
+    skip_interval = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Change the expected loop period without resetting the counters.
+ *
+ * The interval that straddles the change is not counted as jitter.
+ *
+ * @param[in] period_ms New nominal sensor loop period in milliseconds.
+ */
+void perf_metrics_set_period(uint32_t period_ms)
+{
+    portENTER_CRITICAL(&mux);
+    period_us = period_ms * 1000U;
+    skip_interval = true;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Account one sensor loop iteration and log a PERF line when due.
+ *
+ * @param[in] ts_us esp_timer timestamp of the sample.
+ */
+void perf_metrics_on_sample(int64_t ts_us)
+{
+    portENTER_CRITICAL(&mux);
+    if (m.samples == 0) {
+        m.first_sample_ms = ts_us / 1000;
+        next_report_us = ts_us + (int64_t)CONFIG_APP_PERF_REPORT_S * 1000000LL;
+    } else if (skip_interval) {
+        skip_interval = false;
+    } else {
+        int64_t dev = (ts_us - last_ts_us) - (int64_t)period_us;
+        uint32_t jitter = (uint32_t)llabs(dev);
+        if (jitter > m.jitter_max_us) m.jitter_max_us = jitter;
+        if (jitter > win_jitter_max_us) win_jitter_max_us = jitter;
+        win_jitter_sum_us += jitter;
+        win_intervals++;
+    }
+    last_ts_us = ts_us;
+    m.samples++;
+    bool report = (CONFIG_APP_PERF_REPORT_S > 0) && (ts_us >= next_report_us) && m.samples > 1;
+    if (report) {
+        m.jitter_avg_us = win_intervals ? (uint32_t)(win_jitter_sum_us / win_intervals) : 0;
+        m.jitter_win_max_us = win_jitter_max_us;
+        win_jitter_sum_us = 0;
+        win_intervals = 0;
+        win_jitter_max_us = 0;
+        next_report_us += (int64_t)CONFIG_APP_PERF_REPORT_S * 1000000LL;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (report) {
+        perf_metrics_t s;
+        perf_metrics_get(&s);
+        ESP_LOGI(TAG, "uptime_ms=%lld samples=%lu first_sample_ms=%lld jitter_avg_us=%lu "
+                 "jitter_max_us=%lu jitter_win_max_us=%lu heap_free=%lu heap_min=%lu heap_largest=%lu heap_frag_pct=%lu "
+                 "http_requests=%lu http_avg_us=%lu http_max_us=%lu "
+                 "anomalies=%lu anom_outlier=%lu anom_jump=%lu anom_stuck=%lu "
+                 "net_in_use=%lu net_peak=%lu net_fails=%lu",
+                 (long long)(ts_us / 1000), (unsigned long)s.samples, (long long)s.first_sample_ms,
+                 (unsigned long)s.jitter_avg_us, (unsigned long)s.jitter_max_us, (unsigned long)s.jitter_win_max_us,
+                 (unsigned long)s.heap_free, (unsigned long)s.heap_min, (unsigned long)s.heap_largest,
+                 (unsigned long)s.heap_frag_pct, (unsigned long)s.http_requests, (unsigned long)s.http_avg_us, (unsigned long)s.http_max_us,
+                 (unsigned long)s.anomalies, (unsigned long)s.anom_outlier, (unsigned long)s.anom_jump,
+                 (unsigned long)s.anom_stuck, (unsigned long)s.net_in_use, (unsigned long)s.net_peak,
+                 (unsigned long)s.net_fails);
+    }
+}
+
+/**
+ * @brief Account one "/" request.
+ *
+ * @param[in] handler_us Time spent in the handler, including the send.
+ */
+void perf_metrics_on_http(int64_t handler_us)
+{
+    uint32_t us = handler_us > 0 ? (uint32_t)handler_us : 0;
+    portENTER_CRITICAL(&mux);
+    m.http_requests++;
+    http_sum_us += us;
+    if (us > m.http_max_us) m.http_max_us = us;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Account the anomaly flags of one sample.
+ *
+ * @param[in] flags anomaly_check() result (0 = normal, not counted).
+ */
+void perf_metrics_on_anomaly(uint16_t flags)
+{
+    if (!flags) return;
+    portENTER_CRITICAL(&mux);
+    m.anomalies++;
+    if (flags & ANOM_KIND(ANOM_OUTLIER)) m.anom_outlier++;
+    if (flags & ANOM_KIND(ANOM_JUMP))    m.anom_jump++;
+    if (flags & ANOM_KIND(ANOM_STUCK))   m.anom_stuck++;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Snapshot all metrics, sampling the heap now.
+ *
+ * @param[out] out Filled with the current values.
+ */
+void perf_metrics_get(perf_metrics_t *out)
+{
+    portENTER_CRITICAL(&mux);
+    *out = m;
+    out->http_avg_us = m.http_requests ? (uint32_t)(http_sum_us / m.http_requests) : 0;
+    portEXIT_CRITICAL(&mux);
+    out->heap_free = esp_get_free_heap_size();
+    out->heap_min = esp_get_minimum_free_heap_size();
+    out->heap_largest = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->heap_frag_pct = out->heap_free > out->heap_largest
+                       ? 100u - (uint32_t)(100ull * out->heap_largest / out->heap_free) : 0;
+    net_pool_stats_t np;
+    net_pool_stats(&np);
+    out->net_in_use = np.in_use;
+    out->net_peak = np.peak;
+    out->net_fails = np.fails;
+}
@@ -0,0 +1,41 @@
+/*
+ * Runtime performance metrics (public API).
+ * - Boot-to-first-sample time, sensor loop jitter, heap free/min/largest block
+ *   and fragmentation, network buffer pool use and "/" handler latency,
+ *   collected with esp_timer timestamps.
+ * - Samples flagged by the anomaly detectors (anomaly.h), by kind.
+ * - Published every CONFIG_APP_PERF_REPORT_S seconds as one "PERF: k=v ..." log
+ *   line that the QEMU pytest suite parses and checks against its budgets.
+ */
+
+#pragma once
+#include <stdint.h>
+
+typedef struct {
+    uint32_t samples;               // sensor loop iterations seen
+    int64_t  first_sample_ms;       // esp_timer ms at the first sample (-1 = none yet)
+    uint32_t jitter_avg_us;         // mean |interval - period| over the last report window
+    uint32_t jitter_max_us;         // worst |interval - period| since boot
+    uint32_t jitter_win_max_us;     // ... over the last report window
+    uint32_t heap_free;             // bytes
+    uint32_t heap_min;              // low-water mark since boot
+    uint32_t heap_largest;          // largest allocatable block
+    uint32_t heap_frag_pct;         // free heap not in the largest block, % of free
+    uint32_t http_requests;
+    uint32_t http_avg_us;           // "/" handler time, mean since boot
+    uint32_t http_max_us;
+    uint32_t anomalies;             // samples with any anomaly flag
+    uint32_t anom_outlier;          // ... with an outlier on some channel
+    uint32_t anom_jump;
+    uint32_t anom_stuck;
+    uint32_t net_in_use;            // network buffer pool (net_pool.h): blocks out now
+    uint32_t net_peak;              // ... most out at once
+    uint32_t net_fails;             // ... requests that found it empty
+} perf_metrics_t;
+
+void perf_metrics_init(uint32_t period_ms);         // expected sensor loop period
+void perf_metrics_set_period(uint32_t period_ms);   // period changed (adaptive sampling); counters kept
+void perf_metrics_on_sample(int64_t ts_us);        // once per loop iteration; logs when a report is due
+void perf_metrics_on_http(int64_t handler_us);    // per "/" request
+void perf_metrics_on_anomaly(uint16_t flags);     // per sample, anomaly_check() result
+void perf_metrics_get(perf_metrics_t *out);
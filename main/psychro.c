@@ -0,0 +1,98 @@
+/*
+ * Psychrometrics (implementation).
+ * - psy_expf: 2^n * e^f with n = round(x / ln 2), |f| <= ln2 / 2, and a
+ *   degree-6 Taylor polynomial for e^f; 2^n is built from the exponent bits.
+ * - psy_logf: x = 2^e * m with m in [sqrt(1/2), sqrt(2)), then
+ *   ln m = 2 atanh(s), s = (m - 1) / (m + 1), |s| <= 0.172, four odd terms.
+ * - psychro_compute(), baro.c and selfheat.c use these instead of libm
+ *   expf/logf on the per-sample path; fusion.c still calls libm expf (a
+ *   few times per filter step) and logf (once, when the filter is primed).
+ */
+
+#include "psychro.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAGNUS_A     17.62f
+#define MAGNUS_B     243.12f          // °C
+#define ES0_PA       611.2f           // saturation vapour pressure at 0 °C
+#define RV           461.5f           // J/(kg K), water vapour
+#define EPS_G_KG     621.98f          // 1000 * Mw / Md
+#define P_STD_PA     101325.0f
+
+float psy_expf(float x)
+{
+    if (x > 88.0f) x = 88.0f;
+    if (x < -87.0f) x = -87.0f;
+    float t = x * 1.44269504f;                      // x / ln 2
+    int32_t n = (int32_t)(t + (t >= 0 ? 0.5f : -0.5f));
+    float f = x - (float)n * 0.693145752f - (float)n * 1.42860682e-6f;   // ln 2 split: exact product first
+    float p = 1.0f + f * (1.0f + f * (0.5f + f * (1.0f / 6 + f * (1.0f / 24 + f * (1.0f / 120 + f * (1.0f / 720))))));
+    uint32_t bits = (uint32_t)(n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof scale);
+    return p * scale;
+}
+
+float psy_logf(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof bits);
+    int32_t e = (int32_t)((bits >> 23) & 0xFF) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000;        // mantissa in [1, 2)
+    float m;
+    memcpy(&m, &bits, sizeof m);
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e++;
+    }
+    float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+    float lnm = 2.0f * s * (1.0f + s2 * (1.0f / 3 + s2 * (1.0f / 5 + s2 * (1.0f / 7))));
+    return (float)e * 0.693145752f + ((float)e * 1.42860682e-6f + lnm);
+}
+
+// NWS heat index (Rothfusz + adjustments), computed in °F like the reference.
+static float heat_index_C(float T_C, float RH)
+{
+    float T = T_C * 1.8f + 32.0f;
+    float hi = 0.5f * (T + 61.0f + (T - 68.0f) * 1.2f + RH * 0.094f);
+    if ((hi + T) * 0.5f >= 80.0f) {
+        hi = -42.379f + 2.04901523f * T + 10.14333127f * RH - 0.22475541f * T * RH - 6.83783e-3f * T * T -
+             5.481717e-2f * RH * RH + 1.22874e-3f * T * T * RH + 8.5282e-4f * T * RH * RH -
+             1.99e-6f * T * T * RH * RH;
+        if (RH < 13.0f && T >= 80.0f && T <= 112.0f) {
+            hi -= (13.0f - RH) * 0.25f * sqrtf((17.0f - fabsf(T - 95.0f)) / 17.0f);
+        } else if (RH > 85.0f && T >= 80.0f && T <= 87.0f) {
+            hi += (RH - 85.0f) * 0.1f * (87.0f - T) * 0.2f;
+        }
+    }
+    return (hi - 32.0f) / 1.8f;
+}
+
+/**
+ * @brief Derive dew point, absolute humidity, humidity ratio and heat index.
+ *
+ * @param[in]  T_C  Air temperature (°C).
+ * @param[in]  RH   Relative humidity (%), clamped to 0.1..100.
+ * @param[in]  P_Pa Station pressure (Pa), NAN for standard pressure.
+ * @param[out] out  Results; all NAN when T_C or RH is NAN.
+ */
+void psychro_compute(float T_C, float RH, float P_Pa, psychro_t *out)
+{
+    if (isnan(T_C) || isnan(RH)) {
+        out->dew_C = out->abs_g_m3 = out->ratio_g_kg = out->heat_index_C = NAN;
+        return;
+    }
+    if (RH < 0.1f) RH = 0.1f;
+    if (RH > 100.0f) RH = 100.0f;
+    if (isnan(P_Pa)) P_Pa = P_STD_PA;
+
+    float a = MAGNUS_A * T_C / (MAGNUS_B + T_C);
+    float e = ES0_PA * psy_expf(a) * RH * 0.01f;                // vapour pressure, Pa
+    float g = psy_logf(RH * 0.01f) + a;
+    out->dew_C = MAGNUS_B * g / (MAGNUS_A - g);
+    out->abs_g_m3 = e * 1000.0f / (RV * (T_C + 273.15f));
+    out->ratio_g_kg = EPS_G_KG * e / (P_Pa - e);
+    out->heat_index_C = heat_index_C(T_C, RH);
+}
@@ -0,0 +1,30 @@
+/*
+ * Psychrometrics (public API).
+ * - Dew point, absolute humidity, humidity ratio and heat index from one
+ *   T/RH(/P) sample, in single precision with fast exp/log approximations.
+ * - Saturation vapour pressure: Magnus form over water (WMO 2008,
+ *   6.112 hPa, 17.62, 243.12 °C), within 0.3 % of the Hyland-Wexler values
+ *   for -45..60 °C; heat index: NWS Rothfusz regression with its low/high RH
+ *   adjustments (equals roughly T below ~27 °C).
+ * - Approximation error on top of the model (checked by firmware_bench
+ *   against double-precision libm at startup): psy_expf relative error
+ *   < 5e-7 for |x| <= 80, psy_logf absolute error < 5e-7 for x in
+ *   [1e-3, 1e3]; over -40..85 °C and 1..100 %RH the dew point is within
+ *   0.001 °C and absolute humidity / humidity ratio within 0.001 %. The heat
+ *   index uses no exp/log (float rounding only).
+ */
+
+#pragma once
+
+typedef struct {
+    float dew_C;                    // dew point, °C
+    float abs_g_m3;                 // absolute humidity, g/m³
+    float ratio_g_kg;               // humidity ratio (mixing ratio), g water per kg dry air
+    float heat_index_C;             // NWS heat index, °C
+} psychro_t;
+
+// NAN inputs give NAN outputs; P_Pa only affects ratio_g_kg (NAN -> 101325 Pa).
+void  psychro_compute(float T_C, float RH, float P_Pa, psychro_t *out);
+
+float psy_expf(float x);
+float psy_logf(float x);            // x > 0
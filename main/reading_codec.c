@@ -0,0 +1,101 @@
+/*
+ * Reading codec (implementation).
+ * - Rounds and clamps doubles into the fixed-point fields of reading_t.
+ * - Batch encoder/decoder for the layout in reading_codec.h.
+ */
+
+#include "reading_codec.h"
+#include <math.h>
+#include <string.h>
+
+static int32_t round_clamp(double v, double scale, int32_t lo, int32_t hi)
+{
+    if (isnan(v)) return lo;
+    double x = floor(v * scale + 0.5);
+    if (x < lo) return lo;
+    if (x > hi) return hi;
+    return (int32_t)x;
+}
+
+void reading_from_sample(const sample_t *s, int64_t unix_ms, uint32_t seq, reading_t *out)
+{
+    out->unix_ms = unix_ms;
+    out->seq = seq;
+    out->t_cC = (int16_t)round_clamp(s->T_C, 100.0, INT16_MIN, INT16_MAX);
+    out->h_cRH = (uint16_t)round_clamp(s->H_RH, 100.0, 0, 10000);
+    out->p_dPa = (uint32_t)round_clamp(s->P_Pa, 10.0, 0, 0xFFFFFF);
+}
+
+double reading_T_C(const reading_t *r)  { return r->t_cC / 100.0; }
+double reading_P_Pa(const reading_t *r) { return r->p_dPa / 10.0; }
+double reading_H_RH(const reading_t *r) { return r->h_cRH / 100.0; }
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get_u16(const uint8_t *p)   { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p)   { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+/**
+ * @brief Encode consecutive readings into one batch.
+ *
+ * @param[in]  r    Readings, oldest first.
+ * @param[in]  n    Number available.
+ * @param[out] out  Destination buffer.
+ * @param[in]  cap  Size of out.
+ * @param[out] used Readings consumed (0 if cap cannot hold one).
+ * @return Bytes written, 0 if nothing fit.
+ */
+size_t reading_batch_encode(const reading_t *r, size_t n, uint8_t *out, size_t cap, size_t *used)
+{
+    size_t k = 0;
+    *used = 0;
+    if (n == 0 || cap < reading_batch_size(1)) return 0;
+
+    while (k < n && k < READING_BATCH_MAX && reading_batch_size(k + 1) <= cap) {
+        int64_t dt = k ? r[k].unix_ms - r[k - 1].unix_ms : 0;
+        if (k && (r[k].seq != r[k - 1].seq + 1 || dt < 0 || dt > UINT16_MAX)) break;
+        uint8_t *p = out + reading_batch_size(k);
+        put_u16(p, (uint16_t)dt);
+        put_u16(p + 2, (uint16_t)r[k].t_cC);
+        p[4] = (uint8_t)r[k].p_dPa;
+        p[5] = (uint8_t)(r[k].p_dPa >> 8);
+        p[6] = (uint8_t)(r[k].p_dPa >> 16);
+        put_u16(p + 7, r[k].h_cRH);
+        k++;
+    }
+
+    out[0] = 'C';
+    out[1] = 'R';
+    out[2] = READING_BATCH_VERSION;
+    out[3] = (uint8_t)k;
+    put_u32(out + 4, r[0].seq);
+    put_u32(out + 8, (uint32_t)r[0].unix_ms);
+    put_u32(out + 12, (uint32_t)((uint64_t)r[0].unix_ms >> 32));
+    *used = k;
+    return reading_batch_size(k);
+}
+
+/**
+ * @brief Decode a batch produced by reading_batch_encode().
+ *
+ * @return Number of readings written to out, or -1 on a bad header/length.
+ */
+int reading_batch_decode(const uint8_t *in, size_t len, reading_t *out, size_t max)
+{
+    if (len < READING_BATCH_HEADER_LEN || in[0] != 'C' || in[1] != 'R' || in[2] != READING_BATCH_VERSION) return -1;
+    size_t count = in[3];
+    if (len != reading_batch_size(count) || count > max) return -1;
+
+    uint32_t seq = get_u32(in + 4);
+    int64_t t = (int64_t)(get_u32(in + 8) | ((uint64_t)get_u32(in + 12) << 32));
+    for (size_t k = 0; k < count; k++) {
+        const uint8_t *p = in + reading_batch_size(k);
+        t += get_u16(p);
+        out[k].unix_ms = t;
+        out[k].seq = seq + (uint32_t)k;
+        out[k].t_cC = (int16_t)get_u16(p + 2);
+        out[k].p_dPa = (uint32_t)p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16);
+        out[k].h_cRH = get_u16(p + 7);
+    }
+    return (int)count;
+}
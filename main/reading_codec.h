@@ -0,0 +1,45 @@
+/*
+ * Reading codec (public API).
+ * Fixed-point form of a compensated sample for the uplinks (MQTT, HTTP) and a
+ * compact batch encoding of consecutive readings.
+ *
+ * Batch layout (little-endian):
+ *   header  16 bytes: "CR", version, count, first_seq u32, base_unix_ms i64
+ *   records  9 bytes: dt_ms u16 (since previous record, first = 0),
+ *                     T centi-°C i16, P deci-Pa u24, H centi-%RH u16
+ * A batch only holds readings with consecutive seq numbers and gaps under
+ * 65.5 s, so a receiver can rebuild every timestamp and spot lost or
+ * duplicated readings from first_seq alone.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sample_pipeline.h"
+
+#define READING_BATCH_VERSION     1
+#define READING_BATCH_HEADER_LEN  16
+#define READING_BATCH_RECORD_LEN  9
+#define READING_BATCH_MAX         255
+
+typedef struct {
+    int64_t  unix_ms;       // wall clock (before SNTP sync: ms since 1970 as the RTC has it)
+    uint32_t seq;           // per-boot running number
+    int16_t  t_cC;          // °C x 100
+    uint16_t h_cRH;         // %RH x 100
+    uint32_t p_dPa;         // Pa x 10
+} reading_t;
+
+void   reading_from_sample(const sample_t *s, int64_t unix_ms, uint32_t seq, reading_t *out);
+double reading_T_C(const reading_t *r);
+double reading_P_Pa(const reading_t *r);
+double reading_H_RH(const reading_t *r);
+
+// Encode up to n readings (stopping early at a seq gap, a dt that does not fit
+// or READING_BATCH_MAX). Returns bytes written; *used = readings consumed.
+size_t reading_batch_encode(const reading_t *r, size_t n, uint8_t *out, size_t cap, size_t *used);
+static inline size_t reading_batch_size(size_t n) { return READING_BATCH_HEADER_LEN + n * READING_BATCH_RECORD_LEN; }
+
+// Decode a whole batch into out[max]. Returns readings decoded, or -1 if malformed.
+int reading_batch_decode(const uint8_t *in, size_t len, reading_t *out, size_t max);
@@ -0,0 +1,105 @@
+/*
+ * Sample pipeline (implementation).
+ * Compensates one raw reading with the calibration currently loaded in the
+ * BME280 driver. Temperature goes first because it sets t_fine for P and H.
+ * The decimator works on raw codes: T and P codes are 20-bit even at x1
+ * oversampling (low bits zero), so an average of them is still a valid
+ * code, with the extra resolution kept.
+ */
+
+#include "sample_pipeline.h"
+#include "bme280.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief Process one raw reading into a compensated sample.
+ *
+ * @param[in]  raw Raw ADC values and timestamp.
+ * @param[out] out Compensated T/P/H with the same timestamp.
+ */
+void sample_pipeline_process(const raw_sample_t *raw, sample_t *out)
+{
+    out->ts_us = raw->ts_us;
+    out->T_C  = BME280_compensate_T_double(raw->adc_T);   // °C (sets t_fine)
+    out->P_Pa = BME280_compensate_P_double(raw->adc_P);   // Pa
+    out->H_RH = bme280_compensate_H_double(raw->adc_H);   // %RH
+}
+
+/**
+ * @brief Set up a decimator.
+ *
+ * @param[out] d      Decimator state.
+ * @param factor      Reads per output (1..DECIM_MAX_FACTOR).
+ * @param filter      Filter applied to each output's window.
+ */
+void decimator_init(decimator_t *d, uint8_t factor, decim_filter_t filter)
+{
+    memset(d, 0, sizeof *d);
+    if (factor < 1) factor = 1;
+    if (factor > DECIM_MAX_FACTOR) factor = DECIM_MAX_FACTOR;
+    d->factor = factor;
+    d->filter = filter;
+    d->taps = (filter == DECIM_HANN) ? 2 * factor : factor;
+    if (filter == DECIM_HANN) {
+        for (int k = 0; k < d->taps; k++) {
+            float s = sinf((float)M_PI * (k + 0.5f) / d->taps);
+            d->w[k] = (uint16_t)lroundf(s * s * 32767.0f);
+            d->w_sum += d->w[k];
+        }
+    }
+}
+
+static int32_t median_of(int32_t *v, int n)
+{
+    for (int i = 1; i < n; i++) {               // insertion sort; n <= 25
+        int32_t x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+    return (n & 1) ? v[n / 2] : (int32_t)(((int64_t)v[n / 2 - 1] + v[n / 2] + 1) / 2);
+}
+
+/**
+ * @brief Add one raw read; every `factor` reads, emit one filtered raw sample.
+ *
+ * @param d        Decimator state.
+ * @param[in]  in  Raw read.
+ * @param[out] out Filtered raw sample, timestamped with the newest read.
+ * @return true when out was written.
+ */
+bool decimator_push(decimator_t *d, const raw_sample_t *in, raw_sample_t *out)
+{
+    d->ring[d->head] = *in;
+    d->head = (uint8_t)((d->head + 1) % d->taps);
+    if (d->count < d->taps) d->count++;
+    if (++d->phase < d->factor) return false;
+    d->phase = 0;
+    if (d->count < d->taps) return false;       // Hann: first output once 2 x factor reads are in
+
+    int n = d->taps;
+    out->ts_us = in->ts_us;
+    if (d->filter == DECIM_MEDIAN) {
+        int32_t t[DECIM_MAX_FACTOR], p[DECIM_MAX_FACTOR], h[DECIM_MAX_FACTOR];
+        for (int k = 0; k < n; k++) { t[k] = d->ring[k].adc_T; p[k] = d->ring[k].adc_P; h[k] = d->ring[k].adc_H; }
+        out->adc_T = median_of(t, n);
+        out->adc_P = median_of(p, n);
+        out->adc_H = median_of(h, n);
+        return true;
+    }
+
+    int64_t st = 0, sp = 0, sh = 0, div = n;
+    for (int k = 0; k < n; k++) {
+        const raw_sample_t *r = &d->ring[(d->head + k) % n];   // oldest first, so weights line up
+        int64_t w = (d->filter == DECIM_HANN) ? d->w[k] : 1;
+        st += w * r->adc_T;
+        sp += w * r->adc_P;
+        sh += w * r->adc_H;
+    }
+    if (d->filter == DECIM_HANN) div = d->w_sum;
+    out->adc_T = (int32_t)((st + div / 2) / div);
+    out->adc_P = (int32_t)((sp + div / 2) / div);
+    out->adc_H = (int32_t)((sh + div / 2) / div);
+    return true;
+}
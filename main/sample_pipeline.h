@@ -0,0 +1,50 @@
+/*
+ * Sample pipeline (public API).
+ * Single consumer of raw BME280 reads: turns {adc_T, adc_P, adc_H} into a
+ * compensated sample. The live loop in app_main and host trace replay both
+ * feed it, so everything downstream sees identical inputs.
+ * - Oversampled mode (CONFIG_APP_OVERSAMPLE): the loop reads the sensor at
+ *   10-25 Hz and a decimator turns each second of raw reads into one raw
+ *   sample (mean, median or Hann-window FIR per channel) before
+ *   compensation, so compensation, trace and every consumer still run at
+ *   1 Hz. Filtering raw codes keeps the sub-LSB precision the average gains.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    int64_t ts_us;                  // esp_timer time of the read
+    int32_t adc_T, adc_P, adc_H;    // raw ADC codes as returned by bme280_read_raw()
+} raw_sample_t;
+
+typedef struct {
+    int64_t ts_us;
+    double  T_C;                    // °C
+    double  P_Pa;                   // Pa
+    double  H_RH;                   // %RH
+} sample_t;
+
+#define DECIM_MAX_FACTOR 25
+
+typedef enum {
+    DECIM_MEAN = 0,                 // boxcar FIR over the last `factor` reads
+    DECIM_MEDIAN,                   // per-channel median of the last `factor` reads (spike-proof)
+    DECIM_HANN,                     // Hann-weighted FIR over the last 2 x `factor` reads (less aliasing)
+} decim_filter_t;
+
+typedef struct {
+    decim_filter_t filter;
+    uint8_t  factor;                // reads per output
+    uint8_t  taps;                  // factor, or 2 x factor for Hann
+    uint8_t  head, count, phase;
+    raw_sample_t ring[2 * DECIM_MAX_FACTOR];
+    uint16_t w[2 * DECIM_MAX_FACTOR];   // Hann weights, Q15
+    uint32_t w_sum;
+} decimator_t;
+
+void sample_pipeline_process(const raw_sample_t *raw, sample_t *out);
+
+void decimator_init(decimator_t *d, uint8_t factor, decim_filter_t filter);
+bool decimator_push(decimator_t *d, const raw_sample_t *in, raw_sample_t *out);   // true once per `factor` reads
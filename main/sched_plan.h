@@ -0,0 +1,34 @@
+/*
+ * Task placement: core and priority of every task the app creates.
+ * - The sensor loop (reads, filtering) runs on APP_CPU above everything
+ *   else the app starts, so its 1 s grid does not move while the web
+ *   server or an upload is busy. It queues each reading to net_task
+ *   (backlog submits, UDP send) and to alert_task (SMS checks), and never
+ *   waits on the network.
+ * - The network clients and the web server run on PRO_CPU next to the Wi-Fi
+ *   and lwIP tasks they feed.
+ * - Single-core builds (CONFIG_FREERTOS_UNICORE) put everything on core 0;
+ *   the priorities still order the work.
+ * - Values come from the Kconfig "Scheduling" menu.
+ */
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#if CONFIG_FREERTOS_UNICORE
+#define SCHED_SENSOR_CORE 0
+#define SCHED_NET_CORE    0
+#else
+#define SCHED_SENSOR_CORE CONFIG_APP_SENSOR_CORE
+#define SCHED_NET_CORE    ((CONFIG_APP_NET_CORE < 0) ? tskNO_AFFINITY : CONFIG_APP_NET_CORE)
+#endif
+
+#define SCHED_SENSOR_PRIO CONFIG_APP_SENSOR_PRIORITY    // sensor loop
+#define SCHED_NET_PRIO    CONFIG_APP_NET_PRIORITY       // net_task, alert_task, weather, MQTT, uplink, UDP
+#define SCHED_WEB_PRIO    CONFIG_APP_WEB_PRIORITY       // httpd
+
+#if CONFIG_APP_NET_PRIORITY >= CONFIG_APP_SENSOR_PRIORITY || CONFIG_APP_WEB_PRIORITY >= CONFIG_APP_SENSOR_PRIORITY
+#error "APP_SENSOR_PRIORITY must be above APP_NET_PRIORITY and APP_WEB_PRIORITY"
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Sensor self-heating correction (implementation).
+ * - The lagged rate is an exponential filter advanced by each sample's dt,
+ *   so it stays right across sampling-period changes.
+ * - RH: the die and the air share the vapour pressure, so
+ *   RH_air = RH_die * es(T_die) / es(T_air) (Magnus, as psychro.c).
+ * - Calibration keeps the last SELFHEAT_CAL_POINTS pairs of (lagged rate,
+ *   sensor minus reference) and refits by least squares; the sensor side is
+ *   an EWMA of the uncorrected temperature so one noisy sample does not set
+ *   the offset. Hold the sampling rate for a few tau before a reading.
+ * - State is shared between the sensor loop and the httpd task (calibration)
+ *   behind one spinlock; the per-sample work is a few float operations.
+ */
+
+#include "selfheat.h"
+#include "psychro.h"                  // psy_expf
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <stdbool.h>
+
+#define RAW_ALPHA  (1.0f / 16.0f)     // EWMA of the uncorrected temperature for calibration
+#define MIN_SPREAD_HZ 0.2f            // rates closer than this only refit the offset
+
+typedef struct {
+    float rate_hz, dT_C;
+} cal_point_t;
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static selfheat_t   st;
+static bool         have_sample;
+static int64_t      last_us;
+static float        raw_T_ewma;
+static cal_point_t  cal[SELFHEAT_CAL_POINTS];
+static uint8_t      cal_next;
+
+/**
+ * @brief Install the model (from Kconfig) and forget any calibration.
+ */
+void selfheat_init(const selfheat_model_t *m)
+{
+    portENTER_CRITICAL(&mux);
+    st = (selfheat_t){ .model = *m };
+    have_sample = false;
+    cal_next = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Set the sensor's current conversion rate (conversions per second).
+ *
+ * The lagged rate starts from the first rate set, as if the device had been
+ * sampling that way for a while.
+ */
+void selfheat_set_rate(float rate_hz)
+{
+    portENTER_CRITICAL(&mux);
+    if (!have_sample) st.rate_eff_hz = rate_hz;
+    st.rate_hz = rate_hz;
+    portEXIT_CRITICAL(&mux);
+}
+
+static float magnus(float T_C) { return 17.62f * T_C / (243.12f + T_C); }
+
+/**
+ * @brief Remove the modelled self-heating from one sample.
+ *
+ * @param[in,out] s Compensated sample; T_C and H_RH are corrected.
+ */
+void selfheat_apply(sample_t *s)
+{
+    portENTER_CRITICAL(&mux);
+    if (have_sample && st.model.tau_s > 0.0f) {
+        float dt = (float)(s->ts_us - last_us) / 1e6f;
+        if (dt > 0.0f) st.rate_eff_hz += (st.rate_hz - st.rate_eff_hz) * (1.0f - psy_expf(-dt / st.model.tau_s));
+    } else {
+        st.rate_eff_hz = st.rate_hz;
+    }
+    raw_T_ewma = have_sample ? raw_T_ewma + RAW_ALPHA * ((float)s->T_C - raw_T_ewma) : (float)s->T_C;
+    have_sample = true;
+    last_us = s->ts_us;
+    float bias = st.model.offset_C + st.model.C_per_hz * st.rate_eff_hz;
+    st.bias_C = bias;
+    st.samples++;
+    portEXIT_CRITICAL(&mux);
+
+    if (bias == 0.0f) return;
+    float T_die = (float)s->T_C, T_air = T_die - bias;
+    float H = (float)s->H_RH * psy_expf(magnus(T_die) - magnus(T_air));
+    s->T_C = T_air;
+    s->H_RH = H > 100.0f ? 100.0f : H;
+}
+
+/**
+ * @brief Add a reference reading taken now and refit the model.
+ *
+ * @param ref_T_C Air temperature from a reference thermometer next to the device.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before the first sample, or
+ *         ESP_ERR_INVALID_ARG if the refit puts a term outside
+ *         0 .. SELFHEAT_MAX_C (the reading is dropped, the model kept).
+ */
+esp_err_t selfheat_calibrate(float ref_T_C)
+{
+    portENTER_CRITICAL(&mux);
+    if (!have_sample) {
+        portEXIT_CRITICAL(&mux);
+        return ESP_ERR_INVALID_STATE;
+    }
+    cal_point_t *slot = &cal[cal_next % SELFHEAT_CAL_POINTS], old = *slot;
+    *slot = (cal_point_t){ st.rate_eff_hz, raw_T_ewma - ref_T_C };
+    int n = cal_next < SELFHEAT_CAL_POINTS ? cal_next + 1 : SELFHEAT_CAL_POINTS;
+
+    float sx = 0, sy = 0, sxx = 0, sxy = 0, lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        sx += cal[i].rate_hz;
+        sy += cal[i].dT_C;
+        sxx += cal[i].rate_hz * cal[i].rate_hz;
+        sxy += cal[i].rate_hz * cal[i].dT_C;
+        lo = fminf(lo, cal[i].rate_hz);
+        hi = fmaxf(hi, cal[i].rate_hz);
+    }
+    selfheat_model_t m = st.model;
+    if (hi - lo >= MIN_SPREAD_HZ) m.C_per_hz = (n * sxy - sx * sy) / (n * sxx - sx * sx);   // else keep it
+    m.offset_C = (sy - m.C_per_hz * sx) / n;
+    if (!(m.offset_C >= 0 && m.offset_C <= SELFHEAT_MAX_C && m.C_per_hz >= 0 && m.C_per_hz <= SELFHEAT_MAX_C)) {
+        *slot = old;                                            // a wrong reference, or the rate not held
+        portEXIT_CRITICAL(&mux);
+        return ESP_ERR_INVALID_ARG;
+    }
+    st.model = m;
+    cal_next++;
+    st.cal_points = (uint8_t)n;
+    portEXIT_CRITICAL(&mux);
+    return ESP_OK;
+}
+
+void selfheat_get(selfheat_t *out)
+{
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+}
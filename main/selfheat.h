@@ -0,0 +1,47 @@
+/*
+ * Sensor self-heating correction (public API).
+ * - The BME280 and the board around it sit above the air temperature by
+ *       bias = offset + C_per_hz * rate
+ *   where rate is the sensor's conversions per second, seen through a
+ *   first-order thermal lag (time constant tau). offset covers what does
+ *   not depend on sampling (regulator, Wi-Fi); C_per_hz the sensor and the
+ *   MCU wake-ups per sample.
+ * - selfheat_apply() subtracts the bias from each sample and corrects RH
+ *   to the air temperature at the same vapour pressure.
+ * - Coefficients start from CONFIG_APP_SELFHEAT_* and can be refitted
+ *   against reference readings (selfheat_calibrate(), POST /api/calibrate):
+ *   one rate gives the offset, two or more rates give both terms. The fit
+ *   is reported for writing back to sdkconfig; it is not persisted. A
+ *   reading that would take either term outside 0 .. SELFHEAT_MAX_C (the
+ *   Kconfig range) is rejected and leaves the model as it was.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+
+#define SELFHEAT_CAL_POINTS 8
+#define SELFHEAT_MAX_C      5.0f      // upper bound of offset_C and C_per_hz (°C, °C per Hz)
+
+typedef struct {
+    float offset_C;                   // rate-independent warming
+    float C_per_hz;                   // warming per conversion per second
+    float tau_s;                      // thermal time constant
+} selfheat_model_t;
+
+typedef struct {
+    selfheat_model_t model;
+    float    rate_hz;                 // sensor conversions per second now
+    float    rate_eff_hz;             // the same through the thermal lag
+    float    bias_C;                  // subtracted from the last sample
+    uint8_t  cal_points;              // reference readings in the fit
+    uint32_t samples;                 // samples corrected
+} selfheat_t;
+
+void      selfheat_init(const selfheat_model_t *m);
+void      selfheat_set_rate(float rate_hz);        // sensor loop, when the sampling changes
+void      selfheat_apply(sample_t *s);             // sensor loop; T and RH corrected in place
+esp_err_t selfheat_calibrate(float ref_T_C);       // ESP_ERR_INVALID_STATE before the first sample,
+                                                   // ESP_ERR_INVALID_ARG if the fit is implausible
+void      selfheat_get(selfheat_t *out);
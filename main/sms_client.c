@@ -29,7 +29,7 @@ static const char *TAG = "sms";
  *
  * @return Number of bytes written (excluding terminator).
  */
-static int url_encode(const char *in, char *out, int outlen) {
+int url_encode(const char *in, char *out, int outlen) {
     static const char hex[] = "0123456789ABCDEF";
     int o=0;
     for (int i=0; in[i] && o<outlen-1; i++) {
@@ -104,7 +104,12 @@ esp_err_t sms_send_alert(const char *body) {
     };
 
     // Create the HTTP client handle (opaque object that holds connection state)
+#if CONFIG_APP_STATIC_ALLOC
+    static esp_http_client_handle_t h;           // created on the first SMS, then reused (no heap churn)
+    if (!h) h = esp_http_client_init(&cfg);
+#else
     esp_http_client_handle_t h = esp_http_client_init(&cfg);
+#endif
     if (!h) return ESP_FAIL;
 
     // ------------------------------------------------------------------------
@@ -126,7 +131,11 @@ esp_err_t sms_send_alert(const char *body) {
     // If transport/TLS failed (network error, handshake problem, etc.), log and bail.
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP perform: %s", esp_err_to_name(err));
+#if CONFIG_APP_STATIC_ALLOC
+        esp_http_client_close(h);
+#else
         esp_http_client_cleanup(h);
+#endif
         return err;
     }
 
@@ -156,6 +165,10 @@ esp_err_t sms_send_alert(const char *body) {
     }
 
     // Always cleanup the client handle to free resources/sockets
+#if CONFIG_APP_STATIC_ALLOC
+    esp_http_client_close(h);
+#else
     esp_http_client_cleanup(h);
+#endif
     return err;
 }
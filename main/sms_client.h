@@ -9,4 +9,4 @@
 #include "esp_err.h"
 esp_err_t sms_send_alert(const char *body);
 // url_encode() must percent-encode reserved characters for application/x-www-form-urlencoded.
-static int url_encode(const char *in, char *out, int outlen) ;
+int url_encode(const char *in, char *out, int outlen);
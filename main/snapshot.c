@@ -0,0 +1,100 @@
+/*
+ * Climate snapshot (implementation).
+ * - Inputs and the derived cache live behind one spinlock; the derivation
+ *   itself (~1 µs) runs outside it on a copy and is installed only if no
+ *   newer update arrived meanwhile (otherwise the next reader redoes it).
+ */
+
+#include "snapshot.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+#include <math.h>
+#include <stdbool.h>
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static climate_snapshot_t snap = {
+    .in_T_C = NAN, .in_RH = NAN, .in_P_Pa = NAN, .out_T_C = NAN, .out_RH = NAN,
+    .in = { NAN, NAN, NAN, NAN }, .out = { NAN, NAN, NAN, NAN },
+    .sea_level_Pa = NAN, .tendency = { NAN, BARO_TENDENCY_UNKNOWN, 0 },
+};
+static uint32_t derived_version;    // version the cached psychro values belong to
+static snapshot_stats_t st;
+
+/**
+ * @brief Store one sensor pass: a new compensated inside sample and the
+ *        tendency, trend and fusion state that go with it.
+ *
+ * Everything is written and the version bumped under one lock, so a reader
+ * (and a document cached under that version) never pairs this sample with
+ * the previous pass's trend or fusion.
+ *
+ * @param[in] s    Sample from sample_pipeline_process().
+ * @param[in] tend history_tendency() if a minute closed this pass, else NULL (unchanged).
+ * @param[in] tr   trend_get() result, or NULL while there is no fit.
+ * @param[in] fu   fusion_get() result, or NULL while there is no estimate.
+ */
+void snapshot_set_inside(const sample_t *s, const baro_tendency_t *tend, const trend_t *tr, const fusion_t *fu)
+{
+    portENTER_CRITICAL(&mux);
+    snap.ts_us = s->ts_us;
+    snap.in_T_C = (float)s->T_C;
+    snap.in_RH = (float)s->H_RH;
+    snap.in_P_Pa = (float)s->P_Pa;
+    if (tend) snap.tendency = *tend;
+    snap.trend_valid = tr != NULL;
+    if (tr) snap.trend = *tr;
+    snap.fusion_valid = fu != NULL;
+    if (fu) snap.fusion = *fu;
+    snap.version++;
+    st.updates++;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Store the latest outside weather (NAN = unknown).
+ */
+void snapshot_set_outside(float T_C, float RH)
+{
+    portENTER_CRITICAL(&mux);
+    snap.out_T_C = T_C;
+    snap.out_RH = RH;
+    snap.version++;
+    st.updates++;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Copy out the current snapshot, deriving metrics first if stale.
+ *
+ * @param[out] out Snapshot; derived fields match its inputs.
+ */
+void snapshot_get(climate_snapshot_t *out)
+{
+    portENTER_CRITICAL(&mux);
+    *out = snap;
+    bool stale = derived_version != snap.version;
+    st.reads++;
+    portEXIT_CRITICAL(&mux);
+    if (!stale) return;
+
+    psychro_compute(out->in_T_C, out->in_RH, out->in_P_Pa, &out->in);
+    psychro_compute(out->out_T_C, out->out_RH, out->in_P_Pa, &out->out);
+    out->sea_level_Pa = baro_sea_level_Pa(out->in_P_Pa, CONFIG_APP_STATION_ALTITUDE_M, out->out_T_C);
+
+    portENTER_CRITICAL(&mux);
+    st.derivations++;
+    if (snap.version == out->version) {
+        snap.in = out->in;
+        snap.out = out->out;
+        snap.sea_level_Pa = out->sea_level_Pa;
+        derived_version = out->version;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void snapshot_get_stats(snapshot_stats_t *out)
+{
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+}
@@ -0,0 +1,47 @@
+/*
+ * Climate snapshot (public API).
+ * - The latest inside sample, latest outside weather and everything derived
+ *   from them (psychrometrics, sea-level pressure), in one struct that every consumer (web page, JSON API,
+ *   uplinks, alerts) copies out with snapshot_get().
+ * - Writers only store inputs and bump the version; a reader never sees a
+ *   sensor pass half published. Derived metrics
+ *   (psychro.h) are computed by the first snapshot_get() after a change and
+ *   cached for every later reader, so they cost one computation per sample
+ *   however many consumers there are.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "sample_pipeline.h"
+#include "psychro.h"
+#include "baro.h"
+#include "trend.h"
+#include "fusion.h"
+
+typedef struct {
+    uint32_t version;               // bumps on every inside sample or outside update; 0 = nothing yet
+    int64_t  ts_us;                 // esp_timer time of the inside sample
+    float    in_T_C, in_RH, in_P_Pa;
+    float    out_T_C, out_RH;       // NAN until the first outside fetch
+    psychro_t in, out;              // derived; outside uses the inside pressure
+    float    sea_level_Pa;          // derived from in_P_Pa, station altitude and out_T_C
+    baro_tendency_t tendency;       // 3 h station-pressure tendency (history.c)
+    bool     trend_valid;           // false until the trend window is half covered
+    trend_t  trend;                 // inside T/RH fit (trend.c)
+    bool     fusion_valid;          // false until the first sample (or with CONFIG_APP_FUSION off)
+    fusion_t fusion;                // inside/outside heat-balance filter (fusion.c)
+} climate_snapshot_t;
+
+typedef struct {
+    uint32_t updates;               // snapshot_set_* calls
+    uint32_t reads;                 // snapshot_get calls
+    uint32_t derivations;           // psychro computations (<= updates)
+} snapshot_stats_t;
+
+// Sensor loop, once per pass: the sample and what was derived from it, under
+// one version bump. tend NULL = unchanged (no minute closed); tr / fu NULL =
+// no fit / estimate yet.
+void snapshot_set_inside(const sample_t *s, const baro_tendency_t *tend, const trend_t *tr, const fusion_t *fu);
+void snapshot_set_outside(float T_C, float RH);      // outside-weather task
+void snapshot_get(climate_snapshot_t *out);
+void snapshot_get_stats(snapshot_stats_t *out);
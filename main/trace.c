@@ -0,0 +1,270 @@
+/*
+ * Raw sensor trace (implementation).
+ * - Codec for the 64-byte header and 9-byte records described in trace.h.
+ * - Live recorder: RAM ring of the newest readings (absolute ms + packed ADC),
+ *   guarded by a mutex so the httpd task can export while the loop records.
+ *   With CONFIG_APP_STATIC_ALLOC the ring is a static array of
+ *   CONFIG_APP_TRACE_RECORDS slots.
+ * - Export is streamed: a cursor fixes the records present when it starts
+ *   and each trace_export_next() encodes as many as fit in the caller's
+ *   buffer, taking the lock only for that chunk. Records are numbered since
+ *   boot, so a chunk can tell when the loop has overwritten the ones it
+ *   still had to send.
+ */
+
+#include "trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define SLOT_LEN 11   // u32 t_ms + 7 packed ADC bytes
+
+static uint8_t          *ring;          // max_slots * SLOT_LEN
+static size_t            max_slots;
+static size_t            head;          // next slot to write
+static size_t            used;
+static uint32_t          written;       // records recorded since boot
+static trace_header_t    info;          // sensor settings + calibration
+static SemaphoreHandle_t lock;
+#if CONFIG_APP_STATIC_ALLOC
+static uint8_t           ring_mem[CONFIG_APP_TRACE_RECORDS * SLOT_LEN + 1];   // +1: CONFIG may be 0
+static StaticSemaphore_t lock_mem;
+#endif
+
+// ---- little-endian helpers ----
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get_u16(const uint8_t *p)   { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p)   { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+static void pack_adc(uint8_t *d, int32_t T, int32_t P, int32_t H)
+{
+    d[0] = (uint8_t)(T >> 12);
+    d[1] = (uint8_t)(T >> 4);
+    d[2] = (uint8_t)(((T & 0x0F) << 4) | ((P >> 16) & 0x0F));
+    d[3] = (uint8_t)(P >> 8);
+    d[4] = (uint8_t)P;
+    d[5] = (uint8_t)(H >> 8);
+    d[6] = (uint8_t)H;
+}
+
+static void unpack_adc(const uint8_t *d, int32_t *T, int32_t *P, int32_t *H)
+{
+    *T = (int32_t)(((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4));
+    *P = (int32_t)((((uint32_t)d[2] & 0x0F) << 16) | ((uint32_t)d[3] << 8) | d[4]);
+    *H = (int32_t)(((uint32_t)d[5] << 8) | d[6]);
+}
+
+// ---- codec ----
+
+void trace_encode_header(const trace_header_t *h, uint8_t out[TRACE_HEADER_LEN])
+{
+    memset(out, 0, TRACE_HEADER_LEN);
+    memcpy(out, "BTRC", 4);
+    out[4] = TRACE_VERSION;
+    out[5] = h->ctrl_hum;
+    out[6] = h->ctrl_meas;
+    out[7] = h->config;
+    put_u16(out + 8, h->period_ms);
+    put_u32(out + 12, h->record_count);
+    put_u32(out + 16, (uint32_t)h->start_unix_ms);
+    put_u32(out + 20, (uint32_t)((uint64_t)h->start_unix_ms >> 32));
+    put_u32(out + 24, h->start_ms);
+    memcpy(out + 28, h->calib_88, BME280_CALIB_88_LEN);
+    memcpy(out + 28 + BME280_CALIB_88_LEN, h->calib_E1, BME280_CALIB_E1_LEN);
+}
+
+esp_err_t trace_decode_header(const uint8_t *in, size_t len, trace_header_t *h)
+{
+    if (!in || !h || len < TRACE_HEADER_LEN) return ESP_ERR_INVALID_SIZE;
+    if (memcmp(in, "BTRC", 4) != 0) return ESP_ERR_INVALID_ARG;
+    if (in[4] != TRACE_VERSION) return ESP_ERR_INVALID_VERSION;
+    h->ctrl_hum = in[5];
+    h->ctrl_meas = in[6];
+    h->config = in[7];
+    h->period_ms = get_u16(in + 8);
+    h->record_count = get_u32(in + 12);
+    h->start_unix_ms = (int64_t)(get_u32(in + 16) | ((uint64_t)get_u32(in + 20) << 32));
+    h->start_ms = get_u32(in + 24);
+    memcpy(h->calib_88, in + 28, BME280_CALIB_88_LEN);
+    memcpy(h->calib_E1, in + 28 + BME280_CALIB_88_LEN, BME280_CALIB_E1_LEN);
+    return ESP_OK;
+}
+
+/**
+ * @brief Encode one reading, preceded by a gap marker if dt does not fit in 16 bits.
+ *
+ * @return Bytes written to out (9, or 18 with a gap marker).
+ */
+size_t trace_encode_record(uint32_t dt_ms, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                           uint8_t out[2 * TRACE_RECORD_LEN])
+{
+    size_t n = 0;
+    if (dt_ms >= TRACE_GAP_MARKER) {
+        memset(out, 0, TRACE_RECORD_LEN);
+        put_u16(out, TRACE_GAP_MARKER);
+        put_u32(out + 2, dt_ms);
+        n = TRACE_RECORD_LEN;
+        dt_ms = 0;
+    }
+    put_u16(out + n, (uint16_t)dt_ms);
+    pack_adc(out + n + 2, adc_T, adc_P, adc_H);
+    return n + TRACE_RECORD_LEN;
+}
+
+void trace_reader_init(trace_reader_t *r, const trace_header_t *h, const uint8_t *records, size_t len)
+{
+    r->p = records;
+    r->end = records + len;
+    r->t_ms = h->start_ms;
+    r->left = h->record_count ? h->record_count : UINT32_MAX;
+}
+
+/**
+ * @brief Decode the next reading; the first record's dt is 0 (time = start_ms).
+ *
+ * @return false at end of data.
+ */
+bool trace_reader_next(trace_reader_t *r, raw_sample_t *out)
+{
+    while (r->left > 0 && r->end - r->p >= TRACE_RECORD_LEN) {
+        uint16_t dt = get_u16(r->p);
+        if (dt == TRACE_GAP_MARKER) {
+            r->t_ms += get_u32(r->p + 2);
+            r->p += TRACE_RECORD_LEN;
+            continue;
+        }
+        r->t_ms += dt;
+        out->ts_us = r->t_ms * 1000;
+        unpack_adc(r->p + 2, &out->adc_T, &out->adc_P, &out->adc_H);
+        r->p += TRACE_RECORD_LEN;
+        r->left--;
+        return true;
+    }
+    return false;
+}
+
+// ---- live recorder ----
+
+/**
+ * @brief Allocate the RAM ring for the newest max_records readings.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM (ESP_ERR_INVALID_SIZE above the static
+ *         ring). max_records == 0 disables recording.
+ */
+esp_err_t trace_init(size_t max_records, uint16_t period_ms)
+{
+    info.period_ms = period_ms;
+    if (max_records == 0) return ESP_OK;
+#if CONFIG_APP_STATIC_ALLOC
+    if (max_records > CONFIG_APP_TRACE_RECORDS) return ESP_ERR_INVALID_SIZE;
+    lock = xSemaphoreCreateMutexStatic(&lock_mem);
+    ring = ring_mem;
+#else
+    lock = xSemaphoreCreateMutex();
+    ring = malloc(max_records * SLOT_LEN);
+    if (!ring || !lock) {
+        free(ring);                         // trace_record() checks ring
+        ring = NULL;
+        if (lock) vSemaphoreDelete(lock);
+        lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    mem_budget_add("trace", max_records * SLOT_LEN);
+    max_slots = max_records;
+    return ESP_OK;
+}
+
+void trace_set_sensor_info(const uint8_t *calib_88, const uint8_t *calib_E1,
+                           uint8_t ctrl_hum, uint8_t ctrl_meas, uint8_t config)
+{
+    memcpy(info.calib_88, calib_88, BME280_CALIB_88_LEN);
+    memcpy(info.calib_E1, calib_E1, BME280_CALIB_E1_LEN);
+    info.ctrl_hum = ctrl_hum;
+    info.ctrl_meas = ctrl_meas;
+    info.config = config;
+}
+
+void trace_record(const raw_sample_t *raw)
+{
+    if (!ring) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint8_t *slot = ring + head * SLOT_LEN;
+    put_u32(slot, (uint32_t)(raw->ts_us / 1000));
+    pack_adc(slot + 4, raw->adc_T, raw->adc_P, raw->adc_H);
+    head = (head + 1) % max_slots;
+    if (used < max_slots) used++;
+    written++;
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief Start exporting the ring (oldest first) as a trace file.
+ *
+ * @param[out] c   Cursor for trace_export_next().
+ * @param[out] hdr The file header, covering the records present now.
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if recording is off.
+ */
+esp_err_t trace_export_begin(trace_cursor_t *c, uint8_t hdr[TRACE_HEADER_LEN])
+{
+    if (!ring) return ESP_ERR_INVALID_STATE;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    size_t first = (head + max_slots - used) % max_slots;
+    trace_header_t h = info;
+    h.record_count = (uint32_t)used;
+    h.start_ms = used ? get_u32(ring + first * SLOT_LEN) : 0;
+    c->seq = written - (uint32_t)used;
+    c->left = (uint32_t)used;
+    c->prev_ms = h.start_ms;
+    xSemaphoreGive(lock);
+
+    // Anchor to wall clock when SNTP has set it (same "> Nov 2023" test as wifi.c).
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec > 1700000000 && h.record_count) {
+        int64_t now_unix_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        int64_t now_ms = esp_timer_get_time() / 1000;
+        h.start_unix_ms = now_unix_ms - (now_ms - h.start_ms);
+    }
+    trace_encode_header(&h, hdr);
+    return ESP_OK;
+}
+
+/**
+ * @brief Encode the next records of an export into buf.
+ *
+ * @param cap Buffer size; at least 2 * TRACE_RECORD_LEN (a record with its
+ *            gap marker).
+ * @return Bytes written, 0 when the export is complete, or -1 if the loop
+ *         has overwritten records the cursor had not sent yet.
+ */
+int trace_export_next(trace_cursor_t *c, uint8_t *buf, size_t cap)
+{
+    size_t len = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t behind = written - c->seq;               // records from the cursor to the newest
+    if (c->left && behind > max_slots) {
+        xSemaphoreGive(lock);
+        return -1;
+    }
+    while (c->left && cap - len >= 2 * TRACE_RECORD_LEN) {
+        const uint8_t *slot = ring + ((head + max_slots - behind) % max_slots) * SLOT_LEN;
+        uint32_t t = get_u32(slot);
+        int32_t T, P, H;
+        unpack_adc(slot + 4, &T, &P, &H);
+        len += trace_encode_record(t - c->prev_ms, T, P, H, buf + len);
+        c->prev_ms = t;
+        c->seq++;
+        c->left--;
+        behind--;
+    }
+    xSemaphoreGive(lock);
+    return (int)len;
+}
@@ -0,0 +1,65 @@
+/*
+ * Raw sensor trace (public API).
+ * Compact capture of {timestamp, adc_T, adc_P, adc_H} plus the calibration
+ * block, for exact replay of field data on the host.
+ *
+ * File layout (little-endian):
+ *   header  64 bytes: "BTRC", version, ctrl_hum/ctrl_meas/config, period_ms,
+ *                     record_count, start_unix_ms, start_ms, calib 0x88[26], 0xE1[7]
+ *   records  9 bytes: dt_ms u16 (since previous record), then T20|P20|H16 packed
+ *                     big-endian in 7 bytes. dt_ms == 0xFFFF is a gap marker whose
+ *                     first 4 payload bytes hold extra milliseconds (u32 LE).
+ * The device keeps the newest CONFIG_APP_TRACE_RECORDS readings in RAM and
+ * serves them as a trace file at GET /trace.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "bme280.h"
+#include "sample_pipeline.h"
+
+#define TRACE_VERSION     1
+#define TRACE_HEADER_LEN  64
+#define TRACE_RECORD_LEN  9
+#define TRACE_GAP_MARKER  0xFFFF
+
+typedef struct {
+    uint8_t  ctrl_hum, ctrl_meas, config;  // sensor settings at capture time
+    uint16_t period_ms;                    // nominal sampling period
+    uint32_t record_count;                 // 0 = read until end of file
+    int64_t  start_unix_ms;                // wall clock of the first record, 0 if unknown
+    uint32_t start_ms;                     // esp_timer ms of the first record
+    uint8_t  calib_88[BME280_CALIB_88_LEN];
+    uint8_t  calib_E1[BME280_CALIB_E1_LEN];
+} trace_header_t;
+
+typedef struct {
+    const uint8_t *p, *end;
+    int64_t        t_ms;                   // timestamp of the last record returned
+    uint32_t       left;                   // records still expected (if count known)
+} trace_reader_t;
+
+typedef struct {
+    uint32_t seq;                          // next record to send, numbered since boot
+    uint32_t left;                         // records still to send
+    uint32_t prev_ms;                      // timestamp of the last record sent
+} trace_cursor_t;
+
+// ---- codec (pure, used on device and host) ----
+void      trace_encode_header(const trace_header_t *h, uint8_t out[TRACE_HEADER_LEN]);
+esp_err_t trace_decode_header(const uint8_t *in, size_t len, trace_header_t *h);
+size_t    trace_encode_record(uint32_t dt_ms, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                              uint8_t out[2 * TRACE_RECORD_LEN]);
+void      trace_reader_init(trace_reader_t *r, const trace_header_t *h, const uint8_t *records, size_t len);
+bool      trace_reader_next(trace_reader_t *r, raw_sample_t *out);
+
+// ---- live recorder ----
+esp_err_t trace_init(size_t max_records, uint16_t period_ms);
+void      trace_set_sensor_info(const uint8_t *calib_88, const uint8_t *calib_E1,
+                                uint8_t ctrl_hum, uint8_t ctrl_meas, uint8_t config);
+void      trace_record(const raw_sample_t *raw);
+esp_err_t trace_export_begin(trace_cursor_t *c, uint8_t hdr[TRACE_HEADER_LEN]);   // ESP_ERR_INVALID_STATE if off
+int       trace_export_next(trace_cursor_t *c, uint8_t *buf, size_t cap);        // bytes, 0 at end, -1 overrun
@@ -0,0 +1,158 @@
+/*
+ * Trend estimation (implementation).
+ * - Ring of {time, T, RH} in fixed point plus running sums Σx, Σx², Σy,
+ *   Σy², Σxy per channel. x is measured from a base time that is moved up
+ *   to the oldest sample now and then, which shifts the sums exactly and
+ *   keeps every product well inside int64.
+ * - The ring holds one slot per second of window, enough for the 1.03 s loop;
+ *   static (CONFIG_APP_TREND_WINDOW_S + 1 slots) with CONFIG_APP_STATIC_ALLOC.
+ */
+
+#include "trend.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include <math.h>
+#include <stdlib.h>
+
+typedef struct {
+    uint32_t t_ds;                    // esp_timer time, 0.1 s
+    int16_t  T_cC;
+    uint16_t RH_cRH;
+} slot_t;
+
+typedef struct {
+    int64_t y, yy, xy;
+} chan_sums_t;
+
+static slot_t     *ring;
+static uint32_t    cap, head, used;   // head = oldest
+static uint32_t    window_ds;
+static uint32_t    base_ds;           // x = t_ds - base_ds
+static int64_t     sx, sxx;
+static chan_sums_t sT, sH;
+#if CONFIG_APP_STATIC_ALLOC
+static slot_t      ring_mem[CONFIG_APP_TREND_WINDOW_S + 1];
+#endif
+
+/**
+ * @brief Allocate the window.
+ *
+ * @param window_s Window length in seconds; 0 disables trend estimation.
+ * @return ESP_OK, or ESP_ERR_NO_MEM (ESP_ERR_INVALID_SIZE above the static ring).
+ */
+esp_err_t trend_init(uint32_t window_s)
+{
+    if (window_s == 0) return ESP_OK;
+#if CONFIG_APP_STATIC_ALLOC
+    if (window_s > CONFIG_APP_TREND_WINDOW_S) return ESP_ERR_INVALID_SIZE;
+    ring = ring_mem;
+#else
+    ring = calloc(window_s + 1, sizeof(slot_t));
+    if (!ring) return ESP_ERR_NO_MEM;
+#endif
+    mem_budget_add("trend", (window_s + 1) * sizeof(slot_t));
+    cap = window_s + 1;
+    window_ds = window_s * 10;
+    return ESP_OK;
+}
+
+static void sums_apply(const slot_t *s, int sign)
+{
+    int64_t x = (int64_t)(s->t_ds - base_ds);
+    sx  += sign * x;
+    sxx += sign * x * x;
+    sT.y  += sign * s->T_cC;
+    sT.yy += sign * (int64_t)s->T_cC * s->T_cC;
+    sT.xy += sign * x * s->T_cC;
+    sH.y  += sign * s->RH_cRH;
+    sH.yy += sign * (int64_t)s->RH_cRH * s->RH_cRH;
+    sH.xy += sign * x * s->RH_cRH;
+}
+
+// Move the x origin up by d: Σ(x-d) = Σx - n·d, Σ(x-d)² = Σx² - 2dΣx + n·d², Σ(x-d)y = Σxy - dΣy.
+static void rebase(uint32_t new_base)
+{
+    int64_t d = (int64_t)(new_base - base_ds), n = used;
+    sxx += -2 * d * sx + n * d * d;
+    sx  -= n * d;
+    sT.xy -= d * sT.y;
+    sH.xy -= d * sH.y;
+    base_ds = new_base;
+}
+
+/**
+ * @brief Add one sample and evict those older than the window.
+ *
+ * @param[in] s Sample from sample_pipeline_process().
+ */
+void trend_add(const sample_t *s)
+{
+    if (!ring) return;
+    slot_t in = {
+        .t_ds = (uint32_t)(s->ts_us / 100000),
+        .T_cC = (int16_t)lround(s->T_C * 100.0),
+        .RH_cRH = (uint16_t)lround(s->H_RH * 100.0),
+    };
+    if (used == 0) base_ds = in.t_ds;
+
+    while (used && (used == cap || in.t_ds - ring[head].t_ds > window_ds)) {
+        sums_apply(&ring[head], -1);
+        head = (head + 1) % cap;
+        used--;
+    }
+    // keep x below ~2 windows so x·x and n·Σx² stay small
+    if (in.t_ds - base_ds > 2 * window_ds) rebase(used ? ring[head].t_ds : in.t_ds);
+
+    ring[(head + used) % cap] = in;
+    used++;
+    sums_apply(&in, +1);
+}
+
+// Slope, value at x_now and r² of one channel. The centred sums are formed
+// exactly in int64 first, so float is enough for the rest (no double on the FPU).
+static void fit(const chan_sums_t *c, float x_now, float scale, float *value, float *per_h, float *r2)
+{
+    int64_t n = used;
+    float sxx_c = (float)(n * sxx - sx * sx);            // n²·var(x)
+    float sxy_c = (float)(n * c->xy - sx * c->y);        // n²·cov(x, y)
+    float syy_c = (float)(n * c->yy - c->y * c->y);      // n²·var(y)
+    float b = sxx_c > 0 ? sxy_c / sxx_c : 0.0f;
+    float x_mean = (float)sx / n, y_mean = (float)c->y / n;
+    *value = (y_mean + b * (x_now - x_mean)) * scale;
+    *per_h = b * 36000.0f * scale;
+    *r2 = (sxx_c > 0 && syy_c > 0) ? sxy_c / sxx_c * (sxy_c / syy_c) : 0.0f;
+}
+
+/**
+ * @brief Read the current fit.
+ *
+ * @param[out] out Slopes, fitted values and fit quality.
+ * @return false (out untouched) until the window is at least half covered.
+ */
+bool trend_get(trend_t *out)
+{
+    if (!ring || used < 3) return false;
+    const slot_t *oldest = &ring[head], *newest = &ring[(head + used - 1) % cap];
+    uint32_t span = newest->t_ds - oldest->t_ds;
+    if (span * 2 < window_ds) return false;
+
+    float x_now = (float)(newest->t_ds - base_ds);
+    out->n = (uint16_t)used;
+    out->span_s = span / 10.0f;
+    fit(&sT, x_now, 0.01f, &out->T_C, &out->dT_per_h, &out->r2_T);
+    fit(&sH, x_now, 0.01f, &out->RH, &out->dRH_per_h, &out->r2_RH);
+    return true;
+}
+
+/**
+ * @brief Time until a line moving at per_h reaches threshold.
+ *
+ * @return Seconds (0 if already there), or NAN if flat or moving away.
+ */
+float trend_eta_s(float now, float per_h, float threshold)
+{
+    float gap = threshold - now;
+    if (gap == 0.0f) return 0.0f;
+    if (per_h == 0.0f || (gap > 0) != (per_h > 0)) return NAN;
+    return gap / per_h * 3600.0f;
+}
@@ -0,0 +1,30 @@
+/*
+ * Trend estimation (public API).
+ * - Least-squares line through the inside temperature and humidity of the
+ *   last CONFIG_APP_TREND_WINDOW_S seconds, kept as running sums over a
+ *   sliding window: adding a sample and evicting the oldest are O(1), and so
+ *   is reading the fit.
+ * - From the fit: rate of change and the time until a threshold is reached
+ *   (trend_eta_s()), which the forecast alerts in alert_eval.c use.
+ * - Sums are exact integers (0.1 s, 0.01 °C, 0.01 %RH), so they do not
+ *   drift however long the window slides.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+
+typedef struct {
+    uint16_t n;                       // samples in the window
+    float    span_s;                  // time between oldest and newest sample
+    float    T_C, RH;                 // fitted value at the newest sample
+    float    dT_per_h, dRH_per_h;     // slopes
+    float    r2_T, r2_RH;             // coefficient of determination (0..1; 0 if flat)
+} trend_t;
+
+esp_err_t trend_init(uint32_t window_s);   // 0 disables
+void      trend_add(const sample_t *s);    // sensor loop
+bool      trend_get(trend_t *out);         // false until half a window is covered
+float     trend_eta_s(float now, float per_h, float threshold);   // seconds; NAN if not heading there
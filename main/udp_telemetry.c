@@ -0,0 +1,504 @@
+/*
+ * UDP telemetry (implementation).
+ * - udp_telemetry_submit() pushes the sample into the backlog and sends it
+ *   straight away from the caller, app_main's net_task (non-blocking send;
+ *   if the transport is busy or down the reading just waits in the backlog).
+ * - The task owns connection setup (DNS, DTLS handshake) and the receive
+ *   side: each ack releases readings from the backlog and resends the gaps
+ *   it lists, at most RESEND_MAX per ack; a gap resent within the last
+ *   RESEND_TIMEOUT_MS is not resent again.
+ * - DTLS (CONFIG_APP_UDP_DTLS) uses mbedTLS with PSK + AES-128-CCM-8:
+ *   29 bytes per datagram on top of the 24-byte reading.
+ */
+
+#include "udp_telemetry.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "mem_budget.h"
+#include "sched_plan.h"
+#include "sdkconfig.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#if CONFIG_APP_UDP_DTLS
+#define DTLS_NOTE ", DTLS-PSK"
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#else
+#define DTLS_NOTE ""
+#endif
+
+static const char *TAG = "UDP_TM";
+
+#define RESEND_MAX          32
+#define TASK_STACK          4096
+#define RESEND_TIMEOUT_MS   2000
+#define RETRY_FIRST_S       5
+#define RETRY_MAX_S         60
+#define RX_POLL_MS          1000
+#define DTLS_IDLE_RESET_S   60        // no ack for this long with readings pending: new handshake
+#define DTLS_READ_TIMEOUT_MS RX_POLL_MS   // one ssl_read, when the datagram select() saw is not a whole record
+
+static int sock = -1;
+static backlog_t *backlog;
+static SemaphoreHandle_t tx_lock;     // socket/DTLS writes (sensor loop + task)
+static volatile bool ready;           // transport usable
+static uint16_t epoch;
+static volatile uint32_t seq_end;     // one past the newest reading (acks beyond it are bogus)
+static int64_t last_ack_us;
+static uint32_t resend_hwm;           // highest seq resent in the current round
+static int64_t resend_us;
+
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static udp_telemetry_stats_t st;
+
+#define STAT_INC(field) do { portENTER_CRITICAL(&mux); st.field++; portEXIT_CRITICAL(&mux); } while (0)
+
+static bool seq_le(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get_u16(const uint8_t *p)   { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p)   { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+/**
+ * @brief Encode one reading datagram (layout in udp_telemetry.h).
+ */
+void udpt_encode_reading(const reading_t *r, uint8_t type, uint16_t device, uint16_t epoch_, uint16_t depth,
+                         uint8_t out[UDPT_READING_LEN])
+{
+    uint64_t ms = (uint64_t)r->unix_ms;
+    out[0] = (uint8_t)(UDPT_VERSION << 4 | type);
+    put_u16(out + 1, device);
+    put_u16(out + 3, epoch_);
+    put_u16(out + 5, depth);
+    put_u32(out + 7, r->seq);
+    put_u32(out + 11, (uint32_t)ms);
+    put_u16(out + 15, (uint16_t)(ms >> 32));
+    put_u16(out + 17, (uint16_t)r->t_cC);
+    put_u16(out + 19, r->h_cRH);
+    out[21] = (uint8_t)r->p_dPa;
+    out[22] = (uint8_t)(r->p_dPa >> 8);
+    out[23] = (uint8_t)(r->p_dPa >> 16);
+}
+
+bool udpt_decode_reading(const uint8_t *in, size_t len, reading_t *r, uint8_t *type, uint16_t *device,
+                         uint16_t *epoch_, uint16_t *depth)
+{
+    if (len != UDPT_READING_LEN || in[0] >> 4 != UDPT_VERSION) return false;
+    *type = in[0] & 0x0F;
+    if (*type != UDPT_READING && *type != UDPT_RESENT) return false;
+    *device = get_u16(in + 1);
+    *epoch_ = get_u16(in + 3);
+    *depth = get_u16(in + 5);
+    r->seq = get_u32(in + 7);
+    r->unix_ms = (int64_t)(get_u32(in + 11) | (uint64_t)get_u16(in + 15) << 32);
+    r->t_cC = (int16_t)get_u16(in + 17);
+    r->h_cRH = get_u16(in + 19);
+    r->p_dPa = in[21] | (uint32_t)in[22] << 8 | (uint32_t)in[23] << 16;
+    return true;
+}
+
+size_t udpt_encode_ack(const udpt_ack_t *a, uint8_t *out, size_t cap)
+{
+    if (a->n > UDPT_ACK_RANGES_MAX || cap < UDPT_ACK_LEN(a->n)) return 0;
+    out[0] = UDPT_VERSION << 4 | UDPT_ACK;
+    put_u16(out + 1, a->device);
+    put_u16(out + 3, a->epoch);
+    out[5] = a->n;
+    put_u32(out + 6, a->next);
+    for (int i = 0; i < a->n; i++) {
+        put_u32(out + 10 + 6 * i, a->missing[i].first);
+        put_u16(out + 14 + 6 * i, a->missing[i].count);
+    }
+    return UDPT_ACK_LEN(a->n);
+}
+
+bool udpt_decode_ack(const uint8_t *in, size_t len, udpt_ack_t *a)
+{
+    if (len < UDPT_ACK_LEN(0) || in[0] != (UDPT_VERSION << 4 | UDPT_ACK)) return false;
+    a->device = get_u16(in + 1);
+    a->epoch = get_u16(in + 3);
+    a->n = in[5];
+    if (a->n > UDPT_ACK_RANGES_MAX || len != UDPT_ACK_LEN(a->n)) return false;
+    a->next = get_u32(in + 6);
+    for (int i = 0; i < a->n; i++) {
+        a->missing[i].first = get_u32(in + 10 + 6 * i);
+        a->missing[i].count = get_u16(in + 14 + 6 * i);
+    }
+    return true;
+}
+
+/* ---- Transport: plain UDP or DTLS on one connected socket ---- */
+
+#if CONFIG_APP_UDP_DTLS
+static mbedtls_ssl_context ssl;
+static mbedtls_ssl_config ssl_conf;
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+
+static struct {
+    int64_t start_us;
+    uint32_t int_ms, fin_ms;
+} dtls_timer;
+
+static void timer_set(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    dtls_timer.start_us = esp_timer_get_time();
+    dtls_timer.int_ms = int_ms;
+    dtls_timer.fin_ms = fin_ms;
+}
+
+// mbedTLS timer contract: -1 cancelled, 0 running, 1 intermediate passed, 2 final passed.
+static int timer_get(void *ctx)
+{
+    if (dtls_timer.fin_ms == 0) return -1;
+    int64_t ms = (esp_timer_get_time() - dtls_timer.start_us) / 1000;
+    if (ms >= dtls_timer.fin_ms) return 2;
+    if (ms >= dtls_timer.int_ms) return 1;
+    return 0;
+}
+
+static int bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    ssize_t n = send(sock, buf, len, MSG_DONTWAIT);
+    if (n >= 0) return (int)n;
+    return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int bio_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout_ms)
+{
+    fd_set rd;
+    FD_ZERO(&rd);
+    FD_SET(sock, &rd);
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    int r = select(sock + 1, &rd, NULL, NULL, timeout_ms ? &tv : NULL);
+    if (r == 0) return MBEDTLS_ERR_SSL_TIMEOUT;
+    if (r < 0) return MBEDTLS_ERR_NET_RECV_FAILED;
+    ssize_t n = recv(sock, buf, len, MSG_DONTWAIT);
+    if (n >= 0) return (int)n;
+    return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// One-time mbedTLS setup: RNG, DTLS client config with the PSK from Kconfig.
+static esp_err_t dtls_init(void)
+{
+    static const int suites[] = { MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8, 0 };
+    unsigned char psk[32];
+    size_t psk_len = strlen(CONFIG_APP_UDP_DTLS_PSK) / 2;
+    if (psk_len == 0 || psk_len > sizeof psk) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < psk_len; i++) {
+        int hi = hex_nibble(CONFIG_APP_UDP_DTLS_PSK[2 * i]), lo = hex_nibble(CONFIG_APP_UDP_DTLS_PSK[2 * i + 1]);
+        if (hi < 0 || lo < 0) return ESP_ERR_INVALID_ARG;
+        psk[i] = (unsigned char)(hi << 4 | lo);
+    }
+
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&ssl_conf);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) != 0 ||
+        mbedtls_ssl_config_defaults(&ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_DATAGRAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_conf_rng(&ssl_conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_authmode(&ssl_conf, MBEDTLS_SSL_VERIFY_NONE);   // the PSK authenticates both ends
+    mbedtls_ssl_conf_ciphersuites(&ssl_conf, suites);
+    mbedtls_ssl_conf_handshake_timeout(&ssl_conf, 1000, 16000);
+    mbedtls_ssl_conf_read_timeout(&ssl_conf, DTLS_READ_TIMEOUT_MS);   // 0 would make bio_recv_timeout block
+    if (mbedtls_ssl_conf_psk(&ssl_conf, psk, psk_len, (const unsigned char *)CONFIG_APP_UDP_DTLS_PSK_IDENTITY,
+                             strlen(CONFIG_APP_UDP_DTLS_PSK_IDENTITY)) != 0 ||
+        mbedtls_ssl_setup(&ssl, &ssl_conf) != 0) {
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_set_bio(&ssl, NULL, bio_send, NULL, bio_recv_timeout);
+    mbedtls_ssl_set_timer_cb(&ssl, &dtls_timer, timer_set, timer_get);
+    return ESP_OK;
+}
+
+// Drop the session and the socket; the task reconnects (plain UDP never needs to).
+static void transport_close(void)
+{
+    ready = false;
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    mbedtls_ssl_session_reset(&ssl);
+    if (sock >= 0) close(sock);
+    sock = -1;
+    xSemaphoreGive(tx_lock);
+}
+#endif
+
+/**
+ * @brief Resolve CONFIG_APP_UDP_COLLECTOR, connect a UDP socket to it and,
+ *        with DTLS, complete the handshake.
+ *
+ * @return ESP_OK when readings can be sent.
+ */
+static esp_err_t transport_open(void)
+{
+    char host[64];
+    const char *colon = strrchr(CONFIG_APP_UDP_COLLECTOR, ':');
+    size_t hl = colon ? (size_t)(colon - CONFIG_APP_UDP_COLLECTOR) : 0;
+    if (!colon || hl == 0 || hl >= sizeof host) {
+        ESP_LOGE(TAG, "collector must be host:port, got \"%s\"", CONFIG_APP_UDP_COLLECTOR);
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(host, CONFIG_APP_UDP_COLLECTOR, hl);
+    host[hl] = '\0';
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM }, *ai = NULL;
+    if (getaddrinfo(host, colon + 1, &hints, &ai) != 0 || !ai) {
+        ESP_LOGW(TAG, "cannot resolve %s", host);
+        return ESP_FAIL;
+    }
+    int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    bool ok = fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+    freeaddrinfo(ai);
+    if (!ok) {
+        if (fd >= 0) close(fd);
+        return ESP_FAIL;
+    }
+    sock = fd;
+
+#if CONFIG_APP_UDP_DTLS
+    int ret;
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    do {
+        ret = mbedtls_ssl_handshake(&ssl);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    xSemaphoreGive(tx_lock);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "DTLS handshake failed: -0x%04x", (unsigned)-ret);
+        transport_close();
+        return ESP_FAIL;
+    }
+    STAT_INC(handshakes);
+#endif
+    last_ack_us = esp_timer_get_time();
+    ready = true;
+    return ESP_OK;
+}
+
+// Send one datagram; wait says whether to block for the transport lock.
+static bool transport_send(const uint8_t *buf, size_t len, bool wait)
+{
+    if (!ready || !xSemaphoreTake(tx_lock, wait ? portMAX_DELAY : 0)) return false;
+#if CONFIG_APP_UDP_DTLS
+    bool ok = mbedtls_ssl_write(&ssl, buf, len) == (int)len;
+#else
+    bool ok = send(sock, buf, len, MSG_DONTWAIT) == (ssize_t)len;
+#endif
+    xSemaphoreGive(tx_lock);
+    return ok;
+}
+
+// Receive one datagram after select() said the socket is readable; <= 0 if none.
+// With DTLS, a datagram mbedTLS discards (bad record, replay) makes it read
+// again: that wait is bounded by DTLS_READ_TIMEOUT_MS, as tx_lock is held.
+static int transport_recv(uint8_t *buf, size_t cap)
+{
+#if CONFIG_APP_UDP_DTLS
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    int n = mbedtls_ssl_read(&ssl, buf, cap);
+    xSemaphoreGive(tx_lock);
+    if (n == MBEDTLS_ERR_SSL_TIMEOUT || n == MBEDTLS_ERR_SSL_WANT_READ) return 0;   // nothing usable this time
+    if (n == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) transport_close();
+    return n;
+#else
+    return (int)recv(sock, buf, cap, MSG_DONTWAIT);
+#endif
+}
+
+/* ---- Readings and acks ---- */
+
+static bool send_reading(const reading_t *r, uint8_t type, bool wait)
+{
+    reading_t oldest;
+    uint32_t depth = backlog_peek(backlog, &oldest, 1) ? r->seq - oldest.seq : 0;
+    uint8_t dg[UDPT_READING_LEN];
+    udpt_encode_reading(r, type, CONFIG_APP_UDP_DEVICE_ID, epoch, depth > UINT16_MAX ? UINT16_MAX : (uint16_t)depth,
+                        dg);
+    bool ok = transport_send(dg, sizeof dg, wait);
+    portENTER_CRITICAL(&mux);
+    if (!ok) st.send_errors++;
+    else if (type == UDPT_RESENT) st.resent++;
+    else st.sent++;
+    portEXIT_CRITICAL(&mux);
+    return ok;
+}
+
+static bool is_missing(const udpt_ack_t *a, uint32_t seq)
+{
+    for (int i = 0; i < a->n; i++) {
+        if (seq - a->missing[i].first < a->missing[i].count) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Release acknowledged readings and resend the gaps an ack lists.
+ *
+ * @param[in] a Decoded ack (already checked for device id and epoch).
+ */
+static void handle_ack(const udpt_ack_t *a)
+{
+    static reading_t pending[RESEND_MAX];
+
+    if (!seq_le(a->next, seq_end)) return;     // acks seqs never sent (receiver from another life)
+    backlog_ack(backlog, a->next - 1);
+    last_ack_us = esp_timer_get_time();
+    STAT_INC(acks);
+    if (a->n == 0) return;
+
+    if (last_ack_us - resend_us > RESEND_TIMEOUT_MS * 1000LL) resend_hwm = a->next - 1;
+    size_t n = backlog_peek(backlog, pending, RESEND_MAX);
+    bool any = false;
+    for (size_t i = 0; i < n; i++) {
+        if (seq_le(pending[i].seq, resend_hwm) || !is_missing(a, pending[i].seq)) continue;
+        if (!send_reading(&pending[i], UDPT_RESENT, true)) break;
+        resend_hwm = pending[i].seq;
+        any = true;
+    }
+    if (any) resend_us = last_ack_us;
+}
+
+/**
+ * @brief Telemetry task: (re)connects with back-off and processes acks.
+ *
+ * @param arg Unused.
+ */
+static void udp_telemetry_task(void *arg)
+{
+    uint32_t retry_s = 0;
+    uint8_t buf[128];
+
+    while (1) {
+        if (!ready) {
+            if (retry_s) vTaskDelay(pdMS_TO_TICKS(retry_s * 1000U));
+            if (transport_open() != ESP_OK) {
+                retry_s = retry_s ? retry_s * 2 : RETRY_FIRST_S;
+                if (retry_s > RETRY_MAX_S) retry_s = RETRY_MAX_S;
+                continue;
+            }
+            retry_s = 0;
+            ESP_LOGI(TAG, "sending to %s (%u readings queued)", CONFIG_APP_UDP_COLLECTOR,
+                     (unsigned)backlog_count(backlog));
+        }
+
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(sock, &rd);
+        struct timeval tv = { .tv_sec = RX_POLL_MS / 1000, .tv_usec = (RX_POLL_MS % 1000) * 1000 };
+        if (select(sock + 1, &rd, NULL, NULL, &tv) > 0) {
+            int n = transport_recv(buf, sizeof buf);
+            udpt_ack_t a;
+            if (n > 0 && udpt_decode_ack(buf, (size_t)n, &a) && a.device == CONFIG_APP_UDP_DEVICE_ID &&
+                a.epoch == epoch) {
+                handle_ack(&a);
+            }
+        }
+#if CONFIG_APP_UDP_DTLS
+        if (ready && backlog_count(backlog) &&
+            esp_timer_get_time() - last_ack_us > DTLS_IDLE_RESET_S * 1000000LL) {
+            ESP_LOGW(TAG, "no ack for %d s; new DTLS session", DTLS_IDLE_RESET_S);
+            transport_close();
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Create the backlog and start the telemetry task.
+ *
+ * Does nothing when CONFIG_APP_UDP_COLLECTOR is empty. Name resolution and
+ * the DTLS handshake happen in the task, so this does not wait for Wi-Fi.
+ *
+ * @return ESP_OK, or an error if the backlog/task could not be created.
+ */
+esp_err_t udp_telemetry_start(void)
+{
+    if (CONFIG_APP_UDP_COLLECTOR[0] == '\0') {
+        ESP_LOGI(TAG, "no receiver configured; UDP telemetry off");
+        return ESP_OK;
+    }
+
+    const char *part = CONFIG_APP_UDP_BACKLOG_PARTITION;
+#if CONFIG_APP_STATIC_ALLOC
+    static reading_t ram[CONFIG_APP_UDP_BACKLOG_RAM];
+    static StaticSemaphore_t tx_lock_mem;
+    backlog = backlog_create_static(ram, CONFIG_APP_UDP_BACKLOG_RAM, part[0] ? part : NULL);
+    tx_lock = xSemaphoreCreateMutexStatic(&tx_lock_mem);
+#else
+    backlog = backlog_create(CONFIG_APP_UDP_BACKLOG_RAM, part[0] ? part : NULL);
+    tx_lock = xSemaphoreCreateMutex();
+#endif
+    if (!backlog || !tx_lock) return ESP_ERR_NO_MEM;
+#if CONFIG_APP_UDP_DTLS
+    esp_err_t err = dtls_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "DTLS setup failed (PSK must be 1-32 bytes of hex)");
+        return err;
+    }
+#endif
+    epoch = (uint16_t)esp_random();
+    reading_t oldest;
+    seq_end = backlog_peek(backlog, &oldest, 1) ? oldest.seq : 0;
+
+#if CONFIG_APP_STATIC_ALLOC
+    static StackType_t stack[TASK_STACK];
+    static StaticTask_t tcb;
+    if (!xTaskCreateStaticPinnedToCore(udp_telemetry_task, "udp_telemetry", TASK_STACK, NULL, SCHED_NET_PRIO, stack, &tcb,
+                                       SCHED_NET_CORE)) return ESP_ERR_NO_MEM;
+#else
+    if (xTaskCreatePinnedToCore(udp_telemetry_task, "udp_telemetry", TASK_STACK, NULL, SCHED_NET_PRIO, NULL,
+                                SCHED_NET_CORE) != pdPASS) return ESP_ERR_NO_MEM;
+#endif
+    mem_budget_add("udp", TASK_STACK + CONFIG_APP_UDP_BACKLOG_RAM * sizeof(reading_t));
+    ESP_LOGI(TAG, "UDP telemetry to %s, device %d%s", CONFIG_APP_UDP_COLLECTOR, CONFIG_APP_UDP_DEVICE_ID,
+             DTLS_NOTE);
+    return ESP_OK;
+}
+
+/**
+ * @brief Queue one compensated sample and send it immediately.
+ *
+ * @param[in] s Sample from sample_pipeline_process().
+ */
+void udp_telemetry_submit(const sample_t *s, int64_t unix_ms)
+{
+    if (!backlog) return;
+    reading_t r;
+    reading_from_sample(s, unix_ms, backlog_push(backlog, s, unix_ms), &r);
+    seq_end = r.seq + 1;
+    send_reading(&r, UDPT_READING, false);
+}
+
+void udp_telemetry_get_stats(udp_telemetry_stats_t *out)
+{
+    backlog_stats_t b;
+    backlog_get_stats(backlog, &b);
+    portENTER_CRITICAL(&mux);
+    *out = st;
+    portEXIT_CRITICAL(&mux);
+    out->backlog = b;
+}
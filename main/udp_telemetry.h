@@ -0,0 +1,70 @@
+/*
+ * UDP telemetry (public API).
+ * - For congested or metered links: every sample goes out at once as one
+ *   24-byte datagram to CONFIG_APP_UDP_COLLECTOR (no TCP, no batching
+ *   delay), optionally inside DTLS 1.2 with a pre-shared key.
+ * - The receiver acknowledges cumulatively ("everything before seq N") and
+ *   lists the gaps it has seen; the device resends those from its backlog
+ *   (RAM, spilling to flash), so losses are filled in from device history.
+ * - Wire format below is little-endian, like reading_codec.h. Readings carry
+ *   how far back the device's history reaches, so a receiver that starts
+ *   late or restarts knows what it can still ask for.
+ * - Disabled when CONFIG_APP_UDP_COLLECTOR is empty.
+ *
+ *   reading (24 B)  0 hdr | 1 device u16 | 3 epoch u16 | 5 depth u16 | 7 seq u32 |
+ *                   11 unix_ms u48 | 17 t_cC i16 | 19 h_cRH u16 | 21 p_dPa u24
+ *   ack (10 + 6n B) 0 hdr | 1 device u16 | 3 epoch u16 | 5 n u8 | 6 next u32 |
+ *                   n x (first u32, count u16)
+ *
+ *   hdr = UDPT_VERSION << 4 | type. depth = seq - oldest seq still held
+ *   (saturates at 65535). epoch is random per boot; seq continues across
+ *   boots while flash holds unsent readings. next = every seq before it has
+ *   arrived; the ranges are missing seqs at or after next.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sample_pipeline.h"
+#include "reading_codec.h"
+#include "backlog.h"
+
+#define UDPT_VERSION         1
+#define UDPT_READING         1        // first transmission
+#define UDPT_RESENT          2        // resent after an ack listed it missing
+#define UDPT_ACK             3
+#define UDPT_READING_LEN     24
+#define UDPT_ACK_RANGES_MAX  8
+#define UDPT_ACK_LEN(n)      ((size_t)(10 + 6 * (n)))
+
+typedef struct {
+    uint16_t device;
+    uint16_t epoch;
+    uint32_t next;                    // all seqs before next received
+    uint8_t  n;                       // missing ranges that follow
+    struct { uint32_t first; uint16_t count; } missing[UDPT_ACK_RANGES_MAX];
+} udpt_ack_t;
+
+typedef struct {
+    uint32_t sent;                    // first transmissions
+    uint32_t resent;                  // gap fills
+    uint32_t send_errors;             // not handed to the stack (no route, buffers full, handshake)
+    uint32_t acks;                    // valid acks received
+    uint32_t handshakes;              // DTLS sessions established
+    backlog_stats_t backlog;
+} udp_telemetry_stats_t;
+
+esp_err_t udp_telemetry_start(void);                 // ESP_OK when disabled
+void      udp_telemetry_submit(const sample_t *s, int64_t unix_ms);   // from net_task (unix_ms: wall time of the read)
+void      udp_telemetry_get_stats(udp_telemetry_stats_t *out);
+
+// Wire helpers, shared with receivers (uplink_bench). Decoders return false on
+// a wrong length, version or type.
+void udpt_encode_reading(const reading_t *r, uint8_t type, uint16_t device, uint16_t epoch, uint16_t depth,
+                         uint8_t out[UDPT_READING_LEN]);
+bool udpt_decode_reading(const uint8_t *in, size_t len, reading_t *r, uint8_t *type, uint16_t *device,
+                         uint16_t *epoch, uint16_t *depth);
+size_t udpt_encode_ack(const udpt_ack_t *a, uint8_t *out, size_t cap);   // 0 if cap is too small
+bool   udpt_decode_ack(const uint8_t *in, size_t len, udpt_ack_t *a);
@@ -4,6 +4,7 @@
  * - Registers event handlers for connect/retry and logs acquired IPv4.
  * - Utility checks: have_ip() and time_is_set() to gate network/TLS.
  * - start_sntp_once(): one-shot SNTP bootstrap using time.google.com.
+ * - CONFIG_APP_NET_OPENETH: QEMU builds bring up open_eth Ethernet instead.
  * Author: Wael Hamid  |  Date: 2025-08-12
  */
 
@@ -18,6 +19,9 @@
 #include "sdkconfig.h"
 #include <time.h>
 #include "esp_sntp.h"
+#if CONFIG_APP_NET_OPENETH
+#include "esp_eth.h"
+#endif
 
 
 
@@ -37,12 +41,41 @@ static void handler(void *arg, esp_event_base_t base, int32_t id, void *data) {
     } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGI(TAG, "Disconnected; reconnecting...");
         esp_wifi_connect();
-    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+    } else if (base == IP_EVENT && (id == IP_EVENT_STA_GOT_IP || id == IP_EVENT_ETH_GOT_IP)) {
         ip_event_got_ip_t *e = (ip_event_got_ip_t*)data;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&e->ip_info.ip));
     }
 }
 
+#if CONFIG_APP_NET_OPENETH
+/**
+ * @brief Start QEMU's OpenCores Ethernet MAC with DHCP.
+ *
+ * Same bring-up as ESP-IDF's protocol examples: default ETH netif, open_eth
+ * MAC, DP83848 PHY (what QEMU emulates), netif glue, then start.
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+static esp_err_t eth_start_openeth(void) {
+    esp_netif_config_t netif_cfg = ESP_NETIF_DEFAULT_ETH();
+    esp_netif_t *netif = esp_netif_new(&netif_cfg);
+
+    eth_mac_config_t mac_cfg = ETH_MAC_DEFAULT_CONFIG();
+    eth_phy_config_t phy_cfg = ETH_PHY_DEFAULT_CONFIG();
+    phy_cfg.autonego_timeout_ms = 100;            // emulated PHY links up at once
+    esp_eth_mac_t *mac = esp_eth_mac_new_openeth(&mac_cfg);
+    esp_eth_phy_t *phy = esp_eth_phy_new_dp83848(&phy_cfg);
+
+    esp_eth_config_t eth_cfg = ETH_DEFAULT_CONFIG(mac, phy);
+    esp_eth_handle_t eth = NULL;
+    ESP_ERROR_CHECK(esp_eth_driver_install(&eth_cfg, &eth));
+    ESP_ERROR_CHECK(esp_netif_attach(netif, esp_eth_new_netif_glue(eth)));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, &handler, NULL));
+    ESP_LOGI(TAG, "Using QEMU open_eth instead of Wi-Fi");
+    return esp_eth_start(eth);
+}
+#endif
+
 /**
  * @brief Initialize and start Wi-Fi in station mode.
  *
@@ -57,6 +90,9 @@ esp_err_t wifi_start_station(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+#if CONFIG_APP_NET_OPENETH
+    return eth_start_openeth();
+#endif
     esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -89,7 +125,11 @@ esp_err_t wifi_start_station(void) {
  */
 
 bool have_ip(void) {                                              // true if Wi-Fi STA has an IPv4
+#if CONFIG_APP_NET_OPENETH
+    esp_netif_t *sta = esp_netif_get_handle_from_ifkey("ETH_DEF");      // QEMU open_eth netif
+#else
     esp_netif_t *sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"); // default Wi-Fi station netif
+#endif
     if (!sta) return false;                                            // netif not created/available yet
     esp_netif_ip_info_t ip= {0};                                      // holder for IPv4 info
     if (esp_netif_get_ip_info(sta, &ip) != ESP_OK) return false;     // no ip yet...
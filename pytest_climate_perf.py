@@ -0,0 +1,125 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Performance budgets for the climate monitor, run in Espressif's QEMU.
+
+The firmware is built with sdkconfig.ci.qemu (simulated BME280, open_eth
+networking, PERF log line every 5 s). The test boots it, polls the "/" page
+through QEMU's user-mode port forward while the sensor loop runs, and checks
+the published metrics against BUDGETS:
+
+    idf.py -B build_esp32_qemu -DSDKCONFIG_DEFAULTS=sdkconfig.ci.qemu build
+    pytest pytest_climate_perf.py --target esp32 --embedded-services idf,qemu \
+           --build-dir build_esp32_qemu
+
+Environment:
+    PERF_SOAK_S     soak length in seconds (default 300)
+    PERF_TOLERANCE  allowed regression past a budget, as a fraction (default 0.10)
+    PERF_HTTP_PORT  host port forwarded to the device's port 80 (default 8080)
+"""
+
+import json
+import logging
+import os
+import re
+import statistics
+import time
+import urllib.request
+from typing import Dict, List
+
+import pytest
+from pytest_embedded_qemu.dut import QemuDut
+
+SOAK_S = int(os.getenv('PERF_SOAK_S', '300'))
+TOLERANCE = float(os.getenv('PERF_TOLERANCE', '0.10'))
+HTTP_PORT = int(os.getenv('PERF_HTTP_PORT', '8080'))
+HTTP_PROBES_PER_REPORT = 5
+
+# metric: (kind, limit). 'max' fails above limit * (1 + tolerance), 'min' below limit * (1 - tolerance).
+BUDGETS = {
+    'first_sample_ms':     ('max', 20000),   # app_main waits up to 15 s for SNTP before the first read
+    'jitter_avg_us':       ('max', 5000),
+    'jitter_max_us':       ('max', 20000),   # two FreeRTOS ticks at 100 Hz
+    'heap_min':            ('min', 120000),  # free-heap low-water mark
+    'http_handler_max_us': ('max', 50000),   # "/" handler on the device
+    'http_p95_ms':         ('max', 300),     # "/" round trip seen from the host (QEMU + slirp)
+    'heap_growth_bytes':   ('max', 0),       # soak: no loss of free heap between halves
+    'largest_loss_bytes':  ('max', 0),       # soak: ... nor of the largest free block (fragmentation)
+    'net_fails':           ('max', 0),       # network buffer pool never ran dry
+}
+
+PERF_RE = re.compile(rb'PERF: (uptime_ms=\d+[^\r\n]*)')
+
+
+def parse_perf(line: bytes) -> Dict[str, int]:
+    return {k: int(v) for k, v in (kv.split('=') for kv in line.decode().split())}
+
+
+def probe_http(url: str) -> float:
+    t0 = time.perf_counter()
+    with urllib.request.urlopen(url, timeout=5) as r:
+        r.read()
+        assert r.status == 200
+    return (time.perf_counter() - t0) * 1000.0
+
+
+def check_budgets(measured: Dict[str, float]) -> List[str]:
+    failures = []
+    for name, (kind, limit) in BUDGETS.items():
+        if name not in measured:
+            failures.append(f'{name}: not measured')
+            continue
+        value = measured[name]
+        if kind == 'max' and value > limit * (1 + TOLERANCE):
+            failures.append(f'{name}={value:.0f} exceeds budget {limit} (+{TOLERANCE:.0%})')
+        if kind == 'min' and value < limit * (1 - TOLERANCE):
+            failures.append(f'{name}={value:.0f} below budget {limit} (-{TOLERANCE:.0%})')
+    return failures
+
+
+@pytest.mark.esp32
+@pytest.mark.host_test
+@pytest.mark.qemu
+@pytest.mark.parametrize('config', ['qemu'], indirect=True)
+@pytest.mark.parametrize(
+    'qemu_extra_args',
+    [f'-nic user,model=open_eth,hostfwd=tcp:127.0.0.1:{HTTP_PORT}-:80'],
+    indirect=True,
+)
+def test_climate_perf_budgets(dut: QemuDut) -> None:
+    url = f'http://127.0.0.1:{HTTP_PORT}/'
+    dut.expect('Web server started', timeout=60)
+
+    reports: List[Dict[str, int]] = []
+    http_ms: List[float] = []
+    deadline = time.monotonic() + SOAK_S
+    while time.monotonic() < deadline:
+        reports.append(parse_perf(dut.expect(PERF_RE, timeout=60).group(1)))
+        for _ in range(HTTP_PROBES_PER_REPORT):
+            http_ms.append(probe_http(url))
+
+    assert len(reports) >= 4, 'soak too short: need at least 4 PERF reports'
+    last = reports[-1]
+    steady = reports[1:]                       # first window still contains boot allocations
+    half = len(steady) // 2
+    heap_first = min(r['heap_free'] for r in steady[:half])
+    heap_second = min(r['heap_free'] for r in steady[half:])
+    # best largest block per half: a fetch in flight at report time is not fragmentation
+    largest_first = max(r['heap_largest'] for r in steady[:half])
+    largest_second = max(r['heap_largest'] for r in steady[half:])
+
+    measured = {
+        'first_sample_ms':     last['first_sample_ms'],
+        'jitter_avg_us':       max(r['jitter_avg_us'] for r in steady),
+        'jitter_max_us':       last['jitter_max_us'],
+        'heap_min':            last['heap_min'],
+        'http_handler_max_us': last['http_max_us'],
+        'http_p95_ms':         statistics.quantiles(http_ms, n=20)[-1],
+        'heap_growth_bytes':   max(0, heap_first - heap_second),
+        'largest_loss_bytes':  max(0, largest_first - largest_second),
+        'net_fails':           last['net_fails'],
+    }
+    logging.info('perf metrics: %s', json.dumps(measured))
+    with open(os.path.join(dut.logdir, 'perf_metrics.json'), 'w') as f:
+        json.dump({'measured': measured, 'budgets': BUDGETS, 'reports': reports}, f, indent=1)
+
+    failures = check_budgets(measured)
+    assert not failures, 'performance budgets exceeded:\n  ' + '\n  '.join(failures)
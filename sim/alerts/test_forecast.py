@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Forecast alert test: climate_sim with a warming ramp -> stand-in Twilio.
+
+    cmake --build build-sim && pytest sim/alerts
+
+SIM_HTTPS_REDIRECT sends the firmware's https:// traffic to the sink below,
+which records the Twilio SMS bodies and answers the Open-Meteo request from
+sim/fixtures. With the inside temperature climbing 6 °C/h from 26 °C, the
+trend fit (trend.c) must announce the 30 °C crossing about
+CONFIG_APP_ALERT_FORECAST_MIN (30) minutes ahead of the real alert; with a
+flat, noisy temperature it must stay quiet, and a frozen one must send one
+sensor warning and nothing else. $SIM_BUILD points at the sim
+build directory (default build-sim).
+"""
+
+import http.server
+import os
+import re
+import subprocess
+import threading
+import time
+import urllib.parse
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+FIXTURE = os.path.join(ROOT, 'sim', 'fixtures', 'open_meteo_current.json')
+SCALE = 200
+
+
+class Sink(http.server.ThreadingHTTPServer):
+    def __init__(self):
+        super().__init__(('127.0.0.1', 0), SinkHandler)
+        self.sms = []                  # (monotonic time, body)
+        threading.Thread(target=self.serve_forever, daemon=True).start()
+
+
+class SinkHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def _reply(self, status, body):
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        with open(FIXTURE, 'rb') as f:
+            self._reply(200, f.read())
+
+    def do_POST(self):
+        form = urllib.parse.parse_qs(self.rfile.read(int(self.headers['Content-Length'])).decode())
+        self.server.sms.append((time.monotonic(), form['Body'][0]))
+        self._reply(201, b'{"sid":"SMsim","status":"queued"}')
+
+    def log_message(self, *args):
+        pass
+
+
+@pytest.fixture
+def sink():
+    s = Sink()
+    yield s
+    s.shutdown()
+
+
+def run_sim(sink, waves, duration):
+    env = dict(os.environ, SIM_HTTPS_REDIRECT=f'http://127.0.0.1:{sink.server_address[1]}',
+               SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S=str(duration), SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='2', SIM_MQTT_URI='mqtt://127.0.0.1:1', SIM_BME280_WAVES=waves)
+    t0 = time.monotonic()
+    subprocess.run([SIM], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=60, check=False)
+    return [((t - t0) * SCALE, body) for t, body in sink.sms]      # sim seconds
+
+
+def test_forecast_leads_the_alert(sink):
+    sms = run_sim(sink, 'T=26,0,0,6,0.02', 2600)                     # 30 °C at 2400 s
+
+    kinds = [re.match(r'(\w+ \w+):', body).group(1) for _, body in sms]
+    assert kinds == ['Hot Forecast', 'Hot Warning', 'Hot Alert'], sms
+    (t_fc, forecast), _, (t_alert, _) = sms
+    m = re.search(r'rising ([\d.]+)C/h, expected above 30.0C in ~(\d+) min', forecast)
+    assert m, forecast
+    assert abs(float(m.group(1)) - 6.0) < 0.3
+    assert 25 <= int(m.group(2)) <= 30
+    lead_min = (t_alert - t_fc) / 60
+    assert 25 <= lead_min <= 35, sms                                # host timing jitter x SCALE
+
+
+def test_flat_temperature_sends_nothing(sink):
+    sms = run_sim(sink, 'T=25,0,0,0,0.05', 3600)
+    assert sms == []
+
+
+def test_stuck_sensor_warns_once(sink):
+    sms = run_sim(sink, 'T=25,0,0,0,0', 3600)                       # no noise: bit-identical readings
+    assert [body for _, body in sms] == ['Sensor Warning: Inside temperature stuck at 25.00C for 5 min; '
+                                         'check the sensor.'], sms
+    assert 300 <= sms[0][0] <= 600, sms                             # CONFIG_APP_ANOMALY_STUCK_S
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Pressure end-to-end test: sea-level reduction and 3 h tendency on /api/current.
+
+    cmake --build build-sim && pytest sim/baro
+
+climate_sim runs with a linear pressure ramp (SIM_BME280_WAVES slope) at a
+station altitude (SIM_ALTITUDE_M). The tendency must stay "unknown" until 3 h
+of per-minute history exist and then report the ramp's 3 h change and WMO
+code; sea-level pressure must match the hypsometric formula for the reported
+station pressure and outside temperature. $SIM_BUILD points at the sim build
+directory (default build-sim).
+"""
+
+import json
+import math
+import os
+import re
+import subprocess
+import time
+import urllib.request
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+SCALE = 5000
+ALTITUDE_M = 500
+
+
+def sea_level(p_pa, alt_m, t_c):
+    lh = 0.0065 * alt_m
+    t_k = 288.15 if t_c is None else t_c + lh + 273.15
+    return p_pa * (1 - lh / t_k) ** -5.25588
+
+
+def start_sim(slope_pa_h, log):
+    env = dict(os.environ, SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S=str(6 * 3600), SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_ALTITUDE_M=str(ALTITUDE_M), SIM_MQTT_URI='mqtt://127.0.0.1:1',
+               SIM_BME280_WAVES=f'P=95000,0,0,{slope_pa_h},2')
+    proc = subprocess.Popen([SIM], env=env, stdout=log, stderr=subprocess.STDOUT)   # a pipe would fill and stall it
+    deadline = time.time() + 10
+    while time.time() < deadline:
+        m = re.search(r'listening on port (\d+)', open(log.name).read())
+        if m:
+            return proc, int(m.group(1))
+        time.sleep(0.02)
+    proc.kill()
+    pytest.fail('sim did not start its web server')
+
+
+def current(port):
+    with urllib.request.urlopen(f'http://127.0.0.1:{port}/api/current', timeout=5) as r:
+        return json.load(r)
+
+
+@pytest.mark.parametrize('slope,code,trend', [(-100, 7, 'falling'), (100, 2, 'rising'), (0, 4, 'steady')])
+def test_tendency_and_sea_level(slope, code, trend, tmp_path):
+    log = open(tmp_path / 'sim.log', 'w')
+    proc, port = start_sim(slope, log)
+    try:
+        first = current(port)['pressure']
+        assert first['altitude_m'] == ALTITUDE_M
+        assert first['tendency_code'] is None and first['trend'] == 'unknown'
+
+        deadline = time.time() + 30
+        while time.time() < deadline:
+            cur = current(port)
+            if cur['pressure']['tendency_code'] is not None:
+                break
+            time.sleep(0.1)
+        else:
+            pytest.fail('no tendency after 3 h of sim time')
+
+        time.sleep(0.2)                 # a few more closed minutes
+        cur = current(port)
+        p = cur['pressure']
+        assert p['tendency_code'] == code and p['trend'] == trend
+        assert abs(p['tendency_3h'] - 3 * slope) < 3, p      # per-minute means of a ramp
+        assert p['station'] == cur['inside']['p']
+        expect = sea_level(p['station'], ALTITUDE_M, cur['outside']['t'])
+        assert math.isclose(p['sea_level'], expect, abs_tol=1.0), (p, expect)
+
+        page = urllib.request.urlopen(f'http://127.0.0.1:{port}/', timeout=5).read().decode()
+        assert f'{trend} (WMO {code})' in page
+    finally:
+        proc.kill()
+        proc.wait()
+        log.close()
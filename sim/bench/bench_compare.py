@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Compare two firmware_bench JSON results.
+
+    bench_compare.py base.json new.json [--threshold PCT]
+
+Prints the change in mean ns/op per benchmark and exits 1 if any benchmark
+got slower by more than PCT percent (default 10) *and* by more than the
+combined standard deviation of both runs, so ordinary noise does not fail CI.
+"""
+
+import argparse
+import json
+import math
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {r['name']: r['ns_per_op'] for r in json.load(f)['results']}
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('base')
+    ap.add_argument('new')
+    ap.add_argument('--threshold', type=float, default=10.0)
+    args = ap.parse_args()
+
+    base, new = load(args.base), load(args.new)
+    regressed = []
+    print(f"{'benchmark':40} {'base':>10} {'new':>10} {'change':>8}")
+    for name in sorted(base.keys() & new.keys()):
+        b, n = base[name], new[name]
+        pct = (n['mean'] - b['mean']) / b['mean'] * 100.0
+        noise = math.hypot(b['stddev'], n['stddev'])
+        flag = ''
+        if pct > args.threshold and n['mean'] - b['mean'] > noise:
+            flag = '  REGRESSION'
+            regressed.append(name)
+        print(f"{name:40} {b['mean']:10.2f} {n['mean']:10.2f} {pct:+7.1f}%{flag}")
+    for name in sorted(base.keys() ^ new.keys()):
+        print(f"{name:40} only in {'base' if name in base else 'new'}")
+    return 1 if regressed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
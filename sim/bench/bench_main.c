@@ -0,0 +1,888 @@
+/*
+ * Firmware microbenchmarks (host tool).
+ * Times the pure-C hot paths of the firmware as built for the sim: the BME280
+ * compensators, the Open-Meteo number finder, url_encode(), the "/" page
+ * render, the /api/snapshot scrape (re-rendered after a new sample, cached, and
+ * answered 304), sms_eval_alert(), the line protocol / gzip uplink encoders (per
+ * request of LP_READINGS readings, against a snprintf("%.2f") baseline) and
+ * the psychrometrics (fast float path against double libm, and the cached
+ * snapshot read) and a network buffer from the pool against the malloc/free
+ * of the fetch buffer it replaced. Before timing anything it checks psychro.c against double
+ * libm over -40..85 °C / 1..100 %RH and exits 1 if the error bounds stated in
+ * psychro.h do not hold, and likewise if baro.c misclassifies a table of
+ * 3 h pressure shapes (one or more per WMO tendency code) or trend.c's
+ * sliding fit strays from a double least-squares fit over the same window,
+ * or anomaly.c flags clean data or misses a scripted spike/step/glitch/freeze,
+ * or fusion.c fails to smooth a scripted heated room and find its k,
+ * or selfheat.c does not remove a scripted sensor warming after calibration,
+ * or net_pool.c hands out a bad block or miscounts, or /api/snapshot gets
+ * its history, ETag revalidation or ?minutes= bounds wrong.
+ * Each benchmark is run in repeated batches and
+ * reported in ns/op (mean, stddev, min, median) as JSON on stdout.
+ *
+ *   firmware_bench [--reps N] [--min-batch-ms MS] [--filter SUBSTR]
+ *                  [--fixtures DIR] [--label TEXT]
+ *
+ * --reps          batches per benchmark (default 30)
+ * --min-batch-ms  iterations per batch are scaled until a batch takes this long (default 5)
+ * --filter        only run benchmarks whose name contains SUBSTR
+ * --fixtures      directory holding the Open-Meteo payloads (default: sim/fixtures)
+ * --label         free text copied into the JSON (e.g. a commit hash)
+ *
+ * Compare two runs with sim/bench/bench_compare.py.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sim_time.h"
+#include "esp_log.h"
+#include "bme280.h"
+#include "bme280_sim.h"
+#include "sample_pipeline.h"
+#include "http_client_ext.h"
+#include "http_server.h"
+#include "sim_httpd.h"
+#include "sms_client.h"
+#include "alert_eval.h"
+#include "baro.h"
+#include "trend.h"
+#include "anomaly.h"
+#include "fusion.h"
+#include "selfheat.h"
+#include "net_pool.h"
+#include "reading_codec.h"
+#include "line_protocol.h"
+#include "gzip_enc.h"
+#include "psychro.h"
+#include "snapshot.h"
+#include "history.h"
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "fixtures"
+#endif
+
+#define N_INPUTS 256   // rotating input set so branches and caches see varied data
+#define LP_READINGS 60 // one default HTTP uplink request (60 s at 1 Hz)
+
+typedef void (*bench_fn_t)(uint64_t iters);
+
+typedef struct {
+    const char *name;
+    bench_fn_t  fn;
+} bench_t;
+
+static volatile double s_sink_d;   // keeps results observable to the optimizer
+static volatile int    s_sink_i;
+static void *volatile  s_sink_p;
+
+static int32_t s_adc_T[N_INPUTS], s_adc_P[N_INPUTS], s_adc_H[N_INPUTS];
+static char   *s_json_current, *s_json_hourly;
+static httpd_handle_t s_httpd;
+static char    s_page[4096];
+static char    s_snap[8192];           // /api/snapshot responses, headers included
+static char    s_inm[96];              // "If-None-Match: <ETag>\r\n" of the cached document
+static reading_t s_readings[LP_READINGS];
+static char    s_lp_prefix[64];
+static char    s_lp_text[LP_READINGS * 96];
+static size_t  s_lp_len;
+static uint8_t s_gz[GZIP_BOUND(LP_READINGS * 96)];
+
+static int64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static char *load_text(const char *dir, const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof path, "%s/%s", dir, name);
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)n + 1);
+    if (buf && fread(buf, 1, (size_t)n, f) == (size_t)n) buf[n] = '\0';
+    else { free(buf); buf = NULL; }
+    fclose(f);
+    return buf;
+}
+
+// ---- benchmarks ----
+
+static void b_comp_T(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += BME280_compensate_T_double(s_adc_T[i % N_INPUTS]);
+    s_sink_d = acc;
+}
+
+static void b_comp_P(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += BME280_compensate_P_double(s_adc_P[i % N_INPUTS]);
+    s_sink_d = acc;
+}
+
+static void b_comp_H(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += bme280_compensate_H_double(s_adc_H[i % N_INPUTS]);
+    s_sink_d = acc;
+}
+
+static void b_pipeline(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        raw_sample_t raw = { (int64_t)i, s_adc_T[i % N_INPUTS], s_adc_P[i % N_INPUTS], s_adc_H[i % N_INPUTS] };
+        sample_t s;
+        sample_pipeline_process(&raw, &s);
+        acc += s.T_C + s.P_Pa + s.H_RH;
+    }
+    s_sink_d = acc;
+}
+
+static void b_find_current(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        acc += find_key_number_skip_strings(s_json_current, "\"temperature_2m\"");
+        acc += find_key_number_skip_strings(s_json_current, "\"relative_humidity_2m\"");
+    }
+    s_sink_d = acc;
+}
+
+static void b_find_hourly(uint64_t n)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        acc += find_key_number_skip_strings(s_json_hourly, "\"temperature_2m\"");
+        acc += find_key_number_skip_strings(s_json_hourly, "\"relative_humidity_2m\"");
+    }
+    s_sink_d = acc;
+}
+
+static void b_find_missing(uint64_t n)   // key absent: full scan of the large payload
+{
+    int nan_count = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        nan_count += isnan(find_key_number_skip_strings(s_json_hourly, "\"apparent_temperature\""));
+    }
+    s_sink_i = nan_count;
+}
+
+static void b_url_encode(uint64_t n)
+{
+    static const char *msgs[] = {
+        "Hot Alert: Inside temperature 30.4C is above 30.0C.",
+        "Cold Warning: Inside temperature 16.2C is below 16.5C.",
+        "+15551234567",
+    };
+    char out[256];
+    int acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += url_encode(msgs[i % 3], out, sizeof out);
+    s_sink_i = acc;
+}
+
+static void b_root_get(uint64_t n)
+{
+    size_t len = 0, acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sample_t smp = { (int64_t)i, 21.0 + (double)(i & 7) * 0.1, 101325.0, 45.0 };
+        snapshot_set_inside(&smp, NULL, NULL, NULL);
+        sim_httpd_invoke(s_httpd, HTTP_GET, "/", NULL, s_page, sizeof s_page, &len);
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_api_snapshot_render(uint64_t n)   // a new sample since the last scrape: rendered again
+{
+    size_t len = 0, acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sample_t smp = { (int64_t)i, 21.0 + (double)(i & 7) * 0.1, 101325.0, 45.0 };
+        snapshot_set_inside(&smp, NULL, NULL, NULL);
+        sim_httpd_invoke(s_httpd, HTTP_GET, "/api/snapshot", NULL, s_snap, sizeof s_snap, &len);
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_api_snapshot_cached(uint64_t n)   // same sample as the last scrape, no ETag sent
+{
+    size_t len = 0, acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sim_httpd_invoke(s_httpd, HTTP_GET, "/api/snapshot", NULL, s_snap, sizeof s_snap, &len);
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_api_snapshot_304(uint64_t n)      // the scraper already has it
+{
+    size_t len = 0, acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sim_httpd_invoke(s_httpd, HTTP_GET, "/api/snapshot", s_inm, s_snap, sizeof s_snap, &len);
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_alert_in_range(uint64_t n)
+{
+    int acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += sms_eval_alert(20.0 + (double)(i & 15) * 0.25);
+    s_sink_i = acc;
+}
+
+static void b_alert_cooldown(uint64_t n)   // over threshold, suppressed by the 60 min cooldown
+{
+    int acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += sms_eval_alert(31.0 + (double)(i & 7) * 0.1);
+    s_sink_i = acc;
+}
+
+static void b_lp_fixed(uint64_t n)
+{
+    size_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        size_t len = 0;
+        for (int k = 0; k < LP_READINGS; k++) {
+            len += lp_append_reading(s_lp_text + len, sizeof s_lp_text - len, s_lp_prefix, &s_readings[k]);
+        }
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_lp_snprintf(uint64_t n)   // baseline: the same lines through %f
+{
+    size_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        size_t len = 0;
+        for (int k = 0; k < LP_READINGS; k++) {
+            const reading_t *r = &s_readings[k];
+            len += (size_t)snprintf(s_lp_text + len, sizeof s_lp_text - len, "%s t=%.2f,p=%.1f,h=%.2f %lld\n",
+                                    s_lp_prefix, reading_T_C(r), reading_P_Pa(r), reading_H_RH(r),
+                                    (long long)r->unix_ms);
+        }
+        acc += len;
+    }
+    s_sink_i = (int)acc;
+}
+
+static void b_gzip_lp(uint64_t n)
+{
+    size_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) acc += gzip_compress((const uint8_t *)s_lp_text, s_lp_len, s_gz, sizeof s_gz);
+    s_sink_i = (int)acc;
+}
+
+// Reference psychrometrics: same formulas as psychro.c in double with libm.
+static void psychro_ref(double T, double RH, double P, double *dew, double *ah, double *w, double *hi)
+{
+    double a = 17.62 * T / (243.12 + T), e = 611.2 * exp(a) * RH / 100, g = log(RH / 100) + a;
+    *dew = 243.12 * g / (17.62 - g);
+    *ah = e * 1000 / (461.5 * (T + 273.15));
+    *w = 621.98 * e / (P - e);
+    psychro_t f;
+    psychro_compute((float)T, (float)RH, (float)P, &f);   // heat index is a polynomial: no exp/log to check
+    *hi = f.heat_index_C;
+}
+
+static void b_psychro_fast(uint64_t n)
+{
+    psychro_t out;
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        psychro_compute(20.0f + (float)(i & 15), 30.0f + (float)(i & 31), 101325.0f, &out);
+        acc += out.dew_C + out.abs_g_m3 + out.ratio_g_kg;
+    }
+    s_sink_d = acc;
+}
+
+static void b_psychro_libm(uint64_t n)   // baseline: double exp/log
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        double T = 20.0 + (double)(i & 15), RH = 30.0 + (double)(i & 31);
+        double a = 17.62 * T / (243.12 + T), e = 611.2 * exp(a) * RH / 100, g = log(RH / 100) + a;
+        acc += 243.12 * g / (17.62 - g) + e * 1000 / (461.5 * (T + 273.15)) + 621.98 * e / (101325.0 - e);
+    }
+    s_sink_d = acc;
+}
+
+static void b_snapshot_cached(uint64_t n)   // every reader after the first one of a sample
+{
+    climate_snapshot_t snap;
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        snapshot_get(&snap);
+        acc += snap.in.dew_C;
+    }
+    s_sink_d = acc;
+}
+
+static void b_snapshot_update(uint64_t n)   // new sample + first reader (pays for the derivation)
+{
+    climate_snapshot_t snap;
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sample_t smp = { (int64_t)i, 20.0 + (double)(i & 15), 101325.0, 30.0 + (double)(i & 31) };
+        snapshot_set_inside(&smp, NULL, NULL, NULL);
+        snapshot_get(&snap);
+        acc += snap.in.dew_C;
+    }
+    s_sink_d = acc;
+}
+
+static int64_t s_trend_t_us;   // sim time of the trend benches' synthetic samples
+
+static void b_trend(uint64_t n)   // one sensor-loop step: add a sample (evicting the oldest) + read the fit
+{
+    trend_t tr;
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_trend_t_us += 1030000;
+        sample_t smp = { s_trend_t_us, 25.0 + (double)(i & 63) * 0.01, 101325.0, 45.0 + (double)(i & 31) * 0.01 };
+        trend_add(&smp);
+        if (trend_get(&tr)) acc += tr.dT_per_h;
+    }
+    s_sink_d = acc;
+}
+
+// Slide the window over a noisy ramp for 10 h (many evictions and rebases)
+// and compare the O(1) fit with a double least-squares fit over the same window.
+static int check_trend(void)
+{
+    enum { W = 900, N = 35000 };
+    static double xs[N], ts[N];
+    uint32_t rng = 12345;
+    double worst_slope = 0, worst_value = 0;
+    for (int i = 0; i < N; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        xs[i] = i * 1.03;
+        ts[i] = round((20.0 + 2.0 * xs[i] / 3600.0 + ((rng >> 8) / 16777216.0 - 0.5) * 0.2) * 100.0) / 100.0;
+        sample_t smp = { (int64_t)(xs[i] * 1e6), ts[i], 101325.0, 45.0 };
+        trend_add(&smp);
+        trend_t tr;
+        if (i % 997 || !trend_get(&tr)) continue;
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        int m = 0;
+        for (int j = i; j >= 0 && xs[i] - xs[j] <= W + 0.05; j--, m++) {
+            double x = round(xs[j] * 10.0) / 10.0 - xs[i];
+            sx += x; sy += ts[j]; sxx += x * x; sxy += x * ts[j];
+        }
+        double b = (m * sxy - sx * sy) / (m * sxx - sx * sx), a = (sy - b * sx) / m;
+        if (fabs(tr.dT_per_h - b * 3600.0) > worst_slope) worst_slope = fabs(tr.dT_per_h - b * 3600.0);
+        if (fabs(tr.T_C - a) > worst_value) worst_value = fabs(tr.T_C - a);
+    }
+    fprintf(stderr, "trend accuracy: slope %.2e C/h, fitted value %.2e C vs double least squares\n",
+            worst_slope, worst_value);
+    return worst_slope < 1e-3 && worst_value < 1e-3 ? 0 : -1;
+}
+
+static void b_anomaly(uint64_t n)   // all three channels of one sample
+{
+    uint32_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_trend_t_us += 1030000;
+        sample_t smp = { s_trend_t_us, 25.0 + (double)(i & 7) * 0.01, 101325.0 + (double)(i & 3), 45.0 + (double)(i & 15) * 0.05 };
+        acc += anomaly_check(&smp);
+    }
+    s_sink_i = (int)acc;
+}
+
+static uint32_t s_gauss_rng = 777;
+static double gauss(void)   // Box-Muller on an LCG; plenty for test data
+{
+    s_gauss_rng = s_gauss_rng * 1664525u + 1013904223u;
+    double u1 = ((s_gauss_rng >> 8) + 1.0) / 16777217.0;
+    s_gauss_rng = s_gauss_rng * 1664525u + 1013904223u;
+    double u2 = (s_gauss_rng >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Scripted 1 Hz day: sensor noise + 6 °C/h ramps must raise nothing; a spike,
+// a door-opening step, a bus glitch and a frozen humidity channel must be
+// flagged with the right kind, and the step must be absorbed within minutes.
+static int check_anomaly(void)
+{
+    uint32_t false_pos = 0, step_flagged = 0, step_last = 0;
+    uint16_t spike = 0, glitch = 0, stuck_seen = 0;
+    double stuck_h = 0;
+    int64_t t_us = 0;
+    for (int i = 0; i < 14400; i++) {
+        t_us += 1030000;
+        double T = 22.0 + 0.5 * sin(i / 3000.0) + 0.02 * gauss();
+        if (i >= 4000 && i < 5000) T += 6.0 * (i - 4000) / 3600.0;    // heating ramp
+        if (i >= 5000) T += 6.0 * 1000 / 3600.0;
+        if (i >= 8000) T += 2.0;                                      // door opened and left open
+        double H = 45.0 + 0.3 * gauss(), P = 101325.0 + 2.0 * gauss();
+        if (i == 3000) T += 1.5;                                      // single spike
+        if (i == 6000) P += 900.0;                                    // corrupted read
+        if (i == 10000) stuck_h = H;
+        if (i >= 10000 && i < 10400) H = stuck_h;                     // frozen for ~412 s
+        sample_t smp = { t_us, T, P, H };
+        uint16_t f = anomaly_check(&smp);
+        if (i == 3000) spike = f;
+        else if (i == 6000) glitch = f;
+        else if (i >= 8000 && i < 9000) {
+            if (f & ANOM_CHANNEL(ANOM_CH_T)) { step_flagged++; step_last = (uint32_t)(i - 8000); }
+        } else if (i >= 10000 && i < 10400) {
+            stuck_seen |= f;
+        } else if (f) {
+            false_pos++;
+        }
+    }
+    fprintf(stderr, "anomaly check: false positives %u in ~4 h, step flagged for %u samples (last +%u s)\n",
+            false_pos, step_flagged, step_last);
+    return false_pos == 0 && spike == ANOM_FLAG(ANOM_CH_T, ANOM_OUTLIER | ANOM_JUMP)
+        && glitch == ANOM_FLAG(ANOM_CH_P, ANOM_OUTLIER | ANOM_JUMP)
+        && step_flagged > 0 && step_last < 300
+        && stuck_seen == ANOM_FLAG(ANOM_CH_H, ANOM_STUCK) ? 0 : -1;
+}
+
+static int64_t s_fusion_t_us = 1000000LL * 1000000;   // after check_fusion()'s three days
+
+static void b_fusion(uint64_t n)   // one sensor-loop step: predict + inside update (+ outside every 874th)
+{
+    fusion_t fu;
+    float acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_fusion_t_us += 1030000;
+        sample_t smp = { s_fusion_t_us, 22.0 + (double)(i & 7) * 0.01, 101325.0, 45.0 };
+        fusion_update(&smp, 10.0f + (float)((i / 874) & 3) * 0.1f, false);
+        fusion_get(&fu);
+        acc += fu.T_C;
+    }
+    s_sink_d = acc;
+}
+
+// Three days of a heated room (k = 0.5/h, 5 °C/h heating, outside 10 ± 5 °C
+// daily, fetched every 15 min): the filter must smooth the sensor noise and
+// find k and the equilibrium temperature. The first sample is the BME280
+// reset value (26.46 °C); ten minutes in, k must not have taken it for a
+// room that swings by degrees per hour.
+static int check_fusion(void)
+{
+    const double k = 0.5, q = 5.0, dt = 1.03;
+    double T = 20.0, se_raw = 0, se_fu = 0;
+    float out = NAN, k_10min = NAN;
+    int m = 0;
+    fusion_t fu = { 0 };
+    fusion_update(&(sample_t){ -(int64_t)(dt * 1e6), 26.46, 82045.0, 0.0 }, NAN, false);
+    for (int i = 0; i < (int)(3 * 86400 / dt); i++) {
+        double h = i * dt / 3600.0, To = 10.0 + 5.0 * sin(2 * M_PI * (h - 9.0) / 24.0);
+        T += dt / 3600.0 * (q - k * (T - To));
+        if (i % 874 == 0) out = roundf((float)To * 10.0f) / 10.0f;
+        sample_t smp = { (int64_t)(i * dt * 1e6), round((T + 0.03 * gauss()) * 100.0) / 100.0, 101325.0, 45.0 };
+        fusion_update(&smp, out, false);
+        fusion_get(&fu);
+        if (i == (int)(600 / dt)) k_10min = fu.k_per_h;
+        if (h > 1.0) {
+            se_raw += (smp.T_C - T) * (smp.T_C - T);
+            se_fu += (fu.T_C - T) * (fu.T_C - T);
+            m++;
+        }
+    }
+    double T_eq = 10.0 + 5.0 * sin(2 * M_PI * (72.0 - 9.0) / 24.0) + q / k;
+    fprintf(stderr, "fusion check: rmse raw %.4f fused %.4f C, k %.3f +- %.3f /h (0.5; %.3f at 10 min), T_eq %.2f C (%.2f)\n",
+            sqrt(se_raw / m), sqrt(se_fu / m), fu.k_per_h, fu.k_sd, k_10min, fu.T_eq_C, T_eq);
+    return sqrt(se_fu / m) < sqrt(se_raw / m) / 3 && fabsf(fu.k_per_h - 0.5f) < 0.1f && k_10min < 1.0f
+        && fabs(fu.T_eq_C - T_eq) < 1.0 && isnan(fusion_eta_s(&fu, fu.T_eq_C + (fu.T_C > fu.T_eq_C ? -1.0f : 1.0f)))
+        ? 0 : -1;                        // a threshold past the equilibrium is never reached
+}
+
+static int64_t s_selfheat_t_us;
+
+static void b_selfheat(uint64_t n)   // one sample through the calibrated model (T and RH corrected)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        s_selfheat_t_us += 1030000;
+        sample_t smp = { s_selfheat_t_us, 22.8 + (double)(i & 7) * 0.01, 101325.0, 43.0 };
+        selfheat_apply(&smp);
+        acc += smp.T_C + smp.H_RH;
+    }
+    s_sink_d = acc;
+}
+
+// Six hours of a 22 °C room read by a sensor that warms itself by
+// 0.8 °C + 0.5 °C per conversion/s (lag 300 s), switching between 1 Hz and
+// one sample per 10 s every 90 min, with one reference reading at the end of
+// each of the first two periods: the calibrated correction must cut the
+// bias to a few hundredths.
+static int check_selfheat(void)
+{
+    const double off = 0.8, per_hz = 0.5, tau = 300.0, air = 22.0;
+    selfheat_init(&(selfheat_model_t){ 0.0f, 0.0f, (float)tau });
+    double heat = off + per_hz, t = 0, se_raw = 0, se_fix = 0;
+    int m = 0;
+    for (int period = 0; period < 4; period++) {
+        double dt = period % 2 ? 10.0 : 1.03;
+        selfheat_set_rate((float)(1.0 / dt));
+        for (double end = t + 5400.0; t < end; t += dt) {
+            heat += (off + per_hz / dt - heat) * (1.0 - exp(-dt / tau));
+            sample_t smp = { (int64_t)(t * 1e6), round((air + heat + 0.02 * gauss()) * 100.0) / 100.0, 101325.0, 45.0 };
+            double raw = smp.T_C;
+            selfheat_apply(&smp);
+            if (period >= 2) {
+                se_raw += (raw - air) * (raw - air);
+                se_fix += (smp.T_C - air) * (smp.T_C - air);
+                m++;
+            }
+        }
+        if (period < 2) selfheat_calibrate((float)air);
+    }
+    selfheat_t sh;
+    selfheat_get(&sh);
+    fprintf(stderr, "selfheat check: rms bias raw %.3f corrected %.3f C, fit %.3f C + %.3f C/Hz (0.8, 0.5)\n",
+            sqrt(se_raw / m), sqrt(se_fix / m), sh.model.offset_C, sh.model.C_per_hz);
+    return sqrt(se_fix / m) < 0.05 && fabsf(sh.model.offset_C - 0.8f) < 0.03 && fabsf(sh.model.C_per_hz - 0.5f) < 0.03
+        ? 0 : -1;
+}
+
+static void b_net_pool(uint64_t n)   // one network buffer taken and returned
+{
+    uintptr_t acc = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        void *blk = net_pool_get();
+        acc += (uintptr_t)blk;
+        net_pool_put(blk);
+    }
+    s_sink_d = (double)acc;
+}
+
+static void b_malloc_fetch(uint64_t n)   // baseline: the 8 KB response buffer the fetch used to malloc
+{
+    for (uint64_t i = 0; i < n; i++) {
+        char *buf = malloc(8192);
+        s_sink_p = buf;                  // keeps the pair from being optimised out
+        free(buf);
+    }
+}
+
+// Every block once, distinct and aligned; an empty pool says so; foreign,
+// offset and repeated puts are ignored; the counters add up.
+static int check_net_pool(void)
+{
+    void *blk[CONFIG_APP_NET_POOL_BLOCKS];
+    net_pool_init();
+    for (int i = 0; i < CONFIG_APP_NET_POOL_BLOCKS; i++) {
+        blk[i] = net_pool_get();
+        if (!blk[i] || ((uintptr_t)blk[i] & 3)) return -1;
+        memset(blk[i], i, NET_BLOCK_BYTES);
+    }
+    if (net_pool_get() != NULL) return -1;
+    for (int i = 0; i < CONFIG_APP_NET_POOL_BLOCKS; i++) {
+        const uint8_t *b = blk[i];
+        if (b[0] != i || b[NET_BLOCK_BYTES - 1] != i) return -1;   // no overlap
+    }
+    int local;
+    esp_log_level_set("net_pool", ESP_LOG_NONE);
+    net_pool_put(&local);
+    net_pool_put((char *)blk[0] + 4);
+    net_pool_put(blk[1]);
+    net_pool_put(blk[1]);
+    esp_log_level_set("net_pool", ESP_LOG_WARN);
+    net_pool_stats_t st;
+    net_pool_stats(&st);
+    if (st.in_use != CONFIG_APP_NET_POOL_BLOCKS - 1 || st.peak != CONFIG_APP_NET_POOL_BLOCKS ||
+        st.gets != CONFIG_APP_NET_POOL_BLOCKS || st.fails != 1) return -1;
+    if (net_pool_get() != blk[1]) return -1;
+    for (int i = 0; i < CONFIG_APP_NET_POOL_BLOCKS; i++) net_pool_put(blk[i]);
+    net_pool_stats(&st);
+    return st.in_use == 0 ? 0 : -1;
+}
+
+// Copy a response's ETag into s_inm as an If-None-Match header; 0 if it has none.
+static int snapshot_etag(const char *resp)
+{
+    const char *e = strstr(resp, "ETag: ");
+    if (!e) return 0;
+    e += 6;
+    int n = (int)strcspn(e, "\r\n");
+    snprintf(s_inm, sizeof s_inm, "If-None-Match: %.*s\r\n", n, e);
+    return 1;
+}
+
+static const char *snapshot_fetch(const char *uri, const char *headers)
+{
+    size_t len = 0;
+    sim_httpd_invoke(s_httpd, HTTP_GET, uri, headers, s_snap, sizeof s_snap - 1, &len);
+    s_snap[len] = '\0';
+    return s_snap;
+}
+
+// /api/snapshot over 2 h of 1 Hz history: the newest minutes in order, 304
+// only for the current ETag, a new document after a sample, ?minutes= bounds.
+static int check_api_snapshot(void)
+{
+    for (int64_t t = 0; t <= 7200; t++) {                   // minutes 0..119 closed, 120 open
+        sample_t smp = { t * 1000000, 21.0 + (double)(t % 60) * 0.01, 101325.0, 45.0 };
+        history_add(&smp, 0);
+        snapshot_set_inside(&smp, NULL, NULL, NULL);
+    }
+    const char *r = snapshot_fetch("/api/snapshot?minutes=60", NULL);
+    if (!strstr(r, "200 OK") || !snapshot_etag(r)) return -1;
+    const char *minute = strstr(r, "\"minute\":[60,61,");
+    if (!minute || !strstr(minute, ",119],\"n\":[60,60,") || !strstr(r, "\"t_max_cC\":[2159,")) return -1;
+    if (!strstr(r, "\"health\":{\"uptime_s\":")) return -1;
+    if (!strstr(snapshot_fetch("/api/snapshot?minutes=60", s_inm), "304 Not Modified") || strstr(s_snap, "{\"boot\""))
+        return -1;
+    r = snapshot_fetch("/api/snapshot?minutes=5", s_inm);    // another N: another document
+    if (!strstr(r, "200 OK") || !strstr(r, "\"minute\":[115,116,117,118,119]")) return -1;
+    snapshot_etag(r);
+    sample_t smp = { 7201LL * 1000000, 21.5, 101325.0, 45.0 };
+    snapshot_set_inside(&smp, NULL, NULL, NULL);
+    if (!strstr(snapshot_fetch("/api/snapshot?minutes=5", s_inm), "200 OK")) return -1;
+    if (!strstr(snapshot_fetch("/api/snapshot?minutes=61", NULL), "400 Bad Request")) return -1;
+    if (!strstr(snapshot_fetch("/api/snapshot?minutes=x", NULL), "400 Bad Request")) return -1;
+    r = snapshot_fetch("/api/snapshot?minutes=0", NULL);
+    if (!strstr(r, "\"history\":{\"minutes\":0,\"minute\":[],")) return -1;
+    snapshot_etag(snapshot_fetch("/api/snapshot", NULL));   // the benchmarks' default document
+    return 0;
+}
+
+// Check the bounds stated in psychro.h; prints the measured maxima.
+static int check_psychro(void)
+{
+    double e_exp = 0, e_log = 0, e_dew = 0, e_ah = 0, e_w = 0;
+    for (float x = -80.0f; x <= 80.0f; x += 0.001f) {
+        double r = fabs(psy_expf(x) / exp((double)x) - 1);
+        if (r > e_exp) e_exp = r;
+    }
+    for (float x = 1e-3f; x < 1e3f; x *= 1.00001f) {
+        double d = fabs(psy_logf(x) - log((double)x));
+        if (d > e_log) e_log = d;
+    }
+    for (double T = -40; T <= 85; T += 0.25) {
+        for (double RH = 1; RH <= 100; RH += 0.5) {
+            double dew, ah, w, hi;
+            psychro_t f;
+            psychro_ref(T, RH, 101325.0, &dew, &ah, &w, &hi);
+            psychro_compute((float)T, (float)RH, 101325.0f, &f);
+            if (fabs(f.dew_C - dew) > e_dew) e_dew = fabs(f.dew_C - dew);
+            if (fabs(f.abs_g_m3 / ah - 1) > e_ah) e_ah = fabs(f.abs_g_m3 / ah - 1);
+            if (w > 0 && w < 1e4 && fabs(f.ratio_g_kg / w - 1) > e_w) e_w = fabs(f.ratio_g_kg / w - 1);
+        }
+    }
+    fprintf(stderr, "psychro accuracy: expf %.2e rel, logf %.2e abs, dew point %.2e C, abs humidity %.2e rel, "
+                    "humidity ratio %.2e rel\n", e_exp, e_log, e_dew, e_ah, e_w);
+    return e_exp < 5e-7 && e_log < 5e-7 && e_dew < 1e-3 && e_ah < 1e-5 && e_w < 1e-5 ? 0 : -1;
+}
+
+// One or more 3 h shapes (Pa 3 h ago, 90 min ago, now) per WMO 0200 code.
+static int check_baro(void)
+{
+    static const struct { float p3, p90, p0; uint8_t code; } cases[] = {
+        { 1000, 1100, 1000, 0 }, { 1000, 1100, 1050, 0 },
+        { 1000, 1100, 1105, 1 }, { 1000, 1100, 1120, 1 },
+        { 1000, 1050, 1100, 2 }, { 1000, 1004, 1012, 2 },
+        { 1000,  950, 1100, 3 }, { 1000, 1000, 1100, 3 }, { 1000, 1020, 1100, 3 },
+        { 1000, 1000, 1000, 4 }, { 1000, 1005,  999, 4 },
+        { 1000,  900, 1000, 5 }, { 1000,  900,  950, 5 },
+        { 1000,  900,  895, 6 }, { 1000,  900,  880, 6 },
+        { 1000,  950,  900, 7 }, { 1000,  996,  988, 7 },
+        { 1000, 1050,  900, 8 }, { 1000, 1000,  900, 8 }, { 1000,  980,  900, 8 },
+    };
+    int bad = 0;
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        baro_tendency_t t;
+        baro_tendency_classify(cases[i].p3, cases[i].p90, cases[i].p0, &t);
+        if (t.code != cases[i].code) {
+            fprintf(stderr, "baro: %.0f -> %.0f -> %.0f Pa gave code %u, expected %u\n",
+                    cases[i].p3, cases[i].p90, cases[i].p0, t.code, cases[i].code);
+            bad = -1;
+        }
+    }
+    return bad;
+}
+
+static const bench_t BENCHES[] = {
+    { "bme280_compensate_T_double",          b_comp_T },
+    { "bme280_compensate_P_double",          b_comp_P },
+    { "bme280_compensate_H_double",          b_comp_H },
+    { "sample_pipeline_process",             b_pipeline },
+    { "find_key_number/open_meteo_current",  b_find_current },
+    { "find_key_number/open_meteo_hourly_7d", b_find_hourly },
+    { "find_key_number/missing_key_7d",      b_find_missing },
+    { "url_encode/sms_fields",               b_url_encode },
+    { "root_get/render",                     b_root_get },
+    { "api_snapshot/render_10min",           b_api_snapshot_render },
+    { "api_snapshot/cached_10min",           b_api_snapshot_cached },
+    { "api_snapshot/not_modified",           b_api_snapshot_304 },
+    { "sms_eval_alert/in_range",             b_alert_in_range },
+    { "sms_eval_alert/cooldown",             b_alert_cooldown },
+    { "line_protocol/fixed_point_60",        b_lp_fixed },
+    { "line_protocol/snprintf_f_60",         b_lp_snprintf },
+    { "gzip_compress/line_protocol_60",      b_gzip_lp },
+    { "psychro_compute/fast_float",          b_psychro_fast },
+    { "psychro_compute/libm_double",         b_psychro_libm },
+    { "snapshot_get/cached",                 b_snapshot_cached },
+    { "snapshot_get/after_update",           b_snapshot_update },
+    { "trend_add+get/900s_window",           b_trend },
+    { "anomaly_check/3_channels",            b_anomaly },
+    { "fusion_update+get/kalman_4_state",    b_fusion },
+    { "selfheat_apply/t_and_rh",             b_selfheat },
+    { "net_pool_get+put/one_block",          b_net_pool },
+    { "malloc+free/8k_fetch_buffer",         b_malloc_fetch },
+};
+
+// ---- setup ----
+
+static void setup_inputs(void)
+{
+    // Calibration straight from the register model, as bme280_read_calibration() would see it.
+    uint8_t c88[BME280_CALIB_88_LEN], cE1[BME280_CALIB_E1_LEN], reg;
+    bme280_sim_reset();
+    reg = 0x88; bme280_sim_i2c_write(&reg, 1); bme280_sim_i2c_read(c88, sizeof c88);
+    reg = 0xE1; bme280_sim_i2c_write(&reg, 1); bme280_sim_i2c_read(cE1, sizeof cE1);
+    bme280_set_calib_raw(c88, cE1);
+
+    uint32_t x = 12345;   // fixed LCG: identical inputs on every run
+    for (int i = 0; i < N_INPUTS; i++) {
+        x = x * 1664525u + 1013904223u; s_adc_T[i] = 519888 + (int32_t)(x >> 16) % 40000 - 20000;
+        x = x * 1664525u + 1013904223u; s_adc_P[i] = 415148 + (int32_t)(x >> 16) % 40000 - 20000;
+        x = x * 1664525u + 1013904223u; s_adc_H[i] = 30000  + (int32_t)(x >> 16) % 10000 - 5000;
+    }
+
+    for (int k = 0; k < LP_READINGS; k++) {
+        raw_sample_t raw = { (int64_t)k * 1030000, s_adc_T[k], s_adc_P[k], s_adc_H[k] };
+        sample_t smp;
+        sample_pipeline_process(&raw, &smp);
+        reading_from_sample(&smp, 1760000000000LL + k * 1030, (uint32_t)k, &s_readings[k]);
+    }
+    lp_series_prefix(s_lp_prefix, sizeof s_lp_prefix, "climate", "device", "monitor");
+    s_lp_len = 0;
+    for (int k = 0; k < LP_READINGS; k++) {
+        s_lp_len += lp_append_reading(s_lp_text + s_lp_len, sizeof s_lp_text - s_lp_len, s_lp_prefix, &s_readings[k]);
+    }
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    int reps = 30;
+    double min_batch_ms = 5.0;
+    const char *filter = NULL, *label = "", *fixtures = BENCH_FIXTURE_DIR;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)              reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--min-batch-ms") == 0 && i + 1 < argc) min_batch_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)       filter = argv[++i];
+        else if (strcmp(argv[i], "--fixtures") == 0 && i + 1 < argc)     fixtures = argv[++i];
+        else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc)        label = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--reps N] [--min-batch-ms MS] [--filter SUBSTR] "
+                            "[--fixtures DIR] [--label TEXT]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (reps < 2) reps = 2;
+
+    sim_time_init(1.0);
+    esp_log_level_set("*", ESP_LOG_WARN);
+    setup_inputs();
+    if (check_psychro() != 0) {
+        fprintf(stderr, "psychro.c exceeds the error bounds stated in psychro.h\n");
+        return 1;
+    }
+    if (check_baro() != 0) return 1;
+    if (trend_init(900) != ESP_OK || check_trend() != 0) {
+        fprintf(stderr, "trend.c disagrees with a double least-squares fit\n");
+        return 1;
+    }
+    if (check_anomaly() != 0) {
+        fprintf(stderr, "anomaly.c missed a scripted anomaly or flagged normal data\n");
+        return 1;
+    }
+    if (check_fusion() != 0) {
+        fprintf(stderr, "fusion.c did not smooth the scripted room or find its k / equilibrium\n");
+        return 1;
+    }
+    if (check_selfheat() != 0) {
+        fprintf(stderr, "selfheat.c did not remove the scripted sensor warming after calibration\n");
+        return 1;
+    }
+    if (check_net_pool() != 0) {
+        fprintf(stderr, "net_pool.c handed out a bad block or miscounted\n");
+        return 1;
+    }
+    s_selfheat_t_us = 30000LL * 1000000;  // past check_selfheat()'s six hours
+    s_trend_t_us = 40000LL * 1000000;     // past the checks' samples
+
+    s_json_current = load_text(fixtures, "open_meteo_current.json");
+    s_json_hourly  = load_text(fixtures, "open_meteo_hourly_7d.json");
+    if (!s_json_current || !s_json_hourly) {
+        fprintf(stderr, "cannot read Open-Meteo fixtures from %s\n", fixtures);
+        return 1;
+    }
+
+    setenv("SIM_HTTP_PORT", "0", 1);   // ephemeral port; the page is rendered in-process
+    web_start();
+    s_httpd = sim_httpd_last_started();
+    if (!s_httpd) {
+        fprintf(stderr, "web server did not start\n");
+        return 1;
+    }
+
+    if (history_init(CONFIG_APP_HISTORY_MINUTES) != ESP_OK || check_api_snapshot() != 0) {
+        fprintf(stderr, "/api/snapshot got its history, ETag or ?minutes= handling wrong\n");
+        return 1;
+    }
+
+    sms_eval_alert(31.0);   // one real (fixture) send arms the 60 min cooldown for the cooldown bench
+
+    printf("{\n  \"schema\": 1,\n  \"label\": \"%s\",\n  \"reps\": %d,\n  \"results\": [", label, reps);
+    int first = 1;
+    double *samples = malloc(sizeof(double) * (size_t)reps);
+    for (size_t b = 0; b < sizeof BENCHES / sizeof BENCHES[0]; b++) {
+        const bench_t *bn = &BENCHES[b];
+        if (filter && !strstr(bn->name, filter)) continue;
+
+        // Warm up and size the batch so timer resolution is negligible.
+        uint64_t iters = 1;
+        for (;;) {
+            int64_t t0 = host_now_ns();
+            bn->fn(iters);
+            double ms = (double)(host_now_ns() - t0) / 1e6;
+            if (ms >= min_batch_ms || iters >= (1ULL << 32)) break;
+            iters *= (ms < min_batch_ms / 16) ? 8 : 2;
+        }
+
+        double sum = 0.0;
+        for (int r = 0; r < reps; r++) {
+            int64_t t0 = host_now_ns();
+            bn->fn(iters);
+            samples[r] = (double)(host_now_ns() - t0) / (double)iters;
+            sum += samples[r];
+        }
+        double mean = sum / reps, var = 0.0;
+        for (int r = 0; r < reps; r++) var += (samples[r] - mean) * (samples[r] - mean);
+        double sd = sqrt(var / (reps - 1));
+        qsort(samples, (size_t)reps, sizeof(double), cmp_double);
+        double median = (reps & 1) ? samples[reps / 2] : 0.5 * (samples[reps / 2 - 1] + samples[reps / 2]);
+
+        printf("%s\n    {\"name\": \"%s\", \"iters_per_rep\": %llu, \"ns_per_op\": "
+               "{\"mean\": %.3f, \"stddev\": %.3f, \"min\": %.3f, \"median\": %.3f}}",
+               first ? "" : ",", bn->name, (unsigned long long)iters, mean, sd, samples[0], median);
+        fprintf(stderr, "%-40s %10.2f ns/op  +- %6.2f  (min %.2f)\n", bn->name, mean, sd, samples[0]);
+        first = 0;
+    }
+    printf("\n  ]\n}\n");
+    free(samples);
+    return 0;
+}
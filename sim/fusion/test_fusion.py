@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Boot test: the fusion filter starts from a real sample.
+
+    cmake --build build-sim && pytest sim/fusion
+
+Straight after bme280_configure() the data registers still hold their reset
+value (26.46 °C, 820.45 hPa) until the first conversion ends. A read taken
+then primes the filter four degrees off; the next samples are explained as a
+room that exchanges heat at thousands per hour with its equilibrium pinned
+to the outside temperature. climate_sim models the conversion time, so a
+couple of sim minutes after boot the first printed sample must be a measured
+one and the filter must still hold its prior: k near 0.2/h, no equilibrium
+yet, smoothed temperature on the sensor's.
+$SIM_BUILD points at the sim build directory (default build-sim).
+"""
+
+import http.client
+import json
+import os
+import re
+import subprocess
+import time
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+SCALE = 120
+
+
+@pytest.fixture
+def sim(tmp_path):
+    env = dict(os.environ, SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S='3600', SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_MQTT_URI='mqtt://127.0.0.1:1')
+    log = open(tmp_path / 'sim.log', 'w')
+    proc = subprocess.Popen([SIM], env=env, stdout=log, stderr=subprocess.STDOUT)   # a pipe would fill and stall it
+    try:
+        deadline = time.time() + 10
+        while time.time() < deadline:
+            m = re.search(r'listening on port (\d+)', open(log.name).read())
+            if m:
+                break
+            time.sleep(0.02)
+        else:
+            pytest.fail('sim did not start its web server')
+        conn = http.client.HTTPConnection('127.0.0.1', int(m.group(1)), timeout=5)
+        yield conn, log.name
+        conn.close()
+    finally:
+        proc.kill()
+        proc.wait()
+        log.close()
+
+
+def test_fusion_after_boot(sim):
+    conn, log = sim
+    deadline = time.time() + 30
+    while time.time() < deadline:
+        conn.request('GET', '/api/current')
+        doc = json.loads(conn.getresponse().read())
+        if doc['version'] >= 150 and doc['fusion']:           # ~2.5 sim minutes of passes
+            break
+        time.sleep(0.2)
+    else:
+        pytest.fail(f'no fusion estimate: {doc}')
+
+    first = re.search(r'T=(-?[\d.]+) °C  P=([\d.]+) hPa', open(log).read())
+    assert first and abs(float(first.group(1)) - 26.46) > 0.01 and abs(float(first.group(2)) - 820.45) > 0.01, first
+
+    fu = doc['fusion']
+    assert 0.05 < fu['k_per_h'] < 1.0, fu
+    assert fu['t_eq'] is None, fu
+    assert abs(fu['t'] - doc['inside']['t']) < 0.2, (fu, doc['inside'])
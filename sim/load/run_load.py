@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Web server load scenarios: stock vs tuned httpd profile.
+
+Starts climate_sim (HTTPD_DEFAULT_CONFIG) and climate_sim_tuned
+(CONFIG_APP_HTTPD_TUNED, values in sim/CMakeLists.txt) on their own ports,
+runs every scenario through loadgen against both and prints req/s, latency
+percentiles and exhaustion counts side by side.
+
+    run_load.py [--build build-sim] [--duration 5] [--json results.json]
+    run_load.py --target 192.168.1.50:80 --profile device   # one external server
+
+Exits 1 if the tuned profile misses a check in TUNED_CHECKS.
+"""
+
+import argparse
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+# name: loadgen arguments
+SCENARIOS = {
+    'keepalive_12': ['--scenario', 'keepalive', '--conns', '12'],
+    'short_8':      ['--scenario', 'short', '--conns', '8'],
+    'mixed_6':      ['--scenario', 'mixed', '--conns', '6', '--paths', '/:8,/trace:1,/missing:1'],
+    'idle_hold_8':  ['--scenario', 'slowloris', '--idle', '8', '--conns', '4'],
+    'idle_trickle': ['--scenario', 'slowloris', '--idle', '2', '--idle-interval-ms', '3000', '--conns', '4'],
+}
+
+# What the tuned profile must achieve (scenario, description, predicate(tuned, default)).
+TUNED_CHECKS = [
+    ('keepalive_12', 'no socket exhaustion with 12 keep-alive viewers',
+     lambda t, d: t['exhaustion']['total'] == 0),
+    ('short_8', 'no socket exhaustion with 8 clients reconnecting per request',
+     lambda t, d: t['exhaustion']['total'] == 0),
+    ('mixed_6', 'no socket exhaustion on mixed / and API traffic',
+     lambda t, d: t['exhaustion']['total'] == 0),
+    ('idle_hold_8', 'idle sockets cannot lock out new viewers',
+     lambda t, d: t['exhaustion']['total'] == 0 and t['ok'] > 0),
+    # The single httpd task still stalls on each trickling socket until it is
+    # dropped; the profile can only make the drop happen sooner.
+    ('idle_trickle', 'trickling clients are cut off, unlike with the defaults',
+     lambda t, d: t['exhaustion']['idle_dropped'] > d['exhaustion']['idle_dropped']),
+]
+
+PROFILES = {'default': 'climate_sim', 'tuned': 'climate_sim_tuned'}
+
+
+def wait_port(host, port, timeout=10.0):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            with socket.create_connection((host, port), timeout=0.5):
+                return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+
+def run_scenarios(loadgen, host, port, duration):
+    results = {}
+    for name, args in SCENARIOS.items():
+        out = subprocess.run([loadgen, '--host', host, '--port', str(port), '--duration', str(duration),
+                              '--json'] + args, check=True, capture_output=True, text=True).stdout
+        results[name] = json.loads(out)
+        time.sleep(3)   # let idle sockets and timeouts from the last scenario drain
+    return results
+
+
+def print_table(all_results):
+    profiles = list(all_results)
+    print(f"{'scenario':14} {'profile':8} {'req/s':>10} {'p50 ms':>8} {'p99 ms':>8} {'max ms':>9} "
+          f"{'exhaust':>8} {'retries':>8}")
+    for name in SCENARIOS:
+        for p in profiles:
+            r = all_results[p][name]
+            lat = r['latency_ms']
+            print(f"{name:14} {p:8} {r['req_per_s']:10.1f} {lat['p50']:8.2f} {lat['p99']:8.2f} "
+                  f"{lat['max']:9.2f} {r['exhaustion']['total']:8d} {r['exhaustion']['retries']:8d}")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('--build', default=os.path.join(os.path.dirname(__file__), '..', '..', 'build-sim'))
+    ap.add_argument('--duration', type=float, default=5.0)
+    ap.add_argument('--port', type=int, default=18080, help='first local port (sim runs)')
+    ap.add_argument('--target', help='host:port of an already running server (QEMU, device)')
+    ap.add_argument('--profile', default='external', help='label for --target results')
+    ap.add_argument('--json', help='write all results here')
+    args = ap.parse_args()
+
+    loadgen = os.path.join(args.build, 'loadgen')
+    all_results = {}
+
+    if args.target:
+        host, port = args.target.rsplit(':', 1)
+        all_results[args.profile] = run_scenarios(loadgen, host, int(port), args.duration)
+    else:
+        for i, (profile, exe) in enumerate(PROFILES.items()):
+            port = args.port + i
+            env = dict(os.environ, SIM_HTTP_PORT=str(port), SIM_TIME_SCALE='1', SIM_LOG_LEVEL='1')
+            proc = subprocess.Popen([os.path.join(args.build, exe)], env=env,
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            try:
+                if not wait_port('127.0.0.1', port):
+                    sys.exit(f'{exe} did not open port {port}')
+                all_results[profile] = run_scenarios(loadgen, '127.0.0.1', port, args.duration)
+            finally:
+                proc.kill()
+                proc.wait()
+
+    print_table(all_results)
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(all_results, f, indent=1)
+
+    if 'tuned' not in all_results or 'default' not in all_results:
+        return 0
+    failed = 0
+    for name, desc, check in TUNED_CHECKS:
+        ok = check(all_results['tuned'][name], all_results['default'][name])
+        failed += not ok
+        print(f"{'PASS' if ok else 'FAIL'}  {name}: {desc}")
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Static-allocation test: boot RAM budget and a flat heap afterwards.
+
+    cmake --build build-sim && pytest sim/memory
+
+climate_sim_static is the sim built with CONFIG_APP_STATIC_ALLOC. Both it and
+the default climate_sim log the per-subsystem budget at boot ("MEM:" lines);
+the entries must add up to the total and name where the memory comes from.
+With the uplink posting to a local sink (SIM_HTTP_REDIRECT), the static build
+must not move the heap after the first PERF line, and it must boot with at
+least the ring buffers' worth more heap free than the default build.
+$SIM_BUILD points at the sim build directory (default build-sim).
+"""
+
+import http.server
+import os
+import re
+import subprocess
+import threading
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+BUILD = os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim'))
+SCALE = 200
+DURATION_S = 1800
+
+MEM_ROW = re.compile(r'MEM: (\S+)\s+(\d+) B')
+MEM_TOTAL = re.compile(r'MEM: total=(\d+) \((static|heap)\) heap_free=(\d+)')
+PERF_HEAP = re.compile(r'PERF: .* heap_free=(\d+) heap_min=(\d+)')
+
+
+class Sink(http.server.BaseHTTPRequestHandler):
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get('Content-Length', 0)))
+        self.send_response(204)
+        self.end_headers()
+
+    def log_message(self, *args):
+        pass
+
+
+@pytest.fixture(scope='module')
+def sink():
+    srv = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Sink)
+    threading.Thread(target=srv.serve_forever, daemon=True).start()
+    yield srv.server_address[1]
+    srv.shutdown()
+
+
+def run(target, sink_port, tmp_path):
+    env = dict(os.environ, SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S=str(DURATION_S), SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_MQTT_URI='mqtt://127.0.0.1:1',
+               SIM_HTTP_REDIRECT=f'http://127.0.0.1:{sink_port}')
+    path = tmp_path / f'{target}.log'
+    with open(path, 'w') as log:           # a pipe would fill and stall it
+        subprocess.run([os.path.join(BUILD, target)], env=env, stdout=log, stderr=subprocess.STDOUT,
+                       timeout=DURATION_S / SCALE + 30, check=True)
+    text = path.read_text()
+    rows = {m.group(1): int(m.group(2)) for m in MEM_ROW.finditer(text)}
+    total = MEM_TOTAL.search(text)
+    assert total, f'{target}: no budget report'
+    perf = [(int(a), int(b)) for a, b in PERF_HEAP.findall(text)]
+    assert len(perf) >= DURATION_S // 60 - 2, f'{target}: only {len(perf)} PERF lines'
+    return rows, int(total.group(1)), total.group(2), int(total.group(3)), perf
+
+
+def test_budget_and_flat_heap(sink, tmp_path):
+    rows, total, kind, boot_free, perf = run('climate_sim_static', sink, tmp_path)
+    assert kind == 'static'
+    assert sum(rows.values()) == total
+    for name in ('mqtt', 'uplink', 'weather', 'trace', 'history', 'trend'):
+        assert rows.get(name, 0) > 0, f'{name} missing from {rows}'
+
+    steady = perf[0]
+    assert all(p == steady for p in perf), f'heap moved after boot: {perf}'
+
+    d_rows, d_total, d_kind, d_boot_free, _ = run('climate_sim', sink, tmp_path)
+    assert d_kind == 'heap'
+    assert sum(d_rows.values()) == d_total
+    rings = rows['trace'] + rows['history'] + rows['trend']
+    assert boot_free - d_boot_free >= rings, (boot_free, d_boot_free, rings)
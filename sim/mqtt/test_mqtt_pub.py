@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""MQTT publisher tests: climate_sim against a local mosquitto broker.
+
+    cmake --build build-sim && pytest sim/mqtt
+
+Each test starts its own mosquitto on a free port and subscribes to the sim's
+topics with a minimal MQTT 3.1.1 client (no paho dependency). Skipped when
+mosquitto is not on PATH (or $MOSQUITTO). $SIM_BUILD points at the sim build
+directory (default build-sim).
+"""
+
+import os
+import shutil
+import socket
+import struct
+import subprocess
+import threading
+import time
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+MOSQUITTO = os.environ.get('MOSQUITTO') or shutil.which('mosquitto')
+TOPIC = 'climate/sim'      # CONFIG_APP_MQTT_TOPIC in sim/shim/include/sdkconfig.h
+BATCH = 10                 # CONFIG_APP_MQTT_BATCH
+
+pytestmark = pytest.mark.skipif(not MOSQUITTO, reason='mosquitto not installed')
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+def decode_batch(payload):
+    """reading_codec.h batch -> [(seq, unix_ms, T_C, P_Pa, H_RH)]"""
+    magic, version, count, seq, t = struct.unpack_from('<2sBBIq', payload)
+    assert magic == b'CR' and version == 1 and len(payload) == 16 + 9 * count
+    out = []
+    for k in range(count):
+        dt, T, p0, p1, p2, H = struct.unpack_from('<Hh3BH', payload, 16 + 9 * k)
+        t += dt
+        out.append((seq + k, t, T / 100, (p0 | p1 << 8 | p2 << 16) / 10, H / 100))
+    return out
+
+
+class Subscriber:
+    """Collects every message on TOPIC/# in a background thread."""
+
+    def __init__(self, port):
+        self.msgs = []                        # (topic, payload, retain)
+        self.sock = socket.create_connection(('127.0.0.1', port), timeout=5)
+        cid = b'pytest-sub'
+        body = struct.pack('>H4sBBH', 4, b'MQTT', 4, 0x02, 60) + struct.pack('>H', len(cid)) + cid
+        self._send(0x10, body)
+        assert self._read()[0] == 0x20
+        flt = (TOPIC + '/#').encode()
+        self._send(0x82, struct.pack('>HH', 1, len(flt)) + flt + b'\x01')
+        assert self._read()[0] == 0x90
+        self.sock.settimeout(None)
+        threading.Thread(target=self._loop, daemon=True).start()
+
+    def _send(self, hdr, body):
+        n, rem = len(body), bytearray()
+        while True:
+            rem.append((n & 0x7F) | (0x80 if n > 0x7F else 0))
+            n >>= 7
+            if not n:
+                break
+        self.sock.sendall(bytes([hdr]) + bytes(rem) + body)
+
+    def _recv(self, n):
+        buf = b''
+        while len(buf) < n:
+            chunk = self.sock.recv(n - len(buf))
+            if not chunk:
+                raise ConnectionError
+            buf += chunk
+        return buf
+
+    def _read(self):
+        hdr = self._recv(1)[0]
+        n, shift = 0, 0
+        while True:
+            b = self._recv(1)[0]
+            n |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        return hdr, self._recv(n)
+
+    def _loop(self):
+        try:
+            while True:
+                hdr, body = self._read()
+                if hdr >> 4 != 3:
+                    continue
+                tl = struct.unpack_from('>H', body)[0]
+                i = 2 + tl
+                if hdr & 0x06:
+                    self._send(0x40, body[i:i + 2])   # PUBACK
+                    i += 2
+                self.msgs.append((body[2:2 + tl].decode(), body[i:], bool(hdr & 1)))
+        except (ConnectionError, OSError):
+            pass
+
+    def readings(self):
+        return [r for t, p, _ in list(self.msgs) if t == TOPIC + '/readings' for r in decode_batch(p)]
+
+    def status(self):
+        return [p.decode() for t, p, _ in list(self.msgs) if t == TOPIC + '/status']
+
+    def close(self):
+        self.sock.close()
+
+
+@pytest.fixture
+def broker(tmp_path):
+    port = free_port()
+    conf = tmp_path / 'mosquitto.conf'
+    conf.write_text(f'listener {port} 127.0.0.1\nallow_anonymous true\npersistence false\n')
+    proc = subprocess.Popen([MOSQUITTO, '-c', str(conf)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    deadline = time.monotonic() + 5
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection(('127.0.0.1', port), timeout=0.2).close()
+            break
+        except OSError:
+            time.sleep(0.05)
+    yield port
+    proc.kill()
+    proc.wait()
+
+
+def run_sim(port, flash_dir, scale, duration=None):
+    env = dict(os.environ, SIM_MQTT_URI=f'mqtt://127.0.0.1:{port}', SIM_FLASH_DIR=str(flash_dir),
+               SIM_TIME_SCALE=str(scale), SIM_HTTP_PORT='0', SIM_LOG_LEVEL='2')
+    if duration:
+        env['SIM_DURATION_S'] = str(duration)
+    return subprocess.Popen([SIM], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def wait_for(pred, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if pred():
+            return True
+        time.sleep(0.05)
+    return pred()
+
+
+def test_batches_with_qos1(broker, tmp_path):
+    sub = Subscriber(broker)
+    sim = run_sim(broker, tmp_path, scale=20)
+    try:
+        assert wait_for(lambda: len(sub.readings()) >= 5 * BATCH, 20)
+    finally:
+        sim.kill()
+        sim.wait()
+
+    batches = [decode_batch(p) for t, p, _ in sub.msgs if t.endswith('/readings')]
+    assert all(len(b) == BATCH for b in batches), [len(b) for b in batches]
+    seqs = [r[0] for r in sub.readings()]
+    assert seqs == list(range(len(seqs)))
+    for seq, unix_ms, T, P, H in sub.readings():
+        assert -40 < T < 85 and 30000 < P < 110000 and 0 <= H <= 100
+    assert 'online' in sub.status()
+    assert wait_for(lambda: sub.status()[-1] == 'offline', 5), 'will not published after the sim died'
+    sub.close()
+
+
+def test_offline_backlog_survives_reboot(broker, tmp_path):
+    # First boot: broker unreachable for ~600 sim s, so the 300-reading RAM
+    # backlog spills to the flash file; the process then exits like a reset.
+    dead_port = free_port()
+    run_sim(dead_port, tmp_path, scale=1000, duration=600).wait(timeout=30)
+    assert (tmp_path / 'backlog.bin').exists()
+
+    # Second boot with the broker up: the flash backlog drains first, and
+    # numbering continues where flash left off.
+    sub = Subscriber(broker)
+    sim = run_sim(broker, tmp_path, scale=20)
+    try:
+        assert wait_for(lambda: len(sub.readings()) >= 400 + 3 * BATCH, 30)
+    finally:
+        sim.kill()
+        sim.wait()
+    sub.close()
+
+    seqs = sorted(set(r[0] for r in sub.readings()))
+    assert seqs[0] == 0, 'readings from before the reboot were lost'
+    assert seqs == list(range(seqs[-1] + 1)), 'gap in sequence numbers'
+    assert seqs[-1] >= 400
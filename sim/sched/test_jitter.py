@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Sensor loop jitter while the web server is under load.
+
+    cmake --build build-sim && pytest sim/sched
+
+climate_sim_tuned runs in real time (scale 1) with a PERF report every 5 s
+while loadgen keeps 12 clients on /, /api/current and /trace. Every report
+window inside the load must show the sampling interval within 1 ms of its
+1030 ms period, with no sample lost.
+The sim runs each task as a plain host thread (no FreeRTOS priorities or
+cores), so this checks that nothing the web server does holds up the sensor
+loop; the core/priority split itself only acts on the target.
+$SIM_BUILD points at the sim build directory (default build-sim).
+"""
+
+import json
+import os
+import re
+import subprocess
+import time
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+BUILD = os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim'))
+SIM = os.path.join(BUILD, 'climate_sim_tuned')
+LOADGEN = os.path.join(BUILD, 'loadgen')
+REPORT_S = 5
+LOAD_S = 25
+JITTER_LIMIT_US = 1000
+PERF = re.compile(r'PERF: uptime_ms=(\d+) samples=(\d+) .* jitter_win_max_us=(\d+)')
+
+
+def test_jitter_under_web_load(tmp_path):
+    env = dict(os.environ, SIM_TIME_SCALE='1', SIM_DURATION_S=str(LOAD_S + 15), SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_PERF_REPORT_S=str(REPORT_S), SIM_MQTT_URI='mqtt://127.0.0.1:1')
+    log = open(tmp_path / 'sim.log', 'w')
+    proc = subprocess.Popen([SIM], env=env, stdout=log, stderr=subprocess.STDOUT)   # a pipe would fill and stall it
+    try:
+        deadline = time.time() + 10
+        while not (m := re.search(r'listening on port (\d+)', open(log.name).read())):
+            assert time.time() < deadline, 'sim did not start its web server'
+            time.sleep(0.02)
+        port = m.group(1)
+        time.sleep(REPORT_S + 2)                          # past the boot window
+        t0 = len(PERF.findall(open(log.name).read()))
+        out = subprocess.run([LOADGEN, '--port', port, '--scenario', 'mixed', '--conns', '12',
+                              '--paths', '/:8,/api/current:2,/trace:1', '--duration', str(LOAD_S), '--json'],
+                             check=True, capture_output=True, text=True, timeout=LOAD_S + 30).stdout
+        load = json.loads(out)
+    finally:
+        proc.kill()
+        proc.wait()
+    perf = [tuple(map(int, m)) for m in PERF.findall(open(log.name).read())]
+    # windows that started after the load did: the first one after t0 opened before it
+    under_load = perf[t0 + 1:]
+    assert load['ok'] > 1000 and load['http_5xx'] == 0, load
+    assert len(under_load) >= LOAD_S // REPORT_S - 2, perf
+    for (up0, n0, _), (up1, n1, win_max) in zip(perf[t0:], under_load):
+        assert win_max < JITTER_LIMIT_US, f'{win_max} us at uptime {up1} ms'
+        assert n1 - n0 == round((up1 - up0) / 1030), (up0, n0, up1, n1)   # no sample lost or doubled
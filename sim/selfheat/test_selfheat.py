@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Self-heating test: reference calibration and the adaptive sampling rate.
+
+    cmake --build build-sim && pytest sim/selfheat
+
+climate_sim_adaptive runs a steady 22 °C / 45 %RH room with a sensor that
+warms itself by 0.8 °C + 0.1 °C per conversion/s (SIM_BME280_SELFHEAT, time
+constant 300 s as CONFIG_APP_SELFHEAT_TAU_S). The shipped model is zero, so
+the readings start high. The loop drops to forced-mode sampling every 10 s
+on the steady room; one reference reading there fits the offset, the step
+it causes sends the loop back to 1 Hz, and a second reading there (before
+the sensor has settled; the fit uses the lagged rate) separates the per-Hz
+term. Both terms must come out of the fit, and once the loop is
+slow again the corrected temperature and humidity must match the room. $SIM_BUILD
+points at the sim build directory (default build-sim).
+"""
+
+import json
+import os
+import re
+import subprocess
+import time
+import urllib.error
+import urllib.request
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim_adaptive')
+SCALE = 200
+ROOM_T, ROOM_RH = 22.0, 45.0
+OFFSET, PER_HZ, TAU_S = 0.8, 0.1, 300
+
+
+def start_sim(log):
+    env = dict(os.environ, SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S='14000', SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_MQTT_URI='mqtt://127.0.0.1:1',
+               SIM_BME280_WAVES=f'T={ROOM_T},0,0,0,0.02;H={ROOM_RH},0,0,0,0.3',
+               SIM_BME280_SELFHEAT=f'{OFFSET},{PER_HZ},{TAU_S}')
+    proc = subprocess.Popen([SIM], env=env, stdout=log, stderr=subprocess.STDOUT)   # a pipe would fill and stall it
+    deadline = time.time() + 10
+    while time.time() < deadline:
+        m = re.search(r'listening on port (\d+)', open(log.name).read())
+        if m:
+            return proc, int(m.group(1))
+        time.sleep(0.02)
+    proc.kill()
+    pytest.fail('sim did not start its web server')
+
+
+def current(port):
+    with urllib.request.urlopen(f'http://127.0.0.1:{port}/api/current', timeout=5) as r:
+        return json.load(r)
+
+
+def calibrate(port, ref):
+    req = urllib.request.Request(f'http://127.0.0.1:{port}/api/calibrate?t={ref}', method='POST')
+    with urllib.request.urlopen(req, timeout=5) as r:
+        return json.load(r)['selfheat']
+
+
+def wait_rate(port, slow, timeout_s):
+    deadline = time.time() + timeout_s / SCALE
+    while (current(port)['selfheat']['rate_hz'] < 0.2) != slow:
+        assert time.time() < deadline, f'sampling did not go {"slow" if slow else "fast"}'
+        time.sleep(0.05)
+
+
+def test_calibration_and_slow_sampling(tmp_path):
+    log = open(tmp_path / 'sim.log', 'w')
+    proc, port = start_sim(log)
+    try:
+        wait_rate(port, True, 3600)             # steady room: forced mode every 10 s
+        time.sleep(5 * TAU_S / SCALE)
+        cur = current(port)
+        raw_bias = cur['inside']['t'] - ROOM_T
+        assert abs(raw_bias - (OFFSET + PER_HZ * 0.1)) < 0.1, cur
+
+        sh = calibrate(port, ROOM_T)            # one rate: offset only
+        assert sh['points'] == 1 and sh['c_per_hz'] == 0
+        assert abs(sh['offset'] - (OFFSET + PER_HZ * 0.1)) < 0.05, sh
+
+        wait_rate(port, False, 120)             # the corrected reading stepped: back to 1 Hz
+        time.sleep(2 * TAU_S / SCALE)           # not settled: the fit uses the lagged rate
+        sh = calibrate(port, ROOM_T)            # second rate: both terms
+        assert sh['points'] == 2
+        assert abs(sh['offset'] - OFFSET) < 0.05 and abs(sh['c_per_hz'] - PER_HZ) < 0.02, sh
+        with pytest.raises(urllib.error.HTTPError) as e:
+            calibrate(port, ROOM_T - 10)        # a 10 °C bias is not self-heating: rejected, fit kept
+        assert e.value.code == 400
+        assert current(port)['selfheat']['points'] == 2
+
+        wait_rate(port, True, 3600)
+        time.sleep(5 * TAU_S / SCALE)
+        cur = current(port)
+        assert abs(cur['inside']['t'] - ROOM_T) < 0.1, cur
+        assert abs(cur['inside']['rh'] - ROOM_RH) < 1.2, cur          # uncorrected: ~42.8
+        assert abs(cur['selfheat']['bias'] - (OFFSET + PER_HZ * 0.1)) < 0.05, cur
+        print(f'bias {raw_bias:+.2f} °C uncalibrated -> {cur["inside"]["t"] - ROOM_T:+.3f} °C calibrated')
+    finally:
+        proc.kill()
+        proc.wait()
+        log.close()
@@ -0,0 +1,9 @@
+/*
+ * Host shim: esp_crt_bundle.h
+ * TLS is not simulated; the attach hook exists so client configs compile.
+ */
+
+#pragma once
+#include "esp_err.h"
+
+esp_err_t esp_crt_bundle_attach(void *conf);
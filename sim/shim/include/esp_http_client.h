@@ -0,0 +1,86 @@
+/*
+ * Host shim: esp_http_client.h
+ * Plain HTTP/1.1 over host sockets with keep-alive reuse across perform()
+ * calls. https:// requests are either redirected to SIM_HTTPS_REDIRECT
+ * (e.g. "http://127.0.0.1:9000", original Host header kept) or answered
+ * from built-in fixtures for api.open-meteo.com and api.twilio.com.
+ * SIM_HTTP_REDIRECT does the same for http:// URLs.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum {
+    HTTP_METHOD_GET = 0,
+    HTTP_METHOD_POST,
+    HTTP_METHOD_PUT,
+    HTTP_METHOD_PATCH,
+    HTTP_METHOD_DELETE,
+    HTTP_METHOD_HEAD,
+    HTTP_METHOD_MAX,
+} esp_http_client_method_t;
+
+typedef enum {
+    HTTP_AUTH_TYPE_NONE = 0,
+    HTTP_AUTH_TYPE_BASIC,
+    HTTP_AUTH_TYPE_DIGEST,
+} esp_http_client_auth_type_t;
+
+typedef enum {
+    HTTP_TRANSPORT_UNKNOWN = 0,
+    HTTP_TRANSPORT_OVER_TCP,
+    HTTP_TRANSPORT_OVER_SSL,
+} esp_http_client_transport_t;
+
+typedef struct {
+    const char *url;
+    const char *host;
+    int         port;
+    const char *username;
+    const char *password;
+    esp_http_client_auth_type_t auth_type;
+    const char *path;
+    const char *query;
+    const char *cert_pem;
+    esp_http_client_method_t method;
+    int         timeout_ms;
+    bool        disable_auto_redirect;
+    int         max_redirection_count;
+    void       *event_handler;
+    esp_http_client_transport_t transport_type;
+    int         buffer_size;
+    int         buffer_size_tx;
+    void       *user_data;
+    bool        is_async;
+    bool        skip_cert_common_name_check;
+    esp_err_t (*crt_bundle_attach)(void *conf);
+    bool        keep_alive_enable;
+    int         keep_alive_idle;
+    int         keep_alive_interval;
+    int         keep_alive_count;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config);
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value);
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key);
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len);
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client, int timeout_ms);
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+int       esp_http_client_write(esp_http_client_handle_t client, const char *buffer, int len);
+int64_t   esp_http_client_fetch_headers(esp_http_client_handle_t client);
+bool      esp_http_client_is_chunked_response(esp_http_client_handle_t client);
+int       esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+int       esp_http_client_read_response(esp_http_client_handle_t client, char *buffer, int len);
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client, int *len);
+int       esp_http_client_get_status_code(esp_http_client_handle_t client);
+int64_t   esp_http_client_get_content_length(esp_http_client_handle_t client);
+bool      esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
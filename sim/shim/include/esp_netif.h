@@ -0,0 +1,12 @@
+/*
+ * Host shim: esp_netif.h
+ * Only the types app code touches; the sim network is the host stack.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { esp_ip4_addr_t ip, netmask, gw; } esp_netif_ip_info_t;
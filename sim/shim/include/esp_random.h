@@ -0,0 +1,15 @@
+/*
+ * Host shim: esp_random.h
+ * Hardware RNG replaced by the kernel's.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <sys/random.h>
+
+static inline uint32_t esp_random(void)
+{
+    uint32_t v = 0;
+    getrandom(&v, sizeof v, 0);
+    return v;
+}
@@ -0,0 +1,18 @@
+/*
+ * Host shim: esp_rom_crc.h
+ * CRC-32 (IEEE 802.3, reflected) with the ROM function's conventions:
+ * pass 0 to start, or the previous result to continue.
+ */
+
+#pragma once
+#include <stdint.h>
+
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
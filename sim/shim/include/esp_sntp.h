@@ -0,0 +1,14 @@
+/*
+ * Host shim: esp_sntp.h
+ * The host clock is already valid; SNTP calls are no-ops.
+ */
+
+#pragma once
+#include <stdbool.h>
+
+#define ESP_SNTP_OPMODE_POLL 0
+
+static inline bool esp_sntp_enabled(void) { return true; }
+static inline void esp_sntp_setoperatingmode(int mode) { (void)mode; }
+static inline void esp_sntp_setservername(int idx, const char *server) { (void)idx; (void)server; }
+static inline void esp_sntp_init(void) { }
@@ -0,0 +1,13 @@
+/*
+ * Host shim: esp_system.h
+ * Heap figures come from glibc's allocator statistics against a nominal
+ * heap size (SIM_HEAP_BYTES), so leaks show up as a falling free count.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);   // low-water mark of the calls above
+void     esp_restart(void);
@@ -0,0 +1,38 @@
+/*
+ * Host shim: freertos/FreeRTOS.h
+ * Tick types and conversion macros. Ticks run on the scaled sim clock
+ * (see sim_time.h), so a 1 s vTaskDelay() lasts 1 ms at 1000x.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint8_t  StackType_t;     // as ESP-IDF: stack depths are in bytes
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define configTICK_RATE_HZ   CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS   ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY        ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define pdTICKS_TO_MS(t)     ((TickType_t)((uint64_t)(t) * 1000U / configTICK_RATE_HZ))
+
+// Critical sections: one process-wide recursive lock stands in for the
+// per-mux spinlock (cheap enough for the few short sections the firmware has).
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+void sim_enter_critical(void);
+void sim_exit_critical(void);
+#define portENTER_CRITICAL(mux) ((void)(mux), sim_enter_critical())
+#define portEXIT_CRITICAL(mux)  ((void)(mux), sim_exit_critical())
+#define taskENTER_CRITICAL(mux) portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)  portEXIT_CRITICAL(mux)
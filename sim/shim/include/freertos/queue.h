@@ -0,0 +1,19 @@
+/*
+ * Host shim: freertos/queue.h
+ * Fixed-size item queues (items copied in and out, as FreeRTOS does) on a
+ * pthread mutex/condvar. Timeouts are in ticks of the sim clock.
+ */
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_queue *QueueHandle_t;
+
+typedef struct { uint8_t opaque[192]; } StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buf);
+BaseType_t    xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks);   // to the back
+BaseType_t    xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t q);
+void          vQueueDelete(QueueHandle_t q);
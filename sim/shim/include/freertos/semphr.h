@@ -0,0 +1,21 @@
+/*
+ * Host shim: freertos/semphr.h
+ * Mutexes and counting/binary semaphores on pthread primitives. Timeouts are
+ * in ticks of the sim clock.
+ */
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_sem *SemaphoreHandle_t;
+
+typedef struct { uint8_t opaque[128]; } StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
@@ -0,0 +1,31 @@
+/*
+ * Host shim: freertos/task.h
+ * Tasks map to detached pthreads; delays sleep on the scaled sim clock.
+ * Priorities and core affinity are accepted and ignored. The static
+ * variants keep the start record in the caller's TCB and run on a host
+ * stack (the target-sized buffer is too small for host libc).
+ */
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+typedef struct { uint8_t opaque[64]; } StaticTask_t;
+
+#define tskNO_AFFINITY   0x7FFFFFFF
+#define tskIDLE_PRIORITY 0
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t prio, TaskHandle_t *out);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *out, BaseType_t core_id);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                           UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb,
+                                           BaseType_t core_id);
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
+void       vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
@@ -0,0 +1,89 @@
+/*
+ * Host shim: mqtt_client.h (esp-mqtt)
+ * MQTT 3.1.1 over a host TCP socket: CONNECT with clean-session flag, will
+ * and credentials, PUBLISH QoS 0/1, PINGREQ keep-alive and auto-reconnect.
+ * Events are delivered on the client's own thread like the esp-mqtt task.
+ * No subscriptions, TLS or outbox: publish() returns -1 while disconnected.
+ * SIM_MQTT_URI overrides broker.address.uri.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+typedef struct esp_mqtt_client *esp_mqtt_client_handle_t;
+
+typedef enum {
+    MQTT_EVENT_ANY = -1,
+    MQTT_EVENT_ERROR = 0,
+    MQTT_EVENT_CONNECTED,
+    MQTT_EVENT_DISCONNECTED,
+    MQTT_EVENT_SUBSCRIBED,
+    MQTT_EVENT_UNSUBSCRIBED,
+    MQTT_EVENT_PUBLISHED,
+    MQTT_EVENT_DATA,
+    MQTT_EVENT_BEFORE_CONNECT,
+    MQTT_EVENT_DELETED,
+} esp_mqtt_event_id_t;
+
+typedef struct {
+    esp_mqtt_event_id_t      event_id;
+    esp_mqtt_client_handle_t client;
+    char *data;
+    int   data_len;
+    char *topic;
+    int   topic_len;
+    int   msg_id;
+    int   session_present;
+} esp_mqtt_event_t;
+typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
+
+typedef struct {
+    struct {
+        struct {
+            const char *uri;              // mqtt://host[:port]
+        } address;
+    } broker;
+    struct {
+        const char *username;
+        const char *client_id;
+        struct {
+            const char *password;
+        } authentication;
+    } credentials;
+    struct {
+        struct {
+            const char *topic;
+            const char *msg;
+            int msg_len;                  // 0 = strlen(msg)
+            int qos;
+            int retain;
+        } last_will;
+        bool disable_clean_session;
+        int  keepalive;                   // seconds, 0 = 120
+    } session;
+    struct {
+        int  reconnect_timeout_ms;        // 0 = 10000
+        int  timeout_ms;                  // 0 = 10000
+        bool disable_auto_reconnect;
+    } network;
+    struct {
+        int priority;
+        int stack_size;
+    } task;
+    struct {
+        int size;
+        int out_size;
+    } buffer;
+} esp_mqtt_client_config_t;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client);
+int       esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                                  int len, int qos, int retain);
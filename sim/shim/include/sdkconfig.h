@@ -0,0 +1,73 @@
+/*
+ * Host shim: sdkconfig.h
+ * Fixed configuration for the sim build (what menuconfig generates on target).
+ */
+
+#pragma once
+#include <stdlib.h>
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_FREERTOS_HZ 100
+
+#define CONFIG_WIFI_PASSWORD "sim"
+#define CONFIG_TWILIO_ACCOUNT_SID "ACsim"
+#define CONFIG_TWILIO_AUTH_TOKEN "sim"
+#define CONFIG_TWILIO_FROM_NUMBER "+15550000000"
+#define CONFIG_ALERT_TO_NUMBER "+15550000001"
+
+#define CONFIG_APP_TRACE_RECORDS 1024
+#define CONFIG_APP_PERF_REPORT_S (getenv("SIM_PERF_REPORT_S") ? atoi(getenv("SIM_PERF_REPORT_S")) : 60)
+#define CONFIG_APP_NET_BLOCK_BYTES 2048
+#define CONFIG_APP_NET_POOL_BLOCKS 4
+#define CONFIG_APP_SENSOR_CORE 1
+#define CONFIG_APP_SENSOR_PRIORITY 10
+#define CONFIG_APP_NET_CORE 0
+#define CONFIG_APP_NET_PRIORITY 5
+#define CONFIG_APP_WEB_PRIORITY 4
+#define CONFIG_APP_SNAPSHOT_MINUTES 10
+#define CONFIG_APP_SNAPSHOT_MAX_MINUTES 60
+
+#define CONFIG_APP_MQTT_BROKER_URI "mqtt://127.0.0.1:1883"   // SIM_MQTT_URI overrides
+#define CONFIG_APP_MQTT_USERNAME ""
+#define CONFIG_APP_MQTT_PASSWORD ""
+#define CONFIG_APP_MQTT_CLIENT_ID "climate-sim"
+#define CONFIG_APP_MQTT_TOPIC "climate/sim"
+#define CONFIG_APP_MQTT_BATCH 10
+#define CONFIG_APP_MQTT_BATCH_MAX_AGE_S 30
+#define CONFIG_APP_MQTT_QOS 1
+#define CONFIG_APP_MQTT_KEEPALIVE_S 120
+#define CONFIG_APP_MQTT_BACKLOG_RAM 300
+#define CONFIG_APP_MQTT_BACKLOG_PARTITION "backlog"
+
+#define CONFIG_APP_UPLINK_URL "http://127.0.0.1:8086/api/v2/write?org=sim&bucket=climate&precision=ms"  // SIM_HTTP_REDIRECT
+#define CONFIG_APP_UPLINK_AUTH "Token sim"
+#define CONFIG_APP_UPLINK_FORMAT_INFLUX 1
+#define CONFIG_APP_UPLINK_GZIP 1
+#define CONFIG_APP_UPLINK_MEASUREMENT "climate"
+#define CONFIG_APP_UPLINK_DEVICE "sim"
+#define CONFIG_APP_UPLINK_PERIOD_S 60
+#define CONFIG_APP_UPLINK_MAX_BATCH 120
+#define CONFIG_APP_UPLINK_RETRY_MAX_S 300
+#define CONFIG_APP_UPLINK_BACKLOG_RAM 300
+#define CONFIG_APP_UPLINK_BACKLOG_PARTITION ""   // "backlog" belongs to MQTT
+
+#define CONFIG_APP_UDP_COLLECTOR (getenv("SIM_UDP_COLLECTOR") ? getenv("SIM_UDP_COLLECTOR") : "")   // off unless set
+#define CONFIG_APP_UDP_DEVICE_ID 7
+#define CONFIG_APP_UDP_BACKLOG_RAM 300
+#define CONFIG_APP_UDP_BACKLOG_PARTITION ""
+
+#define CONFIG_APP_STATION_ALTITUDE_M (getenv("SIM_ALTITUDE_M") ? atoi(getenv("SIM_ALTITUDE_M")) : 0)
+#define CONFIG_APP_HISTORY_MINUTES 240
+#define CONFIG_APP_TREND_WINDOW_S 900
+#define CONFIG_APP_ALERT_FORECAST_MIN 30
+#define CONFIG_APP_ANOMALY_Z_X10 60
+#define CONFIG_APP_ANOMALY_STUCK_S 300
+#define CONFIG_APP_ALERT_SUPPRESS_ANOMALIES 1   // device default n; the sim exercises it
+#define CONFIG_APP_FUSION 1
+#define CONFIG_APP_ALERT_USE_FUSED 1   // device default n; the sim exercises it
+#define CONFIG_APP_SAMPLE_SLOW_S 10
+#define CONFIG_APP_SELFHEAT 1
+#define CONFIG_APP_SELFHEAT_OFFSET_MC 0
+#define CONFIG_APP_SELFHEAT_MC_PER_HZ 0
+#define CONFIG_APP_SELFHEAT_TAU_S 300
+#define CONFIG_APP_SELFHEAT_CALIBRATE_API 1   // sim/selfheat posts reference readings (device default n)
@@ -0,0 +1,27 @@
+/*
+ * Sim-only extensions to the esp_http_server shim.
+ * - sim_httpd_invoke(): run a registered handler in-process (no socket) and
+ *   capture the full response; used by benchmarks and tests.
+ * - sim_httpd_stats(): session counters for the load harness.
+ * - sim_httpd_last_started(): handle of the newest server, for code (like
+ *   web_start()) that keeps its handle private.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+typedef struct {
+    uint32_t accepted;        // connections accepted
+    uint32_t rejected;        // accepted then closed because all slots were busy
+    uint32_t lru_purged;      // sessions closed by LRU purge to make room
+    uint32_t requests;        // requests dispatched to handlers
+    uint32_t timeouts;        // sessions closed on recv_wait_timeout
+    uint32_t open_now;        // sessions currently open
+} sim_httpd_stats_t;
+
+esp_err_t sim_httpd_invoke(httpd_handle_t handle, httpd_method_t method, const char *uri,
+                           const char *headers, char *out, size_t out_cap, size_t *out_len);
+void      sim_httpd_stats(httpd_handle_t handle, sim_httpd_stats_t *out);
+httpd_handle_t sim_httpd_last_started(void);
@@ -0,0 +1,14 @@
+/*
+ * Sim clock (host only).
+ * All shim time (ticks, esp_timer, log stamps) derives from one monotonic
+ * clock multiplied by SIM_TIME_SCALE, so the firmware runs N x real time.
+ */
+
+#pragma once
+#include <stdint.h>
+
+void    sim_time_init(double scale);   // call once from main() before app_main()
+double  sim_time_scale(void);
+int64_t sim_time_now_us(void);         // sim microseconds since boot
+void    sim_sleep_us(int64_t sim_us);  // sleep for a sim-time duration
+void    sim_sleep_until_us(int64_t sim_deadline_us);
@@ -0,0 +1,61 @@
+/*
+ * Host shim: heap statistics.
+ * free = SIM_HEAP_BYTES (default 300000, about what an ESP32 app has after
+ * Wi-Fi init) minus bytes glibc reports in use; the minimum is tracked across
+ * calls the way esp_get_minimum_free_heap_size() tracks it across allocations.
+ */
+
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_min_free = UINT32_MAX;
+
+static uint32_t heap_total(void)
+{
+    const char *env = getenv("SIM_HEAP_BYTES");
+    return env ? (uint32_t)strtoul(env, NULL, 0) : 300000u;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+    uint32_t total = heap_total();
+    uint32_t used = mi.uordblks > total ? total : (uint32_t)mi.uordblks;
+    uint32_t free_b = total - used;
+    pthread_mutex_lock(&s_lock);
+    if (free_b < s_min_free) s_min_free = free_b;
+    pthread_mutex_unlock(&s_lock);
+    return free_b;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    uint32_t now = esp_get_free_heap_size();
+    pthread_mutex_lock(&s_lock);
+    uint32_t m = s_min_free < now ? s_min_free : now;
+    pthread_mutex_unlock(&s_lock);
+    return m;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return esp_get_free_heap_size();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return esp_get_free_heap_size();   // host heap does not fragment in a way worth modelling
+}
+
+void esp_restart(void)
+{
+    fflush(stdout);
+    exit(3);
+}
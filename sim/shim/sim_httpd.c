@@ -0,0 +1,625 @@
+/*
+ * Host shim: esp_http_server over host sockets.
+ * One server thread runs a select() loop over the listener and up to
+ * max_open_sockets sessions, like the httpd task on target. A request is read
+ * and handled to completion before the next socket is serviced, so a client
+ * that sends a partial header stalls the server for recv_wait_timeout -- the
+ * same head-of-line behaviour the real server has.
+ */
+
+#include "esp_http_server.h"
+#include "sim_httpd.h"
+#include "esp_log.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static const char *TAG = "httpd";
+
+#define SESS_BUF_LEN (HTTPD_MAX_URI_LEN + HTTPD_MAX_REQ_HDR_LEN + 64)
+#define MAX_RESP_HDRS 16
+
+typedef struct {
+    int      fd;            // -1 when the slot is free
+    uint64_t lru;           // last-use stamp for LRU purge
+    char     buf[SESS_BUF_LEN + 1];
+    size_t   len;           // bytes buffered (head + any body/pipelined bytes)
+} sess_t;
+
+typedef struct {
+    httpd_config_t cfg;
+    int            listen_fd;
+    uint16_t       port;
+    httpd_uri_t   *uris;
+    size_t         n_uris;
+    sess_t        *sess;
+    uint64_t       lru_ctr;
+    volatile bool  stop;
+    pthread_t      th;
+    pthread_mutex_t lock;
+    sim_httpd_stats_t stats;
+} server_t;
+
+typedef struct {
+    server_t   *srv;
+    sess_t     *sess;           // NULL for sim_httpd_invoke()
+    const char *hdrs;           // header lines (after the request line)
+    size_t      hdrs_len;
+    const char *body_pre;       // body bytes already buffered with the head
+    size_t      body_pre_len;
+    size_t      body_left;      // body bytes not yet consumed by the handler
+    char        status[48];
+    const char *type;
+    const char *hdr_k[MAX_RESP_HDRS];
+    const char *hdr_v[MAX_RESP_HDRS];
+    int         n_hdr;
+    bool        head_sent;
+    bool        failed;
+    char       *cap;            // sim_httpd_invoke() capture buffer
+    size_t      cap_size, cap_len;
+} req_aux_t;
+
+// ---- output ----
+
+static int out_write(req_aux_t *a, const char *p, size_t n)
+{
+    if (a->failed) return -1;
+    if (!a->sess) {
+        size_t room = a->cap_size - a->cap_len;
+        size_t take = n < room ? n : room;
+        memcpy(a->cap + a->cap_len, p, take);
+        a->cap_len += take;
+        return 0;
+    }
+    while (n > 0) {
+        ssize_t w = send(a->sess->fd, p, n, MSG_NOSIGNAL);
+        if (w <= 0) { a->failed = true; return -1; }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int send_head(req_aux_t *a, ssize_t content_len)
+{
+    char head[1024];
+    int n = snprintf(head, sizeof head, "HTTP/1.1 %s\r\nContent-Type: %s\r\n",
+                     a->status, a->type ? a->type : HTTPD_TYPE_TEXT);
+    if (content_len >= 0)
+        n += snprintf(head + n, sizeof head - n, "Content-Length: %zd\r\n", content_len);
+    else
+        n += snprintf(head + n, sizeof head - n, "Transfer-Encoding: chunked\r\n");
+    for (int i = 0; i < a->n_hdr && n < (int)sizeof head; i++)
+        n += snprintf(head + n, sizeof head - n, "%s: %s\r\n", a->hdr_k[i], a->hdr_v[i]);
+    if (n > (int)sizeof head - 3) return -1;
+    n += snprintf(head + n, sizeof head - n, "\r\n");
+    a->head_sent = true;
+    return out_write(a, head, (size_t)n);
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    if (!r || !status) return ESP_ERR_INVALID_ARG;
+    req_aux_t *a = r->aux;
+    snprintf(a->status, sizeof a->status, "%s", status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    if (!r || !type) return ESP_ERR_INVALID_ARG;
+    ((req_aux_t *)r->aux)->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    if (!r || !field || !value) return ESP_ERR_INVALID_ARG;
+    req_aux_t *a = r->aux;
+    if (a->n_hdr >= MAX_RESP_HDRS || a->n_hdr >= a->srv->cfg.max_resp_headers) return ESP_ERR_HTTPD_RESP_HDR;
+    a->hdr_k[a->n_hdr] = field;
+    a->hdr_v[a->n_hdr] = value;
+    a->n_hdr++;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (!r) return ESP_ERR_INVALID_ARG;
+    req_aux_t *a = r->aux;
+    if (buf_len == HTTPD_RESP_USE_STRLEN) buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    if (send_head(a, buf_len) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+    if (r->method != HTTP_HEAD && buf_len > 0 && out_write(a, buf, (size_t)buf_len) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (!r) return ESP_ERR_INVALID_ARG;
+    req_aux_t *a = r->aux;
+    if (buf_len == HTTPD_RESP_USE_STRLEN) buf_len = buf ? (ssize_t)strlen(buf) : 0;
+    if (!a->head_sent && send_head(a, -1) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+
+    char sz[16];
+    int n = snprintf(sz, sizeof sz, "%zx\r\n", buf_len);
+    if (out_write(a, sz, (size_t)n) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+    if (buf_len > 0 && out_write(a, buf, (size_t)buf_len) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+    if (out_write(a, "\r\n", 2) != 0) return ESP_ERR_HTTPD_RESP_SEND;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t *r, const char *str)
+{
+    return httpd_resp_send(r, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    static const char *const lines[] = {
+        [HTTPD_500_INTERNAL_SERVER_ERROR]   = "500 Internal Server Error",
+        [HTTPD_501_METHOD_NOT_IMPLEMENTED]  = "501 Method Not Implemented",
+        [HTTPD_505_VERSION_NOT_SUPPORTED]   = "505 Version Not Supported",
+        [HTTPD_400_BAD_REQUEST]             = "400 Bad Request",
+        [HTTPD_401_UNAUTHORIZED]            = "401 Unauthorized",
+        [HTTPD_403_FORBIDDEN]               = "403 Forbidden",
+        [HTTPD_404_NOT_FOUND]               = "404 Not Found",
+        [HTTPD_405_METHOD_NOT_ALLOWED]      = "405 Method Not Allowed",
+        [HTTPD_408_REQ_TIMEOUT]             = "408 Request Timeout",
+        [HTTPD_411_LENGTH_REQUIRED]         = "411 Length Required",
+        [HTTPD_414_URI_TOO_LONG]            = "414 URI Too Long",
+        [HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE] = "431 Request Header Fields Too Large",
+    };
+    httpd_resp_set_status(req, lines[error]);
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_send(req, msg ? msg : lines[error], HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_404(httpd_req_t *r)
+{
+    return httpd_resp_send_err(r, HTTPD_404_NOT_FOUND, "This URI does not exist");
+}
+
+// ---- request accessors ----
+
+static const char *find_hdr(req_aux_t *a, const char *field, size_t *vlen)
+{
+    size_t flen = strlen(field);
+    const char *p = a->hdrs, *end = a->hdrs + a->hdrs_len;
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) eol = end;
+        if ((size_t)(eol - p) > flen && strncasecmp(p, field, flen) == 0 && p[flen] == ':') {
+            const char *v = p + flen + 1;
+            while (v < eol && (*v == ' ' || *v == '\t')) v++;
+            const char *ve = eol;
+            while (ve > v && (ve[-1] == '\r' || ve[-1] == ' ')) ve--;
+            *vlen = (size_t)(ve - v);
+            return v;
+        }
+        p = eol + 1;
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field)
+{
+    size_t n = 0;
+    return (r && field && find_hdr(r->aux, field, &n)) ? n : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size)
+{
+    if (!r || !field || !val || val_size == 0) return ESP_ERR_INVALID_ARG;
+    size_t n = 0;
+    const char *v = find_hdr(r->aux, field, &n);
+    if (!v) return ESP_ERR_NOT_FOUND;
+    size_t take = n < val_size - 1 ? n : val_size - 1;
+    memcpy(val, v, take);
+    val[take] = '\0';
+    return take < n ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r)
+{
+    const char *q = r ? strchr(r->uri, '?') : NULL;
+    return q ? strlen(q + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    if (!r || !buf || buf_len == 0) return ESP_ERR_INVALID_ARG;
+    const char *q = strchr(r->uri, '?');
+    if (!q) return ESP_ERR_NOT_FOUND;
+    size_t n = strlen(q + 1);
+    size_t take = n < buf_len - 1 ? n : buf_len - 1;
+    memcpy(buf, q + 1, take);
+    buf[take] = '\0';
+    return take < n ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+    if (!qry || !key || !val || val_size == 0) return ESP_ERR_INVALID_ARG;
+    size_t klen = strlen(key);
+    const char *p = qry;
+    while (*p) {
+        const char *amp = strchr(p, '&');
+        const char *end = amp ? amp : p + strlen(p);
+        if ((size_t)(end - p) >= klen && strncmp(p, key, klen) == 0 && (p[klen] == '=' || p + klen == end)) {
+            const char *v = (p[klen] == '=') ? p + klen + 1 : end;
+            size_t n = (size_t)(end - v);
+            size_t take = n < val_size - 1 ? n : val_size - 1;
+            memcpy(val, v, take);
+            val[take] = '\0';
+            return take < n ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        if (!amp) break;
+        p = amp + 1;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    if (!r || !buf) return -1;
+    req_aux_t *a = r->aux;
+    if (a->body_left == 0 || buf_len == 0) return 0;
+    size_t want = buf_len < a->body_left ? buf_len : a->body_left;
+
+    if (a->body_pre_len > 0) {
+        size_t take = want < a->body_pre_len ? want : a->body_pre_len;
+        memcpy(buf, a->body_pre, take);
+        a->body_pre += take;
+        a->body_pre_len -= take;
+        a->body_left -= take;
+        return (int)take;
+    }
+    if (!a->sess) return 0;
+    ssize_t n = recv(a->sess->fd, buf, want, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return -3;   // HTTPD_SOCK_ERR_TIMEOUT
+    if (n <= 0) return -1;
+    a->body_left -= (size_t)n;
+    return (int)n;
+}
+
+// ---- dispatch ----
+
+static int parse_method(const char *m, size_t n)
+{
+    static const struct { const char *s; int m; } tbl[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+        { "DELETE", HTTP_DELETE }, { "HEAD", HTTP_HEAD },
+    };
+    for (size_t i = 0; i < sizeof tbl / sizeof tbl[0]; i++)
+        if (strlen(tbl[i].s) == n && strncmp(tbl[i].s, m, n) == 0) return tbl[i].m;
+    return -1;
+}
+
+static bool uri_match(const char *tmpl, const char *uri, size_t len)
+{
+    size_t tl = strlen(tmpl);
+    if (tl > 0 && tmpl[tl - 1] == '*')   // httpd_uri_match_wildcard-style prefix
+        return len >= tl - 1 && strncmp(tmpl, uri, tl - 1) == 0;
+    return tl == len && strncmp(tmpl, uri, len) == 0;
+}
+
+// Runs the matching handler. Returns false if the session must be closed.
+static bool dispatch(server_t *srv, httpd_req_t *req, req_aux_t *a)
+{
+    const char *uri = req->uri;
+    const char *q = strchr(uri, '?');
+    size_t path_len = q ? (size_t)(q - uri) : strlen(uri);
+
+    pthread_mutex_lock(&srv->lock);
+    const httpd_uri_t *hit = NULL;
+    bool path_known = false;
+    for (size_t i = 0; i < srv->n_uris; i++) {
+        if (!uri_match(srv->uris[i].uri, uri, path_len)) continue;
+        path_known = true;
+        if (srv->uris[i].method == req->method) { hit = &srv->uris[i]; break; }
+    }
+    srv->stats.requests++;
+    pthread_mutex_unlock(&srv->lock);
+
+    if (!hit) {
+        if (path_known) httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, "Request method for this URI is not handled by server");
+        else            httpd_resp_send_404(req);
+        return !a->failed;
+    }
+    req->user_ctx = hit->user_ctx;
+    esp_err_t rc = hit->handler(req);
+    return rc == ESP_OK && !a->failed;
+}
+
+static void init_req(server_t *srv, httpd_req_t *req, req_aux_t *a, int method,
+                     const char *uri, size_t uri_len)
+{
+    memset(req, 0, sizeof *req);
+    memset(a, 0, sizeof *a);
+    a->srv = srv;
+    snprintf(a->status, sizeof a->status, "%s", HTTPD_200);
+    req->handle = srv;
+    req->method = method;
+    req->aux = a;
+    memcpy((char *)req->uri, uri, uri_len);
+    ((char *)req->uri)[uri_len] = '\0';
+}
+
+static void close_sess(server_t *srv, sess_t *s)
+{
+    if (s->fd < 0) return;
+    close(s->fd);
+    s->fd = -1;
+    s->len = 0;
+    pthread_mutex_lock(&srv->lock);
+    srv->stats.open_now--;
+    pthread_mutex_unlock(&srv->lock);
+}
+
+static void reply_err_raw(int fd, const char *status)
+{
+    char msg[128];
+    int n = snprintf(msg, sizeof msg, "HTTP/1.1 %s\r\nContent-Type: text/plain\r\nContent-Length: 0\r\n\r\n", status);
+    send(fd, msg, (size_t)n, MSG_NOSIGNAL);
+}
+
+// Read and serve requests buffered on one session. Returns false to close it.
+static bool serve_sess(server_t *srv, sess_t *s)
+{
+    // Read until the end of the header block, bounded by recv_wait_timeout.
+    char *eoh;
+    while ((s->buf[s->len] = '\0', eoh = strstr(s->buf, "\r\n\r\n")) == NULL) {
+        if (s->len >= SESS_BUF_LEN) { reply_err_raw(s->fd, "431 Request Header Fields Too Large"); return false; }
+        ssize_t n = recv(s->fd, s->buf + s->len, SESS_BUF_LEN - s->len, 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                pthread_mutex_lock(&srv->lock);
+                srv->stats.timeouts++;
+                pthread_mutex_unlock(&srv->lock);
+                if (s->len > 0) reply_err_raw(s->fd, "408 Request Timeout");
+            }
+            return false;
+        }
+        s->len += (size_t)n;
+    }
+
+    size_t head_len = (size_t)(eoh - s->buf) + 4;
+    char *line_end = strstr(s->buf, "\r\n");
+    char *sp1 = memchr(s->buf, ' ', (size_t)(line_end - s->buf));
+    char *sp2 = sp1 ? memchr(sp1 + 1, ' ', (size_t)(line_end - sp1 - 1)) : NULL;
+    if (!sp1 || !sp2) { reply_err_raw(s->fd, "400 Bad Request"); return false; }
+
+    int method = parse_method(s->buf, (size_t)(sp1 - s->buf));
+    size_t uri_len = (size_t)(sp2 - sp1 - 1);
+    if (method < 0)                  { reply_err_raw(s->fd, "501 Method Not Implemented"); return false; }
+    if (uri_len > HTTPD_MAX_URI_LEN) { reply_err_raw(s->fd, "414 URI Too Long"); return false; }
+    if (head_len - (size_t)(line_end + 2 - s->buf) > HTTPD_MAX_REQ_HDR_LEN) {
+        reply_err_raw(s->fd, "431 Request Header Fields Too Large");
+        return false;
+    }
+
+    httpd_req_t req;
+    req_aux_t a;
+    init_req(srv, &req, &a, method, sp1 + 1, uri_len);
+    a.sess = s;
+    a.hdrs = line_end + 2;
+    a.hdrs_len = (size_t)(eoh + 2 - a.hdrs);
+
+    char cl[16];
+    if (httpd_req_get_hdr_value_str(&req, "Content-Length", cl, sizeof cl) == ESP_OK)
+        req.content_len = strtoul(cl, NULL, 10);
+    a.body_left = req.content_len;
+    a.body_pre = s->buf + head_len;
+    a.body_pre_len = s->len - head_len;
+    if (a.body_pre_len > a.body_left) a.body_pre_len = a.body_left;
+
+    char conn[16] = "";
+    httpd_req_get_hdr_value_str(&req, "Connection", conn, sizeof conn);
+    bool keep = dispatch(srv, &req, &a) && strcasecmp(conn, "close") != 0;
+
+    // Purge unread body so the next request starts at a header.
+    char sink[256];
+    while (keep && a.body_left > 0) {
+        int n = httpd_req_recv(&req, sink, sizeof sink);
+        if (n <= 0) keep = false;
+    }
+
+    size_t consumed = (size_t)(a.body_pre - s->buf);
+    memmove(s->buf, s->buf + consumed, s->len - consumed);
+    s->len -= consumed;
+    s->buf[s->len] = '\0';
+    return keep;
+}
+
+static void accept_conn(server_t *srv)
+{
+    sess_t *slot = NULL, *lru = NULL;
+    for (int i = 0; i < srv->cfg.max_open_sockets; i++) {
+        sess_t *s = &srv->sess[i];
+        if (s->fd < 0) { slot = s; break; }
+        if (!lru || s->lru < lru->lru) lru = s;
+    }
+    if (!slot && srv->cfg.lru_purge_enable && lru) {
+        close_sess(srv, lru);
+        pthread_mutex_lock(&srv->lock);
+        srv->stats.lru_purged++;
+        pthread_mutex_unlock(&srv->lock);
+        slot = lru;
+    }
+
+    int fd = accept(srv->listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    pthread_mutex_lock(&srv->lock);
+    if (!slot) {
+        srv->stats.rejected++;
+        pthread_mutex_unlock(&srv->lock);
+        close(fd);
+        return;
+    }
+    srv->stats.accepted++;
+    srv->stats.open_now++;
+    pthread_mutex_unlock(&srv->lock);
+
+    struct timeval rt = { srv->cfg.recv_wait_timeout, 0 }, st = { srv->cfg.send_wait_timeout, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rt, sizeof rt);
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &st, sizeof st);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    slot->fd = fd;
+    slot->len = 0;
+    slot->lru = ++srv->lru_ctr;
+}
+
+static void *server_task(void *arg)
+{
+    server_t *srv = arg;
+    while (!srv->stop) {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(srv->listen_fd, &rd);
+        int maxfd = srv->listen_fd;
+        for (int i = 0; i < srv->cfg.max_open_sockets; i++) {
+            int fd = srv->sess[i].fd;
+            if (fd >= 0) { FD_SET(fd, &rd); if (fd > maxfd) maxfd = fd; }
+        }
+        struct timeval tv = { 0, 100000 };
+        int n = select(maxfd + 1, &rd, NULL, NULL, &tv);
+        if (n <= 0) continue;
+
+        for (int i = 0; i < srv->cfg.max_open_sockets; i++) {
+            sess_t *s = &srv->sess[i];
+            if (s->fd < 0 || !FD_ISSET(s->fd, &rd)) continue;
+            s->lru = ++srv->lru_ctr;
+            bool keep = serve_sess(srv, s);
+            while (keep && s->len > 0 && strstr(s->buf, "\r\n\r\n")) keep = serve_sess(srv, s);  // pipelined
+            if (!keep) close_sess(srv, s);
+        }
+        if (FD_ISSET(srv->listen_fd, &rd)) accept_conn(srv);
+    }
+    return NULL;
+}
+
+// ---- lifecycle ----
+
+static server_t *s_last = NULL;   // newest running server (sim_httpd_last_started)
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    if (!handle || !config || config->max_open_sockets == 0) return ESP_ERR_INVALID_ARG;
+    server_t *srv = calloc(1, sizeof *srv);
+    if (!srv) return ESP_ERR_HTTPD_ALLOC_MEM;
+    srv->cfg = *config;
+    srv->uris = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    srv->sess = calloc(config->max_open_sockets, sizeof(sess_t));
+    if (!srv->uris || !srv->sess) { free(srv->uris); free(srv->sess); free(srv); return ESP_ERR_HTTPD_ALLOC_MEM; }
+    for (int i = 0; i < config->max_open_sockets; i++) srv->sess[i].fd = -1;
+    pthread_mutex_init(&srv->lock, NULL);
+
+    const char *env = getenv("SIM_HTTP_PORT");
+    int port = env ? atoi(env) : (config->server_port < 1024 ? config->server_port + 8000 : config->server_port);
+
+    srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(srv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port),
+                              .sin_addr.s_addr = htonl(INADDR_ANY) };
+    socklen_t sl = sizeof sa;
+    if (srv->listen_fd < 0 || bind(srv->listen_fd, (struct sockaddr *)&sa, sizeof sa) != 0 ||
+        listen(srv->listen_fd, config->backlog_conn) != 0 ||
+        getsockname(srv->listen_fd, (struct sockaddr *)&sa, &sl) != 0) {
+        ESP_LOGE(TAG, "error binding port %d: %s", port, strerror(errno));
+        if (srv->listen_fd >= 0) close(srv->listen_fd);
+        free(srv->uris); free(srv->sess); free(srv);
+        return ESP_FAIL;
+    }
+    srv->port = ntohs(sa.sin_port);
+
+    if (pthread_create(&srv->th, NULL, server_task, srv) != 0) {
+        close(srv->listen_fd);
+        free(srv->uris); free(srv->sess); free(srv);
+        return ESP_ERR_HTTPD_TASK;
+    }
+    ESP_LOGI(TAG, "listening on port %u (max_open_sockets=%u, lru_purge=%d)",
+             srv->port, config->max_open_sockets, config->lru_purge_enable);
+    *handle = srv;
+    s_last = srv;
+    return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    server_t *srv = handle;
+    if (!srv) return ESP_ERR_INVALID_ARG;
+    if (s_last == srv) s_last = NULL;
+    srv->stop = true;
+    pthread_join(srv->th, NULL);
+    for (int i = 0; i < srv->cfg.max_open_sockets; i++) close_sess(srv, &srv->sess[i]);
+    close(srv->listen_fd);
+    free(srv->uris);
+    free(srv->sess);
+    free(srv);
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    server_t *srv = handle;
+    if (!srv || !uri_handler || !uri_handler->uri || !uri_handler->handler) return ESP_ERR_INVALID_ARG;
+    esp_err_t rc = ESP_OK;
+    pthread_mutex_lock(&srv->lock);
+    for (size_t i = 0; i < srv->n_uris; i++) {
+        if (strcmp(srv->uris[i].uri, uri_handler->uri) == 0 && srv->uris[i].method == uri_handler->method) {
+            rc = ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (rc == ESP_OK && srv->n_uris >= srv->cfg.max_uri_handlers) rc = ESP_ERR_HTTPD_HANDLERS_FULL;
+    if (rc == ESP_OK) srv->uris[srv->n_uris++] = *uri_handler;
+    pthread_mutex_unlock(&srv->lock);
+    if (rc != ESP_OK) ESP_LOGW(TAG, "register %s failed: 0x%x", uri_handler->uri, rc);
+    return rc;
+}
+
+// ---- sim extensions ----
+
+esp_err_t sim_httpd_invoke(httpd_handle_t handle, httpd_method_t method, const char *uri,
+                           const char *headers, char *out, size_t out_cap, size_t *out_len)
+{
+    server_t *srv = handle;
+    size_t uri_len = uri ? strlen(uri) : 0;
+    if (!srv || !uri || !out || uri_len > HTTPD_MAX_URI_LEN) return ESP_ERR_INVALID_ARG;
+
+    httpd_req_t req;
+    req_aux_t a;
+    init_req(srv, &req, &a, method, uri, uri_len);
+    a.hdrs = headers ? headers : "";
+    a.hdrs_len = strlen(a.hdrs);
+    a.cap = out;
+    a.cap_size = out_cap;
+    bool ok = dispatch(srv, &req, &a);
+    if (out_len) *out_len = a.cap_len;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+void sim_httpd_stats(httpd_handle_t handle, sim_httpd_stats_t *out)
+{
+    server_t *srv = handle;
+    pthread_mutex_lock(&srv->lock);
+    *out = srv->stats;
+    pthread_mutex_unlock(&srv->lock);
+}
+
+httpd_handle_t sim_httpd_last_started(void)
+{
+    return s_last;
+}
@@ -0,0 +1,164 @@
+/*
+ * Host shim: legacy I2C master driver over a simulated bus.
+ * Command links are recorded as op lists and executed by i2c_master_cmd_begin().
+ * Each START..STOP segment addresses one device; the first written byte sets
+ * the register pointer, later bytes are register writes, and all reads of a
+ * segment are served by one burst read so multi-byte reads stay coherent.
+ * Only the BME280 register model (bme280_sim.c) is attached at BME280_ADDR.
+ */
+
+#include "driver/i2c.h"
+#include "bme280.h"
+#include "bme280_sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum { OP_START, OP_STOP, OP_WRITE, OP_READ } op_kind_t;
+
+typedef struct {
+    op_kind_t kind;
+    uint8_t  *dst;      // OP_READ destination
+    uint8_t   byte;     // OP_WRITE payload (one op per byte)
+    size_t    len;      // OP_READ length
+} i2c_op_t;
+
+typedef struct {
+    i2c_op_t *ops;
+    size_t    n, cap;
+    bool      is_static;
+} cmd_link_t;
+
+static bool s_installed[2];
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *conf)
+{
+    if (port < 0 || port > 1 || !conf) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx_buf, size_t tx_buf, int intr_flags)
+{
+    (void)mode; (void)rx_buf; (void)tx_buf; (void)intr_flags;
+    if (port < 0 || port > 1) return ESP_ERR_INVALID_ARG;
+    if (s_installed[port]) return ESP_FAIL;
+    s_installed[port] = true;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t port)
+{
+    if (port < 0 || port > 1) return ESP_ERR_INVALID_ARG;
+    s_installed[port] = false;
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    return calloc(1, sizeof(cmd_link_t));
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size)
+{
+    // The caller's buffer only bounds the link; ops still live on the host heap.
+    if (!buffer || size < sizeof(cmd_link_t)) return NULL;
+    cmd_link_t *l = calloc(1, sizeof *l);
+    if (l) l->is_static = true;
+    return l;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd)
+{
+    cmd_link_t *l = cmd;
+    if (!l) return;
+    free(l->ops);
+    free(l);
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd)
+{
+    i2c_cmd_link_delete(cmd);
+}
+
+static esp_err_t push(i2c_cmd_handle_t cmd, i2c_op_t op)
+{
+    cmd_link_t *l = cmd;
+    if (!l) return ESP_ERR_INVALID_ARG;
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 16;
+        i2c_op_t *p = realloc(l->ops, cap * sizeof *p);
+        if (!p) return ESP_ERR_NO_MEM;
+        l->ops = p;
+        l->cap = cap;
+    }
+    l->ops[l->n++] = op;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd) { return push(cmd, (i2c_op_t){ .kind = OP_START }); }
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd)  { return push(cmd, (i2c_op_t){ .kind = OP_STOP }); }
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en)
+{
+    (void)ack_en;
+    return push(cmd, (i2c_op_t){ .kind = OP_WRITE, .byte = data });
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t len, bool ack_en)
+{
+    for (size_t i = 0; i < len; i++) {
+        esp_err_t e = i2c_master_write_byte(cmd, data[i], ack_en);
+        if (e != ESP_OK) return e;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd, uint8_t *data, i2c_ack_type_t ack)
+{
+    return i2c_master_read(cmd, data, 1, ack);
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t len, i2c_ack_type_t ack)
+{
+    (void)ack;
+    if (!data || len == 0) return ESP_ERR_INVALID_ARG;
+    return push(cmd, (i2c_op_t){ .kind = OP_READ, .dst = data, .len = len });
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    cmd_link_t *l = cmd;
+    if (!l || port < 0 || port > 1) return ESP_ERR_INVALID_ARG;
+    if (!s_installed[port]) return ESP_ERR_INVALID_STATE;
+
+    size_t i = 0;
+    while (i < l->n) {
+        if (l->ops[i].kind == OP_STOP) { i++; continue; }
+        if (l->ops[i].kind != OP_START) return ESP_FAIL;
+        i++;
+        if (i >= l->n || l->ops[i].kind != OP_WRITE) return ESP_FAIL;
+
+        uint8_t addr_rw = l->ops[i++].byte;
+        if ((addr_rw >> 1) != BME280_ADDR) return ESP_FAIL;   // nobody ACKed the address
+
+        if ((addr_rw & 1) == I2C_MASTER_WRITE) {
+            uint8_t wbuf[64];
+            size_t wn = 0;
+            while (i < l->n && l->ops[i].kind == OP_WRITE && wn < sizeof wbuf) wbuf[wn++] = l->ops[i++].byte;
+            if (wn > 0) bme280_sim_i2c_write(wbuf, wn);
+        } else {
+            size_t total = 0, j;
+            for (j = i; j < l->n && l->ops[j].kind == OP_READ; j++) total += l->ops[j].len;
+            uint8_t *rbuf = malloc(total ? total : 1);
+            if (!rbuf) return ESP_ERR_NO_MEM;
+            bme280_sim_i2c_read(rbuf, total);
+            size_t off = 0;
+            for (; i < j; i++) {
+                memcpy(l->ops[i].dst, rbuf + off, l->ops[i].len);
+                off += l->ops[i].len;
+            }
+            free(rbuf);
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * Host shim: esp_log and esp_err_to_name.
+ * Level is global (SIM_LOG_LEVEL=0..5, default INFO); per-tag levels are ignored.
+ */
+
+#include "esp_log.h"
+#include "esp_err.h"
+#include "sim_time.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+static esp_log_level_t s_level = (esp_log_level_t)-1;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (tag && tag[0] == '*' && tag[1] == '\0') s_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if ((int)s_level < 0) {
+        const char *env = getenv("SIM_LOG_LEVEL");
+        s_level = env ? (esp_log_level_t)atoi(env) : ESP_LOG_INFO;
+    }
+    if (level > s_level) return;
+
+    static const char letters[] = "NEWIDV";
+    va_list ap;
+    va_start(ap, format);
+    pthread_mutex_lock(&s_lock);
+    printf("%c (%lld) %s: ", letters[level], (long long)(sim_time_now_us() / 1000), tag);
+    vprintf(format, ap);
+    putchar('\n');
+    fflush(stdout);
+    pthread_mutex_unlock(&s_lock);
+    va_end(ap);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                    return "ESP_OK";
+    case ESP_FAIL:                  return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:   return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_HTTP_CONNECT:      return "ESP_ERR_HTTP_CONNECT";
+    case ESP_ERR_HTTP_WRITE_DATA:   return "ESP_ERR_HTTP_WRITE_DATA";
+    case ESP_ERR_HTTP_FETCH_HEADER: return "ESP_ERR_HTTP_FETCH_HEADER";
+    case ESP_ERR_HTTP_EAGAIN:       return "ESP_ERR_HTTP_EAGAIN";
+    default:                        return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,431 @@
+/*
+ * Host shim: esp-mqtt client over host sockets.
+ * - One thread per client connects, reads packets and sends keep-alive
+ *   pings; publish() writes from the caller's thread under a send lock.
+ * - Keep-alive and reconnect delays run on host time (the broker's clock),
+ *   not the scaled sim clock.
+ */
+
+#include "mqtt_client.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static const char *TAG = "mqtt_client";
+
+#define MAX_HANDLERS 4
+
+typedef struct {
+    esp_mqtt_event_id_t id;
+    esp_event_handler_t fn;
+    void *arg;
+} handler_t;
+
+struct esp_mqtt_client {
+    char  host[128];
+    int   port;
+    char *client_id, *username, *password;
+    char *will_topic, *will_msg;
+    int   will_len, will_qos, will_retain;
+    bool  clean;
+    int   keepalive_s, reconnect_ms, timeout_ms;
+    bool  auto_reconnect;
+
+    handler_t handlers[MAX_HANDLERS];
+    int   n_handlers;
+
+    pthread_t       thread;
+    pthread_mutex_t tx_lock;     // one writer at a time; guards fd and connected
+    volatile bool   running;
+    bool  connected;
+    int   fd;
+    uint16_t next_msg_id;
+    int64_t  last_tx_ms;
+};
+
+static int64_t host_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static char *dup_or_null(const char *s) { return s ? strdup(s) : NULL; }
+
+static void dispatch(esp_mqtt_client_handle_t c, esp_mqtt_event_id_t id, int msg_id, int session_present)
+{
+    esp_mqtt_event_t ev = { .event_id = id, .client = c, .msg_id = msg_id, .session_present = session_present };
+    for (int i = 0; i < c->n_handlers; i++) {
+        if (c->handlers[i].id == MQTT_EVENT_ANY || c->handlers[i].id == id) {
+            c->handlers[i].fn(c->handlers[i].arg, "MQTT_EVENTS", id, &ev);
+        }
+    }
+}
+
+// ---- packet building ----
+
+typedef struct {
+    uint8_t *buf;
+    size_t len, cap;
+} pkt_t;
+
+static void pkt_put(pkt_t *p, const void *src, size_t n)
+{
+    if (p->len + n > p->cap) {
+        p->cap = (p->len + n) * 2;
+        p->buf = realloc(p->buf, p->cap);
+    }
+    memcpy(p->buf + p->len, src, n);
+    p->len += n;
+}
+
+static void pkt_u8(pkt_t *p, uint8_t v)   { pkt_put(p, &v, 1); }
+static void pkt_u16(pkt_t *p, uint16_t v) { uint8_t b[2] = { v >> 8, v & 0xFF }; pkt_put(p, b, 2); }
+static void pkt_str(pkt_t *p, const char *s, size_t n) { pkt_u16(p, (uint16_t)n); pkt_put(p, s, n); }
+
+// Prefix the variable header + payload in body with the fixed header.
+static pkt_t pkt_frame(uint8_t type, const pkt_t *body)
+{
+    pkt_t out = { 0 };
+    pkt_u8(&out, type);
+    size_t rem = body->len;
+    do {
+        uint8_t b = rem & 0x7F;
+        rem >>= 7;
+        pkt_u8(&out, b | (rem ? 0x80 : 0));
+    } while (rem);
+    if (body->len) pkt_put(&out, body->buf, body->len);
+    return out;
+}
+
+static bool send_all(int fd, const uint8_t *p, size_t n)
+{
+    while (n) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+static bool send_pkt(esp_mqtt_client_handle_t c, const pkt_t *pkt)
+{
+    bool ok = c->fd >= 0 && send_all(c->fd, pkt->buf, pkt->len);
+    if (ok) c->last_tx_ms = host_ms();
+    return ok;
+}
+
+// ---- connection ----
+
+static int dial(const char *host, int port, int timeout_ms)
+{
+    char port_s[8];
+    snprintf(port_s, sizeof port_s, "%d", port);
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM }, *ai = NULL;
+    if (getaddrinfo(host, port_s, &hints, &ai) != 0 || !ai) return -1;
+
+    int fd = socket(ai->ai_family, ai->ai_socktype, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        int rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            int err = 0;
+            socklen_t el = sizeof err;
+            rc = (poll(&pfd, 1, timeout_ms) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &el) == 0 && !err) ? 0 : -1;
+        }
+        if (rc != 0) {
+            close(fd);
+            fd = -1;
+        } else {
+            fcntl(fd, F_SETFL, 0);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        }
+    }
+    freeaddrinfo(ai);
+    return fd;
+}
+
+// Read one packet (blocking up to timeout_ms for its first byte). Returns the
+// fixed-header type byte, or -1 on timeout (*timed_out) / error.
+static int read_pkt(int fd, int timeout_ms, uint8_t *body, size_t cap, size_t *len, bool *timed_out)
+{
+    *timed_out = false;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int pr = poll(&pfd, 1, timeout_ms);
+    if (pr == 0) { *timed_out = true; return -1; }
+    if (pr < 0) return errno == EINTR ? (*timed_out = true, -1) : -1;
+
+    uint8_t type;
+    if (recv(fd, &type, 1, MSG_WAITALL) != 1) return -1;
+    size_t rem = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        uint8_t b;
+        if (recv(fd, &b, 1, MSG_WAITALL) != 1) return -1;
+        rem |= (size_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    size_t got = 0;
+    while (got < rem) {               // oversized packets are read and truncated
+        uint8_t sink[512];
+        uint8_t *dst = got < cap ? body + got : sink;
+        size_t want = got < cap ? (rem - got < cap - got ? rem - got : cap - got)
+                                : (rem - got < sizeof sink ? rem - got : sizeof sink);
+        ssize_t r = recv(fd, dst, want, 0);
+        if (r <= 0) return -1;
+        got += (size_t)r;
+    }
+    *len = rem < cap ? rem : cap;
+    return type;
+}
+
+static bool mqtt_connect(esp_mqtt_client_handle_t c, int *session_present)
+{
+    int fd = dial(c->host, c->port, c->timeout_ms);
+    if (fd < 0) return false;
+
+    pkt_t body = { 0 };
+    pkt_str(&body, "MQTT", 4);
+    pkt_u8(&body, 4);                                 // protocol level 3.1.1
+    uint8_t flags = c->clean ? 0x02 : 0;
+    if (c->will_topic) flags |= 0x04 | (uint8_t)(c->will_qos << 3) | (c->will_retain ? 0x20 : 0);
+    if (c->username) flags |= 0x80;
+    if (c->password) flags |= 0x40;
+    pkt_u8(&body, flags);
+    pkt_u16(&body, (uint16_t)c->keepalive_s);
+    pkt_str(&body, c->client_id, strlen(c->client_id));
+    if (c->will_topic) {
+        pkt_str(&body, c->will_topic, strlen(c->will_topic));
+        pkt_str(&body, c->will_msg, (size_t)c->will_len);
+    }
+    if (c->username) pkt_str(&body, c->username, strlen(c->username));
+    if (c->password) pkt_str(&body, c->password, strlen(c->password));
+    pkt_t pkt = pkt_frame(0x10, &body);
+    bool ok = send_all(fd, pkt.buf, pkt.len);
+    free(body.buf);
+    free(pkt.buf);
+
+    uint8_t ack[4];
+    size_t n = 0;
+    bool to;
+    if (!ok || read_pkt(fd, c->timeout_ms, ack, sizeof ack, &n, &to) != 0x20 || n < 2 || ack[1] != 0) {
+        if (ok && n >= 2) ESP_LOGE(TAG, "connection refused, rc=%d", ack[1]);
+        close(fd);
+        return false;
+    }
+    *session_present = ack[0] & 1;
+
+    pthread_mutex_lock(&c->tx_lock);
+    c->fd = fd;
+    c->connected = true;
+    c->last_tx_ms = host_ms();
+    pthread_mutex_unlock(&c->tx_lock);
+    return true;
+}
+
+static void mqtt_drop(esp_mqtt_client_handle_t c, bool graceful)
+{
+    pthread_mutex_lock(&c->tx_lock);
+    if (graceful && c->fd >= 0) {
+        uint8_t disc[2] = { 0xE0, 0 };
+        send_all(c->fd, disc, 2);
+    }
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+    c->connected = false;
+    pthread_mutex_unlock(&c->tx_lock);
+}
+
+static void *client_thread(void *arg)
+{
+    esp_mqtt_client_handle_t c = arg;
+    uint8_t body[1024];
+
+    while (c->running) {
+        dispatch(c, MQTT_EVENT_BEFORE_CONNECT, 0, 0);
+        int session_present = 0;
+        if (!mqtt_connect(c, &session_present)) {
+            ESP_LOGW(TAG, "connect to %s:%d failed", c->host, c->port);
+            dispatch(c, MQTT_EVENT_ERROR, 0, 0);
+        } else {
+            ESP_LOGI(TAG, "connected to %s:%d (session_present=%d)", c->host, c->port, session_present);
+            dispatch(c, MQTT_EVENT_CONNECTED, 0, session_present);
+
+            while (c->running) {
+                int64_t idle = host_ms() - c->last_tx_ms;
+                int wait = c->keepalive_s * 1000 / 2 - (int)idle;
+                size_t n = 0;
+                bool timed_out;
+                int type = read_pkt(c->fd, wait > 0 ? wait : 0, body, sizeof body, &n, &timed_out);
+                if (type < 0 && !timed_out) break;
+                if (type < 0) {                               // idle: keep-alive ping
+                    static const uint8_t ping[2] = { 0xC0, 0 };
+                    pkt_t p = { (uint8_t *)ping, 2, 2 };
+                    pthread_mutex_lock(&c->tx_lock);
+                    bool ok = send_pkt(c, &p);
+                    pthread_mutex_unlock(&c->tx_lock);
+                    if (!ok) break;
+                    continue;
+                }
+                switch (type & 0xF0) {
+                case 0x40:                                    // PUBACK
+                    if (n >= 2) dispatch(c, MQTT_EVENT_PUBLISHED, (body[0] << 8) | body[1], 0);
+                    break;
+                case 0x30:                                    // PUBLISH (not subscribed; ack QoS 1)
+                    if ((type & 0x06) == 0x02 && n >= 2) {
+                        size_t tl = (size_t)(body[0] << 8 | body[1]);
+                        if (n >= tl + 4) {
+                            uint8_t ack[4] = { 0x40, 2, body[tl + 2], body[tl + 3] };
+                            pkt_t p = { ack, 4, 4 };
+                            pthread_mutex_lock(&c->tx_lock);
+                            send_pkt(c, &p);
+                            pthread_mutex_unlock(&c->tx_lock);
+                        }
+                    }
+                    break;
+                default:                                      // PINGRESP, SUBACK, ...
+                    break;
+                }
+            }
+            bool graceful = !c->running;
+            mqtt_drop(c, graceful);
+            ESP_LOGW(TAG, "disconnected");
+            dispatch(c, MQTT_EVENT_DISCONNECTED, 0, 0);
+        }
+        if (!c->auto_reconnect) break;
+        for (int64_t until = host_ms() + c->reconnect_ms; c->running && host_ms() < until;) usleep(20000);
+    }
+    return NULL;
+}
+
+// ---- public API ----
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *cfg)
+{
+    const char *uri = getenv("SIM_MQTT_URI");
+    if (!uri) uri = cfg->broker.address.uri;
+    if (!uri || strncmp(uri, "mqtt://", 7) != 0) {
+        ESP_LOGE(TAG, "unsupported broker uri '%s' (sim: mqtt:// only)", uri ? uri : "");
+        return NULL;
+    }
+
+    esp_mqtt_client_handle_t c = calloc(1, sizeof *c);
+    if (!c) return NULL;
+    const char *h = uri + 7;
+    const char *colon = strchr(h, ':');
+    const char *slash = strchr(h, '/');
+    size_t hl = colon ? (size_t)(colon - h) : slash ? (size_t)(slash - h) : strlen(h);
+    if (hl >= sizeof c->host) hl = sizeof c->host - 1;
+    memcpy(c->host, h, hl);
+    c->port = colon ? atoi(colon + 1) : 1883;
+
+    c->client_id = strdup(cfg->credentials.client_id ? cfg->credentials.client_id : "esp32");
+    c->username = dup_or_null(cfg->credentials.username);
+    c->password = dup_or_null(cfg->credentials.authentication.password);
+    if (cfg->session.last_will.topic) {
+        c->will_topic = strdup(cfg->session.last_will.topic);
+        const char *m = cfg->session.last_will.msg ? cfg->session.last_will.msg : "";
+        c->will_len = cfg->session.last_will.msg_len ? cfg->session.last_will.msg_len : (int)strlen(m);
+        c->will_msg = malloc((size_t)c->will_len + 1);
+        memcpy(c->will_msg, m, (size_t)c->will_len);
+        c->will_qos = cfg->session.last_will.qos;
+        c->will_retain = cfg->session.last_will.retain;
+    }
+    c->clean = !cfg->session.disable_clean_session;
+    c->keepalive_s = cfg->session.keepalive ? cfg->session.keepalive : 120;
+    c->reconnect_ms = cfg->network.reconnect_timeout_ms ? cfg->network.reconnect_timeout_ms : 10000;
+    c->timeout_ms = cfg->network.timeout_ms ? cfg->network.timeout_ms : 10000;
+    c->auto_reconnect = !cfg->network.disable_auto_reconnect;
+    c->fd = -1;
+    c->next_msg_id = 1;
+    pthread_mutex_init(&c->tx_lock, NULL);
+    return c;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t c, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg)
+{
+    if (!c || !handler) return ESP_ERR_INVALID_ARG;
+    if (c->n_handlers == MAX_HANDLERS) return ESP_ERR_NO_MEM;
+    c->handlers[c->n_handlers++] = (handler_t){ event, handler, arg };
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t c)
+{
+    if (!c) return ESP_ERR_INVALID_ARG;
+    if (c->running) return ESP_FAIL;
+    c->running = true;
+    if (pthread_create(&c->thread, NULL, client_thread, c) != 0) {
+        c->running = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t c)
+{
+    if (!c || !c->running) return ESP_FAIL;
+    c->running = false;
+    pthread_mutex_lock(&c->tx_lock);
+    if (c->fd >= 0) shutdown(c->fd, SHUT_RD);        // wake the reader
+    pthread_mutex_unlock(&c->tx_lock);
+    pthread_join(c->thread, NULL);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t c)
+{
+    if (!c) return ESP_ERR_INVALID_ARG;
+    if (c->running) esp_mqtt_client_stop(c);
+    pthread_mutex_destroy(&c->tx_lock);
+    free(c->client_id);
+    free(c->username);
+    free(c->password);
+    free(c->will_topic);
+    free(c->will_msg);
+    free(c);
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t c, const char *topic, const char *data,
+                            int len, int qos, int retain)
+{
+    if (!c || !topic || qos < 0 || qos > 1) return -1;
+    if (len == 0 && data) len = (int)strlen(data);
+
+    pthread_mutex_lock(&c->tx_lock);
+    if (!c->connected) {
+        pthread_mutex_unlock(&c->tx_lock);
+        return -1;
+    }
+    int msg_id = 0;
+    pkt_t body = { 0 };
+    pkt_str(&body, topic, strlen(topic));
+    if (qos) {
+        msg_id = c->next_msg_id++;
+        if (c->next_msg_id == 0) c->next_msg_id = 1;
+        pkt_u16(&body, (uint16_t)msg_id);
+    }
+    if (len > 0) pkt_put(&body, data, (size_t)len);
+    pkt_t pkt = pkt_frame((uint8_t)(0x30 | (qos << 1) | (retain ? 1 : 0)), &body);
+    bool ok = send_pkt(c, &pkt);
+    pthread_mutex_unlock(&c->tx_lock);
+    free(body.buf);
+    free(pkt.buf);
+    return ok ? msg_id : -1;
+}
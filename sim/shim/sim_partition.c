@@ -0,0 +1,109 @@
+/*
+ * Host shim: flash data partitions.
+ * Partitions are the firmware's partitions.csv data entries the sim knows
+ * about (table below). Each one lives in RAM, or in SIM_FLASH_DIR/<label>.bin
+ * when that is set, so data survives restarting the sim like flash survives
+ * a reboot.
+ */
+
+#include "esp_partition.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const char *TAG = "partition";
+
+typedef struct {
+    esp_partition_t part;
+    uint8_t *mem;
+} sim_part_t;
+
+// Mirrors partitions.csv
+static sim_part_t s_parts[] = {
+    { { ESP_PARTITION_TYPE_DATA, 0x40, 0x190000, 256 * 1024, SPI_FLASH_SEC_SIZE, "backlog", false }, NULL },
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool part_map(sim_part_t *p)
+{
+    if (p->mem) return true;
+    const char *dir = getenv("SIM_FLASH_DIR");
+    if (!dir) {
+        p->mem = malloc(p->part.size);
+        if (p->mem) memset(p->mem, 0xFF, p->part.size);
+        return p->mem != NULL;
+    }
+
+    char path[512];
+    snprintf(path, sizeof path, "%s/%s.bin", dir, p->part.label);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "cannot open %s", path);
+        return false;
+    }
+    off_t len = lseek(fd, 0, SEEK_END);
+    bool fresh = len != (off_t)p->part.size;
+    if (fresh && ftruncate(fd, p->part.size) != 0) {
+        close(fd);
+        return false;
+    }
+    void *m = mmap(NULL, p->part.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return false;
+    p->mem = m;
+    if (fresh) memset(p->mem, 0xFF, p->part.size);   // blank flash
+    ESP_LOGI(TAG, "%s -> %s", p->part.label, path);
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    const esp_partition_t *found = NULL;
+    pthread_mutex_lock(&s_lock);
+    for (size_t i = 0; i < sizeof s_parts / sizeof s_parts[0]; i++) {
+        sim_part_t *p = &s_parts[i];
+        if (p->part.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p->part.subtype != subtype) continue;
+        if (label && strcmp(label, p->part.label) != 0) continue;
+        if (part_map(p)) found = &p->part;
+        break;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return found;
+}
+
+static uint8_t *part_mem(const esp_partition_t *part)
+{
+    return ((const sim_part_t *)part)->mem;   // part is the first member
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    if (!part || offset + size > part->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, part_mem(part) + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size)
+{
+    if (!part || offset + size > part->size) return ESP_ERR_INVALID_SIZE;
+    uint8_t *m = part_mem(part) + offset;
+    const uint8_t *s = src;
+    for (size_t i = 0; i < size; i++) m[i] &= s[i];   // NOR: 1 -> 0 only
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size)
+{
+    if (!part || offset + size > part->size) return ESP_ERR_INVALID_SIZE;
+    if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+    memset(part_mem(part) + offset, 0xFF, size);
+    return ESP_OK;
+}
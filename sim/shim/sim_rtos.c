@@ -0,0 +1,102 @@
+/*
+ * Host shim: FreeRTOS tasks and delays.
+ * Each task is a detached pthread. The tick count is derived from the sim
+ * clock, so vTaskDelayUntil() keeps the same drift-free period semantics.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim_time.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+#define US_PER_TICK (1000000LL / configTICK_RATE_HZ)
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+    bool  owned;                    // malloc'd by xTaskCreate*, else in a StaticTask_t
+} task_start_t;
+
+static void *task_trampoline(void *p)
+{
+    task_start_t st = *(task_start_t *)p;
+    if (st.owned) free(p);
+    st.fn(st.arg);
+    return NULL;
+}
+
+static pthread_t start_thread(task_start_t *st, uint32_t stack_depth)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    // Host stacks need headroom over the target's byte budget (libc printf etc.)
+    size_t stack = (size_t)stack_depth * 16;
+    if (stack < 256 * 1024) stack = 256 * 1024;
+    pthread_attr_setstacksize(&attr, stack);
+
+    pthread_t th;
+    int rc = pthread_create(&th, &attr, task_trampoline, st);
+    pthread_attr_destroy(&attr);
+    return rc == 0 ? th : 0;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *out, BaseType_t core_id)
+{
+    (void)name; (void)prio; (void)core_id;
+    task_start_t *st = malloc(sizeof *st);
+    if (!st) return pdFAIL;
+    *st = (task_start_t){ fn, arg, true };
+    pthread_t th = start_thread(st, stack_depth);
+    if (!th) { free(st); return pdFAIL; }
+    if (out) *out = (TaskHandle_t)th;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t prio, TaskHandle_t *out)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, prio, out, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                           UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb,
+                                           BaseType_t core_id)
+{
+    _Static_assert(sizeof(StaticTask_t) >= sizeof(task_start_t), "StaticTask_t too small");
+    (void)name; (void)prio; (void)core_id;
+    if (!stack || !tcb) return NULL;
+    task_start_t *st = (task_start_t *)tcb;
+    *st = (task_start_t){ fn, arg, false };
+    return (TaskHandle_t)start_thread(st, stack_depth);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb)
+{
+    return xTaskCreateStaticPinnedToCore(fn, name, stack_depth, arg, prio, stack, tcb, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) pthread_exit(NULL);   // only self-delete is used by app code
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_time_now_us() / US_PER_TICK);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_sleep_us((int64_t)ticks * US_PER_TICK);
+}
+
+void vTaskDelayUntil(TickType_t *prev_wake, TickType_t increment)
+{
+    TickType_t target = *prev_wake + increment;
+    sim_sleep_until_us((int64_t)target * US_PER_TICK);
+    *prev_wake = target;
+}
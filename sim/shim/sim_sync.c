@@ -0,0 +1,214 @@
+/*
+ * Host shim: FreeRTOS semaphores, mutexes, queues and critical sections.
+ * A semaphore is a count guarded by a pthread mutex/condvar; a mutex is a
+ * binary semaphore that starts available. A queue is a ring of item copies
+ * under the same kind of mutex/condvar. portENTER_CRITICAL() maps to one
+ * recursive process-wide lock.
+ */
+
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "sim_time.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct sim_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    UBaseType_t     count, max;
+    bool            is_static;
+};
+
+static void lock_init(pthread_mutex_t *lock, pthread_cond_t *cond)
+{
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_mutex_init(lock, NULL);
+    pthread_cond_init(cond, &ca);
+    pthread_condattr_destroy(&ca);
+}
+
+// Wait on cond (lock held) until *ready is non-zero or ticks of sim time
+// pass; 0 ticks does not wait.
+static void wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock, const UBaseType_t *ready, TickType_t ticks)
+{
+    if (*ready || ticks == 0) return;
+    if (ticks == portMAX_DELAY) {
+        while (!*ready) pthread_cond_wait(cond, lock);
+        return;
+    }
+    int64_t host_ns = (int64_t)((double)ticks * (1e9 / configTICK_RATE_HZ) / sim_time_scale());
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    host_ns += ts.tv_nsec;
+    ts.tv_sec += host_ns / 1000000000LL;
+    ts.tv_nsec = host_ns % 1000000000LL;
+    while (!*ready && pthread_cond_timedwait(cond, lock, &ts) == 0) { }
+}
+
+static SemaphoreHandle_t sem_init(struct sim_sem *s, UBaseType_t max, UBaseType_t initial)
+{
+    lock_init(&s->lock, &s->cond);
+    s->count = initial;
+    s->max = max;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    struct sim_sem *s = calloc(1, sizeof *s);
+    return s ? sem_init(s, max, initial) : NULL;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)  { return xSemaphoreCreateCounting(1, 1); }
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return xSemaphoreCreateCounting(1, 0); }
+
+static SemaphoreHandle_t sem_init_static(StaticSemaphore_t *buf, UBaseType_t initial)
+{
+    _Static_assert(sizeof(StaticSemaphore_t) >= sizeof(struct sim_sem), "StaticSemaphore_t too small");
+    struct sim_sem *s = (struct sim_sem *)buf;
+    s->is_static = true;
+    return sem_init(s, 1, initial);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf)  { return sem_init_static(buf, 1); }
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf) { return sem_init_static(buf, 0); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    pthread_mutex_lock(&s->lock);
+    wait_ticks(&s->cond, &s->lock, &s->count, ticks);
+    BaseType_t ok = s->count > 0;
+    if (ok) s->count--;
+    pthread_mutex_unlock(&s->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    pthread_mutex_lock(&s->lock);
+    BaseType_t ok = s->count < s->max;
+    if (ok) {
+        s->count++;
+        pthread_cond_signal(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    if (!s) return;
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    if (!s->is_static) free(s);
+}
+
+// ---- queues ----
+
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;             // broadcast on every send and receive
+    uint8_t        *items;
+    UBaseType_t     length, item_size, head, count, space;   // space = length - count, for wait_ticks()
+    bool            is_static;
+};
+
+static QueueHandle_t queue_init(struct sim_queue *q, UBaseType_t length, UBaseType_t item_size, uint8_t *items)
+{
+    lock_init(&q->lock, &q->cond);
+    q->items = items;
+    q->length = q->space = length;
+    q->item_size = item_size;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof *q + (size_t)length * item_size);
+    return q ? queue_init(q, length, item_size, (uint8_t *)(q + 1)) : NULL;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buf)
+{
+    _Static_assert(sizeof(StaticQueue_t) >= sizeof(struct sim_queue), "StaticQueue_t too small");
+    struct sim_queue *q = (struct sim_queue *)buf;
+    memset(q, 0, sizeof *q);
+    q->is_static = true;
+    return queue_init(q, length, item_size, storage);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&q->lock);
+    wait_ticks(&q->cond, &q->lock, &q->space, ticks);
+    BaseType_t ok = q->space > 0;
+    if (ok) {
+        memcpy(q->items + (size_t)((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+        q->count++;
+        q->space--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&q->lock);
+    wait_ticks(&q->cond, &q->lock, &q->count, ticks);
+    BaseType_t ok = q->count > 0;
+    if (ok) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        q->space++;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q) return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    if (!q->is_static) free(q);
+}
+
+// ---- critical sections ----
+
+static pthread_mutex_t s_crit;
+static pthread_once_t  s_crit_once = PTHREAD_ONCE_INIT;
+
+static void crit_init(void)
+{
+    pthread_mutexattr_t a;
+    pthread_mutexattr_init(&a);
+    pthread_mutexattr_settype(&a, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_crit, &a);
+    pthread_mutexattr_destroy(&a);
+}
+
+void sim_enter_critical(void)
+{
+    pthread_once(&s_crit_once, crit_init);
+    pthread_mutex_lock(&s_crit);
+}
+
+void sim_exit_critical(void)
+{
+    pthread_mutex_unlock(&s_crit);
+}
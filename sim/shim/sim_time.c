@@ -0,0 +1,46 @@
+/*
+ * Sim clock (implementation).
+ * sim_us = (host monotonic - boot) * scale. Sleeping converts sim durations
+ * back to host time, so every shim that waits stays in step with the rest.
+ */
+
+#include "sim_time.h"
+#include <time.h>
+#include <errno.h>
+
+static double  s_scale = 1.0;
+static int64_t s_boot_ns = 0;
+
+static int64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void sim_time_init(double scale)
+{
+    s_scale = (scale > 0.0) ? scale : 1.0;
+    s_boot_ns = host_now_ns();
+}
+
+double sim_time_scale(void) { return s_scale; }
+
+int64_t sim_time_now_us(void)
+{
+    if (s_boot_ns == 0) sim_time_init(1.0);   // library use without sim_main
+    return (int64_t)((double)(host_now_ns() - s_boot_ns) * s_scale / 1000.0);
+}
+
+void sim_sleep_us(int64_t sim_us)
+{
+    if (sim_us <= 0) return;
+    int64_t host_ns = (int64_t)((double)sim_us * 1000.0 / s_scale);
+    struct timespec ts = { host_ns / 1000000000LL, host_ns % 1000000000LL };
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) { }
+}
+
+void sim_sleep_until_us(int64_t sim_deadline_us)
+{
+    sim_sleep_us(sim_deadline_us - sim_time_now_us());
+}
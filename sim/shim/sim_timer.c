@@ -0,0 +1,150 @@
+/*
+ * Host shim: esp_timer.
+ * Armed timers sit in a small list; one dispatcher thread sleeps until the
+ * earliest deadline on the sim clock and runs callbacks in task context.
+ */
+
+#include "esp_timer.h"
+#include "sim_time.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    int64_t  deadline_us;    // sim time; 0 when not armed
+    uint64_t period_us;      // 0 for one-shot
+    struct esp_timer *next;
+};
+
+static pthread_mutex_t  s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   s_cond;
+static pthread_once_t   s_once = PTHREAD_ONCE_INIT;
+static struct esp_timer *s_timers = NULL;
+
+static void *dispatcher(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&s_lock);
+    while (1) {
+        int64_t now = sim_time_now_us();
+        struct esp_timer *due = NULL;
+        int64_t next = INT64_MAX;
+        for (struct esp_timer *t = s_timers; t; t = t->next) {
+            if (t->deadline_us == 0) continue;
+            if (t->deadline_us <= now) { due = t; break; }
+            if (t->deadline_us < next) next = t->deadline_us;
+        }
+        if (due) {
+            due->deadline_us = due->period_us ? due->deadline_us + (int64_t)due->period_us : 0;
+            esp_timer_cb_t cb = due->args.callback;
+            void *cb_arg = due->args.arg;
+            pthread_mutex_unlock(&s_lock);
+            cb(cb_arg);
+            pthread_mutex_lock(&s_lock);
+            continue;
+        }
+        if (next == INT64_MAX) {
+            pthread_cond_wait(&s_cond, &s_lock);
+        } else {
+            // convert the sim-time gap to an absolute host deadline
+            int64_t host_ns = (int64_t)((double)(next - now) * 1000.0 / sim_time_scale());
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            host_ns += ts.tv_nsec;
+            ts.tv_sec += host_ns / 1000000000LL;
+            ts.tv_nsec = host_ns % 1000000000LL;
+            pthread_cond_timedwait(&s_cond, &s_lock, &ts);
+        }
+    }
+    return NULL;
+}
+
+static void start_dispatcher(void)
+{
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_cond, &ca);
+    pthread_condattr_destroy(&ca);
+
+    pthread_t th;
+    pthread_create(&th, NULL, dispatcher, NULL);
+    pthread_detach(th);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (!args || !args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    pthread_once(&s_once, start_dispatcher);
+
+    struct esp_timer *t = calloc(1, sizeof *t);
+    if (!t) return ESP_ERR_NO_MEM;
+    t->args = *args;
+
+    pthread_mutex_lock(&s_lock);
+    t->next = s_timers;
+    s_timers = t;
+    pthread_mutex_unlock(&s_lock);
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t arm(esp_timer_handle_t t, uint64_t us, uint64_t period)
+{
+    if (!t) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    if (t->deadline_us != 0) { pthread_mutex_unlock(&s_lock); return ESP_ERR_INVALID_STATE; }
+    t->deadline_us = sim_time_now_us() + (int64_t)us;
+    if (t->deadline_us == 0) t->deadline_us = 1;
+    t->period_us = period;
+    pthread_cond_signal(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    esp_err_t rc = timer->deadline_us ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->deadline_us = 0;
+    pthread_mutex_unlock(&s_lock);
+    return rc;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&s_lock);
+    if (timer->deadline_us) { pthread_mutex_unlock(&s_lock); return ESP_ERR_INVALID_STATE; }
+    for (struct esp_timer **pp = &s_timers; *pp; pp = &(*pp)->next) {
+        if (*pp == timer) { *pp = timer->next; break; }
+    }
+    pthread_mutex_unlock(&s_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&s_lock);
+    bool active = timer && timer->deadline_us != 0;
+    pthread_mutex_unlock(&s_lock);
+    return active;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_time_now_us();
+}
@@ -0,0 +1,20 @@
+/*
+ * Wi-Fi station (sim implementation).
+ * The host network stack is already up and the host clock is valid, so the
+ * wifi.h API reports ready immediately.
+ */
+
+#include "wifi.h"
+#include "esp_log.h"
+
+static const char *TAG = "wifi";
+
+esp_err_t wifi_start_station(void)
+{
+    ESP_LOGI(TAG, "sim: using host network");
+    return ESP_OK;
+}
+
+bool have_ip(void)        { return true; }
+bool time_is_set(void)    { return true; }
+void start_sntp_once(void) { }
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Scrape endpoint test: /api/snapshot history, health counters and ETag revalidation.
+
+    cmake --build build-sim && pytest sim/snapshot
+
+climate_sim runs at 120x, so a new sample lands every ~9 ms of wall time.
+After a quarter of an hour of sim time the document must carry the newest
+closed minutes in order, the same fields as /api/current, health counters
+that count the samples, and an ETag that an If-None-Match on the same
+keep-alive connection turns into a bodyless 304 while the room is unchanged:
+polled every 10 s of sim time, most polls between closed minutes get one.
+$SIM_BUILD points at the sim build directory (default build-sim).
+"""
+
+import http.client
+import json
+import os
+import re
+import subprocess
+import time
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+SCALE = 120
+
+
+@pytest.fixture
+def sim(tmp_path):
+    env = dict(os.environ, SIM_TIME_SCALE=str(SCALE), SIM_DURATION_S='7200', SIM_HTTP_PORT='0',
+               SIM_LOG_LEVEL='3', SIM_MQTT_URI='mqtt://127.0.0.1:1')
+    log = open(tmp_path / 'sim.log', 'w')
+    proc = subprocess.Popen([SIM], env=env, stdout=log, stderr=subprocess.STDOUT)   # a pipe would fill and stall it
+    try:
+        deadline = time.time() + 10
+        while time.time() < deadline:
+            m = re.search(r'listening on port (\d+)', open(log.name).read())
+            if m:
+                break
+            time.sleep(0.02)
+        else:
+            pytest.fail('sim did not start its web server')
+        conn = http.client.HTTPConnection('127.0.0.1', int(m.group(1)), timeout=5)
+        yield conn
+        conn.close()
+    finally:
+        proc.kill()
+        proc.wait()
+        log.close()
+
+
+def get(conn, path, etag=None):
+    conn.request('GET', path, headers={'If-None-Match': etag} if etag else {})
+    r = conn.getresponse()
+    return r.status, r.getheader('ETag'), r.read()
+
+
+def test_snapshot_document(sim):
+    deadline = time.time() + 30
+    while time.time() < deadline:
+        status, etag, body = get(sim, '/api/snapshot')
+        doc = json.loads(body)
+        if len(doc['history']['minute']) == 10:
+            break
+        time.sleep(0.2)
+    else:
+        pytest.fail(f'no 10 closed minutes: {doc["history"]}')
+    assert status == 200 and re.fullmatch(f'W/"{doc["boot"]}-[0-9a-f]{{8}}-10"', etag), etag
+    assert len(body) < 2500, len(body)
+
+    h = doc['history']
+    minutes = h['minute']
+    assert minutes == list(range(minutes[0], minutes[0] + 10))
+    assert doc['sample_ms'] // 60000 >= minutes[-1] + 1          # the open minute is not in it
+    for col in ('n', 't_min_cC', 't_mean_cC', 't_max_cC', 'rh_cRH', 'p_dPa', 'anomalies'):
+        assert len(h[col]) == 10, col
+    assert all(55 <= n <= 60 for n in h['n'])                      # 1030 ms loop: 58-59 per minute
+    assert all(lo <= mean <= hi for lo, mean, hi in zip(h['t_min_cC'], h['t_mean_cC'], h['t_max_cC']))
+
+    cur = doc['current']
+    assert set(cur) == {'inside', 'outside', 'pressure', 'trend', 'fusion', 'selfheat'}
+    assert abs(cur['inside']['t'] * 100 - h['t_mean_cC'][-1]) < 100
+    assert abs(cur['inside']['p'] * 10 - h['p_dPa'][-1]) < 500
+    health = doc['health']
+    assert health['samples'] >= sum(h['n']) and health['uptime_s'] >= minutes[-1] * 60
+    assert {'uplink', 'mqtt', 'udp'} <= set(health)
+
+    for n in (0, 60):
+        status, etag_n, body = get(sim, f'/api/snapshot?minutes={n}')
+        assert status == 200 and etag_n.endswith(f'-{n}"')
+        assert json.loads(body)['history']['minutes'] == n
+    assert get(sim, '/api/snapshot?minutes=61')[0] == 400
+
+
+def test_etag_revalidation(sim):
+    time.sleep(0.5)
+    status, etag, body = get(sim, '/api/snapshot')
+    seen_304 = polls = 0
+    for _ in range(60):                                             # 10 sim minutes
+        time.sleep(10.0 / SCALE)                                    # a scraper's 10 s: ~10 samples in between
+        doc = json.loads(body) if status == 200 else doc
+        status, etag2, body = get(sim, '/api/snapshot', etag)
+        polls += 1
+        if status == 304:
+            assert body == b'' and etag2 == etag
+            seen_304 += 1
+        else:                                                       # a minute closed or a reading moved
+            assert status == 200 and etag2 != etag and json.loads(body)['version'] > doc['version']
+            etag = etag2
+    assert seen_304 >= polls // 2, seen_304
+    assert get(sim, '/api/snapshot', 'W/"00000000-1-10"')[0] == 200
+    assert get(sim, '/api/snapshot', '*')[0] == 304
@@ -0,0 +1,334 @@
+/*
+ * Heap fragmentation soak (host tool).
+ * Replays a week of the firmware's heap traffic against a model of the
+ * ESP32 DRAM heap, twice: with the transient network buffers taken from the
+ * heap the way the firmware used to (weather response malloc'd per fetch,
+ * /trace export malloc'd whole) and with them drawn from net_pool.c. Reports
+ * free heap, largest free block and fragmentation once per simulated day.
+ *
+ *   heap_soak [--days N] [--seed S] [--json]
+ *
+ * Heap model: one region, first fit in address order, blocks split on
+ * allocation and coalesced with both neighbours on free, 4-byte alignment
+ * and 8 bytes of header per block (multi_heap with poisoning off). The
+ * ESP32's heap is several regions and TLSF from IDF 5; first fit leaves the
+ * same holes, only sooner.
+ *
+ * Traffic, in one-second steps:
+ *   boot          long-lived IDF/app allocations (Wi-Fi, lwIP, httpd, MQTT,
+ *                 timers), BOOT_BYTES in 64 B..2 KB pieces, never freed
+ *   weather       every 6 s: client (~1.3 KB in 4 pieces) for the length of
+ *                 the fetch; legacy adds the 8 KB response buffer (chunked
+ *                 reply, no Content-Length) for the same time
+ *   /trace        every 6 h: legacy mallocs the whole export (64 + 18 B per
+ *                 record, 1024 records) while it is sent
+ *   MQTT          every 10 s: a ~250 B outbox entry until the PUBACK (1-3 s)
+ *   httpd         every 10 s (dashboard refresh): ~600 B session for 1-5 s
+ *   lwIP          2-5 pbufs per second, 100-1600 B, freed within the second
+ *   churn         every ~5 min: a 32 B..1 KB allocation that lives for an
+ *                 exponential 2 h (DNS/ARP entries, reconnect state)
+ * The short-lived traffic of a second is allocated before the churn of
+ * that second and freed after it, so long-lived pieces land wherever the
+ * heap is while the transient buffers are out. The pooled run gives the
+ * heap NET_BLOCK_BYTES * CONFIG_APP_NET_POOL_BLOCKS less, the .bss the
+ * pool takes on the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "net_pool.h"
+
+#define HEAP_BYTES     (110 * 1024)   // largest DRAM region left after Wi-Fi on an ESP32
+#define BOOT_BYTES     (40 * 1024)
+#define HDR            8
+#define MIN_BLOCK      16             // smaller remainders stay with the allocation
+#define MAX_LIVE       4096
+#define TRACE_EXPORT   (64 + 2 * 9 * 1024)
+#define FETCH_BUF      8192
+#define DRIFT_PCT      15             // allowed change of the pooled run's mean largest block, half to half
+
+// ---- heap model ----
+
+typedef struct blk {
+    uint32_t off, size;               // size includes the header
+    bool     used;
+    struct blk *prev, *next;          // address order
+} blk_t;
+
+typedef struct {
+    blk_t   *head;
+    uint32_t total, used_bytes;
+    uint32_t fails;
+} heap_t;
+
+static void heap_init(heap_t *h, uint32_t bytes)
+{
+    blk_t *b = calloc(1, sizeof *b);
+    b->size = bytes;
+    *h = (heap_t){ .head = b, .total = bytes };
+}
+
+static void heap_destroy(heap_t *h)
+{
+    for (blk_t *b = h->head, *n; b; b = n) {
+        n = b->next;
+        free(b);
+    }
+}
+
+static blk_t *heap_alloc(heap_t *h, uint32_t len)
+{
+    uint32_t need = ((len + 3) & ~3u) + HDR;
+    for (blk_t *b = h->head; b; b = b->next) {
+        if (b->used || b->size < need) continue;
+        if (b->size - need >= MIN_BLOCK) {
+            blk_t *rest = calloc(1, sizeof *rest);
+            *rest = (blk_t){ .off = b->off + need, .size = b->size - need, .prev = b, .next = b->next };
+            if (b->next) b->next->prev = rest;
+            b->next = rest;
+            b->size = need;
+        }
+        b->used = true;
+        h->used_bytes += b->size;
+        return b;
+    }
+    h->fails++;
+    return NULL;
+}
+
+static void heap_free(heap_t *h, blk_t *b)
+{
+    if (!b) return;
+    b->used = false;
+    h->used_bytes -= b->size;
+    if (b->next && !b->next->used) {
+        blk_t *n = b->next;
+        b->size += n->size;
+        b->next = n->next;
+        if (n->next) n->next->prev = b;
+        free(n);
+    }
+    if (b->prev && !b->prev->used) {
+        blk_t *p = b->prev;
+        p->size += b->size;
+        p->next = b->next;
+        if (b->next) b->next->prev = p;
+        free(b);
+    }
+}
+
+// Free and largest as heap_caps_* report them: payload bytes, headers excluded.
+static uint32_t heap_free_bytes(const heap_t *h) { return h->total - h->used_bytes; }
+
+static uint32_t heap_largest(const heap_t *h)
+{
+    uint32_t best = 0;
+    for (const blk_t *b = h->head; b; b = b->next) {
+        if (!b->used && b->size > best) best = b->size;
+    }
+    return best > HDR ? best - HDR : 0;
+}
+
+// ---- traffic ----
+
+static uint64_t rng_state;
+
+static uint32_t rnd(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi) { return lo + rnd() % (hi - lo + 1); }
+static double   rnd_unit(void) { return (rnd() + 0.5) / 4294967296.0; }
+
+typedef struct {
+    blk_t   *b;
+    int64_t  free_at;                 // second
+} live_t;
+
+typedef struct {
+    live_t   v[MAX_LIVE];
+    int      n;
+} live_set_t;
+
+static void keep(live_set_t *s, blk_t *b, int64_t free_at)
+{
+    if (b && s->n < MAX_LIVE) s->v[s->n++] = (live_t){ b, free_at };
+}
+
+static void expire(heap_t *h, live_set_t *s, int64_t now)
+{
+    for (int i = 0; i < s->n;) {
+        if (s->v[i].free_at <= now) {
+            heap_free(h, s->v[i].b);
+            s->v[i] = s->v[--s->n];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Sampled every second while that second's transient buffers are out.
+typedef struct {
+    double   free_sum, largest_sum, frag_sum;
+    uint32_t largest_min;
+} day_t;
+
+typedef struct {
+    day_t    day[64];
+    uint32_t min_largest;             // over the whole run, sampled every second
+    uint32_t heap_fails;
+    net_pool_stats_t pool;
+} soak_t;
+
+static uint32_t frag_pct(uint32_t free_b, uint32_t largest)
+{
+    return free_b > largest ? 100u - (uint32_t)(100ull * largest / free_b) : 0;
+}
+
+static void run(bool pooled, int days, uint64_t seed, soak_t *out)
+{
+    heap_t h;
+    live_set_t *live = calloc(1, sizeof *live);
+    uint32_t pool_bytes = (uint32_t)NET_BLOCK_BYTES * CONFIG_APP_NET_POOL_BLOCKS;
+    heap_init(&h, HEAP_BYTES - (pooled ? pool_bytes : 0));
+    net_pool_init();
+    rng_state = seed;
+    memset(out, 0, sizeof *out);
+    out->min_largest = UINT32_MAX;
+
+    for (uint32_t got = 0; got < BOOT_BYTES;) {
+        uint32_t len = rnd_range(64, 2048);
+        heap_alloc(&h, len);
+        got += len;
+    }
+
+    int64_t end = (int64_t)days * 86400;
+    int64_t next_churn = 0;
+    for (int64_t t = 0; t < end; t++) {
+        blk_t *tmp[16];
+        int n_tmp = 0;
+        void *blocks[2] = { NULL, NULL };
+
+        if (t % 6 == 0) {                              // weather fetch
+            tmp[n_tmp++] = heap_alloc(&h, 620);        // esp_http_client_t
+            tmp[n_tmp++] = heap_alloc(&h, 512);        // rx buffer
+            tmp[n_tmp++] = heap_alloc(&h, 512);        // tx buffer
+            tmp[n_tmp++] = heap_alloc(&h, 96);         // URL pieces
+            if (pooled) blocks[0] = net_pool_get();
+            else tmp[n_tmp++] = heap_alloc(&h, FETCH_BUF);
+        }
+        if (t % (6 * 3600) == 3000) {                  // /trace download
+            if (pooled) blocks[1] = net_pool_get();
+            else tmp[n_tmp++] = heap_alloc(&h, TRACE_EXPORT);
+        }
+        if (t % 10 == 3) keep(live, heap_alloc(&h, rnd_range(200, 300)), t + rnd_range(1, 3));   // MQTT outbox
+        if (t % 10 == 7) keep(live, heap_alloc(&h, rnd_range(500, 700)), t + rnd_range(1, 5));   // httpd session
+        for (int i = (int)rnd_range(2, 5); i > 0; i--) tmp[n_tmp++] = heap_alloc(&h, rnd_range(100, 1600));
+
+        if (t >= next_churn) {                         // long-lived piece
+            keep(live, heap_alloc(&h, rnd_range(32, 1024)), t + 1 + (int64_t)(-7200.0 * log(rnd_unit())));
+            next_churn = t + 1 + (int64_t)(-300.0 * log(rnd_unit()));
+        }
+
+        day_t *d = &out->day[t / 86400];
+        uint32_t free_b = heap_free_bytes(&h), largest = heap_largest(&h);
+        d->free_sum += free_b;
+        d->largest_sum += largest;
+        d->frag_sum += frag_pct(free_b, largest);
+        if (t % 86400 == 0 || largest < d->largest_min) d->largest_min = largest;
+        if (largest < out->min_largest) out->min_largest = largest;
+        for (int i = n_tmp - 1; i >= 0; i--) heap_free(&h, tmp[i]);
+        net_pool_put(blocks[0]);
+        net_pool_put(blocks[1]);
+        expire(&h, live, t);
+    }
+    out->heap_fails = h.fails;
+    net_pool_stats(&out->pool);
+    heap_destroy(&h);
+    free(live);
+}
+
+int main(int argc, char **argv)
+{
+    int days = 7, json = 0;
+    uint64_t seed = 0x5eed;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) days = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--json") == 0) json = 1;
+        else {
+            fprintf(stderr, "usage: %s [--days N] [--seed S] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (days < 1 || days > 64 || seed == 0) {
+        fprintf(stderr, "--days 1..64, --seed nonzero\n");
+        return 2;
+    }
+
+    static soak_t res[2];
+    const char *names[2] = { "heap", "pool" };
+    for (int m = 0; m < 2; m++) run(m == 1, days, seed, &res[m]);
+
+    if (json) {
+        printf("{");
+        for (int m = 0; m < 2; m++) {
+            const soak_t *r = &res[m];
+            printf("%s\"%s\":{\"min_largest\":%u,\"heap_fails\":%u,\"pool_peak\":%u,\"pool_fails\":%u,\"days\":[",
+                   m ? "," : "", names[m], r->min_largest, r->heap_fails, r->pool.peak, r->pool.fails);
+            for (int d = 0; d < days; d++) {
+                const day_t *x = &r->day[d];
+                printf("%s{\"free_avg\":%.0f,\"largest_avg\":%.0f,\"largest_min\":%u,\"frag_avg_pct\":%.1f}",
+                       d ? "," : "", x->free_sum / 86400, x->largest_sum / 86400, x->largest_min, x->frag_sum / 86400);
+            }
+            printf("]}");
+        }
+        printf("}\n");
+    } else {
+        printf("%-4s %-5s %9s %12s %12s %9s\n", "day", "mode", "free_avg", "largest_avg", "largest_min", "frag_avg");
+        for (int d = 0; d < days; d++) {
+            for (int m = 0; m < 2; m++) {
+                const day_t *x = &res[m].day[d];
+                printf("%-4d %-5s %9.0f %12.0f %12u %8.1f%%\n", d + 1, names[m], x->free_sum / 86400,
+                       x->largest_sum / 86400, x->largest_min, x->frag_sum / 86400);
+            }
+        }
+        for (int m = 0; m < 2; m++) {
+            printf("%-5s lowest largest block %u B, failed allocations %u, pool peak %u/%u, pool misses %u\n",
+                   names[m], res[m].min_largest, res[m].heap_fails, res[m].pool.peak, res[m].pool.blocks,
+                   res[m].pool.fails);
+        }
+    }
+    // The pooled run must not drift: the mean largest block of the second
+    // half of the soak within DRIFT_PCT of the first half's (the churn alone
+    // moves it by up to ~10 % across seeds), and no failed allocation or pool
+    // miss. The worst second is reported, not checked; it is an extreme and
+    // moves more.
+    double first = 0, second = 0;
+    uint32_t worst_first = UINT32_MAX, worst_second = UINT32_MAX;
+    int half = days / 2;
+    for (int d = 0; d < days; d++) {
+        const day_t *x = &res[1].day[d];
+        if (d < half || days == 1) {
+            first += x->largest_sum / (days == 1 ? 1 : half);
+            if (x->largest_min < worst_first) worst_first = x->largest_min;
+        }
+        if (d >= half) {
+            second += x->largest_sum / (days - half);
+            if (x->largest_min < worst_second) worst_second = x->largest_min;
+        }
+    }
+    bool drift = second < first * (100 - DRIFT_PCT) / 100;
+    if (!json) printf("pool  second half vs first: mean largest %+.1f%%, worst %+.1f%%%s\n",
+                      100.0 * (second - first) / first, 100.0 * ((double)worst_second - worst_first) / worst_first,
+                      drift ? " (drift)" : "");
+    return drift || res[1].heap_fails || res[1].pool.fails ? 1 : 0;
+}
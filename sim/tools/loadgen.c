@@ -0,0 +1,397 @@
+/*
+ * HTTP load generator (host tool).
+ * Drives the dashboard server of the sim (or a QEMU/real device) with one
+ * thread per virtual client and reports throughput, latency percentiles and
+ * signs of socket exhaustion.
+ *
+ *   loadgen [--host H] [--port P] [--scenario NAME] [--conns N] [--duration S]
+ *           [--paths "/:8,/trace:1"] [--idle N] [--idle-interval-ms MS]
+ *           [--timeout-ms MS] [--json]
+ *
+ * Scenarios:
+ *   keepalive  each client reuses one connection for all its requests
+ *   short      a new connection per request (Connection: close)
+ *   slowloris  --idle sockets hold server slots while --conns clients run the
+ *              short scenario next to them. With --idle-interval-ms 0 (default)
+ *              they connect and send nothing; otherwise they send a partial
+ *              header and trickle one more header line every interval.
+ *   mixed      keepalive clients picking paths by weight from --paths
+ *
+ * A reused keep-alive connection that closes before answering is retried once
+ * on a fresh connection, as browsers do for GET; it is counted in "retries".
+ * Exhaustion = connect failures + connections closed without a response +
+ * response timeouts.
+ */
+
+#define _GNU_SOURCE            // strcasestr
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_PATHS 8
+
+typedef enum { SC_KEEPALIVE, SC_SHORT, SC_SLOWLORIS, SC_MIXED } scenario_t;
+
+typedef struct {
+    const char *path;
+    int         weight;
+} path_t;
+
+typedef struct {
+    uint64_t ok, http_4xx, http_5xx;
+    uint64_t connect_fail, closed_no_resp, timeouts, retries;
+    uint64_t bytes;
+    double  *lat_ms;            // per-request latency samples
+    size_t   n_lat, cap_lat;
+} client_stats_t;
+
+typedef struct {
+    struct sockaddr_in addr;
+    const char *host;
+    scenario_t  scenario;
+    int         conns, idle, idle_interval_ms;
+    double      duration_s;
+    int         timeout_ms;
+    path_t      paths[MAX_PATHS];
+    int         n_paths, weight_sum;
+    double      t_end;
+} config_t;
+
+typedef struct {
+    const config_t *cfg;
+    client_stats_t  st;
+    unsigned        seed;
+    uint64_t        idle_reconnects;   // slowloris sockets the server dropped
+} client_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void add_lat(client_stats_t *st, double ms)
+{
+    if (st->n_lat == st->cap_lat) {
+        st->cap_lat = st->cap_lat ? st->cap_lat * 2 : 1024;
+        st->lat_ms = realloc(st->lat_ms, st->cap_lat * sizeof(double));
+    }
+    st->lat_ms[st->n_lat++] = ms;
+}
+
+static int open_conn(const config_t *cfg)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct timeval tv = { cfg->timeout_ms / 1000, (cfg->timeout_ms % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    if (connect(fd, (const struct sockaddr *)&cfg->addr, sizeof cfg->addr) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static const char *pick_path(client_t *c)
+{
+    const config_t *cfg = c->cfg;
+    if (cfg->scenario != SC_MIXED || cfg->n_paths == 1) return cfg->paths[0].path;
+    int r = rand_r(&c->seed) % cfg->weight_sum;
+    for (int i = 0; i < cfg->n_paths; i++) {
+        if ((r -= cfg->paths[i].weight) < 0) return cfg->paths[i].path;
+    }
+    return cfg->paths[0].path;
+}
+
+typedef enum { RESP_OK, RESP_CLOSED, RESP_TIMEOUT } resp_t;
+
+// Read one response; *status gets the HTTP status. Handles Content-Length and
+// read-until-close bodies (chunked responses are read until the last chunk).
+static resp_t read_response(int fd, int *status, uint64_t *bytes, bool *server_closes)
+{
+    char buf[8192];
+    size_t len = 0;
+    char *eoh = NULL;
+    while (!eoh) {
+        if (len == sizeof buf - 1) return RESP_CLOSED;
+        ssize_t n = recv(fd, buf + len, sizeof buf - 1 - len, 0);
+        if (n == 0) return RESP_CLOSED;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? RESP_TIMEOUT : RESP_CLOSED;
+        len += (size_t)n;
+        buf[len] = '\0';
+        eoh = strstr(buf, "\r\n\r\n");
+    }
+    *status = (strncmp(buf, "HTTP/1.", 7) == 0) ? atoi(buf + 9) : 0;
+    *bytes += len;
+
+    size_t head = (size_t)(eoh + 4 - buf), have = len - head;
+    const char *cl = strcasestr(buf, "\r\nContent-Length:");
+    bool chunked = strcasestr(buf, "\r\nTransfer-Encoding: chunked") != NULL;
+    *server_closes = strcasestr(buf, "\r\nConnection: close") != NULL;
+    if (cl && cl < eoh) {
+        size_t want = strtoul(cl + 17, NULL, 10);
+        while (have < want) {
+            ssize_t n = recv(fd, buf, sizeof buf, 0);
+            if (n <= 0) return (n < 0 && errno == EAGAIN) ? RESP_TIMEOUT : RESP_CLOSED;
+            have += (size_t)n;
+            *bytes += (size_t)n;
+        }
+        return RESP_OK;
+    }
+    // No length: chunked until "0\r\n\r\n", otherwise until the server closes.
+    char tail[8] = "";
+    if (chunked && have >= 5) memcpy(tail, eoh + 4 + have - 5, 5);
+    for (;;) {
+        if (chunked && memcmp(tail, "0\r\n\r\n", 5) == 0) return RESP_OK;
+        ssize_t n = recv(fd, buf, sizeof buf, 0);
+        if (n == 0) { *server_closes = true; return RESP_OK; }
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? RESP_TIMEOUT : RESP_CLOSED;
+        *bytes += (size_t)n;
+        if (n >= 5) memcpy(tail, buf + n - 5, 5);
+        else { memmove(tail, tail + n, (size_t)(5 - n)); memcpy(tail + 5 - n, buf, (size_t)n); }
+    }
+}
+
+static void count_status(client_stats_t *st, int status)
+{
+    if (status >= 200 && status < 400) st->ok++;
+    else if (status >= 400 && status < 500) st->http_4xx++;
+    else st->http_5xx++;
+}
+
+static void *client_thread(void *arg)
+{
+    client_t *c = arg;
+    const config_t *cfg = c->cfg;
+    bool keep = (cfg->scenario == SC_KEEPALIVE || cfg->scenario == SC_MIXED);
+    int fd = -1;
+    char req[512];
+
+    while (now_s() < cfg->t_end) {
+        const char *path = pick_path(c);
+        int n = snprintf(req, sizeof req, "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n",
+                         path, cfg->host, keep ? "keep-alive" : "close");
+        bool reused = (fd >= 0);
+        double t0 = now_s();
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (fd < 0 && (fd = open_conn(cfg)) < 0) {
+                c->st.connect_fail++;
+                usleep(10000);
+                break;
+            }
+            int status = 0;
+            bool server_closes = false;
+            resp_t r = (send(fd, req, (size_t)n, MSG_NOSIGNAL) == n)
+                           ? read_response(fd, &status, &c->st.bytes, &server_closes)
+                           : RESP_CLOSED;
+            if (r == RESP_OK) {
+                add_lat(&c->st, (now_s() - t0) * 1000.0);
+                count_status(&c->st, status);
+                if (!keep || server_closes) { close(fd); fd = -1; }
+                break;
+            }
+            close(fd);
+            fd = -1;
+            if (r == RESP_CLOSED && reused && attempt == 0) {   // stale keep-alive: retry once
+                c->st.retries++;
+                reused = false;
+                continue;
+            }
+            if (r == RESP_TIMEOUT) c->st.timeouts++;
+            else c->st.closed_no_resp++;
+            break;
+        }
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+// Slowloris socket: hold a connection open without completing a request
+// (silent, or trickling header lines). Reconnects when the server drops it.
+static void *idle_thread(void *arg)
+{
+    client_t *c = arg;
+    const config_t *cfg = c->cfg;
+    int fd = -1;
+    double next_send = 0.0;
+    while (now_s() < cfg->t_end) {
+        if (fd < 0) {
+            if ((fd = open_conn(cfg)) < 0) { usleep(100000); continue; }
+            if (cfg->idle_interval_ms > 0) {
+                char head[128];
+                int n = snprintf(head, sizeof head, "GET / HTTP/1.1\r\nHost: %s\r\n", cfg->host);
+                send(fd, head, (size_t)n, MSG_NOSIGNAL);
+                next_send = now_s() + cfg->idle_interval_ms / 1000.0;
+            }
+        }
+        usleep(100000);
+        char b;
+        ssize_t r = recv(fd, &b, 1, MSG_DONTWAIT);      // 0 or a reply: the server gave up on us
+        bool dropped = (r == 0) || (r > 0) || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+        if (!dropped && cfg->idle_interval_ms > 0 && now_s() >= next_send) {
+            dropped = send(fd, "X-a: b\r\n", 8, MSG_NOSIGNAL) != 8;
+            next_send += cfg->idle_interval_ms / 1000.0;
+        }
+        if (dropped) {
+            close(fd);
+            fd = -1;
+            c->idle_reconnects++;
+        }
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double pct(const double *v, size_t n, double p)
+{
+    if (n == 0) return 0.0;
+    size_t i = (size_t)(p / 100.0 * (double)(n - 1) + 0.5);
+    return v[i < n ? i : n - 1];
+}
+
+static int parse_paths(config_t *cfg, const char *spec)
+{
+    static char copy[512];
+    snprintf(copy, sizeof copy, "%s", spec);
+    cfg->n_paths = 0;
+    cfg->weight_sum = 0;
+    for (char *save = NULL, *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        if (cfg->n_paths == MAX_PATHS || tok[0] != '/') return -1;
+        char *colon = strrchr(tok, ':');
+        int w = 1;
+        if (colon) { *colon = '\0'; w = atoi(colon + 1); }
+        if (w <= 0) return -1;
+        cfg->paths[cfg->n_paths++] = (path_t){ tok, w };
+        cfg->weight_sum += w;
+    }
+    return cfg->n_paths > 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    config_t cfg = { .host = "127.0.0.1", .scenario = SC_KEEPALIVE, .conns = 4, .idle = 0,
+                     .duration_s = 10.0, .timeout_ms = 3000 };
+    int port = 8080;
+    bool json = false;
+    const char *paths = "/", *scen = "keepalive";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)            cfg.host = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)       port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)   scen = argv[++i];
+        else if (strcmp(argv[i], "--conns") == 0 && i + 1 < argc)      cfg.conns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--idle") == 0 && i + 1 < argc)       cfg.idle = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--idle-interval-ms") == 0 && i + 1 < argc) cfg.idle_interval_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc)   cfg.duration_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--paths") == 0 && i + 1 < argc)      paths = argv[++i];
+        else if (strcmp(argv[i], "--timeout-ms") == 0 && i + 1 < argc) cfg.timeout_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0)                       json = true;
+        else {
+            fprintf(stderr, "usage: %s [--host H] [--port P] [--scenario keepalive|short|slowloris|mixed]\n"
+                            "       [--conns N] [--idle N] [--idle-interval-ms MS] [--duration S]\n"
+                            "       [--paths \"/:8,/trace:1\"]\n"
+                            "       [--timeout-ms MS] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (strcmp(scen, "keepalive") == 0)      cfg.scenario = SC_KEEPALIVE;
+    else if (strcmp(scen, "short") == 0)     cfg.scenario = SC_SHORT;
+    else if (strcmp(scen, "slowloris") == 0) cfg.scenario = SC_SLOWLORIS;
+    else if (strcmp(scen, "mixed") == 0)     cfg.scenario = SC_MIXED;
+    else { fprintf(stderr, "unknown scenario %s\n", scen); return 2; }
+    if (parse_paths(&cfg, paths) != 0) { fprintf(stderr, "bad --paths %s\n", paths); return 2; }
+    if (cfg.scenario == SC_SLOWLORIS && cfg.idle == 0) cfg.idle = 8;
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM }, *ai = NULL;
+    if (getaddrinfo(cfg.host, NULL, &hints, &ai) != 0 || !ai) { fprintf(stderr, "cannot resolve %s\n", cfg.host); return 2; }
+    cfg.addr = *(struct sockaddr_in *)ai->ai_addr;
+    cfg.addr.sin_port = htons((uint16_t)port);
+    freeaddrinfo(ai);
+
+    int n_idle = (cfg.scenario == SC_SLOWLORIS) ? cfg.idle : 0;
+    int total = cfg.conns + n_idle;
+    client_t  *cl = calloc((size_t)total, sizeof *cl);
+    pthread_t *th = calloc((size_t)total, sizeof *th);
+    double t_start = now_s();
+    cfg.t_end = t_start + cfg.duration_s;
+
+    for (int i = 0; i < n_idle; i++) {          // idle sockets first so they hold slots
+        cl[i] = (client_t){ .cfg = &cfg, .seed = (unsigned)i + 1 };
+        pthread_create(&th[i], NULL, idle_thread, &cl[i]);
+    }
+    if (n_idle) usleep(200000);
+    for (int i = n_idle; i < total; i++) {
+        cl[i] = (client_t){ .cfg = &cfg, .seed = (unsigned)i + 1 };
+        pthread_create(&th[i], NULL, client_thread, &cl[i]);
+    }
+    for (int i = 0; i < total; i++) pthread_join(th[i], NULL);
+    double elapsed = now_s() - t_start;
+
+    client_stats_t sum = { 0 };
+    uint64_t idle_reconnects = 0;
+    for (int i = 0; i < total; i++) {
+        client_stats_t *s = &cl[i].st;
+        sum.ok += s->ok; sum.http_4xx += s->http_4xx; sum.http_5xx += s->http_5xx;
+        sum.connect_fail += s->connect_fail; sum.closed_no_resp += s->closed_no_resp;
+        sum.timeouts += s->timeouts; sum.retries += s->retries; sum.bytes += s->bytes;
+        idle_reconnects += cl[i].idle_reconnects;
+        for (size_t k = 0; k < s->n_lat; k++) add_lat(&sum, s->lat_ms[k]);
+        free(s->lat_ms);
+    }
+    qsort(sum.lat_ms, sum.n_lat, sizeof(double), cmp_double);
+    uint64_t answered = sum.ok + sum.http_4xx + sum.http_5xx;
+    uint64_t exhausted = sum.connect_fail + sum.closed_no_resp + sum.timeouts;
+    double rps = answered / elapsed;
+    double p50 = pct(sum.lat_ms, sum.n_lat, 50), p90 = pct(sum.lat_ms, sum.n_lat, 90);
+    double p99 = pct(sum.lat_ms, sum.n_lat, 99), pmax = sum.n_lat ? sum.lat_ms[sum.n_lat - 1] : 0.0;
+
+    if (json) {
+        printf("{\"scenario\": \"%s\", \"conns\": %d, \"idle\": %d, \"duration_s\": %.2f, "
+               "\"requests\": %llu, \"ok\": %llu, \"http_4xx\": %llu, \"http_5xx\": %llu, "
+               "\"req_per_s\": %.1f, \"latency_ms\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}, "
+               "\"exhaustion\": {\"total\": %llu, \"connect_fail\": %llu, \"closed_no_response\": %llu, "
+               "\"timeouts\": %llu, \"retries\": %llu, \"idle_dropped\": %llu}, \"bytes\": %llu}\n",
+               scen, cfg.conns, n_idle, elapsed, (unsigned long long)answered, (unsigned long long)sum.ok,
+               (unsigned long long)sum.http_4xx, (unsigned long long)sum.http_5xx, rps, p50, p90, p99, pmax,
+               (unsigned long long)exhausted, (unsigned long long)sum.connect_fail,
+               (unsigned long long)sum.closed_no_resp, (unsigned long long)sum.timeouts,
+               (unsigned long long)sum.retries, (unsigned long long)idle_reconnects,
+               (unsigned long long)sum.bytes);
+    } else {
+        printf("scenario %-9s conns=%d idle=%d  %.1f s\n", scen, cfg.conns, n_idle, elapsed);
+        printf("  requests %llu (ok %llu, 4xx %llu, 5xx %llu)  %.1f req/s\n",
+               (unsigned long long)answered, (unsigned long long)sum.ok, (unsigned long long)sum.http_4xx,
+               (unsigned long long)sum.http_5xx, rps);
+        printf("  latency ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n", p50, p90, p99, pmax);
+        printf("  exhaustion %llu (connect fail %llu, closed w/o response %llu, timeouts %llu)  "
+               "retries %llu  idle sockets dropped %llu\n",
+               (unsigned long long)exhausted, (unsigned long long)sum.connect_fail,
+               (unsigned long long)sum.closed_no_resp, (unsigned long long)sum.timeouts,
+               (unsigned long long)sum.retries, (unsigned long long)idle_reconnects);
+    }
+    free(sum.lat_ms);
+    free(cl);
+    free(th);
+    return 0;
+}
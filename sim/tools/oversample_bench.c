@@ -0,0 +1,219 @@
+/*
+ * Sampling mode benchmark: noise vs CPU, bus and sensor current (host tool).
+ * Drives the BME280 register model directly on a virtual clock with each
+ * sampling configuration, runs the reads through the firmware's decimator
+ * and compensation, and reports per 1 Hz output sample:
+ *
+ *   sd_T / sd_P / sd_H  output noise on a flat signal (model noise: 0.02 °C,
+ *                       2 Pa, 0.3 %RH per x1 conversion)
+ *   lag_s               delay measured on a 0.01 °C/s temperature ramp
+ *   cpu_ns              host time of decimation + compensation per second
+ *   reads/s, bus_ms/s   I2C burst reads and bus time at 100 kHz (~112 bit
+ *                       times per 8-byte burst read incl. addressing)
+ *   sensor_uA           BME280 supply current from the conversion rate and
+ *                       datasheet typical currents (T 350 uA, P 714 uA,
+ *                       H 340 uA during their phases, 0.2 uA standby)
+ *
+ *   oversample_bench [--seconds N] [--json]
+ *
+ * Host CPU time is only a relative measure; on the ESP32 the compensation
+ * (double precision, software) dominates and runs once per output in every
+ * mode, while each extra read costs an I2C transaction and a wake-up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "bme280.h"
+#include "bme280_sim.h"
+#include "sample_pipeline.h"
+
+typedef struct {
+    const char *name;
+    uint8_t ctrl_hum, ctrl_meas, config;
+    uint8_t hz;                       // reads per second
+    int     filter;                   // -1 = no decimation (1 read per output)
+} mode_t_;
+
+static const mode_t_ MODES[] = {
+    { "x4_iir4_1hz",      CTRL_VAL1,      CTRL_VAL2,      CTRL_VAL3,      1,  -1 },   // current default
+    { "x16_1hz",          0x05,           0xB7,           0xA0,           1,  -1 },   // sensor-side x16, IIR off
+    { "x16_iir16_1hz",    0x05,           0xB7,           0xB0,           1,  -1 },
+    { "x1_10hz_mean",     CTRL_VAL1_FAST, CTRL_VAL2_FAST, CTRL_VAL3_FAST, 10, DECIM_MEAN },
+    { "x1_25hz_mean",     CTRL_VAL1_FAST, CTRL_VAL2_FAST, CTRL_VAL3_FAST, 25, DECIM_MEAN },
+    { "x1_25hz_median",   CTRL_VAL1_FAST, CTRL_VAL2_FAST, CTRL_VAL3_FAST, 25, DECIM_MEDIAN },
+    { "x1_25hz_hann",     CTRL_VAL1_FAST, CTRL_VAL2_FAST, CTRL_VAL3_FAST, 25, DECIM_HANN },
+};
+
+#define BUS_BITS_PER_READ 112.0
+#define I2C_BIT_US        (1e6 / I2C_HZ)
+
+static int64_t s_now_us;
+static int64_t virt_clock(void) { return s_now_us; }
+
+static double host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void write_reg(uint8_t reg, uint8_t val)
+{
+    uint8_t b[2] = { reg, val };
+    bme280_sim_i2c_write(b, 2);
+}
+
+static void read_raw(raw_sample_t *r)
+{
+    uint8_t reg = 0xF7, d[8];
+    bme280_sim_i2c_write(&reg, 1);
+    bme280_sim_i2c_read(d, sizeof d);
+    r->adc_P = (int32_t)(((uint32_t)d[0] << 12) | ((uint32_t)d[1] << 4) | (d[2] >> 4));
+    r->adc_T = (int32_t)(((uint32_t)d[3] << 12) | ((uint32_t)d[4] << 4) | (d[5] >> 4));
+    r->adc_H = (int32_t)(((uint32_t)d[6] << 8) | d[7]);
+    r->ts_us = s_now_us;
+}
+
+// Supply current of the sensor for its settings at `conv_per_s` conversions/s.
+static double sensor_uA(const mode_t_ *m, double conv_per_s)
+{
+    static const uint8_t os[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+    int ot = os[(m->ctrl_meas >> 5) & 7], op = os[(m->ctrl_meas >> 2) & 7], oh = os[m->ctrl_hum & 7];
+    double uA_ms = (1.25 + 2.3 * ot) * 350.0;
+    if (op) uA_ms += (2.3 * op + 0.575) * 714.0;
+    if (oh) uA_ms += (2.3 * oh + 0.575) * 340.0;
+    return conv_per_s * uA_ms / 1000.0 + 0.2;
+}
+
+typedef struct {
+    double sd_T, sd_P, sd_H, lag_s, cpu_ns, reads_per_s, bus_ms, uA;
+} result_t;
+
+// One run: `seconds` of outputs; returns output samples in *out (caller frees).
+static size_t run(const mode_t_ *m, int seconds, sample_t **out, double *cpu_ns, uint32_t *conversions)
+{
+    s_now_us = 0;
+    bme280_sim_reset();
+    s_now_us = 10000;                               // past the NVM copy after reset
+    write_reg(0xF2, m->ctrl_hum);
+    write_reg(0xF4, m->ctrl_meas);
+    write_reg(0xF5, m->config);
+
+    decimator_t dec;
+    if (m->filter >= 0) decimator_init(&dec, m->hz, (decim_filter_t)m->filter);
+    int64_t step_us = m->filter >= 0 ? 1000000 / m->hz : 1030000;
+    int warm = 10;                                  // outputs discarded while IIR/Hann fill
+    sample_t *s = calloc((size_t)(seconds + warm), sizeof *s);
+    size_t n = 0;
+    double t_cpu = 0;
+    bme280_sim_stats_t st0;
+    bme280_sim_get_stats(&st0);
+
+    while (n < (size_t)(seconds + warm)) {
+        s_now_us += step_us;
+        raw_sample_t raw, dec_out;
+        read_raw(&raw);
+        double t0 = host_ns();
+        bool ready = true;
+        if (m->filter >= 0) ready = decimator_push(&dec, &raw, &dec_out);
+        else dec_out = raw;
+        if (ready) sample_pipeline_process(&dec_out, &s[n]);
+        t_cpu += host_ns() - t0;
+        if (ready) n++;
+    }
+    bme280_sim_stats_t st1;
+    bme280_sim_get_stats(&st1);
+    *conversions = st1.conversions - st0.conversions;
+    *cpu_ns = t_cpu / (double)n;
+    memmove(s, s + warm, (size_t)seconds * sizeof *s);
+    *out = s;
+    return (size_t)seconds;
+}
+
+static double sd_of(const sample_t *s, size_t n, int ch)
+{
+    double sum = 0, sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        double v = ch == 0 ? s[i].T_C : ch == 1 ? s[i].P_Pa : s[i].H_RH;
+        sum += v;
+        sq += v * v;
+    }
+    double mean = sum / n;
+    return sqrt(sq / n - mean * mean);
+}
+
+static void measure(const mode_t_ *m, int seconds, result_t *r)
+{
+    sample_t *s;
+    uint32_t conv;
+
+    // noise: flat signal
+    bme280_sim_parse_waves("T=22.5,0,0,0,0.02;P=101325,0,0,0,2;H=45,0,0,0,0.3");
+    bme280_sim_set_seed(1);
+    size_t n = run(m, seconds, &s, &r->cpu_ns, &conv);
+    r->sd_T = sd_of(s, n, 0);
+    r->sd_P = sd_of(s, n, 1);
+    r->sd_H = sd_of(s, n, 2);
+    double secs = (double)(s_now_us - 10000) / 1e6;
+    r->uA = sensor_uA(m, conv / secs);
+    r->reads_per_s = m->filter >= 0 ? m->hz : 1e6 / 1030000.0;
+    r->bus_ms = r->reads_per_s * BUS_BITS_PER_READ * I2C_BIT_US / 1000.0;
+    free(s);
+
+    // lag: 0.01 °C/s ramp, almost noise-free
+    const double slope = 0.01;
+    bme280_sim_parse_waves("T=22.5,0,0,36,0.0005;P=101325,0,0,0,0;H=45,0,0,0,0");
+    double cpu;
+    n = run(m, seconds < 120 ? seconds : 120, &s, &cpu, &conv);
+    double lag = 0;
+    for (size_t i = 0; i < n; i++) {
+        double truth = 22.5 + slope * (double)s[i].ts_us / 1e6;
+        lag += (truth - s[i].T_C) / slope;
+    }
+    r->lag_s = lag / n;
+    free(s);
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 1800;
+    int json = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0) json = 1;
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seconds < 10) seconds = 10;
+
+    // calibration as the driver reads it from the model
+    uint8_t c88[BME280_CALIB_88_LEN], cE1[BME280_CALIB_E1_LEN], reg;
+    bme280_sim_set_clock(virt_clock);
+    bme280_sim_reset();
+    reg = 0x88; bme280_sim_i2c_write(&reg, 1); bme280_sim_i2c_read(c88, sizeof c88);
+    reg = 0xE1; bme280_sim_i2c_write(&reg, 1); bme280_sim_i2c_read(cE1, sizeof cE1);
+    bme280_set_calib_raw(c88, cE1);
+
+    if (json) printf("{\"seconds\":%d,\"modes\":{", seconds);
+    else printf("%-16s %8s %7s %7s %6s %7s %7s %9s %9s\n", "mode", "sd_T_mC", "sd_P_Pa", "sd_H",
+                "lag_s", "cpu_ns", "reads/s", "bus_ms/s", "sensor_uA");
+    for (size_t i = 0; i < sizeof MODES / sizeof MODES[0]; i++) {
+        result_t r;
+        measure(&MODES[i], seconds, &r);
+        if (json) {
+            printf("%s\"%s\":{\"sd_T_C\":%.5f,\"sd_P_Pa\":%.3f,\"sd_H_RH\":%.4f,\"lag_s\":%.2f,\"cpu_ns\":%.0f,"
+                   "\"reads_per_s\":%.2f,\"bus_ms_per_s\":%.2f,\"sensor_uA\":%.1f}", i ? "," : "", MODES[i].name,
+                   r.sd_T, r.sd_P, r.sd_H, r.lag_s, r.cpu_ns, r.reads_per_s, r.bus_ms, r.uA);
+        } else {
+            printf("%-16s %8.2f %7.3f %7.4f %6.2f %7.0f %7.2f %9.2f %9.1f\n", MODES[i].name, r.sd_T * 1000,
+                   r.sd_P, r.sd_H, r.lag_s, r.cpu_ns, r.reads_per_s, r.bus_ms, r.uA);
+        }
+    }
+    if (json) printf("}}\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Trace replay (host tool).
+ * Feeds a raw sensor trace captured from GET /trace back through the same
+ * consumer as the live loop (sample_pipeline_process) using the trace's own
+ * calibration block.
+ *
+ *   trace_replay [--speed N] [--csv] [--alerts] [--loops N] trace.btrc
+ *
+ * --speed   trace seconds per host second (default 0 = as fast as possible)
+ * --csv     print ts_ms,T_C,P_Pa,H_RH per sample
+ * --alerts  also run sms_eval_alert() on each sample (cooldowns follow --speed)
+ * --loops   replay the file N times (for throughput measurements)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim_time.h"
+#include "bme280.h"
+#include "sample_pipeline.h"
+#include "trace.h"
+#include "alert_eval.h"
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = (n > 0) ? malloc((size_t)n) : NULL;
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) { free(buf); buf = NULL; }
+    fclose(f);
+    *len = buf ? (size_t)n : 0;
+    return buf;
+}
+
+static double host_now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    double speed = 0.0;
+    int csv = 0, alerts = 0;
+    long loops = 1;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)      speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) loops = atol(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0)                   csv = 1;
+        else if (strcmp(argv[i], "--alerts") == 0)                alerts = 1;
+        else if (argv[i][0] != '-' && !path)                      path = argv[i];
+        else path = NULL, i = argc;
+    }
+    if (!path || loops < 1) {
+        fprintf(stderr, "usage: %s [--speed N] [--csv] [--alerts] [--loops N] trace.btrc\n", argv[0]);
+        return 2;
+    }
+
+    size_t len = 0;
+    uint8_t *buf = read_file(path, &len);
+    trace_header_t h;
+    if (!buf || trace_decode_header(buf, len, &h) != ESP_OK) {
+        fprintf(stderr, "%s: not a readable trace file\n", path);
+        free(buf);
+        return 1;
+    }
+    if (bme280_set_calib_raw(h.calib_88, h.calib_E1) != ESP_OK) {
+        fprintf(stderr, "%s: bad calibration block\n", path);
+        free(buf);
+        return 1;
+    }
+    fprintf(stderr, "trace: %u records, period %u ms, ctrl 0x%02X/0x%02X/0x%02X, start_unix_ms %lld\n",
+            (unsigned)h.record_count, h.period_ms, h.ctrl_hum, h.ctrl_meas, h.config,
+            (long long)h.start_unix_ms);
+
+    sim_time_init(speed > 0.0 ? speed : 1.0);   // alert cooldowns run on this clock
+
+    uint64_t n = 0;
+    double sum_T = 0.0, chk = 0.0;
+    double t0 = host_now_s();
+    for (long l = 0; l < loops; l++) {
+        trace_reader_t r;
+        trace_reader_init(&r, &h, buf + TRACE_HEADER_LEN, len - TRACE_HEADER_LEN);
+        raw_sample_t raw;
+        int64_t first_us = -1;
+        int64_t base_us = sim_time_now_us();
+        while (trace_reader_next(&r, &raw)) {
+            if (first_us < 0) first_us = raw.ts_us;
+            if (speed > 0.0) sim_sleep_until_us(base_us + (raw.ts_us - first_us));
+
+            sample_t s;
+            sample_pipeline_process(&raw, &s);
+            if (csv) printf("%lld,%.2f,%.2f,%.2f\n", (long long)(s.ts_us / 1000), s.T_C, s.P_Pa, s.H_RH);
+            if (alerts) sms_eval_alert(s.T_C);
+            sum_T += s.T_C;
+            chk += s.P_Pa + s.H_RH;
+            n++;
+        }
+    }
+    double dt = host_now_s() - t0;
+
+    fprintf(stderr, "replayed %llu samples in %.3f s (%.0f samples/s), mean T %.3f C, checksum %.3f\n",
+            (unsigned long long)n, dt, dt > 0.0 ? n / dt : 0.0, n ? sum_T / n : 0.0, chk);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,413 @@
+/*
+ * Uplink bytes-per-sample and latency benchmark (host tool).
+ * Sends the same readings to an in-process collector sink through the
+ * firmware's HTTP client path (http_ext_client_new/http_ext_post) in several
+ * ways, and through udp_telemetry.c to an in-process UDP receiver, and
+ * reports what each costs per sample: payload bytes as counted by the sink,
+ * an on-air estimate that adds TCP/IP (or UDP/IP) + 802.11 framing per packet
+ * and, optionally, a TLS/DTLS cost, and the mean age of a sample when it
+ * reaches the sink.
+ *
+ *   uplink_bench [--samples N] [--json]
+ *
+ * Modes:
+ *   json_close     one JSON reading per POST, new connection each time
+ *   json_keepalive one JSON reading per POST on one connection
+ *   bin_keepalive  one reading per POST (reading_codec batch of 1)
+ *   batch_N        http_uplink_encode_body() of N readings per POST
+ *                  (N = 10, 60 = the default 60 s period at 1 Hz, 120)
+ *   udp            udp_telemetry_submit() per reading; the receiver acks
+ *                  every 10 readings, like the reference receiver in sim/udp
+ *
+ * On-air model (estimate, not a capture): every packet costs 40 B TCP/IP +
+ * 36 B 802.11 MAC/LLC/FCS; data is cut into 1460 B segments; each request
+ * and each response gets one pure ACK; a connection adds 3 handshake + 4
+ * teardown packets. TLS adds ~4500 B of handshake per connection and 29 B
+ * per record (AES-GCM), one record per request and per response. UDP packets
+ * cost 28 B UDP/IP + 36 B; DTLS-PSK adds ~600 B of handshake per session and
+ * 29 B per datagram (AES-CCM-8).
+ *
+ * Age = measured loopback delivery time plus the time a 1 Hz sample waits
+ * for its batch ((N - 1) / 2 s for batches of N).
+ */
+
+#define _GNU_SOURCE            // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "http_client_ext.h"
+#include "http_uplink.h"
+#include "reading_codec.h"
+#include "udp_telemetry.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <time.h>
+#include <sys/time.h>
+
+#define PKT_OVERHEAD    (40 + 36)
+#define UDP_PKT_OVERHEAD (28 + 36)
+#define MSS             1460
+#define TLS_HANDSHAKE   4500
+#define TLS_RECORD      29
+#define DTLS_HANDSHAKE  600
+#define DTLS_RECORD     29
+#define UDP_ACK_EVERY   10
+
+typedef struct {
+    uint64_t conns, requests, bytes_in, bytes_out, readings, packets;
+} sink_stats_t;
+
+static int s_listen_fd;
+static sink_stats_t s_sink;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t segs(size_t n) { return n ? (n + MSS - 1) / MSS : 0; }
+
+// Count readings in a body: back-to-back reading_codec batches, or one JSON reading.
+static uint64_t body_readings(const uint8_t *b, size_t len)
+{
+    if (len && b[0] == '{') return 1;
+    uint64_t n = 0;
+    static reading_t tmp[READING_BATCH_MAX];
+    while (len >= READING_BATCH_HEADER_LEN) {
+        size_t blen = reading_batch_size(b[3]);
+        int k = blen <= len ? reading_batch_decode(b, blen, tmp, READING_BATCH_MAX) : -1;
+        if (k < 0) break;
+        n += (uint64_t)k;
+        b += blen;
+        len -= blen;
+    }
+    return n;
+}
+
+// Serve one connection: parse requests (Content-Length bodies), answer 204.
+static void serve(int fd)
+{
+    static const char RESP[] = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+    static uint8_t buf[64 * 1024];
+    size_t have = 0;
+    pthread_mutex_lock(&s_lock);
+    s_sink.conns++;
+    s_sink.packets += 7;
+    pthread_mutex_unlock(&s_lock);
+
+    while (1) {
+        ssize_t r = recv(fd, buf + have, sizeof buf - have, 0);
+        if (r <= 0) break;
+        have += (size_t)r;
+        while (1) {
+            uint8_t *end = memmem(buf, have, "\r\n\r\n", 4);
+            if (!end) break;
+            size_t hdr = (size_t)(end - buf) + 4;
+            size_t clen = 0;
+            for (uint8_t *p = buf; p < end; p++) {
+                if ((p == buf || p[-1] == '\n') && strncasecmp((char *)p, "Content-Length:", 15) == 0) {
+                    clen = strtoul((char *)p + 15, NULL, 10);
+                }
+            }
+            if (have < hdr + clen) break;
+            send(fd, RESP, sizeof RESP - 1, MSG_NOSIGNAL);
+            pthread_mutex_lock(&s_lock);
+            s_sink.requests++;
+            s_sink.bytes_in += hdr + clen;
+            s_sink.bytes_out += sizeof RESP - 1;
+            s_sink.readings += body_readings(buf + hdr, clen);
+            s_sink.packets += segs(hdr + clen) + segs(sizeof RESP - 1) + 2;
+            pthread_mutex_unlock(&s_lock);
+            memmove(buf, buf + hdr + clen, have - hdr - clen);
+            have -= hdr + clen;
+        }
+    }
+    close(fd);
+}
+
+static void *sink_thread(void *arg)
+{
+    (void)arg;
+    while (1) {
+        int fd = accept(s_listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+        serve(fd);     // the bench is a single client: one connection at a time
+    }
+    return NULL;
+}
+
+static int sink_start(void)
+{
+    s_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t al = sizeof a;
+    if (bind(s_listen_fd, (struct sockaddr *)&a, sizeof a) != 0 || listen(s_listen_fd, 4) != 0) return -1;
+    getsockname(s_listen_fd, (struct sockaddr *)&a, &al);
+    pthread_t th;
+    pthread_create(&th, NULL, sink_thread, NULL);
+    return ntohs(a.sin_port);
+}
+
+static void sink_snapshot(sink_stats_t *out)
+{
+    // Wait for the sink to finish the last request/close before reading counters.
+    usleep(50000);
+    pthread_mutex_lock(&s_lock);
+    *out = s_sink;
+    pthread_mutex_unlock(&s_lock);
+}
+
+typedef struct {
+    const char *name;
+    size_t per_post;          // readings per request
+    bool   json;
+    bool   reconnect;         // new client (connection) per request
+} uplink_mode_t;
+
+static const uplink_mode_t MODES[] = {
+    { "json_close",     1,   true,  true  },
+    { "json_keepalive", 1,   true,  false },
+    { "bin_keepalive",  1,   false, false },
+    { "batch_10",       10,  false, false },
+    { "batch_60",       60,  false, false },
+    { "batch_120",      120, false, false },
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void make_samples(sample_t *s, reading_t *r, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        s[i] = (sample_t){ .ts_us = (int64_t)i * 1030000, .T_C = 22.4 + 0.3 * ((i % 40) / 40.0),
+                           .P_Pa = 101325.0 - (double)(i % 97), .H_RH = 45.0 + 0.1 * (double)(i % 13) };
+        reading_from_sample(&s[i], 1760000000000LL + (int64_t)i * 1030, (uint32_t)i, &r[i]);
+    }
+}
+
+// *post_ms = sum over readings of the time their request took.
+static bool run_mode(const uplink_mode_t *m, const char *url, const reading_t *r, size_t n, double *post_ms)
+{
+    esp_http_client_handle_t c = NULL;
+    uint8_t body[http_uplink_body_cap(120)];
+    *post_ms = 0;
+    for (size_t i = 0; i < n; i += m->per_post) {
+        size_t k = n - i < m->per_post ? n - i : m->per_post;
+        size_t len, used = k;
+        int64_t t0 = now_ns();
+        if (m->json) {
+            len = (size_t)snprintf((char *)body, sizeof body,
+                                   "{\"seq\":%u,\"ts\":%lld,\"t\":%.2f,\"p\":%.1f,\"h\":%.2f}",
+                                   (unsigned)r[i].seq, (long long)r[i].unix_ms, reading_T_C(&r[i]),
+                                   reading_P_Pa(&r[i]), reading_H_RH(&r[i]));
+        } else {
+            len = http_uplink_encode_body(&r[i], k, body, sizeof body, &used);
+        }
+        if (!c) c = http_ext_client_new(url, 5000);
+        int status;
+        const char *ctype = m->json ? "application/json" : HTTP_UPLINK_CONTENT_TYPE;
+        if (http_ext_post(c, ctype, (const char *)body, (int)len, &status) != ESP_OK || status != 204 || used != k) {
+            fprintf(stderr, "%s: post failed (status %d)\n", m->name, status);
+            esp_http_client_cleanup(c);
+            return false;
+        }
+        *post_ms += (double)k * (double)(now_ns() - t0) / 1e6;
+        if (m->reconnect) {
+            esp_http_client_cleanup(c);
+            c = NULL;
+        }
+    }
+    if (c) esp_http_client_cleanup(c);
+    return true;
+}
+
+/* ---- UDP: udp_telemetry.c -> in-process receiver ---- */
+
+typedef struct {
+    uint64_t datagrams, acks, bytes_in, bytes_out, readings;
+    double delay_ms;                  // sum of submit -> arrival
+} udp_sink_stats_t;
+
+static int s_udp_fd;
+static udp_sink_stats_t s_udp;
+static int64_t *s_sent_ns;            // per seq, set before submit
+static uint8_t *s_seen;
+static size_t s_udp_n;
+
+// Reference receiver without loss: cumulative ack every UDP_ACK_EVERY readings.
+static void *udp_sink_thread(void *arg)
+{
+    (void)arg;
+    uint8_t buf[64];
+    uint32_t next = 0, since_ack = 0;
+    while (1) {
+        struct sockaddr_in peer;
+        socklen_t pl = sizeof peer;
+        ssize_t len = recvfrom(s_udp_fd, buf, sizeof buf, 0, (struct sockaddr *)&peer, &pl);
+        int64_t t = now_ns();
+        reading_t r;
+        uint8_t type;
+        uint16_t dev, epoch, depth;
+        if (len < 0 || !udpt_decode_reading(buf, (size_t)len, &r, &type, &dev, &epoch, &depth)) continue;
+        pthread_mutex_lock(&s_lock);
+        s_udp.datagrams++;
+        s_udp.bytes_in += (uint64_t)len;
+        if (r.seq < s_udp_n && !s_seen[r.seq]) {
+            s_seen[r.seq] = 1;
+            s_udp.readings++;
+            s_udp.delay_ms += (double)(t - s_sent_ns[r.seq]) / 1e6;
+        }
+        while (next < s_udp_n && s_seen[next]) next++;
+        bool ack = ++since_ack >= UDP_ACK_EVERY || next == s_udp_n;
+        pthread_mutex_unlock(&s_lock);
+        if (ack) {
+            udpt_ack_t a = { .device = dev, .epoch = epoch, .next = next };
+            uint8_t out[UDPT_ACK_LEN(0)];
+            size_t al = udpt_encode_ack(&a, out, sizeof out);
+            sendto(s_udp_fd, out, al, 0, (struct sockaddr *)&peer, pl);
+            pthread_mutex_lock(&s_lock);
+            s_udp.acks++;
+            s_udp.bytes_out += al;
+            pthread_mutex_unlock(&s_lock);
+            since_ack = 0;
+        }
+    }
+    return NULL;
+}
+
+static bool run_udp(sample_t *s, size_t n, udp_sink_stats_t *out)
+{
+    memset(out, 0, sizeof *out);                // the early returns report zeros
+    s_udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t al = sizeof a;
+    if (bind(s_udp_fd, (struct sockaddr *)&a, sizeof a) != 0) return false;
+    getsockname(s_udp_fd, (struct sockaddr *)&a, &al);
+    s_udp_n = n;
+    s_sent_ns = calloc(n, sizeof *s_sent_ns);
+    s_seen = calloc(n, 1);
+    pthread_t th;
+    pthread_create(&th, NULL, udp_sink_thread, NULL);
+
+    char target[32];
+    snprintf(target, sizeof target, "127.0.0.1:%d", ntohs(a.sin_port));
+    setenv("SIM_UDP_COLLECTOR", target, 1);     // read by the sim sdkconfig.h
+    if (udp_telemetry_start() != ESP_OK) return false;
+    usleep(100000);                             // task connects the socket
+
+    for (size_t i = 0; i < n; i++) {
+        s[i].ts_us = esp_timer_get_time();
+        pthread_mutex_lock(&s_lock);
+        s_sent_ns[i] = now_ns();
+        pthread_mutex_unlock(&s_lock);
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        udp_telemetry_submit(&s[i], (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+        usleep(200);                            // paced, not a burst
+    }
+    for (int i = 0; i < 100; i++) {
+        pthread_mutex_lock(&s_lock);
+        bool done = s_udp.readings == n;
+        pthread_mutex_unlock(&s_lock);
+        if (done) break;
+        usleep(20000);
+    }
+    usleep(50000);                              // last ack
+    pthread_mutex_lock(&s_lock);
+    *out = s_udp;
+    pthread_mutex_unlock(&s_lock);
+    return out->readings == n;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = 1200;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) n = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--json") == 0) json = true;
+        else {
+            fprintf(stderr, "usage: %s [--samples N] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);      // keep stdout to the table / JSON
+    int port = sink_start();
+    if (port < 0) {
+        perror("sink");
+        return 1;
+    }
+    char url[64];
+    snprintf(url, sizeof url, "http://127.0.0.1:%d/ingest", port);
+    sample_t *s = malloc(n * sizeof *s);
+    reading_t *r = malloc(n * sizeof *r);
+    make_samples(s, r, n);
+
+    if (json) printf("{\"samples\":%zu,\"modes\":{", n);
+    else printf("%-15s %6s %5s %11s %9s %10s %13s %10s\n", "mode", "posts", "conns", "bytes/smp",
+                "pkts/smp", "air B/smp", "air+TLS B/smp", "age ms");
+
+    int rc = 0;
+    double ns = (double)n;
+    for (size_t mi = 0; mi < sizeof MODES / sizeof MODES[0]; mi++) {
+        const uplink_mode_t *m = &MODES[mi];
+        sink_stats_t a, b;
+        double post_ms;
+        sink_snapshot(&a);
+        bool ok = run_mode(m, url, r, n, &post_ms);
+        sink_snapshot(&b);
+
+        uint64_t conns = b.conns - a.conns, reqs = b.requests - a.requests;
+        uint64_t http = (b.bytes_in - a.bytes_in) + (b.bytes_out - a.bytes_out);
+        uint64_t pkts = b.packets - a.packets;
+        uint64_t air = http + pkts * PKT_OVERHEAD;
+        uint64_t air_tls = air + conns * TLS_HANDSHAKE + reqs * 2 * TLS_RECORD;
+        uint64_t got = b.readings - a.readings;
+        double age_ms = (double)(m->per_post - 1) / 2 * 1000 + post_ms / ns;
+        if (!ok || got != n) {
+            fprintf(stderr, "%s: sink received %llu of %zu readings\n", m->name, (unsigned long long)got, n);
+            rc = 1;
+        }
+        if (json) {
+            printf("%s\"%s\":{\"posts\":%llu,\"conns\":%llu,\"http_bytes_per_sample\":%.1f,"
+                   "\"packets_per_sample\":%.2f,\"air_bytes_per_sample\":%.1f,\"air_tls_bytes_per_sample\":%.1f,"
+                   "\"age_ms\":%.3f}",
+                   mi ? "," : "", m->name, (unsigned long long)reqs, (unsigned long long)conns,
+                   http / ns, pkts / ns, air / ns, air_tls / ns, age_ms);
+        } else {
+            printf("%-15s %6llu %5llu %11.1f %9.2f %10.1f %13.1f %10.3f\n", m->name, (unsigned long long)reqs,
+                   (unsigned long long)conns, http / ns, pkts / ns, air / ns, air_tls / ns, age_ms);
+        }
+    }
+
+    udp_sink_stats_t u = { 0 };
+    if (!run_udp(s, n, &u)) {
+        fprintf(stderr, "udp: receiver got %llu of %zu readings\n", (unsigned long long)u.readings, n);
+        rc = 1;
+    }
+    uint64_t pkts = u.datagrams + u.acks, bytes = u.bytes_in + u.bytes_out;
+    uint64_t air = bytes + pkts * UDP_PKT_OVERHEAD;
+    uint64_t air_dtls = air + DTLS_HANDSHAKE + pkts * DTLS_RECORD;
+    double age_ms = u.readings ? u.delay_ms / (double)u.readings : 0;
+    if (json) {
+        printf(",\"udp\":{\"datagrams\":%llu,\"acks\":%llu,\"bytes_per_sample\":%.1f,\"packets_per_sample\":%.2f,"
+               "\"air_bytes_per_sample\":%.1f,\"air_dtls_bytes_per_sample\":%.1f,\"age_ms\":%.3f}}}\n",
+               (unsigned long long)u.datagrams, (unsigned long long)u.acks, bytes / ns, pkts / ns, air / ns,
+               air_dtls / ns, age_ms);
+    } else {
+        printf("%-15s %6s %5s %11.1f %9.2f %10.1f %13.1f %10.3f\n", "udp", "-", "-", bytes / ns, pkts / ns,
+               air / ns, air_dtls / ns, age_ms);
+    }
+    free(s);
+    free(r);
+    return rc;
+}
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""UDP telemetry tests: climate_sim -> a reference receiver with packet loss.
+
+    cmake --build build-sim && pytest sim/udp
+
+The receiver follows udp_telemetry.h: cumulative ack + missing ranges, sent
+every ACK_EVERY readings, when a new gap shows up, and ACK_DELAY_S after the
+oldest unacknowledged reading. It
+can drop a share of the datagrams in either direction to exercise gap fill
+from the device's history. $SIM_BUILD points at the sim build directory
+(default build-sim).
+"""
+
+import os
+import random
+import socket
+import struct
+import subprocess
+import threading
+import time
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+DEVICE = 7                 # CONFIG_APP_UDP_DEVICE_ID in sim/shim/include/sdkconfig.h
+SCALE = 20                 # SIM_TIME_SCALE
+ACK_EVERY = 10
+ACK_DELAY_S = 15 / SCALE   # ack a partial window after 15 sim s (real seconds here)
+
+
+class Receiver:
+    def __init__(self, seed=1, drop_in=0.0, drop_out=0.0):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('127.0.0.1', 0))
+        self.sock.settimeout(0.01)
+        self.rng = random.Random(seed)
+        self.drop_in, self.drop_out = drop_in, drop_out
+        self.deaf = False                 # drop everything (outage)
+        self.readings = {}                # seq -> (unix_ms, T_C, P_Pa, H_RH)
+        self.first_arrival = {}           # seq -> 'new' | 'resent'
+        self.datagrams = self.resent = self.dupes = self.acks = 0
+        self.epoch = None
+        self.next = None
+        self.peer = None
+        self.since_ack = 0
+        self.unacked_since = None
+        self.running = True
+        self.thread = threading.Thread(target=self._loop, daemon=True)
+        self.thread.start()
+
+    @property
+    def port(self):
+        return self.sock.getsockname()[1]
+
+    def _missing(self):
+        if self.next is None or not self.readings:
+            return []
+        top = max(self.readings)
+        out, s = [], self.next
+        while s <= top and len(out) < 8:
+            if s in self.readings:
+                s += 1
+                continue
+            first = s
+            while s <= top and s not in self.readings and s - first < 0xFFFF:
+                s += 1
+            out.append((first, s - first))
+        return out
+
+    def _ack(self):
+        if self.peer is None or self.next is None:
+            return
+        self.since_ack = 0
+        self.unacked_since = None
+        ranges = self._missing()
+        if self.rng.random() < self.drop_out:
+            return
+        pkt = struct.pack('<BHHBI', 0x13, DEVICE, self.epoch, len(ranges), self.next)
+        pkt += b''.join(struct.pack('<IH', f, c) for f, c in ranges)
+        self.sock.sendto(pkt, self.peer)
+        self.acks += 1
+
+    def _reading(self, data, peer):
+        hdr, dev, epoch, depth, seq, ms_lo, ms_hi, t, h, p0, p1, p2 = struct.unpack('<BHHHIIHhH3B', data)
+        assert hdr >> 4 == 1 and dev == DEVICE
+        oldest = seq - depth
+        self.peer = peer
+        if epoch != self.epoch:
+            if self.next is None or not oldest <= self.next <= seq + 1:
+                self.next = oldest
+            self.epoch = epoch
+        if self.next < oldest:
+            self.next = oldest                         # the device no longer has those
+        self.datagrams += 1
+        if hdr & 0x0F == 2:
+            self.resent += 1
+        gap_opened = bool(self.readings) and seq > max(self.readings) + 1
+        if seq < self.next or seq in self.readings:
+            self.dupes += 1
+        else:
+            self.readings[seq] = (ms_lo | ms_hi << 32, t / 100, (p0 | p1 << 8 | p2 << 16) / 10, h / 100)
+            self.first_arrival[seq] = 'resent' if hdr & 0x0F == 2 else 'new'
+            while self.next in self.readings:
+                self.next += 1
+        self.since_ack += 1
+        if self.unacked_since is None:
+            self.unacked_since = time.monotonic()
+        if self.since_ack >= ACK_EVERY or gap_opened:
+            self._ack()
+
+    def _loop(self):
+        while self.running:
+            try:
+                data, peer = self.sock.recvfrom(128)
+            except socket.timeout:
+                if self.unacked_since and time.monotonic() - self.unacked_since > ACK_DELAY_S:
+                    self._ack()
+                continue
+            except OSError:
+                return
+            if self.deaf or self.rng.random() < self.drop_in:
+                continue
+            self._reading(data, peer)
+
+    def close(self):
+        self.running = False
+        self.thread.join()
+        self.sock.close()
+
+
+def run_sim(port, scale, duration):
+    env = dict(os.environ, SIM_UDP_COLLECTOR=f'127.0.0.1:{port}', SIM_TIME_SCALE=str(scale),
+               SIM_DURATION_S=str(duration), SIM_HTTP_PORT='0', SIM_LOG_LEVEL='2',
+               SIM_MQTT_URI='mqtt://127.0.0.1:1', SIM_HTTP_REDIRECT='http://127.0.0.1:1')
+    return subprocess.Popen([SIM], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def contiguous(seqs):
+    return seqs == list(range(seqs[0], seqs[0] + len(seqs)))
+
+
+def test_every_sample_arrives_at_once():
+    rx = Receiver()
+    run_sim(rx.port, scale=SCALE, duration=120).wait(timeout=30)
+    time.sleep(0.2)
+    rx.close()
+
+    seqs = sorted(rx.readings)
+    assert seqs[0] == 0 and contiguous(seqs) and len(seqs) >= 100
+    # Only a reading taken before the socket was up may arrive as a resend.
+    assert rx.resent <= 1 and rx.dupes == 0
+    assert rx.acks <= len(seqs) / ACK_EVERY + 5
+    for ms, T, P, H in rx.readings.values():
+        assert -40 < T < 85 and 30000 < P < 110000 and 0 <= H <= 100
+
+
+def test_gaps_filled_from_device_history():
+    rx = Receiver(seed=2, drop_in=0.15, drop_out=0.3)
+    run_sim(rx.port, scale=SCALE, duration=300).wait(timeout=40)
+    time.sleep(0.2)
+    rx.close()
+
+    seqs = sorted(rx.readings)
+    # All but the last few seconds (whose gaps had no time to be asked for) arrived.
+    assert seqs[0] == 0 and len(seqs) >= 250
+    assert contiguous(seqs[:-5]), 'gap left unfilled'
+    assert rx.resent > 0.1 * len(seqs)
+    assert rx.dupes < 0.2 * len(seqs)
+
+
+def test_outage_backfilled_after_receiver_returns():
+    rx = Receiver()
+    rx.deaf = True
+    sim = run_sim(rx.port, scale=SCALE, duration=240)
+    time.sleep(4)                       # ~80 sim s unheard
+    rx.deaf = False
+    sim.wait(timeout=40)
+    time.sleep(0.2)
+    rx.close()
+
+    seqs = sorted(rx.readings)
+    assert seqs[0] == 0 and contiguous(seqs) and len(seqs) >= 200
+    backfilled = [s for s, how in rx.first_arrival.items() if how == 'resent']
+    assert len(backfilled) >= 50
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""HTTP uplink end-to-end test: climate_sim -> stand-in InfluxDB 2 write API.
+
+    cmake --build build-sim && pytest sim/uplink
+
+The sim build has the uplink in line-protocol mode (CONFIG_APP_UPLINK_FORMAT_INFLUX,
+gzip on, sim/shim/include/sdkconfig.h); SIM_HTTP_REDIRECT points it at the
+sink below, which checks each request the way InfluxDB would (path, query,
+token, Content-Encoding) and parses every line. $SIM_BUILD points at the sim
+build directory (default build-sim).
+"""
+
+import gzip
+import http.server
+import os
+import re
+import subprocess
+import threading
+import time
+import urllib.parse
+
+import pytest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SIM = os.path.join(os.environ.get('SIM_BUILD', os.path.join(ROOT, 'build-sim')), 'climate_sim')
+
+LINE = re.compile(r'^(?P<series>[^ ]+) (?P<fields>[^ ]+) (?P<ts>\d+)$')
+
+
+class InfluxSink(http.server.ThreadingHTTPServer):
+    def __init__(self, status=204):
+        super().__init__(('127.0.0.1', 0), SinkHandler)
+        self.status = status
+        self.requests = []            # dict(path, query, headers, raw_len, lines)
+        self.errors = []
+        threading.Thread(target=self.serve_forever, daemon=True).start()
+
+    @property
+    def port(self):
+        return self.server_address[1]
+
+    def points(self):
+        """Lines of the accepted requests."""
+        return [p for r in list(self.requests) if r['status'] < 300 for p in r['lines']]
+
+
+class SinkHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_POST(self):
+        srv = self.server
+        status = srv.status
+        body = self.rfile.read(int(self.headers['Content-Length']))
+        url = urllib.parse.urlsplit(self.path)
+        try:
+            raw_len = len(body)
+            if self.headers.get('Content-Encoding') == 'gzip':
+                body = gzip.decompress(body)
+            lines = []
+            for text in body.decode().splitlines():
+                m = LINE.match(text)
+                if not m:
+                    raise ValueError(f'bad line: {text!r}')
+                fields = dict(kv.split('=') for kv in m['fields'].split(','))
+                lines.append((m['series'], {k: float(v) for k, v in fields.items()}, int(m['ts'])))
+            srv.requests.append({'path': url.path, 'query': urllib.parse.parse_qs(url.query),
+                                 'headers': dict(self.headers), 'status': status, 'raw_len': raw_len,
+                                 'text_len': len(body), 'lines': lines})
+        except Exception as e:          # noqa: BLE001 - reported through the test
+            srv.errors.append(str(e))
+            self.send_response(400)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+        self.send_response(status)
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+
+    def log_message(self, *args):
+        pass
+
+
+def run_sim(sink_port, scale, duration):
+    env = dict(os.environ, SIM_HTTP_REDIRECT=f'http://127.0.0.1:{sink_port}', SIM_TIME_SCALE=str(scale),
+               SIM_DURATION_S=str(duration), SIM_HTTP_PORT='0', SIM_LOG_LEVEL='2',
+               SIM_MQTT_URI='mqtt://127.0.0.1:1')
+    subprocess.run([SIM], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=60, check=False)
+
+
+@pytest.fixture
+def sink():
+    s = InfluxSink()
+    yield s
+    s.shutdown()
+
+
+def test_line_protocol_uploads(sink):
+    run_sim(sink.port, scale=100, duration=400)      # 6 uploads of ~58 readings
+
+    assert not sink.errors, sink.errors
+    assert len(sink.requests) >= 5
+    for r in sink.requests:
+        assert r['path'] == '/api/v2/write'
+        assert r['query'] == {'org': ['sim'], 'bucket': ['climate'], 'precision': ['ms']}
+        assert r['headers']['Authorization'] == 'Token sim'
+        assert r['headers']['Content-Encoding'] == 'gzip'
+        if len(r['lines']) >= 30:
+            assert r['raw_len'] * 3 < r['text_len'], 'gzip should shrink line protocol > 3x'
+
+    readings = [p for p in sink.points() if 't' in p[1]]
+    outside = [p for p in sink.points() if 'out_t' in p[1]]
+    assert all(series == 'climate,device=sim' for series, _, _ in sink.points())
+    for _, f, _ in readings:
+        assert set(f) == {'t', 'p', 'h'}
+        assert -40 < f['t'] < 85 and 30000 < f['p'] < 110000 and 0 <= f['h'] <= 100
+    ts = [t for _, _, t in readings]
+    # The sim's wall clock runs in real time, so readings are only ~10 ms apart
+    # and the wall/monotonic conversion can jitter by a millisecond.
+    assert all(b > a - 2 for a, b in zip(ts, ts[1:]))
+    assert len(outside) == len(sink.requests)
+    assert outside[-1][1] == {'out_t': 18.4, 'out_h': 71.0}    # sim Open-Meteo fixture
+
+
+def test_retry_after_collector_errors(sink):
+    # 503 for the first ~200 sim s: nothing is acked, so the next accepted
+    # upload must start from the first reading.
+    sink.status = 503
+    t = threading.Timer(2.0, lambda: setattr(sink, 'status', 204))
+    t.start()
+    run_sim(sink.port, scale=100, duration=900)
+    t.cancel()
+
+    statuses = [r['status'] for r in sink.requests]
+    assert statuses[0] == 503 and 204 in statuses, statuses
+    first = sink.requests[0]['lines'][0]
+    accepted = sink.requests[statuses.index(204)]
+    assert accepted['lines'][0] == first, 'rejected readings were not sent again'
+    assert len(accepted['lines']) > len(sink.requests[0]['lines'])